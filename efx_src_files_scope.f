@@ -4,6 +4,8 @@ hdl/AcqCtlPkg.vhd
 hdl/SDRAMBufPkg.vhd
 hdl/BitBangIF.vhd
 hdl/CommandBitBang.vhd
+hdl/SimpleI2cMaster.vhd
+hdl/CommandI2c.vhd
 hdl/CommandAcqParm.vhd
 hdl/MaxAdc.vhd
 hdl/CicFilter.vhd
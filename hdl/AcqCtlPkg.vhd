@@ -41,6 +41,9 @@ package AcqCtlPkg is
       src          : TriggerSrcType;
       rising       : boolean;
       trgDirOut    : boolean;
+      -- ping-pong buffering (record into one half of the memory
+      -- while the other one is read out)
+      dblBuf       : boolean;
       lvl          : signed  (15 downto 0);
       nprets       : unsigned(23 downto 0);
       nsamples     : unsigned(23 downto 0);
@@ -51,6 +54,10 @@ package AcqCtlPkg is
       shift1       : unsigned( 6 downto 0);
       scale        : signed  (17 downto 0);
       hyst         : unsigned(15 downto 0);
+      -- number of segments - 1 (0: ordinary acquisition)
+      nsegs        : unsigned(15 downto 0);
+      -- number of averaged acquisitions - 1 (0: no averaging)
+      navg         : unsigned(15 downto 0);
    end record AcqCtlParmType;
 
    function toSlv(constant x : in AcqCtlParmType) return std_logic_vector;
@@ -61,6 +68,7 @@ package AcqCtlPkg is
       src         => CHA,
       rising      => true,
       trgDirOut   => false,
+      dblBuf      => false,
       lvl         => (others => '0'),
       nprets      => (others => '0'),
       nsamples    => (others => '0'),
@@ -70,7 +78,9 @@ package AcqCtlPkg is
       shift0      => (others => '0'),
       shift1      => (others => '0'),
       scale       => (16 => '1', others => '0'),
-      hyst        => to_unsigned( 1024, 16 )
+      hyst        => to_unsigned( 1024, 16 ),
+      nsegs       => (others => '0'),
+      navg        => (others => '0')
    );
 
    function acqCtlParmSizeBytes return natural;
@@ -92,7 +102,7 @@ package body AcqCtlPkg is
       variable v : natural := 0;
       variable x : AcqCtlParmType;
    begin
-      v := v + 1; -- src + 'rising' + 'trgDirOut' flags (5 bits tot)
+      v := v + 1; -- src + 'rising' + 'trgDirOut' + 'dblBuf' flags (6 bits tot)
       v := v + ( x.lvl'length + 7) / 8;
       v := v + ( x.nprets'length + 7) / 8;
       v := v + ( x.nsamples'length + 7) / 8;
@@ -100,6 +110,8 @@ package body AcqCtlPkg is
       v := v + ( x.decm0'length  + x.decm1'length  + 7) / 8;
       v := v + ( x.shift0'length + x.shift1'length + x.scale'length + 7) / 8;
       v := v + ( x.hyst'length + 7) / 8;
+      v := v + ( x.nsegs'length + 7) / 8;
+      v := v + ( x.navg'length + 7) / 8;
       return v;
    end function acqCtlParmSizeBytes;
 
@@ -111,9 +123,12 @@ package body AcqCtlPkg is
    function toSlv(constant x : in AcqCtlParmType) return std_logic_vector is
       constant e : std_logic        := ite( x.rising    );
       constant d : std_logic        := ite( x.trgDirOut );
+      constant b : std_logic        := ite( x.dblBuf    );
       constant v : std_logic_vector :=
              (
-                std_logic_vector( x.hyst       )
+                std_logic_vector( x.navg       )
+              & std_logic_vector( x.nsegs      )
+              & std_logic_vector( x.hyst       )
               & std_logic_vector( x.shift0     )   --  5
               & std_logic_vector( x.shift1     )   --  7
               & "00" & std_logic_vector( x.scale ) -- 20
@@ -123,7 +138,7 @@ package body AcqCtlPkg is
               & std_logic_vector( x.nsamples   )
               & std_logic_vector( x.nprets     )
               & std_logic_vector( x.lvl        )
-              & "000" & d & e & std_logic_vector( to_unsigned( TriggerSrcType'pos( x.src ), 3 ) ) );
+              & "00" & b & d & e & std_logic_vector( to_unsigned( TriggerSrcType'pos( x.src ), 3 ) ) );
       variable r : std_logic_vector(v'high downto v'low);
    begin
       r := v;
@@ -170,6 +185,7 @@ package body AcqCtlPkg is
       end if;
       v.rising     := (x(3) = '1');
       v.trgDirOut  := (x(4) = '1');
+      v.dblBuf     := (x(5) = '1');
       l            := 8;
       lr( x, l, r, v.lvl        );
       lr( x, l, r, v.nprets     );
@@ -182,6 +198,8 @@ package body AcqCtlPkg is
       lr( x, l, r, v.shift1     );
       lr( x, l, r, v.shift0     );
       lr( x, l, r, v.hyst       );
+      lr( x, l, r, v.nsegs      );
+      lr( x, l, r, v.navg       );
       return v;
    end function toAcqCtlParmType;
 
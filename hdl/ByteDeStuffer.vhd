@@ -26,6 +26,7 @@
 
 library ieee;
 use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
 
 entity ByteDeStuffer is
    generic (
@@ -45,7 +46,9 @@ entity ByteDeStuffer is
       rdyOut  : in  std_logic;
       synOut  : out std_logic;
       -- sequence of empty frames ,, asserts rstOut
-      rstOut  : out std_logic
+      rstOut  : out std_logic;
+      -- select COBS framing; must only change between frames
+      cobs    : in  std_logic := '0'
    );
 end entity ByteDeStuffer;
 
@@ -55,6 +58,10 @@ architecture rtl of ByteDeStuffer is
    --   - message starts with comma -> , esc ,
    --   - message starts with ESC   -> , esc esc
 
+   -- COBS: 'cnt' counts the data octets remaining in the current
+   -- block; 'dlm' flags a comma implied at the end of the block
+   -- which is emitted once the next block starts.
+
    type StateType is (INIT, SYNC, RUN, ESC);
 
    type RegType is record
@@ -63,6 +70,8 @@ architecture rtl of ByteDeStuffer is
       vld     : std_logic;
       synced  : std_logic;
       lst     : std_logic;
+      cnt     : unsigned(COMMA_G'range);
+      dlm     : std_logic;
    end record RegType;
 
    constant REG_INIT_C : RegType := (
@@ -70,7 +79,9 @@ architecture rtl of ByteDeStuffer is
       dat     => (COMMA_G'high downto COMMA_G'low => 'X'),
       vld     => '0',
       synced  => '0',
-      lst     => '0'
+      lst     => '0',
+      cnt     => (others => '0'),
+      dlm     => '0'
    );
 
    signal r      : RegType := REG_INIT_C;
@@ -86,12 +97,13 @@ begin
    isCom <= (datInp = COMMA_G);
    isEsc <= (datInp = ESCAP_G);
 
-   P_CMB : process (r, datInp, vldInp, isCom, isEsc, rdyOut) is
+   P_CMB : process (r, datInp, vldInp, isCom, isEsc, rdyOut, cobs) is
       variable v    : RegType;
       variable rdyI : std_logic;
       variable vldO : std_logic;
       variable rstO : std_logic;
       variable lstO : std_logic;
+      variable code : unsigned(COMMA_G'range);
    begin
       v   := r;
 
@@ -100,6 +112,7 @@ begin
       vldO := r.vld and vldInp;
       rstO := '0';
       lstO := '0';
+      code := unsigned( datInp xor COMMA_G );
 
       case ( r.state ) is
          when INIT  =>
@@ -124,25 +137,57 @@ begin
          when RUN   =>
             -- can consume data if register is empty or output is ready
             rdyI := ( not r.vld ) or rdyOut;
-            if ( ( vldInp = '1' ) and isEsc ) then
-               -- must not let them consume the data in the
-               -- storage register
-               vldO := '0';
-            end if;
-            if ( ( vldInp and rdyI ) = '1' ) then
-               -- handle input data
-               if ( isCom ) then
-                  lstO  := '1';
-                  -- if the data register is empty this means
-                  -- there was an empty frame; assert reset
-                  rstO  := not r.vld;
-                  v.vld := '0';
-               elsif ( isEsc ) then
-                  v.state := ESC;
-               else
-                  -- consume and register new data
-                  v.dat   := datInp;
-                  v.vld   := '1';
+            if ( cobs = '1' ) then
+               if ( ( vldInp = '1' ) and not isCom and ( r.cnt = 0 ) and ( r.dlm = '0' ) ) then
+                  -- code octet w/o data; hold the storage register
+                  vldO := '0';
+               end if;
+               if ( ( vldInp and rdyI ) = '1' ) then
+                  if ( isCom ) then
+                     lstO  := '1';
+                     rstO  := not r.vld;
+                     v.vld := '0';
+                     v.cnt := (others => '0');
+                     v.dlm := '0';
+                  elsif ( r.cnt = 0 ) then
+                     if ( r.dlm = '1' ) then
+                        -- emit the implied comma
+                        v.dat := COMMA_G;
+                        v.vld := '1';
+                     end if;
+                     v.cnt := code - 1;
+                     if ( code = 2**COMMA_G'length - 1 ) then
+                        v.dlm := '0';
+                     else
+                        v.dlm := '1';
+                     end if;
+                  else
+                     v.dat := datInp;
+                     v.vld := '1';
+                     v.cnt := r.cnt - 1;
+                  end if;
+               end if;
+            else
+               if ( ( vldInp = '1' ) and isEsc ) then
+                  -- must not let them consume the data in the
+                  -- storage register
+                  vldO := '0';
+               end if;
+               if ( ( vldInp and rdyI ) = '1' ) then
+                  -- handle input data
+                  if ( isCom ) then
+                     lstO  := '1';
+                     -- if the data register is empty this means
+                     -- there was an empty frame; assert reset
+                     rstO  := not r.vld;
+                     v.vld := '0';
+                  elsif ( isEsc ) then
+                     v.state := ESC;
+                  else
+                     -- consume and register new data
+                     v.dat   := datInp;
+                     v.vld   := '1';
+                  end if;
                end if;
             end if;
 
@@ -26,6 +26,7 @@
 
 library ieee;
 use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
 
 entity ByteStuffer is
    generic (
@@ -42,7 +43,9 @@ entity ByteStuffer is
       lstInp  : in  std_logic;
       datOut  : out std_logic_vector(COMMA_G'range);
       vldOut  : out std_logic;
-      rdyOut  : in  std_logic
+      rdyOut  : in  std_logic;
+      -- select COBS framing; sampled at the start of each frame
+      cobs    : in  std_logic := '0'
    );
 end entity ByteStuffer;
 
@@ -52,23 +55,49 @@ architecture rtl of ByteStuffer is
    --   - message starts with comma -> , esc ,
    --   - message starts with ESC   -> , esc esc
 
-   type StateType is (FWD, STUFF, LST);
+   -- COBS (see sw/byteStuff.h): a frame is a sequence of blocks
+   --   code (n xor COMMA), n-1 data; a comma is implied after a
+   --   block with n < 255 unless it is the last one of the frame.
+   -- Data are buffered (CFILL) until a comma is found, the max.
+   -- run length is reached or the frame ends; the block is then
+   -- played back (CCODE, CDATA).
+
+   constant MAXRUN_C : natural := 254;
+
+   type StateType is (FWD, STUFF, LST, CFILL, CCODE, CDATA);
+
+   type BufType is array (0 to MAXRUN_C - 1) of std_logic_vector(COMMA_G'range);
 
    type RegType is record
       dat     : std_logic_vector(COMMA_G'range);
       lst     : std_logic;
       state   : StateType;
+      -- a frame is in progress
+      busy    : std_logic;
+      -- block is terminated by a comma/by the end of the frame
+      dlm     : std_logic;
+      lstB    : std_logic;
+      wp      : natural range 0 to MAXRUN_C;
+      rp      : natural range 0 to MAXRUN_C - 1;
    end record RegType;
 
    constant REG_INIT_C : RegType := (
       dat     => (COMMA_G'high downto COMMA_G'low   => 'X'),
       lst     => 'X',
-      state   => FWD
+      state   => FWD,
+      busy    => '0',
+      dlm     => '0',
+      lstB    => '0',
+      wp      => 0,
+      rp      => 0
    );
 
    signal r      : RegType := REG_INIT_C;
    signal rin    : RegType;
 
+   signal buf    : BufType;
+   signal bufWen : std_logic;
+
    signal isCom  : boolean;
    signal isEsc  : boolean;
 
@@ -79,11 +108,13 @@ begin
    isCom <= (datInp = COMMA_G);
    isEsc <= (datInp = ESCAP_G);
 
-   P_CMB : process (r, datInp, vldInp, isCom, isEsc, lstInp, rdyOut) is
+   P_CMB : process (r, datInp, vldInp, isCom, isEsc, lstInp, rdyOut, cobs, buf) is
       variable v   : RegType;
       variable d   : std_logic_vector(datInp'range);
       variable vld : std_logic;
       variable rdy : std_logic;
+      variable we  : std_logic;
+      variable eob : boolean;
    begin
       v   := r;
 
@@ -91,21 +122,30 @@ begin
       rdy := rdyOut;
       vld := vldInp;
       d   := datInp;
+      we  := '0';
+      eob := false;
 
       case ( r.state ) is
          when FWD   =>
-            if ( ( vldInp = '1' ) and ( isCom or isEsc ) ) then
-               d       := ESCAP_G;
-            end if;
-            if ( (vldInp and rdyOut) = '1' ) then
-               -- might have some work to do
-               if ( isCom or isEsc ) then
-                  -- hold data
-                  v.dat   := datInp;
-                  v.lst   := lstInp;
-                  v.state := STUFF;
-               elsif ( lstInp = '1' ) then
-                  v.state := LST;
+            if ( ( r.busy = '0' ) and ( cobs = '1' ) ) then
+               rdy     := '0';
+               vld     := '0';
+               v.state := CFILL;
+            else
+               if ( ( vldInp = '1' ) and ( isCom or isEsc ) ) then
+                  d       := ESCAP_G;
+               end if;
+               if ( (vldInp and rdyOut) = '1' ) then
+                  v.busy := not lstInp;
+                  -- might have some work to do
+                  if ( isCom or isEsc ) then
+                     -- hold data
+                     v.dat   := datInp;
+                     v.lst   := lstInp;
+                     v.state := STUFF;
+                  elsif ( lstInp = '1' ) then
+                     v.state := LST;
+                  end if;
                end if;
             end if;
 
@@ -128,15 +168,87 @@ begin
             if ( (vld and rdyOut) = '1' ) then
                v.state := FWD;
             end if;
-            
+
+         when CFILL =>
+            rdy := '1';
+            vld := '0';
+            if ( ( r.busy = '0' ) and ( cobs = '0' ) ) then
+               -- framing was switched back between frames
+               rdy     := '0';
+               v.state := FWD;
+            elsif ( vldInp = '1' ) then
+               v.busy  := not lstInp;
+               v.lstB  := lstInp;
+               if ( isCom ) then
+                  -- implied by the code
+                  v.dlm   := '1';
+                  v.state := CCODE;
+               else
+                  we      := '1';
+                  v.wp    := r.wp + 1;
+                  v.dlm   := '0';
+                  if ( ( lstInp = '1' ) or ( r.wp = MAXRUN_C - 1 ) ) then
+                     v.state := CCODE;
+                  end if;
+               end if;
+            end if;
+
+         when CCODE =>
+            rdy := '0';
+            vld := '1';
+            d   := std_logic_vector( to_unsigned( r.wp + 1, d'length ) ) xor COMMA_G;
+            if ( rdyOut = '1' ) then
+               v.rp := 0;
+               if ( r.wp = 0 ) then
+                  eob     := true;
+               else
+                  v.state := CDATA;
+               end if;
+            end if;
+
+         when CDATA =>
+            rdy := '0';
+            vld := '1';
+            d   := buf( r.rp );
+            if ( rdyOut = '1' ) then
+               if ( r.rp = r.wp - 1 ) then
+                  eob     := true;
+               else
+                  v.rp    := r.rp + 1;
+               end if;
+            end if;
+
       end case;
 
+      if ( eob ) then
+         v.wp := 0;
+         if ( r.lstB = '0' ) then
+            v.state := CFILL;
+         elsif ( r.dlm = '1' ) then
+            -- frame ends with a comma; append an empty block
+            v.dlm   := '0';
+            v.state := CCODE;
+         else
+            v.state := LST;
+         end if;
+      end if;
+
       rdyInp <= rdy;
       vldOut <= vld;
       datOut <= d;
+      bufWen <= we;
       rin    <= v;
    end process P_CMB;
 
+   P_BUF : process (clk) is
+   begin
+      if ( rising_edge( clk ) ) then
+         if ( bufWen = '1' ) then
+            buf( r.wp ) <= datInp;
+         end if;
+      end if;
+   end process P_BUF;
+
    P_SEQ : process (clk) is
    begin
       if ( rising_edge( clk ) ) then
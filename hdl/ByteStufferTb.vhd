@@ -108,6 +108,54 @@ architecture rtl of ByteStufferTb is
       62, 28, 231, 209, 190, 246, 143, 37, 53, 196, 252, 41, 165, 24, 98, 194
    );
 
+   -- COBS test frames; bit 8 flags the last octet of a frame
+   type   FrameArray is array (natural range <>) of natural range 0 to 511;
+
+   constant COM_C : natural := to_integer( unsigned( COMMA_C ) );
+   constant ESC_C : natural := to_integer( unsigned( ESCAP_C ) );
+   constant LST_C : natural := 256;
+
+   -- runs of exactly 254 and 255 octets w/o a comma, a maximal run
+   -- followed by a comma, a frame ending in a comma, back-to-back
+   -- commas, a frame of commas only and escapes (not special with COBS)
+   function cobsFramesF return FrameArray is
+      variable v : FrameArray(0 to 254 + 255 + 258 + 3 + 5 + 2 + 3 - 1);
+      variable i : natural;
+   begin
+      i := 0;
+      for k in 0 to 253 loop
+         v(i) := ( k mod 255 ) + 1; -- anything but COMMA_C
+         i    := i + 1;
+      end loop;
+      v(i - 1) := v(i - 1) + LST_C;
+      for k in 0 to 254 loop
+         v(i) := ( k mod 255 ) + 1;
+         i    := i + 1;
+      end loop;
+      v(i - 1) := v(i - 1) + LST_C;
+      for k in 0 to 253 loop
+         v(i) := ( k mod 255 ) + 1;
+         i    := i + 1;
+      end loop;
+      v(i to i + 3) := ( COM_C, 16#11#, 16#22#, 16#33# + LST_C );
+      i := i + 4;
+      v(i to i + 2) := ( 16#12#, 16#34#, COM_C + LST_C );
+      i := i + 3;
+      v(i to i + 4) := ( 16#56#, COM_C, COM_C, COM_C, 16#78# + LST_C );
+      i := i + 5;
+      v(i to i + 1) := ( COM_C, COM_C + LST_C );
+      i := i + 2;
+      v(i to i + 2) := ( ESC_C, COM_C, ESC_C + LST_C );
+      return v;
+   end function cobsFramesF;
+
+   constant COBS_VEC : FrameArray := cobsFramesF;
+
+   -- sent after an empty frame reverted the framing to stuffing
+   constant STUF_VEC : FrameArray := ( COM_C, ESC_C, 16#42#, COM_C + LST_C );
+
+   constant CHK_VEC  : FrameArray := COBS_VEC & STUF_VEC;
+
    signal clk : std_logic := '0';
    signal rst : std_logic := '0';
    signal run : boolean   := true;
@@ -148,6 +196,20 @@ architecture rtl of ByteStufferTb is
    signal rxSyncd: std_logic;
    signal rstTst : std_logic := '0';
 
+   -- framing mode; set by the test and cleared by an empty frame
+   -- (like CommandVersion)
+   signal cobs   : std_logic := '0';
+   signal cobsSet: std_logic := '0';
+   -- stuffing test done; index into CHK_VEC
+   signal stfDone: boolean   := false;
+   signal chkIdx : natural   := 0;
+
+   -- inject raw octets into the de-stuffer
+   signal inj    : std_logic := '0';
+   signal datDs  : std_logic_vector(7 downto 0);
+   signal vldDs  : std_logic;
+   signal rdyDs  : std_logic;
+
    function to_hstring(x : std_logic_vector) return string is
       constant hl : natural := ( x'length + 3 ) / 4;
       variable lx : std_logic_vector(x'left + 3 downto x'right);
@@ -280,16 +342,80 @@ report "sending " & integer'image(testVec(i)) & " l " & integer'image(l) & " lst
       report integer'image(xmit.nTxOcts) & " octets sent #######################";
 
       W_DONE : for i in 1 to 1000 loop
+         exit W_DONE when stfDone;
          wait until rising_edge( clk );
       end loop W_DONE;
 
-      -- never get here if RX process stops the test
+      assert stfDone report "Test FAILED -- won't finish" severity failure;
+
+      -- switch to COBS between frames
+      cobsSet <= '1';
+      wait until rising_edge( clk );
+      cobsSet <= '0';
 
-      report "Test FAILED -- won't finish" severity failure;
+      for i in COBS_VEC'range loop
+         v := std_logic_vector( to_unsigned( COBS_VEC(i) mod LST_C, v'length ) );
+         if ( COBS_VEC(i) >= LST_C ) then
+            lst := '1';
+         else
+            lst := '0';
+         end if;
+         sendCmd(xmit, v, lst, i mod 3);
+      end loop;
+
+      W_COBS : for i in 1 to 1000 loop
+         exit W_COBS when chkIdx = COBS_VEC'length;
+         wait until rising_edge( clk );
+      end loop W_COBS;
+
+      assert chkIdx = COBS_VEC'length report "Test FAILED -- COBS frames not received" severity failure;
+
+      -- an empty frame (comma following the end of the previous frame)
+      -- reverts to stuffing; the stuffer is idle (waiting for data)
+      inj <= '1';
+      wait until rising_edge( clk );
+      while ( rdyDs = '0' ) loop
+         wait until rising_edge( clk );
+      end loop;
+      inj <= '0';
+      wait until rising_edge( clk );
+
+      assert cobs = '0' report "Test FAILED -- empty frame did not revert to stuffing" severity failure;
+
+      for i in STUF_VEC'range loop
+         v := std_logic_vector( to_unsigned( STUF_VEC(i) mod LST_C, v'length ) );
+         if ( STUF_VEC(i) >= LST_C ) then
+            lst := '1';
+         else
+            lst := '0';
+         end if;
+         sendCmd(xmit, v, lst);
+      end loop;
+
+      W_STUF : for i in 1 to 1000 loop
+         exit W_STUF when chkIdx = CHK_VEC'length;
+         wait until rising_edge( clk );
+      end loop W_STUF;
+
+      assert chkIdx = CHK_VEC'length report "Test FAILED -- won't finish" severity failure;
+
+      report "TEST PASSED";
+      run <= false;
 
       wait;
    end process P_TST;
 
+   P_COBS : process ( clk ) is
+   begin
+      if ( rising_edge( clk ) ) then
+         if ( rstTst = '1' ) then
+            cobs <= '0';
+         elsif ( cobsSet = '1' ) then
+            cobs <= '1';
+         end if;
+      end if;
+   end process P_COBS;
+
    P_REP : process ( clk ) is
    begin
       if ( rising_edge( clk ) ) then
@@ -314,7 +440,8 @@ report "sending " & integer'image(testVec(i)) & " l " & integer'image(l) & " lst
          lstInp => xmit.s,
          datOut => datOut,
          vldOut => vldOut,
-         rdyOut => rdyOut
+         rdyOut => rdyOut,
+         cobs   => cobs
       );
 
 G_NO_DESTUFF: if ( not GEN_DESTUFF_C ) generate
@@ -329,20 +456,20 @@ G_DESTUFF: if ( GEN_DESTUFF_C ) generate
    P_REPX : process ( clk ) is
    begin
       if ( rising_edge( clk ) ) then
-         if ( nRxOcts = EXPECTED_OCTS_C ) then
+         if ( ( nRxOcts = EXPECTED_OCTS_C ) and not stfDone ) then
             if ( nRxOcts /= xmit.nTxOcts ) then
                report "Test FAILED: Mismatching TX (" & integer'image(xmit.nTxOcts) & ") and RX octets" severity failure;
             end if;
             if ( nRxFram /= xmit.nTxFram ) then
                report "Test FAILED: Mismatching TX and RX frames" severity failure;
             end if;
-            report "TEST PASSED";
-            run <= false;
+            report "Stuffing test passed";
+            stfDone <= true;
          end if;
          if ( ( vldOutX and rdyOutX) = '1' ) then
             nRxOcts <= nRxOcts + 1;
             if ( lstOutX = '1' ) then
-               if ( datOutX = x"FF" ) then
+               if ( ( datOutX = x"FF" ) and not stfDone ) then
                   tst  <= 0;
                   flen <= 0;
                end if;
@@ -366,6 +493,17 @@ G_DESTUFF: if ( GEN_DESTUFF_C ) generate
                   severity failure;
                tst <= tst + 1;
             end if;
+
+            if ( stfDone ) then
+               assert chkIdx < CHK_VEC'length
+                  report "Test FAILED: unexpected octet"
+                  severity failure;
+               assert    ( to_integer( unsigned( datOutX ) ) = ( CHK_VEC(chkIdx) mod LST_C ) )
+                     and ( ( lstOutX = '1' ) = ( CHK_VEC(chkIdx) >= LST_C ) )
+                  report "Test FAILED: Data mismatch; expected [" & integer'image(chkIdx) & "] " & integer'image(CHK_VEC(chkIdx)) & " got " & integer'image(to_integer(unsigned(datOutX))) & " L " & std_logic'image(lstOutX)
+                  severity failure;
+               chkIdx <= chkIdx + 1;
+            end if;
             dly     <= to_integer(unsigned(datOutX(1 downto 0)));
          end if;
          if ( dly /= 0 ) then
@@ -383,6 +521,11 @@ G_DESTUFF: if ( GEN_DESTUFF_C ) generate
       end if;
    end process P_RDYOUT;
 
+   -- the stuffer is held off while a comma is injected
+   datDs  <= COMMA_C when inj = '1' else datOut;
+   vldDs  <= inj or vldOut;
+   rdyOut <= rdyDs and not inj;
+
    U_DUT1 : entity work.ByteDeStuffer
       generic map (
          COMMA_G => COMMA_C,
@@ -392,21 +535,22 @@ G_DESTUFF: if ( GEN_DESTUFF_C ) generate
          clk    => clk,
          rst    => rst,
 
-         datInp => datOut,
-         vldInp => vldOut,
-         rdyInp => rdyOut,
+         datInp => datDs,
+         vldInp => vldDs,
+         rdyInp => rdyDs,
          lstOut => lstOutX,
          datOut => datOutX,
          vldOut => vldOutX,
          rdyOut => rdyOutX,
          synOut => rxSyncd,
-         rstOut => rstTst
+         rstOut => rstTst,
+         cobs   => cobs
       );
 
    P_CHECK_RST : process ( clk ) is
    begin
       if ( rising_edge( clk ) ) then
-         assert (rstTst = '0') report "Test FAILED -- spurious reset" severity error;
+         assert (rstTst = '0') or (inj = '1') report "Test FAILED -- spurious reset" severity error;
       end if;
    end process P_CHECK_RST;
 
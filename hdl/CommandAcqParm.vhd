@@ -36,7 +36,13 @@ use work.AcqCtlPkg.all;
 entity CommandAcqParm is
    generic (
       CLOCK_FREQ_G : real;
-      MEM_DEPTH_G  : natural
+      MEM_DEPTH_G  : natural;
+      -- sample buffer supports ping-pong mode
+      DBL_BUF_G    : boolean := true;
+      -- depth of the averaging memory (0: averaging not supported)
+      AVG_DEPTH_G  : natural := 0;
+      -- max. number of acquisitions that can be averaged
+      AVG_MAX_G    : natural := 1
    );
    port (
       clk          : in  std_logic;
@@ -68,6 +74,9 @@ architecture rtl of CommandAcqParm is
    constant M_SET_SCL_BIT_C : natural  := 6;
    constant M_SET_NSM_BIT_C : natural  := 7;
    constant M_SET_TGO_BIT_C : natural  := 8;
+   constant M_SET_SEG_BIT_C : natural  := 9;
+   constant M_SET_DBL_BIT_C : natural  := 10;
+   constant M_SET_AVG_BIT_C : natural  := 11;
 
    constant CMD_LEN_C       : natural := acqCtlParmSizeBytes;
 
@@ -167,6 +176,15 @@ begin
                if ( r.mask( M_SET_NSM_BIT_C ) = '0' ) then
                   v.p.nsamples   := r.p.nsamples;
                end if;
+               if ( r.mask( M_SET_SEG_BIT_C ) = '0' ) then
+                  v.p.nsegs      := r.p.nsegs;
+               end if;
+               if ( r.mask( M_SET_DBL_BIT_C ) = '0' ) then
+                  v.p.dblBuf     := r.p.dblBuf;
+               end if;
+               if ( r.mask( M_SET_AVG_BIT_C ) = '0' ) then
+                  v.p.navg       := r.p.navg;
+               end if;
                if ( r.mask( M_SET_AUT_BIT_C ) = '0' ) then
                   v.p.autoTimeMs := r.p.autoTimeMs;
                end if;
@@ -201,12 +219,36 @@ begin
             if ( r.p.decm0 = 0 ) then
                v.p.decm1      := (others => '0');
             end if;
+            if ( not DBL_BUF_G ) then
+               v.p.dblBuf   := false;
+            end if;
             if ( r.p.nsamples >= MEM_DEPTH_G ) then
                v.p.nsamples := to_unsigned( MEM_DEPTH_G - 1, v.p.nsamples'length );
             end if;
+            if ( v.p.dblBuf and ( r.p.nsamples >= MEM_DEPTH_G/2 ) ) then
+               -- each half holds an acquisition
+               v.p.nsamples := to_unsigned( MEM_DEPTH_G/2 - 1, v.p.nsamples'length );
+            end if;
+            if ( ( AVG_DEPTH_G = 0 ) or ( AVG_MAX_G < 2 ) ) then
+               v.p.navg     := (others => '0');
+            elsif ( r.p.navg >= AVG_MAX_G ) then
+               v.p.navg     := to_unsigned( AVG_MAX_G - 1, v.p.navg'length );
+            end if;
+            if ( v.p.navg /= 0 ) then
+               -- the averaged record must fit the accumulator memory
+               if ( v.p.nsamples >= AVG_DEPTH_G ) then
+                  v.p.nsamples := to_unsigned( AVG_DEPTH_G - 1, v.p.nsamples'length );
+               end if;
+               -- averaging and segmented mode are mutually exclusive
+               v.p.nsegs    := (others => '0');
+            end if;
             if ( r.p.nprets > v.p.nsamples ) then
                v.p.nprets   := v.p.nsamples;
             end if;
+            if ( v.p.nsegs /= 0 ) then
+               -- segments are recorded from the trigger on
+               v.p.nprets   := (others => '0');
+            end if;
             if ( r.p.src = EXT ) then
                v.p.trgDirOut := false;
             end if;
@@ -252,6 +294,9 @@ begin
             report "CIC0 S: " & integer'image( to_integer( r.p.shift0 ) );
             report "CIC1 S: " & integer'image( to_integer( r.p.shift1 ) );
             report "Scale : " & integer'image( to_integer( r.p.scale ) );
+            report "NSEGS : " & integer'image( to_integer( r.p.nsegs ) );
+            report "DBLBUF: " & boolean'image( r.p.dblBuf );
+            report "NAVG  : " & integer'image( to_integer( r.p.navg ) );
          end if;
       end if;
    end process P_DBG;
@@ -0,0 +1,418 @@
+--LB-MIT
+--
+-- MIT License
+--
+-- Copyright (c) 2026 Till Straumann
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the "Software"), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+-- copies of the Software, and to permit persons to whom the Software is
+-- furnished to do so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+-- IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+-- FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+-- AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+-- LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+-- OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+-- SOFTWARE.
+--
+--LE-MIT
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.math_real.all;
+
+use work.BasicPkg.all;
+use work.CommandMuxPkg.all;
+use work.SimpleI2cMasterPkg.all;
+
+-- transaction-level i2c master
+--
+--  REQUEST:
+--    command byte followed by the (left-shifted) slave address, a 16-bit
+--    (little-endian) read count and zero or more bytes to write.
+--
+--       cmd, sla, nrdLo, nrdHi, w0, ..., wn
+--
+--    The controller issues a START, writes 'sla' (the R/W bit is ignored)
+--    and the write bytes. If the read count is nonzero it then issues a
+--    (repeated) START, writes 'sla | 1' and reads 'nrd' bytes (ACKing all but
+--    the last one). If there are no write bytes then the read is started
+--    right away. The transaction is terminated by a STOP.
+--
+--  REPLY:
+--    command byte (echo) followed by 'nrd' data bytes and a 16-bit (little-
+--    endian) status.
+--
+--       cmd, d0, ..., dnrd-1, staLo, staHi
+--
+--    bits 14..0 of the status hold the number of bytes (including the
+--    address bytes) which were ACKed by the slave. Bit 15 is set if the
+--    transaction was aborted due to a NAK (or a malformed request); the
+--    data bytes are then padded with 0xFF.
+--    A frame consisting of the command byte only produces (aborted) status
+--    without any bus activity; this may be used to probe for the command.
+
+entity CommandI2c is
+   generic (
+      CLOCK_FREQ_G : real;
+      I2C_FREQ_G   : real := 100.0E3
+   );
+   port (
+      clk          : in  std_logic;
+      rst          : in  std_logic;
+
+      mIb          : in  SimpleBusMstType;
+      rIb          : out std_logic;
+
+      mOb          : out SimpleBusMstType;
+      rOb          : in  std_logic;
+
+      sclInp       : in  std_logic;
+      sclOut       : out std_logic;
+      sdaInp       : in  std_logic;
+      sdaOut       : out std_logic
+   );
+end entity CommandI2c;
+
+architecture rtl of CommandI2c is
+
+   type StateType is (IDLE, ADR, NRDL, NRDH, WADR, WDAT, DRAIN, ECHO, RADR, RDAT, STO, FILL, STAL, STAH);
+
+   type RegType is record
+      state        : StateType;
+      cmd          : std_logic_vector(7 downto 0);
+      sla          : std_logic_vector(7 downto 1);
+      cnt          : unsigned(15 downto 0);
+      acks         : unsigned(14 downto 0);
+      nak          : std_logic;
+      own          : std_logic; -- START was issued
+      lstSeen      : std_logic;
+      pend         : std_logic;
+      rdat         : std_logic_vector(7 downto 0);
+      rvld         : std_logic;
+      req          : I2cReqType;
+   end record RegType;
+
+   constant REG_INIT_C : RegType := (
+      state        => IDLE,
+      cmd          => (others => '0'),
+      sla          => (others => '0'),
+      cnt          => (others => '0'),
+      acks         => (others => '0'),
+      nak          => '0',
+      own          => '0',
+      lstSeen      => '0',
+      pend         => '0',
+      rdat         => (others => '1'),
+      rvld         => '0',
+      req          => I2C_REQ_INIT_C
+   );
+
+   signal r        : RegType := REG_INIT_C;
+   signal rin      : RegType;
+
+   signal i2cRdy   : std_logic;
+   signal i2cDon   : std_logic;
+   signal i2cDat   : std_logic_vector(8 downto 0);
+
+   signal sclSync  : std_logic;
+   signal sdaSync  : std_logic;
+
+begin
+
+   P_COMB : process ( r, mIb, rOb, i2cRdy, i2cDon, i2cDat ) is
+      variable v : RegType;
+
+      procedure issue(
+         constant start : in std_logic;
+         constant cmd   : in std_logic_vector(1 downto 0);
+         constant stop  : in std_logic;
+         constant wdat  : in std_logic_vector(7 downto 0)
+      ) is
+      begin
+         v.req.start := start;
+         v.req.cmd   := cmd;
+         v.req.stop  := stop;
+         v.req.wdat  := wdat;
+         v.req.vld   := '1';
+         v.pend      := '1';
+         if ( start = '1' ) then
+            v.own    := '1';
+         end if;
+      end procedure issue;
+
+      -- state following the echo
+      procedure nextRead is
+      begin
+         if    ( r.nak = '1' ) then
+            if ( r.own = '1' ) then
+               v.state := STO;
+            elsif ( r.cnt /= 0 ) then
+               v.state := FILL;
+            else
+               v.state := STAL;
+            end if;
+         elsif ( r.cnt = 0 ) then
+            v.state := STO;
+         elsif ( r.lstSeen = '1' and r.acks = 1 ) then
+            -- no write data; the address was already sent with the R bit set
+            v.state := RDAT;
+         else
+            v.state := RADR;
+         end if;
+      end procedure nextRead;
+
+   begin
+      v          := r;
+      mOb        <= SIMPLE_BUS_MST_INIT_C;
+      mOb.dat    <= r.cmd;
+      rIb        <= '0';
+
+      -- the controller latches a request in the cycle 'vld' and 'rdy' are asserted
+      if ( (r.req.vld and i2cRdy) = '1' ) then
+         v.req.vld := '0';
+      end if;
+
+      case ( r.state ) is
+         when IDLE  =>
+            rIb       <= '1';
+            v.cnt     := (others => '0');
+            v.acks    := (others => '0');
+            v.nak     := '0';
+            v.own     := '0';
+            v.lstSeen := '0';
+            if ( mIb.vld = '1' ) then
+               v.cmd   := mIb.dat;
+               v.state := ADR;
+               if ( mIb.lst = '1' ) then
+                  v.nak   := '1';
+                  v.state := ECHO;
+               end if;
+            end if;
+
+         when ADR   =>
+            rIb <= '1';
+            if ( mIb.vld = '1' ) then
+               v.sla   := mIb.dat(7 downto 1);
+               v.state := NRDL;
+               if ( mIb.lst = '1' ) then
+                  v.nak   := '1';
+                  v.state := ECHO;
+               end if;
+            end if;
+
+         when NRDL  =>
+            rIb <= '1';
+            if ( mIb.vld = '1' ) then
+               v.cnt(7 downto 0) := unsigned( mIb.dat );
+               v.state           := NRDH;
+               if ( mIb.lst = '1' ) then
+                  v.cnt   := (others => '0');
+                  v.nak   := '1';
+                  v.state := ECHO;
+               end if;
+            end if;
+
+         when NRDH  =>
+            rIb <= '1';
+            if ( mIb.vld = '1' ) then
+               v.cnt(15 downto 8) := unsigned( mIb.dat );
+               v.lstSeen          := mIb.lst;
+               v.state            := WADR;
+            end if;
+
+         when WADR  =>
+            if ( r.pend = '0' ) then
+               if ( r.lstSeen = '1' and r.cnt /= 0 ) then
+                  issue( '1', I2C_CMD_WRITE, '0', r.sla & '1' );
+               else
+                  issue( '1', I2C_CMD_WRITE, '0', r.sla & '0' );
+               end if;
+            elsif ( i2cDon = '1' ) then
+               v.pend := '0';
+               if ( i2cDat(0) = '0' ) then
+                  v.acks := r.acks + 1;
+                  if ( r.lstSeen = '1' ) then
+                     v.state := ECHO;
+                  else
+                     v.state := WDAT;
+                  end if;
+               else
+                  v.nak := '1';
+                  if ( r.lstSeen = '1' ) then
+                     v.state := ECHO;
+                  else
+                     v.state := DRAIN;
+                  end if;
+               end if;
+            end if;
+
+         when WDAT  =>
+            if ( r.pend = '0' ) then
+               rIb <= '1';
+               if ( mIb.vld = '1' ) then
+                  issue( '0', I2C_CMD_WRITE, '0', mIb.dat );
+                  v.lstSeen := mIb.lst;
+               end if;
+            elsif ( i2cDon = '1' ) then
+               v.pend := '0';
+               if ( i2cDat(0) = '0' ) then
+                  v.acks := r.acks + 1;
+                  if ( r.lstSeen = '1' ) then
+                     v.state := ECHO;
+                  end if;
+               else
+                  v.nak := '1';
+                  if ( r.lstSeen = '1' ) then
+                     v.state := ECHO;
+                  else
+                     v.state := DRAIN;
+                  end if;
+               end if;
+            end if;
+
+         when DRAIN =>
+            rIb <= '1';
+            if ( (mIb.vld and mIb.lst) = '1' ) then
+               v.lstSeen := '1';
+               v.state   := ECHO;
+            end if;
+
+         when ECHO  =>
+            mOb.vld <= '1';
+            if ( rOb = '1' ) then
+               nextRead;
+            end if;
+
+         when RADR  =>
+            if ( r.pend = '0' ) then
+               issue( '1', I2C_CMD_WRITE, '0', r.sla & '1' );
+            elsif ( i2cDon = '1' ) then
+               v.pend := '0';
+               if ( i2cDat(0) = '0' ) then
+                  v.acks  := r.acks + 1;
+                  v.state := RDAT;
+               else
+                  v.nak   := '1';
+                  v.state := STO;
+               end if;
+            end if;
+
+         when RDAT  =>
+            mOb.dat <= r.rdat;
+            mOb.vld <= r.rvld;
+            if ( r.rvld = '1' ) then
+               if ( rOb = '1' ) then
+                  v.rvld := '0';
+                  v.cnt  := r.cnt - 1;
+                  if ( r.cnt = 1 ) then
+                     v.state := STO;
+                  end if;
+               end if;
+            elsif ( r.pend = '0' ) then
+               if ( r.cnt = 1 ) then
+                  issue( '0', I2C_CMD_RNAK, '0', x"FF" );
+               else
+                  issue( '0', I2C_CMD_READ, '0', x"FF" );
+               end if;
+            elsif ( i2cDon = '1' ) then
+               v.pend := '0';
+               v.rdat := i2cDat(8 downto 1);
+               v.rvld := '1';
+            end if;
+
+         when STO   =>
+            if ( r.pend = '0' ) then
+               issue( '0', I2C_CMD_NONE, '1', x"FF" );
+            elsif ( i2cDon = '1' ) then
+               v.pend := '0';
+               v.own  := '0';
+               if ( r.cnt /= 0 ) then
+                  v.state := FILL;
+               else
+                  v.state := STAL;
+               end if;
+            end if;
+
+         when FILL  =>
+            mOb.dat <= (others => '1');
+            mOb.vld <= '1';
+            if ( rOb = '1' ) then
+               v.cnt := r.cnt - 1;
+               if ( r.cnt = 1 ) then
+                  v.state := STAL;
+               end if;
+            end if;
+
+         when STAL  =>
+            mOb.dat <= std_logic_vector( r.acks(7 downto 0) );
+            mOb.vld <= '1';
+            if ( rOb = '1' ) then
+               v.state := STAH;
+            end if;
+
+         when STAH  =>
+            mOb.dat <= r.nak & std_logic_vector( r.acks(14 downto 8) );
+            mOb.vld <= '1';
+            mOb.lst <= '1';
+            if ( rOb = '1' ) then
+               v.state := IDLE;
+            end if;
+      end case;
+
+      rin <= v;
+   end process P_COMB;
+
+   P_SEQ : process ( clk ) is
+   begin
+      if ( rising_edge( clk ) ) then
+         if ( rst = '1' ) then
+            r <= REG_INIT_C;
+         else
+            r <= rin;
+         end if;
+      end if;
+   end process P_SEQ;
+
+   U_SYNC : entity work.SynchronizerBit
+      generic map (
+         WIDTH_G     => 2,
+         RSTPOL_G    => '1'
+      )
+      port map (
+         clk         => clk,
+         rst         => rst,
+         datInp(0)   => sclInp,
+         datInp(1)   => sdaInp,
+         datOut(0)   => sclSync,
+         datOut(1)   => sdaSync
+      );
+
+   U_I2C : entity work.SimpleI2cMaster
+      generic map (
+         BUS_FREQ_HZ_G => CLOCK_FREQ_G,
+         I2C_FREQ_HZ_G => I2C_FREQ_G
+      )
+      port map (
+         clk           => clk,
+         rst           => rst,
+         req           => r.req,
+         rdy           => i2cRdy,
+         rdat          => i2cDat,
+         don           => i2cDon,
+
+         sclInp        => sclSync,
+         sclOut        => sclOut,
+         sdaInp        => sdaSync,
+         sdaOut        => sdaOut
+      );
+
+end architecture rtl;
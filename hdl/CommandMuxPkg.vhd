@@ -109,6 +109,7 @@ package CommandMuxPkg is
 
    constant CMD_REG_RD8_C     : SubCommandRegType := SubCommandRegType( to_unsigned( 0, SubCommandRegType'length ) );
    constant CMD_REG_WR8_C     : SubCommandRegType := SubCommandRegType( to_unsigned( 1, SubCommandRegType'length ) );
+   constant CMD_REG_VEC_C     : SubCommandRegType := SubCommandRegType( to_unsigned( 2, SubCommandRegType'length ) );
 
    function subCommandRegGet(constant cmd : std_logic_vector(7 downto 0))
       return SubCommandRegType;
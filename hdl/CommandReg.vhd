@@ -64,6 +64,24 @@ use work.CommandMuxPkg.all;
 --    nonzero status indicates a write error flagged by the application or
 --    an invalid command (e.g., missing address).
 --
+--  VECTOR (SCATTER/GATHER) REQUEST:
+--    command byte followed by one or more tuples. A tuple consists of a control
+--    byte, an address byte and - for a write - count + 1 data bytes. The control
+--    byte holds the direction in bit 7 ('1' for write) and the count (actual count
+--    minus one) in bits 6..0.
+--
+--       cmd, ctl0, addr0, [d0, ..., dn], ctl1, addr1, [d0, ..., dm], ...
+--
+--  VECTOR REPLY:
+--    command byte (echo) followed by the data of all read tuples (in request order)
+--    and a terminating status byte.
+--
+--       cmd, d0, ..., status
+--
+--    Processing stops at the first error; the remainder of the request is discarded
+--    and a nonzero status is returned (a failing read also produces an all-ones data
+--    byte). An incomplete tuple is an error, too.
+--
 --  APPLICATION DATA PORT:
 --
 --    addr, rdnw ('1' for read, '0' for write) and wdat (if rdnw='0') qualified by 'vld=1'
@@ -102,7 +120,7 @@ end entity CommandReg;
 
 architecture rtl of CommandReg is
 
-   type StateType is (IDLE, A8, L8, RD8, WR8, STA, DRAIN, REPLY);
+   type StateType is (IDLE, A8, L8, RD8, WR8, STA, DRAIN, REPLY, VCTL, VADR, VWR, VDRN);
 
    type RegType is record
       state        : StateType;
@@ -112,6 +130,9 @@ architecture rtl of CommandReg is
       rdat         : std_logic_vector(7 downto 0);
       rvld         : std_logic;
       err          : std_logic;
+      vec          : std_logic;
+      wr           : std_logic;
+      lst          : std_logic;
    end record RegType;
 
    constant REG_INIT_C : RegType := (
@@ -121,7 +142,10 @@ architecture rtl of CommandReg is
       cmd          => (others => '0'),
       rdat         => (others => '0'),
       rvld         => '0',
-      err          => '0'
+      err          => '0',
+      vec          => '0',
+      wr           => '0',
+      lst          => '0'
    );
 
    signal r        : RegType := REG_INIT_C;
@@ -194,13 +218,20 @@ begin
             v.err   := '1';
             if ( mIbLoc.vld = '1' ) then
                v.cmd := mIbLoc.dat;
+               v.vec := '0';
                if (   subCommandRegGet( mIbLoc.dat ) = CMD_REG_RD8_C
                    or subCommandRegGet( mIbLoc.dat ) = CMD_REG_WR8_C ) then
                      v.state := A8;
+               elsif ( subCommandRegGet( mIbLoc.dat ) = CMD_REG_VEC_C ) then
+                     -- echo the command; tuples are processed after that
+                     v.vec   := '1';
+                     v.err   := '0';
+                     v.state := REPLY;
                else
                      v.state := DRAIN;
                end if;
                if ( mIbLoc.lst = '1' ) then
+                  v.err   := '1';
                   v.state := REPLY;
                end if;
             end if;
@@ -250,7 +281,8 @@ begin
             mObLoc.dat <= r.rdat; -- needs rework if DATA_W_G /= 8
             mObLoc.vld <= r.rvld;
             -- if an error occurred then this is also the last/status cycle
-            mObLoc.lst <= r.err;
+            -- (unless there is a vector request to be drained)
+            mObLoc.lst <= r.err and not r.vec;
             if ( ( not r.rvld and rdy ) = '1' ) then
                -- read cycle
                v.rvld := '1';
@@ -267,9 +299,17 @@ begin
                v.count := r.count - 1;
                v.rvld  := '0';
                if ( r.err = '1' ) then
-                  v.state := IDLE;
+                  if ( r.vec = '1' ) then
+                     v.state := VDRN;
+                  else
+                     v.state := IDLE;
+                  end if;
                elsif ( v.count(v.count'left) = '1' ) then
-                  v.state := STA;
+                  if ( (r.vec and not r.lst) = '1' ) then
+                     v.state := VCTL;
+                  else
+                     v.state := STA;
+                  end if;
                end if;
             end if;
 
@@ -294,10 +334,72 @@ begin
                if ( r.count(r.count'left) = '0' ) then
                   -- successfully latched a count; this must be a read op
                   v.state := RD8;
+               elsif ( (r.vec and not r.err) = '1' ) then
+                  v.state := VCTL;
+               else
+                  v.state := STA;
+               end if;
+            end if;
+
+         when VCTL  =>
+            rIbLoc <= '1';
+            if ( mIbLoc.vld = '1' ) then
+               v.count := resize( unsigned( mIbLoc.dat(6 downto 0) ), v.count'length );
+               v.wr    := mIbLoc.dat(7);
+               v.state := VADR;
+               if ( mIbLoc.lst = '1' ) then
+                  -- incomplete tuple
+                  v.err   := '1';
+                  v.state := STA;
+               end if;
+            end if;
+
+         when VADR  =>
+            rIbLoc <= '1';
+            if ( mIbLoc.vld = '1' ) then
+               v.addr := resize( unsigned( mIbLoc.dat ), v.addr'length );
+               v.lst  := mIbLoc.lst;
+               if ( r.wr = '0' ) then
+                  v.state := RD8;
+               elsif ( mIbLoc.lst = '1' ) then
+                  -- write without data
+                  v.err   := '1';
+                  v.state := STA;
                else
+                  v.state := VWR;
+               end if;
+            end if;
+
+         when VWR   =>
+            rdnw    <= '0';
+            rIbLoc  <= rdy;
+            vld     <= mIbLoc.vld;
+            if ( (mIbLoc.vld and rdy ) = '1' ) then
+               v.addr  := r.addr  + 1;
+               v.count := r.count - 1;
+               v.err   := err;
+               v.lst   := mIbLoc.lst;
+               if    ( err = '1' ) then
+                  v.state := VDRN;
+               elsif ( v.count(v.count'left) = '1' ) then
+                  if ( mIbLoc.lst = '1' ) then
+                     v.state := STA;
+                  else
+                     v.state := VCTL;
+                  end if;
+               elsif ( mIbLoc.lst = '1' ) then
+                  -- incomplete tuple
+                  v.err   := '1';
                   v.state := STA;
                end if;
             end if;
+
+         when VDRN  =>
+            -- discard the remainder of a failed vector request
+            rIbLoc <= not r.lst;
+            if ( (r.lst or (mIbLoc.vld and mIbLoc.lst)) = '1' ) then
+               v.state := STA;
+            end if;
       end case;
 
       rin        <= v;
@@ -47,7 +47,13 @@ entity CommandVersion is
       rIb          : out std_logic;
 
       mOb          : out SimpleBusMstType;
-      rOb          : in  std_logic
+      rOb          : in  std_logic;
+
+      -- framing mode (COBS) requested by the host; takes effect
+      -- once the reply has been sent; cleared by 'abrt' (empty frame
+      -- seen by the de-stuffer).
+      cobs         : out std_logic;
+      abrt         : in  std_logic := '0'
    );
 end entity CommandVersion;
 
@@ -62,26 +68,40 @@ architecture rtl of CommandVersion is
       5 => GIT_VERSION_G( 7 downto  0)
    );
 
+   -- An optional parameter octet selects the framing (bit 0: COBS);
+   -- if present then a capability octet is appended to the reply.
+   -- Note that the stuffer samples the mode at the start of a frame;
+   -- this reply is longer than the pipeline to the stuffer and thus
+   -- is sent with the old framing.
+   constant PARM_COBS_C : natural := 0;
+   constant CAP_C       : std_logic_vector(7 downto 0) := x"01";
+
    type StateType is (ECHO, DRAIN, PLAY);
 
    type RegType is record
       state         : StateType;
-      addr          : integer range VERSION_C'low to VERSION_C'high;
+      addr          : integer range VERSION_C'low to VERSION_C'high + 1;
+      parm          : std_logic;
+      req           : std_logic;
+      cobs          : std_logic;
    end record RegType;
 
    constant REG_INIT_C : RegType := (
       state         => ECHO,
-      addr          => VERSION_C'low
+      addr          => VERSION_C'low,
+      parm          => '0',
+      req           => '0',
+      cobs          => '0'
    );
 
    signal r               : RegType := REG_INIT_C;
    signal rin             : RegType;
 
-   signal version         : Slv8Array(VERSION_C'range);
+   signal version         : Slv8Array(VERSION_C'low to VERSION_C'high + 1);
 
 begin
 
-   P_COMB : process ( r, mIb, rOb, hwVersion, version ) is
+   P_COMB : process ( r, mIb, rOb, hwVersion, version, abrt ) is
       variable v       : RegType;
    begin
       v := r;
@@ -89,13 +109,14 @@ begin
       mOb        <= mIb;
       rIb        <= rOb;
 
-      version    <= VERSION_C;
+      version    <= VERSION_C & CAP_C;
       version(0) <= hwVersion;
 
       case ( r.state ) is
          when ECHO =>
             mOb.lst <= '0';
             v.addr  := VERSION_C'low;
+            v.parm  := '0';
             if ( (rOb and mIb.vld) = '1' ) then
                if ( mIb.lst /= '1' ) then
                   v.state := DRAIN;
@@ -107,6 +128,10 @@ begin
          when DRAIN =>
             mOb.vld <= '0';
             rIb     <= '1';
+            if ( ( mIb.vld = '1' ) and ( r.parm = '0' ) ) then
+               v.parm    := '1';
+               v.req     := mIb.dat(PARM_COBS_C);
+            end if;
             if ( (mIb.vld and mIb.lst) = '1' ) then
                v.state   := PLAY;
             end if;
@@ -117,18 +142,27 @@ begin
             mOb.lst <= '0';
             mOb.dat <= version(r.addr);
             if ( rOb = '1' ) then
-               if ( r.addr = VERSION_C'high ) then
+               if ( r.addr = VERSION_C'high + 1 or ( r.addr = VERSION_C'high and r.parm = '0' ) ) then
                   v.state := ECHO;
                   mOb.lst <= '1';
+                  if ( r.parm = '1' ) then
+                     v.cobs := r.req;
+                  end if;
                else
                   v.addr  := r.addr + 1;
                end if;
             end if;
       end case;
 
+      if ( abrt = '1' ) then
+         v.cobs := '0';
+      end if;
+
       rin     <= v;
    end process P_COMB;
 
+   cobs <= r.cobs;
+
    P_SEQ : process ( clk ) is
    begin
       if ( rising_edge( clk ) ) then
@@ -112,6 +112,7 @@ architecture rtl of CommandWrapper is
 
    signal   deStufferSynced   : std_logic;
    signal   deStufferAbort    : std_logic;
+   signal   cobsFraming       : std_logic;
 
    signal   pipelinedBusIb    : SimpleBusMstType                           := SIMPLE_BUS_MST_INIT_C;
    signal   pipelinedRdyIb    : std_logic                                  := '1';
@@ -142,7 +143,9 @@ begin
 
          datInp      => datIb,
          vldInp      => vldIb,
-         rdyInp      => rdyIb
+         rdyInp      => rdyIb,
+
+         cobs        => cobsFraming
       );
 
    U_PIPE_IB : entity work.SimpleBusPipeStage
@@ -173,7 +176,9 @@ begin
 
          datOut      => datOb,
          vldOut      => vldOb,
-         rdyOut      => rdyOb
+         rdyOut      => rdyOb,
+
+         cobs        => cobsFraming
       );
 
    U_PIPE_OB : entity work.SimpleBusPipeStage
@@ -227,7 +232,11 @@ begin
          rIb          => readysIbLoc(CMD_VER_IDX_C),
 
          mOb          => bussesObLoc(CMD_VER_IDX_C),
-         rOb          => readysObLoc(CMD_VER_IDX_C)
+         rOb          => readysObLoc(CMD_VER_IDX_C),
+
+         -- the framing reverts to stuffing when the host resyncs
+         cobs         => cobsFraming,
+         abrt         => deStufferAbort
       );
 
    U_SPI : entity work.CommandSpi
@@ -245,6 +245,7 @@ begin
          RAM_BITS_G          => RAM_BITS_C,
          MEM_DEPTH_G         => MEM_DEPTH_C,
          USE_SDRAM_BUF_G     => false,
+         AVG_DEPTH_G         => MEM_DEPTH_C,
          SDRAM_ADDR_WIDTH_G  => RAM_A_WIDTH_C,
          GIT_VERSION_G       => x"deadbeef",
          REG_ASYNC_G         => true
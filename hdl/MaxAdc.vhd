@@ -39,6 +39,12 @@ use     work.SDRAMBufPkg.all;
 entity MaxADC is
    generic (
       ADC_CLOCK_FREQ_G     : real                  := 130.0E6;
+      -- 'busClk' frequency; used to time 'read-wait' commands
+      BUS_CLOCK_FREQ_G     : real                  := 100.0E6;
+      -- max. time a 'read-wait' command holds the reply while
+      -- the acquisition is incomplete; reported to the host in the
+      -- extended flags (units of 10ms, max. 150ms)
+      WAIT_TIMEOUT_G       : real                  := 0.1;
       MEM_DEPTH_G          : natural               := 1024;
       ADC_BITS_G           : natural               := 8;
       ONE_MEM_G            : boolean               := false;
@@ -46,6 +52,10 @@ entity MaxADC is
       RAM_BITS_G           : natural range 8 to 16 := 10;
       SDRAM_ADDR_WIDTH_G   : natural               := 0;
       USE_SDRAM_BUF_G      : boolean               := false;
+      -- averaging: depth of the accumulator memory (0: averaging not
+      -- supported) and log2 of the max. number of averaged acquisitions
+      AVG_DEPTH_G          : natural               := 0;
+      AVG_LD_MAX_G         : natural range 1 to 16 := 8;
       -- set to opposite of initial value of 'parmsTgl'
       -- this will start an initial acquistion
       INIT_ACQ_POL_G       : std_logic             := '0'
@@ -166,6 +176,37 @@ architecture rtl of MaxADC is
    constant FLAG_IDX_2B_C   : natural               := 0;
    constant FLAG_IDX_NL_C   : natural               := 1;
    constant FLAG_IDX_NH_C   : natural               := 3;
+   constant FLAG_IDX_WAIT_C : natural               := 4;
+   constant FLAG_IDX_ROI_C  : natural               := 5;
+   constant FLAG_IDX_PEAK_C : natural               := 6;
+   constant FLAG_IDX_SEG_C  : natural               := 7;
+
+   -- extended flags (MSIZE with the 'range' modifier)
+   constant XFLAG_IDX_XHDR_C : natural              := 0;
+   constant XFLAG_IDX_DBL_C  : natural              := 1;
+   constant XFLAG_IDX_PACK_C : natural              := 2;
+   constant XFLAG_IDX_AVG_C  : natural              := 3;
+   -- read-wait timeout in units of XFLAG_HOLD_MS_C (rounded up)
+   constant XFLAG_IDX_HOLD_C : natural              := 4;
+   constant XFLAG_HOLD_MS_C  : real                 := 10.0;
+   constant XFLAG_HOLD_C     : natural              := natural( ceil( WAIT_TIMEOUT_G * 1000.0 / XFLAG_HOLD_MS_C - 1.0E-6 ) );
+
+   -- packed transfer (RAM_BITS_G bits per sample instead of two bytes);
+   -- pointless for 8- and 16-bit samples
+   constant PACK_SUP_C       : boolean              := ( RAM_BITS_G > 8 ) and ( RAM_BITS_G < 16 );
+
+   -- averaging: successive acquisitions are drained from the sample
+   -- buffer and summed up in the accumulator memory (the sample buffer
+   -- is a stream and cannot be updated in place).
+   constant AVG_SUP_C        : boolean              := ( AVG_DEPTH_G > 0 );
+   constant AVG_DEPTH_C      : natural              := ite( AVG_DEPTH_G > 1, AVG_DEPTH_G, 2 );
+   constant ACC_BITS_C       : natural              := RAM_BITS_G + AVG_LD_MAX_G;
+   -- bytes per sample of an averaged reply (32-bit sums of both channels)
+   constant AVG_BYTES_C      : natural              := 8;
+
+   constant WAIT_TICKS_C    : natural               := natural( round( WAIT_TIMEOUT_G * BUS_CLOCK_FREQ_G ) );
+
+   subtype  WaitCntType     is unsigned( numBits( WAIT_TICKS_C ) - 1 downto 0 );
 
    function MSIZE_FLAGS_F return std_logic_vector is
       variable v : std_logic_vector(7 downto 0);
@@ -175,12 +216,41 @@ architecture rtl of MaxADC is
       if ( RAM_BITS_G > 8 ) then
         v(FLAG_IDX_NH_C downto FLAG_IDX_NL_C ) := std_logic_vector( to_unsigned( RAM_BITS_G - 9, FLAG_IDX_NH_C - FLAG_IDX_NL_C + 1 ) );
       end if;
+      v(FLAG_IDX_WAIT_C) := '1';
+      v(FLAG_IDX_ROI_C)  := '1';
+      v(FLAG_IDX_PEAK_C) := '1';
+      v(FLAG_IDX_SEG_C)  := '1';
       return v;
    end function MSIZE_FLAGS_F;
 
+   function MSIZE_XFLAGS_F return std_logic_vector is
+      variable v : std_logic_vector(7 downto 0);
+   begin
+      v := (others => '0');
+      v(XFLAG_IDX_XHDR_C) := '1';
+      -- ping-pong mode is only supported by the BRAM buffer
+      v(XFLAG_IDX_DBL_C)  := ite( not USE_SDRAM_BUF_G );
+      v(XFLAG_IDX_PACK_C) := ite( PACK_SUP_C );
+      v(XFLAG_IDX_AVG_C)  := ite( AVG_SUP_C );
+      v(7 downto XFLAG_IDX_HOLD_C) := std_logic_vector( to_unsigned( XFLAG_HOLD_C, 8 - XFLAG_IDX_HOLD_C ) );
+      return v;
+   end function MSIZE_XFLAGS_F;
+
    constant LD_BCNT_C       : natural               := ite( RAM_BITS_G > 8, 2, 1 );
 
-   type     WrStateType     is (INIT, FILL, RUN, STOP1, STOP2, HOLD);
+   type     WrStateType     is (INIT, FILL, RUN, TRL, STOP1, STOP2, HOLD);
+
+   -- segmented acquisition: each segment is followed by a trailer of
+   -- 'sample' words; the 16-bit trailer values are stored in the upper
+   -- 8 bits of channel A (low byte) and B (high byte):
+   --   0: ovrA (bit 0), ovrB (bit 1), auto-triggered (bit 8)
+   --   1..3: trigger timestamp (ADC clock cycles), bits 15..0, 31..16, 47..32
+   constant SEG_TRL_WORDS_C : natural := 4;
+
+   subtype  TStampType      is unsigned(47 downto 0);
+
+   -- number of triggered acquisitions (wraps around)
+   subtype  AcqSeqType      is unsigned(15 downto 0);
 
    type     WrRegType       is record
       state   : WrStateType;
@@ -195,6 +265,14 @@ architecture rtl of MaxADC is
       tgl     : std_logic;
       armLvl  : signed(RamWord'range);
       fifoFul : std_logic;
+      segIdx  : unsigned(15 downto 0);
+      segSmpl : RamAddr;
+      segOvrA : std_logic;
+      segOvrB : std_logic;
+      tstamp  : TStampType;
+      trlIdx  : natural range 0 to SEG_TRL_WORDS_C - 1;
+      seq     : AcqSeqType;
+      acqTs   : TStampType;
    end record WrRegType;
 
    constant WR_REG_INIT_C   : WrRegType := (
@@ -209,20 +287,91 @@ architecture rtl of MaxADC is
       decmIs1 => true,
       tgl     => '0',
       armLvl  => (others => '0'),
-      fifoFul => '0'
+      fifoFul => '0',
+      segIdx  => (others => '0'),
+      segSmpl => (others => '0'),
+      segOvrA => '0',
+      segOvrB => '0',
+      tstamp  => (others => '0'),
+      trlIdx  => 0,
+      seq     => (others => '0'),
+      acqTs   => (others => '0')
    );
 
+   -- trailer word 'idx' of a segment
+   function segTrlWord(constant r : WrRegType; constant idx : natural) return std_logic_vector is
+      variable x : std_logic_vector(15 downto 0);
+      variable v : std_logic_vector(2*RAM_BITS_G downto 0);
+   begin
+      x := (others => '0');
+      case ( idx ) is
+         when 0      =>
+            x(0) := r.segOvrA;
+            x(1) := r.segOvrB;
+            x(8) := r.autTrg;
+         when 1      => x := std_logic_vector( r.tstamp(15 downto  0) );
+         when 2      => x := std_logic_vector( r.tstamp(31 downto 16) );
+         when others => x := std_logic_vector( r.tstamp(47 downto 32) );
+      end case;
+      v := (others => '0');
+      v(  RAM_BITS_G - 1 downto   RAM_BITS_G - 8) := x( 7 downto 0);
+      v(2*RAM_BITS_G - 1 downto 2*RAM_BITS_G - 8) := x(15 downto 8);
+      return v;
+   end function segTrlWord;
+
    function WR_REG_START_F(constant r : in WrRegType)
    return WrRegType is
       variable v : WrRegType;
    begin
       v       := WR_REG_INIT_C;
       v.tgl   := r.tgl;
+      v.seq   := r.seq;
       v.state := FILL;
       return v;
    end function WR_REG_START_F;
 
-   type     RdStateType     is (ECHO, MSIZE, HDR, READ);
+   -- header information; latched when an acquisition is handed
+   -- to the reader and stable while the reader owns the respective
+   -- half of the buffer (half 0 unless in ping-pong mode)
+   type   WrCCRegType is record
+      ovrA    : std_logic;
+      ovrB    : std_logic;
+      autTrg  : std_logic;
+      seq     : AcqSeqType;
+      tstamp  : TStampType;
+   end record WrCCRegType;
+
+   constant WR_CC_REG_INIT_C : WrCCRegType := (
+      ovrA    => '0',
+      ovrB    => '0',
+      autTrg  => '0',
+      seq     => (others => '0'),
+      tstamp  => (others => '0')
+   );
+
+   type     RdStateType     is (ECHO, MSIZE, XFLG, PARM, SKIP, HDR, XHDR, READ, PACK, ACC, EMIT, AVG, ALD, AOUT, FIN);
+
+   -- max. number of parameter bytes of a 'range' read (offset, count
+   -- and the optional peak-detect bucket size and option flags)
+   constant ROI_PARM_BYTES_C : natural := 16;
+
+   -- option flags of a 'range' read
+   constant ROI_OPT_XHDR_C  : natural := 0;
+   constant ROI_OPT_PACK_C  : natural := 1;
+
+   -- extended header: sequence number (16 bits) followed by the
+   -- trigger timestamp (48 bits, ADC clock cycles); little-endian
+   constant XHDR_BYTES_C    : natural := 8;
+
+   -- peak-detect: bytes per bucket (min. of both channels followed by max.)
+   constant PEAK_BYTES_C    : natural := 4*LD_BCNT_C;
+
+   subtype  RoiCntType      is unsigned(31 downto 0);
+
+   subtype  AvgIdxType      is unsigned(numBits( AVG_DEPTH_C - 1 ) - 1 downto 0);
+
+   -- accumulator word; channel A in the lower half
+   subtype  AccWord         is std_logic_vector(2*ACC_BITS_C - 1 downto 0);
 
    type     RdRegType       is record
       state   : RdStateType;
@@ -231,8 +380,83 @@ architecture rtl of MaxADC is
       tgl     : std_logic;
       flush   : std_logic;
       fifoEmp : std_logic;
+      waitCnt : WaitCntType;
+      parmCnt : natural range 0 to ROI_PARM_BYTES_C;
+      roiOff  : RoiCntType;
+      roiCnt  : RoiCntType;
+      roiEna  : boolean;
+      empty   : boolean;
+      drain   : std_logic;
+      bktSize : RoiCntType;
+      bktLeft : RoiCntType;
+      roiOpts : RoiCntType;
+      xhdr    : boolean;
+      xflg    : boolean;
+      xhdrIdx : natural range 0 to XHDR_BYTES_C - 1;
+      pack    : boolean;
+      pkAcc   : std_logic_vector(2*RAM_BITS_G + 6 downto 0);
+      pkBits  : natural range 0 to 2*RAM_BITS_G + 7;
+      peak    : boolean;
+      final   : boolean;
+      minA    : RamWord;
+      minB    : RamWord;
+      maxA    : RamWord;
+      maxB    : RamWord;
+      emitIdx : natural range 0 to PEAK_BYTES_C - 1;
+      avg     : boolean;
+      avgIdx  : AvgIdxType;
+      avgLen  : AvgIdxType;
+      avgCnt  : unsigned(15 downto 0);
+      avgRdy  : boolean;
+      avgCC   : WrCCRegType;
+      avgWe   : std_logic;
+      avgWa   : AvgIdxType;
+      avgFst  : boolean;
+      smpA    : RamWord;
+      smpB    : RamWord;
+      accIdx  : natural range 0 to AVG_BYTES_C - 1;
+      pTgl    : std_logic;
    end record RdRegType;
 
+   -- byte 'idx' of a peak-detect bucket; same byte order as READ
+   function peakByte(constant r : RdRegType; constant idx : natural) return std_logic_vector is
+      variable w : RamWord;
+   begin
+      case ( idx / LD_BCNT_C ) is
+         when 0      => w := r.minA;
+         when 1      => w := r.minB;
+         when 2      => w := r.maxA;
+         when others => w := r.maxB;
+      end case;
+      if ( ( LD_BCNT_C = 1 ) or ( ( idx mod 2 ) = 1 ) ) then
+         return hiByte( w );
+      end if;
+      return loByte( w );
+   end function peakByte;
+
+   -- byte 'idx' of the extended header
+   function xhdrByte(constant seq : AcqSeqType; constant ts : TStampType; constant idx : natural)
+   return std_logic_vector is
+      variable x : std_logic_vector(8*XHDR_BYTES_C - 1 downto 0);
+   begin
+      x := std_logic_vector( ts ) & std_logic_vector( seq );
+      return x(8*idx + 7 downto 8*idx);
+   end function xhdrByte;
+
+   -- byte 'idx' of an averaged sample: the sums of channel A and B,
+   -- sign-extended to 32 bits, little-endian
+   function accByte(constant x : AccWord; constant idx : natural)
+   return std_logic_vector is
+      variable a : signed(31 downto 0);
+   begin
+      if ( idx < AVG_BYTES_C/2 ) then
+         a := resize( signed( x(  ACC_BITS_C - 1 downto          0) ), a'length );
+      else
+         a := resize( signed( x(2*ACC_BITS_C - 1 downto ACC_BITS_C) ), a'length );
+      end if;
+      return std_logic_vector( a(8*(idx mod 4) + 7 downto 8*(idx mod 4)) );
+   end function accByte;
+
    function SIMPLE_BUS_MST_INIT_F return SimpleBusMstType is
       variable v : SimpleBusMstType := SIMPLE_BUS_MST_INIT_C;
    begin
@@ -248,7 +472,43 @@ architecture rtl of MaxADC is
       busOb   => SIMPLE_BUS_MST_INIT_F,
       tgl     => '0',
       flush   => '0',
-      fifoEmp => '0'
+      fifoEmp => '0',
+      waitCnt => to_unsigned( WAIT_TICKS_C, WaitCntType'length ),
+      parmCnt => 0,
+      roiOff  => (others => '0'),
+      roiCnt  => (others => '0'),
+      roiEna  => false,
+      empty   => false,
+      drain   => '0',
+      bktSize => (others => '0'),
+      bktLeft => (others => '0'),
+      roiOpts => (others => '0'),
+      xhdr    => false,
+      xflg    => false,
+      xhdrIdx => 0,
+      pack    => false,
+      pkAcc   => (others => '0'),
+      pkBits  => 0,
+      peak    => false,
+      final   => false,
+      minA    => (others => '0'),
+      minB    => (others => '0'),
+      maxA    => (others => '0'),
+      maxB    => (others => '0'),
+      emitIdx => 0,
+      avg     => false,
+      avgIdx  => (others => '0'),
+      avgLen  => (others => '0'),
+      avgCnt  => (others => '0'),
+      avgRdy  => false,
+      avgCC   => WR_CC_REG_INIT_C,
+      avgWe   => '0',
+      avgWa   => (others => '0'),
+      avgFst  => true,
+      smpA    => (others => '0'),
+      smpB    => (others => '0'),
+      accIdx  => 0,
+      pTgl    => '0'
    );
 
    type     ParmHskStateType is (LOCAL, RUN);
@@ -274,17 +534,17 @@ architecture rtl of MaxADC is
    signal rParmsHsk     : ParmHskRegType := PARM_HSK_REG_INIT_C;
    signal rinParmsHsk   : ParmHskRegType;
 
-   type   WrCCRegType is record
-      ovrA    : std_logic;
-      ovrB    : std_logic;
-      autTrg  : std_logic;
-   end record WrCCRegType;
+   type   WrCCRegArray is array (0 to 1) of WrCCRegType;
 
+   signal rWrCCHlf  : WrCCRegArray := (others => WR_CC_REG_INIT_C);
    signal rWrCC     : WrCCRegType;
 
    -- helps writing constraints
-   attribute KEEP         of rWrCC   : signal is "TRUE";
-   attribute SYN_KEEP     of rWrCC   : signal is true;
+   attribute KEEP         of rWrCCHlf : signal is "TRUE";
+   attribute SYN_KEEP     of rWrCCHlf : signal is true;
+
+   signal accRa     : AvgIdxType;
+   signal accRdDat  : AccWord := (others => '0');
 
    signal memClk    : std_logic;
    signal filClk    : std_logic;
@@ -347,6 +607,8 @@ architecture rtl of MaxADC is
 
    signal wrDon             : std_logic;
    signal wrEna             : std_logic;
+   -- suppress writing while a segment waits for its trigger
+   signal wrGate            : std_logic;
    signal wrFul             : std_logic;
    signal wrDat             : std_logic_vector(2*RamWord'length downto 0);
    signal rdDat             : std_logic_vector(2*RamWord'length downto 0);
@@ -354,6 +616,11 @@ architecture rtl of MaxADC is
    signal rdEna             : std_logic;
 
    signal memFull           : std_logic;
+   -- sample buffer cannot accept the next acquisition yet
+   signal wrHld             : std_logic;
+   -- half of the sample buffer being recorded/read (ping-pong mode)
+   signal wrHlf             : std_logic;
+   signal rdHlf             : std_logic;
    signal rdTgl             : std_logic;
    signal wrTgl             : std_logic;
    signal wrDecm            : std_logic := '1';
@@ -366,6 +633,9 @@ architecture rtl of MaxADC is
    signal msTimer           : unsigned( 15 downto 0 )                 := AUTO_TIME_STOP_C;
    signal msTimerExpired    : boolean                                 := false;
 
+   -- free-running ADC clock counter; latched at the trigger of a segment
+   signal tsCounter         : TStampType                              := (others => '0');
+
    signal lparms            : AcqCtlParmType := ACQ_CTL_PARM_INIT_C;
 
    signal statusLoc         : std_logic_vector(status'range) := (others => '0');
@@ -382,13 +652,17 @@ begin
 
    assert ADC_FREQ_MHZ_C < 256 report "Cannot report accurate Freq. [MHz]" severity failure;
 
+   assert ACC_BITS_C <= 32 report "Accumulator too wide for the averaged reply" severity failure;
+
+   assert XFLAG_HOLD_C < 16 report "Cannot report the read-wait timeout (WAIT_TIMEOUT_G too long)" severity failure;
+
    lparms  <= rWr.parms;
 
    memClk  <= adcClk;
    filClk  <= memClk;
 
    memFull <= '1' when (rWr.state = HOLD) else '0';
-   wrEna   <= not memFull and wrDecm and sampleBufferReady;
+   wrEna   <= not memFull and wrDecm and sampleBufferReady and not wrGate;
 
    U_RD_SYNC : entity work.SynchronizerBit
       port map (
@@ -419,21 +693,58 @@ begin
    fdatB         <= adcDataB(ADC_BITS_G downto 1);
    fdorB         <= adcDataB(                  0);
 
-   rWrCC.ovrA    <= statusLoc(ACQ_STA_OVR_A_C);
-   rWrCC.ovrB    <= statusLoc(ACQ_STA_OVR_B_C);
-   rWrCC.autTrg  <= rWr.autTrg;
+   rWrCC         <= rWrCCHlf(1) when rdHlf = '1' else rWrCCHlf(0);
+
+   P_WR_CC : process ( memClk ) is
+   begin
+      if ( rising_edge( memClk ) ) then
+         if ( ( rWr.state = STOP2 ) and ( wrDecm = '1' ) ) then
+            -- hand-over to the reader; the writer may proceed
+            -- with the other half in ping-pong mode
+            if ( wrHlf = '1' ) then
+               rWrCCHlf(1) <= ( ovrA   => statusLoc(ACQ_STA_OVR_A_C),
+                                ovrB   => statusLoc(ACQ_STA_OVR_B_C),
+                                autTrg => rWr.autTrg,
+                                seq    => rWr.seq,
+                                tstamp => rWr.acqTs );
+            else
+               rWrCCHlf(0) <= ( ovrA   => statusLoc(ACQ_STA_OVR_A_C),
+                                ovrB   => statusLoc(ACQ_STA_OVR_B_C),
+                                autTrg => rWr.autTrg,
+                                seq    => rWr.seq,
+                                tstamp => rWr.acqTs );
+            end if;
+         end if;
+      end if;
+   end process P_WR_CC;
 
    -- ise doesn't seem to properly handle nested records
    -- (getting warning about rRd.busOb missing from sensitivity list)
-   P_RD_COMB : process (rRd, rRd.busOb, busIb, rdyOb, rdEmp, rdDat, wrTgl, rWrCC) is
+   P_RD_COMB : process (rRd, rRd.busOb, busIb, rdyOb, rdEmp, rdDat, wrTgl, rWrCC, parms, parmsTgl, accRdDat) is
       variable v       : RdRegType;
       variable rdatA   : RamWord;
       variable rdatB   : RamWord;
       variable rdLst   : std_logic;
+      variable avgOn   : boolean;
+      variable dEmp    : std_logic;
+      variable cc      : WrCCRegType;
 
   begin
       v          := rRd;
 
+      -- in averaging mode the reply is generated from the accumulator
+      -- memory once the requested number of acquisitions is summed up
+      avgOn      := AVG_SUP_C and ( parms.navg /= 0 );
+      dEmp       := rdEmp;
+      if ( avgOn ) then
+         dEmp    := toSl( not rRd.avgRdy );
+      end if;
+
+      cc         := rWrCC;
+      if ( rRd.avg ) then
+         cc      := rRd.avgCC;
+      end if;
+
       rdatA      := rdDat(   RAM_BITS_G - 1 downto          0 );
       rdatB      := rdDat( 2*RAM_BITS_G - 1 downto RAM_BITS_G );
       rdLst      := rdDat( rdDat'left                         );
@@ -444,6 +755,7 @@ begin
       rdEna      <= '0';
 
       v.flush    := '0';
+      v.avgWe    := '0';
 
       -- compute byteCnt; covers all relevant states
       if ( rdyOb = '1' ) then
@@ -461,9 +773,43 @@ begin
             v.busOb.vld := '1';
             v.busOb.lst := '0';
 
-            if ( (rdyOb and busIb.vld) = '1' ) then
+            v.avg       := avgOn;
+            if ( avgOn ) then
+               cc       := rRd.avgCC;
+            else
+               cc       := rWrCC;
+            end if;
+
+            if ( parmsTgl /= rRd.pTgl ) then
+               -- new parameters; start over
+               v.pTgl   := parmsTgl;
+               v.avgCnt := (others => '0');
+               v.avgRdy := false;
+            end if;
+
+            if ( avgOn and ( not rRd.avgRdy ) and ( rdEmp = '0' ) ) then
+               -- accumulate the next acquisition; the command (if any)
+               -- is held until this is done
+               busOb.vld <= '0';
+               rdyIb     <= '0';
+               v.avgIdx  := (others => '0');
+               v.state   := AVG;
+            elsif (     ( busIb.vld = '1' )
+                 and ( CMD_ACQ_READ_C = subCommandAcqGet( busIb.dat ) )
+                 and subCommandAcqWait( busIb.dat )
+                 and ( dEmp = '1' )
+                 and ( rRd.waitCnt /= 0 ) ) then
+               -- read-wait: hold the command (and thus the reply) until
+               -- the acquisition is complete or the timeout expires
+               -- (which yields the ordinary 'no data' reply).
+               busOb.vld <= '0';
+               rdyIb     <= '0';
+               v.waitCnt := rRd.waitCnt - 1;
+            elsif ( (rdyOb and busIb.vld) = '1' ) then
+               v.waitCnt := RD_REG_INIT_C.waitCnt;
                if    ( CMD_ACQ_MSIZE_C = subCommandAcqGet( busIb.dat ) ) then
                   v.state        := MSIZE;
+                  v.xflg         := subCommandAcqRange( busIb.dat );
                   v.busOb.dat    := std_logic_vector( MSIZE_INFO_C(7 downto 0) );
                elsif ( CMD_ACQ_SFREQ_C = subCommandAcqGet( busIb.dat ) ) then
                   v.busOb.dat    := std_logic_vector( to_unsigned( ADC_FREQ_MHZ_C, 8 ) );
@@ -472,16 +818,41 @@ begin
                   -- which will return to ECHO once the single byte is
                   -- consumed
                   v.state        := MSIZE;
-               elsif ( ( rdEmp = '0' ) and ( CMD_ACQ_READ_C = subCommandAcqGet( busIb.dat ) ) ) then
+                  v.xflg         := false;
+               elsif ( ( CMD_ACQ_READ_C = subCommandAcqGet( busIb.dat ) ) and subCommandAcqRange( busIb.dat ) ) then
+                  -- collect the parameters even if there are no data (they
+                  -- must not be interpreted as commands); an empty
+                  -- acquisition is reported by a header w/o data.
+                  v.state        := PARM;
+                  v.parmCnt      := 0;
+                  v.roiOff       := (others => '0');
+                  v.roiCnt       := (others => '0');
+                  v.bktSize      := (others => '0');
+                  v.roiOpts      := (others => '0');
+                  v.empty        := ( dEmp = '1' );
+                  v.busOb.dat    := (others => '0');
+                  v.busOb.dat(0) := cc.ovrA;
+                  v.busOb.dat(1) := cc.ovrB;
+               elsif ( ( dEmp = '0' ) and ( CMD_ACQ_READ_C = subCommandAcqGet( busIb.dat ) ) ) then
                   v.state        := HDR;
+                  v.roiEna       := false;
+                  v.peak         := false;
+                  v.xhdr         := false;
+                  v.pack         := false;
+                  v.avgIdx       := (others => '0');
                   v.busOb.dat    := (others => '0');
-                  v.busOb.dat(0) := rWrCC.ovrA;
-                  v.busOb.dat(1) := rWrCC.ovrB;
+                  v.busOb.dat(0) := cc.ovrA;
+                  v.busOb.dat(1) := cc.ovrB;
                else
                   busOb.lst <= '1';
-                  if ( rdEmp = '0' ) then  -- implies CMD_ACQ_FLUSH_C = subCommandAcqGet( busIb.dat )
-                     v.flush := '1';
-                     v.tgl   := wrTgl;
+                  if ( CMD_ACQ_FLUSH_C = subCommandAcqGet( busIb.dat ) ) then
+                     if ( rdEmp = '0' ) then
+                        v.flush := '1';
+                        v.tgl   := wrTgl;
+                     end if;
+                     -- discard the partial average
+                     v.avgCnt   := (others => '0');
+                     v.avgRdy   := false;
                   end if;
                end if;
             end if;
@@ -497,6 +868,83 @@ begin
                   v.busOb.dat := MSIZE_FLAGS_F;
                   v.busOb.vld := '1';
                   v.busOb.lst := '1';
+                  if ( rRd.xflg ) then
+                     v.busOb.lst := '0';
+                     v.state     := XFLG;
+                  end if;
+               end if;
+            end if;
+
+         when XFLG =>
+            if ( rdyOb = '1' ) then -- flags consumed
+               v.busOb.dat := MSIZE_XFLAGS_F;
+               v.busOb.vld := '1';
+               v.busOb.lst := '1';
+               v.xflg      := false;
+               v.state     := MSIZE;
+            end if;
+
+         when PARM =>
+            -- hold the header until the parameters are in
+            busOb.vld <= '0';
+            v.busOb   := rRd.busOb;
+            v.byteCnt := rRd.byteCnt;
+            if ( rRd.parmCnt /= ROI_PARM_BYTES_C ) then
+               if ( busIb.vld = '1' ) then
+                  -- little-endian; offset, count, bucket size
+                  case ( rRd.parmCnt / 4 ) is
+                     when 0      =>
+                        v.roiOff ( 8*(rRd.parmCnt mod 4) + 7 downto 8*(rRd.parmCnt mod 4) ) := unsigned( busIb.dat );
+                     when 1      =>
+                        v.roiCnt ( 8*(rRd.parmCnt mod 4) + 7 downto 8*(rRd.parmCnt mod 4) ) := unsigned( busIb.dat );
+                     when 2      =>
+                        v.bktSize( 8*(rRd.parmCnt mod 4) + 7 downto 8*(rRd.parmCnt mod 4) ) := unsigned( busIb.dat );
+                     when others =>
+                        v.roiOpts( 8*(rRd.parmCnt mod 4) + 7 downto 8*(rRd.parmCnt mod 4) ) := unsigned( busIb.dat );
+                  end case;
+                  v.parmCnt := rRd.parmCnt + 1;
+                  if ( busIb.lst = '1' ) then
+                     -- the bucket size and options are optional
+                     v.parmCnt := ROI_PARM_BYTES_C;
+                  end if;
+               end if;
+            else
+               v.roiEna   := ( rRd.roiCnt /= 0 );
+               v.peak     := ( rRd.bktSize > 1 );
+               v.bktLeft  := rRd.bktSize;
+               v.xhdr     := ( rRd.roiOpts(ROI_OPT_XHDR_C) = '1' );
+               v.pack     := PACK_SUP_C and ( rRd.roiOpts(ROI_OPT_PACK_C) = '1' );
+               v.state   := SKIP;
+               if ( rRd.avg ) then
+                  -- the accumulator memory is addressed directly
+                  v.peak  := false;
+                  v.pack  := false;
+                  v.state := HDR;
+                  if ( rRd.roiOff > rRd.avgLen ) then
+                     v.avgIdx := rRd.avgLen;
+                  else
+                     v.avgIdx := resize( rRd.roiOff, v.avgIdx'length );
+                  end if;
+               end if;
+               if ( rRd.empty ) then
+                  v.state := HDR;
+               end if;
+            end if;
+
+         when SKIP =>
+            -- discard samples preceding the region of interest; the
+            -- last sample is never skipped so that a reply always
+            -- carries data.
+            busOb.vld <= '0';
+            v.busOb   := rRd.busOb;
+            v.byteCnt := rRd.byteCnt;
+            -- READ relies on valid data at the head of the FIFO
+            if ( rdEmp = '0' ) then
+               if ( ( rRd.roiOff = 0 ) or ( rdLst = '1' ) ) then
+                  v.state  := HDR;
+               else
+                  rdEna    <= '1';
+                  v.roiOff := rRd.roiOff - 1;
                end if;
             end if;
 
@@ -504,9 +952,57 @@ begin
             if ( rdyOb = '1' ) then -- busOb.vld is '1' at this point
                -- rRd.byteCnt is 0 here
                v.busOb.dat    := (others => '0');
-               v.busOb.dat(0) := rWrCC.autTrg;
+               v.busOb.dat(0) := cc.autTrg;
+               v.busOb.dat(1) := rdHlf;
                v.state        := READ;
                v.busOb.vld    := '1';
+               v.pkAcc        := (others => '0');
+               v.pkBits       := 0;
+               v.final        := false;
+               if ( rRd.pack ) then
+                  v.state     := PACK;
+               end if;
+               if ( rRd.peak ) then
+                  v.state     := ACC;
+               end if;
+               if ( rRd.avg ) then
+                  v.busOb.dat(1) := '0';
+                  v.busOb.dat(2) := '1';
+                  v.accIdx       := 0;
+                  v.state        := ALD;
+               end if;
+               if ( rRd.xhdr ) then
+                  v.xhdrIdx   := 0;
+                  v.state     := XHDR;
+               end if;
+               if ( rRd.empty ) then
+                  -- header only; MSIZE returns to ECHO after the last byte
+                  v.busOb.lst := '1';
+                  v.state     := MSIZE;
+                  v.empty     := false;
+               end if;
+            end if;
+
+         when XHDR =>
+            -- READ expects byteCnt as left by HDR
+            v.byteCnt := rRd.byteCnt;
+            if ( rdyOb = '1' ) then -- previous byte consumed
+               v.busOb.dat := xhdrByte( cc.seq, cc.tstamp, rRd.xhdrIdx );
+               v.busOb.vld := '1';
+               if ( rRd.xhdrIdx = XHDR_BYTES_C - 1 ) then
+                  v.state  := READ;
+                  if ( rRd.pack ) then
+                     v.state := PACK;
+                  end if;
+                  if ( rRd.peak ) then
+                     v.state := ACC;
+                  end if;
+                  if ( rRd.avg ) then
+                     v.state := ALD;
+                  end if;
+               else
+                  v.xhdrIdx := rRd.xhdrIdx + 1;
+               end if;
             end if;
 
          when READ =>
@@ -526,10 +1022,20 @@ begin
                   v.busOb.dat := hiByte( rdatB );
                   -- is the end reached 
                   v.busOb.lst := rdLst;
+                  if ( rRd.roiEna ) then
+                     v.roiCnt := rRd.roiCnt - 1;
+                     if ( ( rRd.roiCnt = 1 ) and ( rdLst = '0' ) ) then
+                        -- end of the region; discard the rest when done
+                        v.busOb.lst := '1';
+                        v.drain     := '1';
+                     end if;
+                  end if;
                else
                   if ( rRd.busOb.lst = '1' ) then
                      v.state := ECHO;
                      v.tgl   := wrTgl;
+                     v.flush := rRd.drain;
+                     v.drain := '0';
                   end if;
                   if ( ( rRd.byteCnt'length /= 2 ) or ( rRd.byteCnt(0) = '0' ) ) then
                      v.busOb.dat := hiByte( rdatA );
@@ -540,6 +1046,162 @@ begin
                   end if;
                end if;
             end if;
+         when PACK =>
+            -- packed transfer: the samples of both channels are appended
+            -- to a bit-accumulator (LSB first) which is drained one byte
+            -- at a time; the last byte is padded with zeros.
+            if ( ( rRd.pkBits >= 8 ) or ( rRd.final and ( rRd.pkBits > 0 ) ) ) then
+               if ( ( rdyOb = '1' ) or ( rRd.busOb.vld = '0' ) ) then
+                  v.busOb.dat := rRd.pkAcc(7 downto 0);
+                  v.busOb.vld := '1';
+                  v.busOb.lst := '0';
+                  v.pkAcc     := x"00" & rRd.pkAcc(rRd.pkAcc'left downto 8);
+                  if ( rRd.pkBits > 8 ) then
+                     v.pkBits := rRd.pkBits - 8;
+                  else
+                     v.pkBits := 0;
+                     if ( rRd.final ) then
+                        v.busOb.lst := '1';
+                        v.state     := FIN;
+                     end if;
+                  end if;
+               end if;
+            elsif ( ( not rRd.final ) and ( rdEmp = '0' ) ) then
+               -- fewer than 8 bits left; append the next sample pair
+               rdEna     <= '1';
+               v.pkAcc   := rRd.pkAcc or std_logic_vector( shift_left( resize( unsigned( rdatB & rdatA ), rRd.pkAcc'length ), rRd.pkBits ) );
+               v.pkBits  := rRd.pkBits + 2*RAM_BITS_G;
+               if ( rRd.roiEna ) then
+                  v.roiCnt := rRd.roiCnt - 1;
+               end if;
+               v.final   := ( rdLst = '1' ) or ( rRd.roiEna and ( rRd.roiCnt = 1 ) );
+               if ( v.final ) then
+                  v.drain := not rdLst;
+               end if;
+            end if;
+
+         when ACC  =>
+            -- peak-detect: consume the samples of a bucket (one per
+            -- cycle) while the previous byte drains
+            if ( rdEmp = '0' ) then
+               rdEna     <= '1';
+               if ( rRd.bktLeft = rRd.bktSize ) then
+                  v.minA := rdatA;
+                  v.maxA := rdatA;
+                  v.minB := rdatB;
+                  v.maxB := rdatB;
+               else
+                  if ( signed( rdatA ) < signed( rRd.minA ) ) then v.minA := rdatA; end if;
+                  if ( signed( rdatA ) > signed( rRd.maxA ) ) then v.maxA := rdatA; end if;
+                  if ( signed( rdatB ) < signed( rRd.minB ) ) then v.minB := rdatB; end if;
+                  if ( signed( rdatB ) > signed( rRd.maxB ) ) then v.maxB := rdatB; end if;
+               end if;
+               v.bktLeft := rRd.bktLeft - 1;
+               if ( rRd.roiEna ) then
+                  v.roiCnt := rRd.roiCnt - 1;
+               end if;
+               v.final   := ( rdLst = '1' ) or ( rRd.roiEna and ( rRd.roiCnt = 1 ) );
+               if ( ( rRd.bktLeft = 1 ) or v.final ) then
+                  v.bktLeft := rRd.bktSize;
+                  v.emitIdx := 0;
+                  v.drain   := not rdLst;
+                  v.state   := EMIT;
+               end if;
+            end if;
+
+         when EMIT =>
+            if ( ( rdyOb = '1' ) or ( rRd.busOb.vld = '0' ) ) then
+               v.busOb.dat := peakByte( rRd, rRd.emitIdx );
+               v.busOb.vld := '1';
+               v.busOb.lst := '0';
+               if ( rRd.emitIdx = PEAK_BYTES_C - 1 ) then
+                  v.state     := ACC;
+                  if ( rRd.final ) then
+                     v.busOb.lst := '1';
+                     v.state     := FIN;
+                  end if;
+               else
+                  v.emitIdx   := rRd.emitIdx + 1;
+               end if;
+            end if;
+
+         when AVG  =>
+            -- add an acquisition (one sample per cycle) to the accumulator
+            -- memory; the sum is written back in the following cycle
+            busOb.vld <= '0';
+            rdyIb     <= '0';
+            v.busOb   := rRd.busOb;
+            v.byteCnt := rRd.byteCnt;
+            if ( rdEmp = '0' ) then
+               rdEna     <= '1';
+               v.avgWe   := '1';
+               v.avgWa   := rRd.avgIdx;
+               v.avgFst  := ( rRd.avgCnt = 0 );
+               v.smpA    := rdatA;
+               v.smpB    := rdatB;
+               v.avgIdx  := rRd.avgIdx + 1;
+               if ( ( rdLst = '1' ) or ( rRd.avgIdx = AVG_DEPTH_C - 1 ) ) then
+                  -- discard what does not fit (parameters changed)
+                  v.flush  := not rdLst;
+                  -- release the buffer
+                  v.tgl    := wrTgl;
+                  v.avgLen := rRd.avgIdx;
+                  v.avgIdx := (others => '0');
+                  v.avgCC  := rWrCC;
+                  if ( rRd.avgCnt /= 0 ) then
+                     v.avgCC.ovrA   := rRd.avgCC.ovrA   or rWrCC.ovrA;
+                     v.avgCC.ovrB   := rRd.avgCC.ovrB   or rWrCC.ovrB;
+                     v.avgCC.autTrg := rRd.avgCC.autTrg or rWrCC.autTrg;
+                  end if;
+                  if ( rRd.avgCnt >= parms.navg ) then
+                     v.avgRdy := true;
+                  else
+                     v.avgCnt := rRd.avgCnt + 1;
+                  end if;
+                  v.state  := ECHO;
+               end if;
+            end if;
+
+         when ALD  =>
+            -- the accumulator memory has one cycle of read latency
+            v.state := AOUT;
+
+         when AOUT =>
+            if ( ( rdyOb = '1' ) or ( rRd.busOb.vld = '0' ) ) then
+               v.busOb.dat := accByte( accRdDat, rRd.accIdx );
+               v.busOb.vld := '1';
+               v.busOb.lst := '0';
+               if ( rRd.accIdx = AVG_BYTES_C - 1 ) then
+                  v.accIdx := 0;
+                  if ( rRd.roiEna ) then
+                     v.roiCnt := rRd.roiCnt - 1;
+                  end if;
+                  if ( ( rRd.avgIdx = rRd.avgLen ) or ( rRd.roiEna and ( rRd.roiCnt = 1 ) ) ) then
+                     v.busOb.lst := '1';
+                     v.state     := FIN;
+                  else
+                     v.avgIdx    := rRd.avgIdx + 1;
+                     v.state     := ALD;
+                  end if;
+               else
+                  v.accIdx := rRd.accIdx + 1;
+               end if;
+            end if;
+
+         when FIN  =>
+            if ( rdyOb = '1' ) then -- last byte consumed
+               v.state := ECHO;
+               if ( rRd.avg ) then
+                  -- the average has been read; start over
+                  v.avgIdx := (others => '0');
+                  v.avgCnt := (others => '0');
+                  v.avgRdy := false;
+               else
+                  v.tgl   := wrTgl;
+                  v.flush := rRd.drain;
+                  v.drain := '0';
+               end if;
+            end if;
       end case;
 
       rinRd <= v;
@@ -556,6 +1218,33 @@ begin
       end if;
    end process P_RD_SEQ;
 
+   accRa <= rRd.avgIdx;
+
+   G_AVG : if ( AVG_SUP_C ) generate
+      type   AccArray is array (natural range 0 to AVG_DEPTH_C - 1) of AccWord;
+      signal accMem : AccArray;
+   begin
+
+      P_ACC : process ( busClk ) is
+         variable a : signed(ACC_BITS_C - 1 downto 0);
+         variable b : signed(ACC_BITS_C - 1 downto 0);
+      begin
+         if ( rising_edge( busClk ) ) then
+            if ( rRd.avgWe = '1' ) then
+               a := resize( signed( rRd.smpA ), ACC_BITS_C );
+               b := resize( signed( rRd.smpB ), ACC_BITS_C );
+               if ( not rRd.avgFst ) then
+                  a := a + signed( accRdDat(  ACC_BITS_C - 1 downto          0) );
+                  b := b + signed( accRdDat(2*ACC_BITS_C - 1 downto ACC_BITS_C) );
+               end if;
+               accMem( to_integer( rRd.avgWa ) ) <= std_logic_vector( b ) & std_logic_vector( a );
+            end if;
+            accRdDat <= accMem( to_integer( accRa ) );
+         end if;
+      end process P_ACC;
+
+   end generate G_AVG;
+
    GEN_MEM_ILA : if ( false ) generate
    begin
       U_ILA_MEM : component ILAWrapper
@@ -650,6 +1339,7 @@ begin
    P_TICK : process ( memClk ) is
    begin
       if ( rising_edge( memClk ) ) then
+         tsCounter <= tsCounter + 1;
          -- not absolutely precise timing...
          if ( msTickCounter = 0 ) then
             msTickCounter <= MS_TICK_PERIOD_C - 1;
@@ -662,7 +1352,8 @@ begin
          else
             msTickCounter <= msTickCounter - 1;
          end if;
-         if ( rWr.state = FILL ) then
+         -- (re-)start with every acquisition and segment
+         if ( ( rWr.state = FILL ) or ( rWr.state = TRL ) ) then
            msTimerExpired <= false;
            msTimer        <= lparms.autoTimeMs;
            msTickCounter  <= 0;
@@ -670,7 +1361,7 @@ begin
       end if;
    end process P_TICK;
 
-   P_WR_COMB : process ( rWr, lparms, rTrg, rdTgl, wrFul, wdatA, wdorA, wdatB, wdorB, msTimerExpired ) is
+   P_WR_COMB : process ( rWr, lparms, rTrg, rdTgl, wrFul, wrHld, wdatA, wdorA, wdatB, wdorB, msTimerExpired, tsCounter ) is
       variable v : WrRegType;
       variable a : signed( lparms.lvl'length downto 0 );
       variable s : std_logic;
@@ -679,6 +1370,7 @@ begin
       v         := rWr;
 
       wrDat     <= '0' & wdatB & wdatA;
+      wrGate    <= '0';
 
       if ( lparms.rising ) then
          a := resize( lparms.lvl, a'length ) - signed( resize( lparms.hyst, a'length ) );
@@ -729,8 +1421,30 @@ begin
             if ( not rWr.wasTrg and ( ( ( not rWr.lstTrg and rTrg.trg ) = '1' ) or msTimerExpired ) ) then
                v.wasTrg := true;
                v.autTrg := toSl( msTimerExpired );
+               v.tstamp := tsCounter;
+               if ( rWr.segIdx = 0 ) then
+                  -- extended header
+                  v.seq   := rWr.seq + 1;
+                  v.acqTs := tsCounter;
+               end if;
             end if;
-            if ( v.wasTrg ) then
+            if ( lparms.nsegs /= 0 ) then
+               -- segmented: there are no pre-trigger samples; nothing
+               -- is written until the trigger so that the preceding
+               -- segments are preserved.
+               if ( v.wasTrg ) then
+                  v.segSmpl := rWr.segSmpl + 1;
+                  v.segOvrA := rWr.segOvrA or wdorA;
+                  v.segOvrB := rWr.segOvrB or wdorB;
+                  if ( lparms.nsamples = rWr.segSmpl ) then
+                     v.trlIdx := 0;
+                     v.state  := TRL;
+                  end if;
+               else
+                  wrGate   <= '1';
+                  v.nsmpls := rWr.nsmpls;
+               end if;
+            elsif ( v.wasTrg ) then
                -- lparms.nsamples is the actual number of samples - 1
                -- comparison is ok, this last sample still
                -- is stored and in 'STOP1/2/HOLD' state rWr.nsmpls = nsamples + 1
@@ -742,6 +1456,29 @@ begin
                v.nsmpls := rWr.nsmpls;
             end if;
 
+         when TRL        =>
+            wrDat    <= segTrlWord( rWr, rWr.trlIdx );
+            v.nsmpls := rWr.nsmpls + 1;
+            if ( rWr.trlIdx = SEG_TRL_WORDS_C - 1 ) then
+               -- stop after the last segment or when the next one would
+               -- not fit (rWr.nsmpls + 1 words are stored at this point)
+               if (    ( rWr.segIdx = lparms.nsegs )
+                    or ( resize( rWr.nsmpls, 25 ) + lparms.nsamples + 1 + SEG_TRL_WORDS_C >= ite( lparms.dblBuf, MEM_DEPTH_G/2, MEM_DEPTH_G ) ) ) then
+                  v.state   := STOP1;
+               else
+                  -- re-arm for the next segment
+                  v.state   := RUN;
+                  v.segIdx  := rWr.segIdx + 1;
+                  v.segSmpl := (others => '0');
+                  v.segOvrA := '0';
+                  v.segOvrB := '0';
+                  v.wasTrg  := false;
+                  v.autTrg  := '0';
+               end if;
+            else
+               v.trlIdx := rWr.trlIdx + 1;
+            end if;
+
          when STOP1      =>
             wrDat             <= (others => '0');
             wrDat(wrDat'left) <= '1';
@@ -762,13 +1499,19 @@ begin
             v.tgl    := not rWr.tgl;
 
          when HOLD       =>
-            if ( rdTgl = rWr.tgl ) then
-               v.nsmpls := to_unsigned( 0, v.nsmpls'length );
-               v.state  := FILL;
-               v.wasTrg := false;
-               v.autTrg := '0';
-               v.ovrA   := to_unsigned( 0, v.ovrA'length );
-               v.ovrB   := to_unsigned( 0, v.ovrB'length );
+            -- in ping-pong mode the reader need not be done; it is
+            -- enough for the buffer to have a free half.
+            if ( ( ( rdTgl = rWr.tgl ) or lparms.dblBuf ) and ( wrHld = '0' ) ) then
+               v.nsmpls  := to_unsigned( 0, v.nsmpls'length );
+               v.state   := FILL;
+               v.wasTrg  := false;
+               v.autTrg  := '0';
+               v.ovrA    := to_unsigned( 0, v.ovrA'length );
+               v.ovrB    := to_unsigned( 0, v.ovrB'length );
+               v.segIdx  := (others => '0');
+               v.segSmpl := (others => '0');
+               v.segOvrA := '0';
+               v.segOvrB := '0';
             end if;
       end case;
       rinWr <= v;
@@ -875,6 +1618,14 @@ begin
             rTrg.trg    <= '0';
             rTrg.extTrg <= '0';
          end if;
+         if ( rWr.state = TRL ) then
+            -- re-arm the level trigger for the next segment; the
+            -- external trigger is edge-detected by the writer
+            rTrg.armed  <= false;
+            if ( rWr.parms.src /= EXT ) then
+               rTrg.trg <= '0';
+            end if;
+         end if;
          if ( adcRst = '1' ) then
             rWr         <= WR_REG_INIT_C;
             rTrg        <= TRG_REG_INIT_C;
@@ -888,9 +1639,8 @@ begin
    begin
       bTrg3(0)          <= rRd.byteCnt(rRd.byteCnt'left);
       bTrg3(1)          <= rdyOb;
-      bTrg3(2)          <= '0';
-      bTrg3(4 downto 3) <= std_logic_vector( to_unsigned( RdStateType'pos( rRd.state ), 2 ) );
-      bTrg3(7 downto 5) <= rRd.busOb.dat(7 downto 5);
+      bTrg3(5 downto 2) <= std_logic_vector( to_unsigned( RdStateType'pos( rRd.state ), 4 ) );
+      bTrg3(7 downto 6) <= rRd.busOb.dat(7 downto 6);
 
       U_ILA_REG : component ILAWrapper
          port map (
@@ -1425,6 +2175,9 @@ begin
             wrDat       => wrDat,
             wrFul       => wrFul,
             wrRdy       => sampleBufferReady,
+            wrDbl       => toSl( lparms.dblBuf ),
+            wrHld       => wrHld,
+            wrHlf       => wrHlf,
 
             sdramClk    => sdramClk,
             sdramReq    => sdramReq,
@@ -1434,7 +2187,8 @@ begin
             rdEna       => rdEna,
             rdDat       => rdDat,
             rdEmp       => rdEmp,
-            rdFlush     => rRd.flush
+            rdFlush     => rRd.flush,
+            rdHlf       => rdHlf
          );
    end generate G_DRAMBUF;
 
@@ -1453,6 +2207,9 @@ begin
             wrDat       => wrDat,
             wrFul       => wrFul,
             wrRdy       => sampleBufferReady,
+            wrDbl       => toSl( lparms.dblBuf ),
+            wrHld       => wrHld,
+            wrHlf       => wrHlf,
 
             sdramClk    => sdramClk,
             sdramReq    => sdramReq,
@@ -1462,7 +2219,8 @@ begin
             rdEna       => rdEna,
             rdDat       => rdDat,
             rdEmp       => rdEmp,
-            rdFlush     => rRd.flush
+            rdFlush     => rRd.flush,
+            rdHlf       => rdHlf
          );
    end generate G_BRAMBUF;
 
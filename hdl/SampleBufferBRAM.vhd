@@ -47,6 +47,13 @@ entity SampleBufferBRAM is
       wrDat         : in  std_logic_vector(D_WIDTH_G     downto 0);
       wrFul         : out std_logic := '0'; -- diagnostic signal (unused)
       wrRdy         : out std_logic := '1';
+      -- ping-pong mode: record into one half of the memory while the
+      -- other half is read out (adopted when the next acquisition starts)
+      wrDbl         : in  std_logic := '0';
+      -- writer halted; the next acquisition cannot be recorded yet
+      wrHld         : out std_logic;
+      -- half of the memory being recorded (always '0' unless in ping-pong mode)
+      wrHlf         : out std_logic;
 
       -- UNUSED - for compatibility with SDRAM architecture only
       sdramClk      : in  std_logic    := '0';
@@ -58,7 +65,9 @@ entity SampleBufferBRAM is
       rdEna         : in  std_logic;
       rdDat         : out std_logic_vector(D_WIDTH_G     downto 0);
       rdEmp         : out std_logic;
-      rdFlush       : in  std_logic
+      rdFlush       : in  std_logic;
+      -- half of the memory being read (always '0' unless in ping-pong mode)
+      rdHlf         : out std_logic
    );
 end entity SampleBufferBRAM;
 
@@ -70,27 +79,75 @@ architecture BRAM of SampleBufferBRAM is
    attribute SYN_RAMDECOMP  : string; -- efinity; try to force 10 bit-width into 5k
 
    constant MEM_DEPTH_C     : natural := ite( MEM_DEPTH_G = 0, 2**A_WIDTH_G, MEM_DEPTH_G );
+   constant HALF_DEPTH_C    : natural := MEM_DEPTH_C / 2;
 
    constant NUM_ADDR_BITS_C : natural := numBits(MEM_DEPTH_C - 1);
 
    subtype  RamAddr         is unsigned(NUM_ADDR_BITS_C - 1 downto 0);
+   -- one extra bit; holds MEM_DEPTH_C
+   subtype  RamCnt          is unsigned(NUM_ADDR_BITS_C     downto 0);
    subtype  RamWord         is std_logic_vector(D_WIDTH_G - 1 downto 0);
    type     RamArray        is array(MEM_DEPTH_C - 1 downto 0) of RamWord;
 
+   -- per half of the memory (ping-pong mode); a single acquisition
+   -- which occupies the entire memory is accounted for in half 0.
+   type     RamAddrArray    is array(0 to 1) of RamAddr;
+
    constant END_ADDR_C      : RamAddr := to_unsigned( MEM_DEPTH_C - 1, RamAddr'length );
 
+   function idx(constant h : in std_logic) return natural is
+   begin
+      if ( h = '1' ) then return 1; else return 0; end if;
+   end function idx;
+
+   -- first address of the ring buffer holding half 'h'
+   function ringBase(constant h : in std_logic; constant dbl : in std_logic) return RamAddr is
+   begin
+      if ( ( h and dbl ) = '1' ) then
+         return to_unsigned( HALF_DEPTH_C, RamAddr'length );
+      end if;
+      return to_unsigned( 0, RamAddr'length );
+   end function ringBase;
+
+   -- last address of the ring buffer holding half 'h'
+   function ringLast(constant h : in std_logic; constant dbl : in std_logic) return RamAddr is
+   begin
+      if ( ( not h and dbl ) = '1' ) then
+         return to_unsigned( HALF_DEPTH_C - 1, RamAddr'length );
+      end if;
+      return END_ADDR_C;
+   end function ringLast;
+
+   function ringSize(constant dbl : in std_logic) return RamCnt is
+   begin
+      if ( dbl = '1' ) then
+         return to_unsigned( HALF_DEPTH_C, RamCnt'length );
+      end if;
+      return to_unsigned( MEM_DEPTH_C, RamCnt'length );
+   end function ringSize;
+
    type     WrStateType     is (WRITE, NSMPLS_HI, HALT);
 
    type WrRegType   is record
       state       : WrStateType;
-      nsmpl       : RamAddr;
-      tgl         : std_logic;
+      -- half being recorded and ping-pong mode of the current acquisition
+      hlf         : std_logic;
+      dbl         : std_logic;
+      -- per half; stable while the reader owns the half
+      nsmpl       : RamAddrArray;
+      wend        : RamAddrArray;
+      hdbl        : std_logic_vector(1 downto 0);
+      tgl         : std_logic_vector(1 downto 0);
    end record WrRegType;
 
    constant WR_REG_INIT_C   : WrRegType := (
       state       => WRITE,
-      nsmpl       => (others => '0'),
-      tgl         => '0'
+      hlf         => '0',
+      dbl         => '0',
+      nsmpl       => (others => (others => '0')),
+      wend        => (others => (others => '0')),
+      hdbl        => (others => '0'),
+      tgl         => (others => '0')
    );
 
    type     RdStateType     is (WAITRD, PRELD, READ);
@@ -99,29 +156,42 @@ architecture BRAM of SampleBufferBRAM is
       state       : RdStateType;
       raddr       : RamAddr;
       rdata       : RamWord;
-      tgl         : std_logic;
+      -- half being read (or to be read next) and its layout
+      hlf         : std_logic;
+      dbl         : std_logic;
+      wend        : RamAddr;
+      tgl         : std_logic_vector(1 downto 0);
    end record RdRegType;
 
    constant RD_REG_INIT_C   : RdRegType := (
       state       => WAITRD,
       raddr       => (others => '0'),
       rdata       => (others => 'X'),
-      tgl         => '0'
+      hlf         => '0',
+      dbl         => '0',
+      wend        => (others => '0'),
+      tgl         => (others => '0')
    );
 
    signal rWr               : WrRegType := WR_REG_INIT_C;
    signal rWrIn             : WrRegType;
 
    signal waddr             : RamAddr := (others => '0');
+   -- restart writing at 'wrLdAddr' (ping-pong mode)
+   signal wrLd              : std_logic;
+   signal wrLdAddr          : RamAddr;
 
-   -- while the write is halted the reader may access
+   -- while a half is owned by the reader the reader may access
    -- these signals (-> false path)
-   signal waddrCC           : RamAddr := (others => '0');
-   attribute KEEP           of waddrCC : signal is "TRUE";
-   attribute SYN_KEEP       of waddrCC : signal is true;
-   signal nsmplCC           : RamAddr := (others => '0');
+   signal wendCC            : RamAddrArray := (others => (others => '0'));
+   attribute KEEP           of wendCC  : signal is "TRUE";
+   attribute SYN_KEEP       of wendCC  : signal is true;
+   signal nsmplCC           : RamAddrArray := (others => (others => '0'));
    attribute KEEP           of nsmplCC : signal is "TRUE";
    attribute SYN_KEEP       of nsmplCC : signal is true;
+   signal hdblCC            : std_logic_vector(1 downto 0) := (others => '0');
+   attribute KEEP           of hdblCC  : signal is "TRUE";
+   attribute SYN_KEEP       of hdblCC  : signal is true;
 
    signal DPRAMD            : RamArray;
    -- efinitiy: try to force using 10-bit wide 5k blocks (assuming 10-bit ADC);
@@ -141,64 +211,101 @@ architecture BRAM of SampleBufferBRAM is
    signal rRdIn             : RdRegType;
    signal rdLst             : std_logic;
 
-   signal wrTglSync         : std_logic;
-   signal rdTglSync         : std_logic;
+   signal wrTglSync         : std_logic_vector(1 downto 0);
+   signal rdTglSync         : std_logic_vector(1 downto 0);
 
 begin
 
+   assert MEM_DEPTH_C mod 2 = 0 report "Ping-pong mode requires an even memory depth" severity failure;
+
    -- EFINITY BUG (2025.1) the mere tie-off of wrRdy (above := '1') was not
    -- propagated out, resulting wrEn to be permanently disabled which led
    -- to the block ram not being inferred correctly!
    wrRdy <= '1';
    wrFul <= '0'; -- diagnostic signal (unused)
+   wrHld <= '1' when rWr.state = HALT else '0';
+   wrHlf <= rWr.hlf;
 
+   -- one handshake per half; the halves are released independently
    U_WR_SYNC : entity work.SynchronizerBit
+      generic map (
+         WIDTH_G   => 2
+      )
       port map (
          clk       => wrClk,
          rst       => '0',
-         datInp(0) => rRd.tgl, 
-         datOut(0) => rdTglSync
+         datInp    => rRd.tgl,
+         datOut    => rdTglSync
       );
 
    U_RD_SYNC : entity work.SynchronizerBit
+      generic map (
+         WIDTH_G   => 2
+      )
       port map (
          clk       => rdClk,
          rst       => '0',
-         datInp(0) => rWr.tgl, 
-         datOut(0) => wrTglSync
+         datInp    => rWr.tgl,
+         datOut    => wrTglSync
       );
 
-   P_COMB_WR : process ( rWr, wrEna, wrDat, rdTglSync ) is
+   P_COMB_WR : process ( rWr, wrEna, wrDat, wrDbl, waddr, rdTglSync ) is
       variable v : WrRegType;
+      variable h : natural range 0 to 1;
    begin
       v           := rWr;
+      h           := idx( rWr.hlf );
 
       memWriteEna <= '0';
+      wrLd        <= '0';
+      wrLdAddr    <= ringBase( not rWr.hlf, '1' );
 
       case ( rWr.state ) is
          when WRITE =>
             if ( ( wrDat(wrDat'left) and wrEna ) = '1' ) then
                if ( RamAddr'length >= 16 ) then
-                  v.nsmpl (15 downto 0) := unsigned( wrDat(15 downto 0) );
+                  v.nsmpl(h)(15 downto 0) := unsigned( wrDat(15 downto 0) );
                else
-                  v.nsmpl               := unsigned( wrDat( v.nsmpl'range ) );
+                  v.nsmpl(h)              := unsigned( wrDat( RamAddr'range ) );
                end if;
                v.state     := NSMPLS_HI;
             else
                memWriteEna <= wrEna;
+               if ( ( ( rWr.dbl and not wrDbl ) = '1' ) and ( rdTglSync = rWr.tgl ) ) then
+                  -- leaving ping-pong mode; extend the ring to the entire
+                  -- memory (once the reader is idle) so that the acquisition
+                  -- in progress may use it. Entering ping-pong mode has to
+                  -- wait for the end of the acquisition.
+                  v.dbl    := '0';
+                  v.hlf    := '0';
+               end if;
             end if;
 
          when NSMPLS_HI =>
             if ( wrEna = '1' ) then
                if ( RamAddr'length > 16 ) then
-                  v.nsmpl(v.nsmpl'left downto 16) := unsigned( wrDat( RamAddr'length - 16 - 1 downto 0 ) );
+                  v.nsmpl(h)(RamAddr'left downto 16) := unsigned( wrDat( RamAddr'length - 16 - 1 downto 0 ) );
                end if;
-               v.tgl       := not rWr.tgl;
+               v.wend(h)   := waddr;
+               v.hdbl(h)   := rWr.dbl;
+               v.tgl(h)    := not rWr.tgl(h);
                v.state     := HALT;
             end if;
 
          when HALT =>
-            if ( rdTglSync = rWr.tgl ) then
+            if ( ( wrDbl and rWr.dbl ) = '1' ) then
+               -- ping-pong; proceed as soon as the other half is free
+               if ( rdTglSync( idx( not rWr.hlf ) ) = rWr.tgl( idx( not rWr.hlf ) ) ) then
+                  v.hlf   := not rWr.hlf;
+                  wrLd    <= '1';
+                  v.state := WRITE;
+               end if;
+            elsif ( rdTglSync = rWr.tgl ) then
+               -- entire memory free
+               v.dbl   := wrDbl;
+               v.hlf   := '0';
+               wrLd     <= wrDbl;
+               wrLdAddr <= ringBase( '0', '1' );
                v.state := WRITE;
             end if;
       end case;
@@ -209,10 +316,16 @@ begin
    rdata   <= DPRAMD( to_integer( rRd.raddr ) );
 
    nsmplCC <= rWr.nsmpl;
-   waddrCC <= waddr;
+   wendCC  <= rWr.wend;
+   hdblCC  <= rWr.hdbl;
 
-   P_COMB_RD : process ( rRd, rdEna, nsmplCC, waddrCC, wrTglSync, rdata, rdFlush ) is
+   P_COMB_RD : process ( rRd, rdEna, nsmplCC, wendCC, hdblCC, wrTglSync, rdata, rdFlush ) is
       variable v : RdRegType;
+      variable h : std_logic;
+      variable w : RamCnt;
+      variable n : RamCnt;
+      variable s : RamCnt;
+      variable a : RamCnt;
    begin
       v        := rRd;
       rdEmp    <= '1';
@@ -220,24 +333,35 @@ begin
 
       case ( rRd.state ) is
          when WAITRD =>
-            if ( wrTglSync /= rRd.tgl ) then
-               v.raddr := waddrCC - nsmplCC;
-               -- simulator complains that MEM_DEPTH_C overflows
-               -- which is the case if it's a power of two. This
-               -- doesn't matter but we want to avoid the warning.
-               if ( 2**NUM_ADDR_BITS_C > MEM_DEPTH_C ) then
-                  if    ( nsmplCC >= MEM_DEPTH_C ) then
-                     v.raddr := waddrCC;
-                  elsif ( nsmplCC > waddrCC ) then 
-                     v.raddr := waddrCC - nsmplCC + MEM_DEPTH_C;
-                  end if;
+            -- if both halves are full then the one expected next is older
+            h := rRd.hlf;
+            if ( wrTglSync( idx( h ) ) = rRd.tgl( idx( h ) ) ) then
+               h := not h;
+            end if;
+            if ( wrTglSync( idx( h ) ) /= rRd.tgl( idx( h ) ) ) then
+               v.hlf   := h;
+               v.dbl   := hdblCC( idx( h ) );
+               v.wend  := wendCC( idx( h ) );
+               -- read the last 'nsmpl' words preceding the write pointer
+               -- (wrapping within the ring holding this half)
+               w       := resize( wendCC ( idx( h ) ), RamCnt'length );
+               n       := resize( nsmplCC( idx( h ) ), RamCnt'length );
+               s       := ringSize( v.dbl );
+               if    ( ( n = 0 ) or ( n >= s ) ) then
+                  -- nsmpl = 0: MEM_DEPTH_C overflowed RamAddr
+                  a    := w;
+               elsif ( n > w - resize( ringBase( h, v.dbl ), RamCnt'length ) ) then
+                  a    := w + s - n;
+               else
+                  a    := w - n;
                end if;
+               v.raddr := a( RamAddr'range );
                v.state := PRELD;
             end if;
 
          when PRELD =>
-            if ( rRd.raddr = END_ADDR_C ) then
-               v.raddr := (others => '0');
+            if ( rRd.raddr = ringLast( rRd.hlf, rRd.dbl ) ) then
+               v.raddr := ringBase( rRd.hlf, rRd.dbl );
             else
                v.raddr := rRd.raddr + 1;
             end if;
@@ -247,14 +371,15 @@ begin
          when READ  =>
             rdEmp   <= '0';
             if ( (rdFlush or rdEna) = '1' ) then
-               if ( (rRd.raddr = waddrCC) or (rdFlush = '1') ) then
+               if ( (rRd.raddr = rRd.wend) or (rdFlush = '1') ) then
                   -- done (doesn't matter if we read the next item)
-                  v.state := WAITRD;
-                  v.tgl   := not rRd.tgl;
+                  v.state             := WAITRD;
+                  v.tgl(idx(rRd.hlf)) := not rRd.tgl(idx(rRd.hlf));
+                  v.hlf               := not rRd.hlf;
                   rdLst   <= '1';
                end if;
-               if ( rRd.raddr = END_ADDR_C ) then
-                  v.raddr := (others => '0');
+               if ( rRd.raddr = ringLast( rRd.hlf, rRd.dbl ) ) then
+                  v.raddr := ringBase( rRd.hlf, rRd.dbl );
                else
                   v.raddr := rRd.raddr + 1;
                end if;
@@ -276,10 +401,12 @@ begin
    P_WR_RAM : process ( wrClk ) is
    begin
       if ( rising_edge( wrClk ) ) then
-         if ( memWriteEna = '1' ) then
+         if ( wrLd = '1' ) then
+            waddr                         <= wrLdAddr;
+         elsif ( memWriteEna = '1' ) then
             DPRAMD( to_integer( waddr ) ) <= wrDat( D_WIDTH_G - 1 downto 0 );
-            if ( waddr = END_ADDR_C ) then
-               waddr                      <= (others => '0');
+            if ( waddr = ringLast( rWr.hlf, rWr.dbl ) ) then
+               waddr                      <= ringBase( rWr.hlf, rWr.dbl );
             else
                waddr                      <= waddr + 1;
             end if;
@@ -295,5 +422,6 @@ begin
    end process P_SEQ_RD;
 
    rdDat <= rdLst & rRd.rdata;
+   rdHlf <= rRd.hlf;
 
 end architecture BRAM;
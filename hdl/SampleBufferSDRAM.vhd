@@ -63,6 +63,11 @@ entity SampleBufferSDRAM is
       wrFul         : out std_logic; -- diagnostic signal
       -- buffer ready / init done
       wrRdy         : out std_logic;
+      -- UNUSED - ping-pong mode is not supported; the single SDRAM port
+      -- cannot record and read back at the same time.
+      wrDbl         : in  std_logic := '0';
+      wrHld         : out std_logic := '0';
+      wrHlf         : out std_logic := '0';
 
       -- sdram interface
       sdramClk      : in  std_logic;
@@ -74,7 +79,8 @@ entity SampleBufferSDRAM is
       rdEna         : in  std_logic;
       rdDat         : out std_logic_vector(D_WIDTH_G     downto 0);
       rdEmp         : out std_logic;
-      rdFlush       : in  std_logic
+      rdFlush       : in  std_logic;
+      rdHlf         : out std_logic := '0'
    );
 end entity SampleBufferSDRAM;
 
@@ -449,6 +455,10 @@ end if;
       end if;
    end process P_SEQ;
 
+   wrHld          <= '0';
+   wrHlf          <= '0';
+   rdHlf          <= '0';
+
    sdramReq.req   <= r.sdramReq;
    sdramReq.rdnwr <= r.sdramRdnwr;
    sdramReq.wdat  <= r.sdramWDat;
@@ -105,7 +105,9 @@ use     work.SDRAMBufPkg.all;
 
 entity SampleBufferTbNotbound is
    generic  (
-      SAMPLE_WIDTH_G : natural := 20
+      SAMPLE_WIDTH_G : natural := 20;
+      -- test ping-pong mode (not supported by the SDRAM buffer)
+      DBL_G          : boolean := false
    );
 end entity SampleBufferTbNotbound;
 
@@ -127,6 +129,11 @@ architecture sim of SampleBufferTbNotbound is
    signal   rdDat    : std_logic_vector(DW_C downto 0);
    signal   rdEmp    : std_logic;
 
+   signal   wrDbl    : std_logic := '0';
+   signal   wrHld    : std_logic;
+   signal   wrHlf    : std_logic;
+   signal   rdHlf    : std_logic;
+
    signal   run      : boolean   := true;
 
    signal   reader   : boolean   := false;
@@ -224,6 +231,9 @@ architecture sim of SampleBufferTbNotbound is
          -- msb is 'command' flag
          wrDat         : in  std_logic_vector(D_WIDTH_G     downto 0);
          wrFul         : out std_logic := '0'; -- diagnostic signal (unused)
+         wrDbl         : in  std_logic := '0';
+         wrHld         : out std_logic;
+         wrHlf         : out std_logic;
    
          -- UNUSED - for compatibility with SDRAM architecture only
          sdramClk      : in  std_logic    := '0';
@@ -235,7 +245,8 @@ architecture sim of SampleBufferTbNotbound is
          rdEna         : in  std_logic;
          rdDat         : out std_logic_vector(D_WIDTH_G     downto 0);
          rdEmp         : out std_logic;
-         rdFlush       : in  std_logic
+         rdFlush       : in  std_logic;
+         rdHlf         : out std_logic
       );
    end component SampleBuffer;
 
@@ -276,6 +287,16 @@ begin
          wtick;
          while ( writer /= reader ) loop wtick; end loop;
       end procedure flipSync;
+
+      procedure waitWrite(constant hlf : in std_logic) is
+      begin
+         for i in 1 to 1000 loop
+            exit when wrHld = '0';
+            wtick;
+         end loop;
+         assert wrHld = '0' report "writer stuck" severity failure;
+         assert wrHlf = hlf report "writer recording the wrong half" severity failure;
+      end procedure waitWrite;
    begin
       wtick; wtick;
       for i in 1 to 10 loop
@@ -284,11 +305,48 @@ begin
             flipSync;
          end loop;
       end loop;
+      if ( DBL_G ) then
+         -- ping-pong mode is adopted when the acquisition in progress ends
+         wrDbl <= '1';
+         snd( wrDat, wrEna, 2000, 5, 5 );
+         flipSync;
+         waitWrite( '0' );
+         -- the other half is free; no need to wait for the reader
+         snd( wrDat, wrEna, 3000, 8, 8 );
+         waitWrite( '1' );
+         -- record (wrapping within half 1) while half 0 is read
+         writer <= not writer;
+         snd( wrDat, wrEna, 4000, 10, 7 );
+         assert wrHld = '1' report "writer did not wait for the reader to release half 0" severity failure;
+         waitWrite( '0' );
+         -- record (wrapping within half 0) while half 1 is read
+         snd( wrDat, wrEna, 5000, 11, 5 );
+         -- back to a single buffer once the reader is done
+         wrDbl <= '0';
+         flipSync;
+         waitWrite( '0' );
+         for i in 1 to 4 loop wtick; end loop;
+         -- uses the entire memory again
+         snd( wrDat, wrEna, 6000, 14, 14 );
+         flipSync;
+      end if;
       run <= false;
       wait;
    end process P_DRV;
 
    P_RD : process is
+      procedure rcvHlf(
+         constant hlf : in    std_logic;
+         constant pre : in    natural;
+         constant fil : in    natural;
+         constant nrd : in    natural
+      ) is
+      begin
+         while ( rdEmp = '1' ) loop rtick; end loop;
+         assert rdHlf = hlf report "reading the wrong half" severity failure;
+         rcv( rdEna, pre, fil, nrd );
+         report "PING-PONG: " & integer'image(pre) & " PASSED";
+      end procedure rcvHlf;
    begin
       for i in 1 to 10 loop
          for j in 1 to i loop
@@ -298,6 +356,21 @@ begin
             rtick;
          end loop;
       end loop;
+      if ( DBL_G ) then
+         rcvHlf( '0', 2000,  5,  5 );
+         reader <= writer;
+         rtick;
+         -- read half 0 while the writer records into half 1
+         while ( reader = writer ) loop rtick; end loop;
+         rcvHlf( '0', 3000,  8,  8 );
+         rcvHlf( '1', 4000, 10,  7 );
+         rcvHlf( '0', 5000, 11,  5 );
+         reader <= writer;
+         rtick;
+         rcvHlf( '0', 6000, 14, 14 );
+         reader <= writer;
+         rtick;
+      end if;
       wait;
    end process P_RD;
 
@@ -328,6 +401,9 @@ begin
          wrDat         => wrDat,
          wrFul         => wrFul,
          wrRdy         => open,
+         wrDbl         => wrDbl,
+         wrHld         => wrHld,
+         wrHlf         => wrHlf,
 
          -- sdram interface
          sdramClk      => ramClk,
@@ -339,7 +415,8 @@ begin
          rdEna         => rdEna,
          rdDat         => rdDat,
          rdEmp         => rdEmp,
-         rdFlush       => '0'
+         rdFlush       => '0',
+         rdHlf         => rdHlf
       );
   
 end architecture sim;
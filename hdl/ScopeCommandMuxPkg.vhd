@@ -42,6 +42,8 @@ package ScopeCommandMuxPkg is
    constant CMD_ADC_MEMORY_C  : std_logic_vector(7 downto 0) := x"05";
    -- Scope parameters
    constant CMD_ACQ_PARAMS_C  : std_logic_vector(7 downto 0) := x"06";
+   -- I2C master (transaction level)
+   constant CMD_I2C_C         : std_logic_vector(7 downto 0) := x"07";
 
    subtype  SubCommandAcqType is std_logic_vector(1 downto 0);
    constant CMD_ACQ_READ_C    : SubCommandAcqType := SubCommandAcqType( to_unsigned( 0, SubCommandAcqType'length ) );
@@ -54,6 +56,35 @@ package ScopeCommandMuxPkg is
    function subCommandAcqGet(constant cmd : std_logic_vector(7 downto 0))
       return SubCommandAcqType;
 
+   -- modifier of CMD_ACQ_READ_C: hold the reply until the acquisition
+   -- is complete (or a timeout expires)
+   constant CMD_ACQ_WAIT_BIT_C : natural := NUM_CMD_BITS_C + SubCommandAcqType'length;
+
+   function subCommandAcqWait(constant cmd : std_logic_vector(7 downto 0))
+      return boolean;
+
+   -- modifier of CMD_ACQ_READ_C: the command is followed by the
+   -- (little-endian, 32-bit) index of the first sample and the
+   -- number of samples (0: up to the end) to read. An optional third
+   -- parameter, the bucket size, selects peak-detect mode if > 1: for
+   -- each bucket the minimum and the maximum (of both channels) are
+   -- returned as two consecutive samples. An optional fourth parameter
+   -- holds option flags; bit 0 requests the extended header (sequence
+   -- number and trigger timestamp follow the ordinary header); bit 1
+   -- requests packed samples (the bits of both channels' RAM words,
+   -- channel A first, are concatenated LSB-first and transferred as
+   -- a little-endian bit stream; the last byte is zero-padded). Peak-
+   -- detect mode ignores bit 1.
+   -- In averaging mode (see 'navg' in AcqCtlPkg) a read returns the
+   -- sums of both channels (32-bit, little-endian, channel A first)
+   -- once the requested number of acquisitions has been accumulated;
+   -- header bit 10 is set. Peak-detect and packing are not available.
+   -- Modifier of CMD_ACQ_MSIZE_C: append a byte of extended flags.
+   constant CMD_ACQ_RANGE_BIT_C : natural := CMD_ACQ_WAIT_BIT_C + 1;
+
+   function subCommandAcqRange(constant cmd : std_logic_vector(7 downto 0))
+      return boolean;
+
    subtype SubCommandAcqParmType is std_logic_vector(1 downto 0);
 
    constant CMD_PRM_SET_GET   : SubCommandAcqParmType := SubCommandAcqParmType( to_unsigned( 0, SubCommandAcqParmType'length ) );
@@ -70,6 +101,16 @@ package body ScopeCommandMuxPkg is
       return SubCommandAcqType( cmd(NUM_CMD_BITS_C + SubCommandAcqType'length - 1 downto NUM_CMD_BITS_C) );
    end function subCommandAcqGet;
 
+   function subCommandAcqWait(constant cmd : std_logic_vector(7 downto 0)) return boolean is
+   begin
+      return cmd( CMD_ACQ_WAIT_BIT_C ) = '1';
+   end function subCommandAcqWait;
+
+   function subCommandAcqRange(constant cmd : std_logic_vector(7 downto 0)) return boolean is
+   begin
+      return cmd( CMD_ACQ_RANGE_BIT_C ) = '1';
+   end function subCommandAcqRange;
+
    function subCommandAcqParmGet(constant cmd : in std_logic_vector (7 downto 0))
       return SubCommandAcqParmType is
    begin
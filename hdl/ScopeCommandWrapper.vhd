@@ -39,6 +39,7 @@ use work.GenRegPkg.all;
 entity ScopeCommandWrapper is
    generic (
       I2C_SCL_G                : integer := -1;        -- index of I2C SCL (to handle clock stretching)
+      I2C_SDA_G                : integer := -1;        -- index of I2C SDA (required by the I2C command)
       BBO_INIT_G               : std_logic_vector(7 downto 0) := x"FF";
       I2C_FREQ_G               : real    := 100.0E3;
       FIFO_FREQ_G              : real;
@@ -55,6 +56,10 @@ entity ScopeCommandWrapper is
       MEM_DEPTH_G              : natural := 1024;
       SDRAM_ADDR_WIDTH_G       : natural := 0;
       USE_SDRAM_BUF_G          : boolean := false;
+      -- averaging mode: depth of the accumulator memory (0: disabled)
+      -- and log2 of the max. number of averaged acquisitions
+      AVG_DEPTH_G              : natural := 0;
+      AVG_LD_MAX_G             : natural := 8;
       COMMA_G                  : std_logic_vector(7 downto 0) := x"CA";
       ESCAP_G                  : std_logic_vector(7 downto 0) := x"55";
       DISABLE_DECIMATORS_G     : boolean := false;
@@ -65,6 +70,8 @@ entity ScopeCommandWrapper is
       HAVE_BB_CMD_G            : boolean := true;
       HAVE_REG_CMD_G           : boolean := true;
       HAVE_ADC_CMD_G           : boolean := true;
+      -- I2C master command; only available if I2C_SCL_G and I2C_SDA_G are valid
+      HAVE_I2C_CMD_G           : boolean := true;
       -- registers are in other, asynchronous clock domain
       REG_ASYNC_G              : boolean := false
    );
@@ -134,6 +141,7 @@ architecture rtl of ScopeCommandWrapper is
    constant CMD_BB_IDX_C      : natural := to_integer(unsigned(CMD_BITBANG_C   ));
    constant CMD_ADC_MEM_IDX_C : natural := to_integer(unsigned(CMD_ADC_MEMORY_C));
    constant CMD_ACQ_PRM_IDX_C : natural := to_integer(unsigned(CMD_ACQ_PARAMS_C));
+   constant CMD_I2C_IDX_C     : natural := to_integer(unsigned(CMD_I2C_C       ));
 
    type CmdListType is array(natural range <>) of CmdIdxRangeType;
 
@@ -141,7 +149,8 @@ architecture rtl of ScopeCommandWrapper is
       CMD_APP_REG_IDX_C,
       CMD_BB_IDX_C,
       CMD_ADC_MEM_IDX_C,
-      CMD_ACQ_PRM_IDX_C
+      CMD_ACQ_PRM_IDX_C,
+      CMD_I2C_IDX_C
    );
 
    function max(constant x: CmdListType) return CmdIdxRangeType is
@@ -163,6 +172,9 @@ architecture rtl of ScopeCommandWrapper is
       v(CMD_BB_IDX_C     ) := HAVE_BB_CMD_G;
       v(CMD_ADC_MEM_IDX_C) := HAVE_ADC_CMD_G;
       v(CMD_ACQ_PRM_IDX_C) := HAVE_ADC_CMD_G;
+      v(CMD_I2C_IDX_C    ) := HAVE_I2C_CMD_G
+                              and ( I2C_SCL_G >= 0 and I2C_SCL_G < 8 )
+                              and ( I2C_SDA_G >= 0 and I2C_SDA_G < 8 );
       return v;
    end function CMDS_SUPPORTED_F;
 
@@ -181,6 +193,10 @@ architecture rtl of ScopeCommandWrapper is
    signal   acqParmsTgl       : std_logic      := '0';
    signal   acqParmsAck       : std_logic;
 
+   signal   bboBB             : std_logic_vector(7 downto 0) := BBO_INIT_G;
+   signal   i2cScl            : std_logic := '1';
+   signal   i2cSda            : std_logic := '1';
+
 begin
 
    U_BASIC_CMDS : entity work.CommandWrapper
@@ -249,21 +265,64 @@ begin
             rOb          => readysOb(CMD_BB_IDX_C),
 
             bbi          => bbi,
-            bbo          => bbo,
+            bbo          => bboBB,
             subCmd       => subCmdBB
          );
    end generate G_BITBANG;
 
+   G_I2C : if ( CMDS_SUPPORTED_C(CMD_I2C_IDX_C) ) generate
+
+      U_I2C : entity work.CommandI2c
+         generic map (
+            CLOCK_FREQ_G => FIFO_FREQ_G,
+            I2C_FREQ_G   => I2C_FREQ_G
+         )
+         port map (
+            clk          => clk,
+            rst          => rst,
+
+            mIb          => bussesIb(CMD_I2C_IDX_C),
+            rIb          => readysIb(CMD_I2C_IDX_C),
+
+            mOb          => bussesOb(CMD_I2C_IDX_C),
+            rOb          => readysOb(CMD_I2C_IDX_C),
+
+            sclInp       => bbi(I2C_SCL_G),
+            sclOut       => i2cScl,
+            sdaInp       => bbi(I2C_SDA_G),
+            sdaOut       => i2cSda
+         );
+
+      -- open-drain lines; the bit-bang interface and the i2c master
+      -- release them (drive '1') while idle.
+      P_BBO : process ( bboBB, i2cScl, i2cSda ) is
+         variable v : std_logic_vector(7 downto 0);
+      begin
+         v            := bboBB;
+         v(I2C_SCL_G) := bboBB(I2C_SCL_G) and i2cScl;
+         v(I2C_SDA_G) := bboBB(I2C_SDA_G) and i2cSda;
+         bbo          <= v;
+      end process P_BBO;
+
+   end generate G_I2C;
+
+   G_NO_I2C : if ( not CMDS_SUPPORTED_C(CMD_I2C_IDX_C) ) generate
+      bbo <= bboBB;
+   end generate G_NO_I2C;
+
    G_ADC : if ( CMDS_SUPPORTED_C( CMD_ADC_MEM_IDX_C ) ) generate
       U_ADC_BUF : entity work.MaxAdc
          generic map (
             ADC_CLOCK_FREQ_G     => ADC_FREQ_G,
+            BUS_CLOCK_FREQ_G     => FIFO_FREQ_G,
             MEM_DEPTH_G          => MEM_DEPTH_G,
             ADC_BITS_G           => ADC_BITS_G,
             RAM_BITS_G           => RAM_BITS_G,
             DISABLE_DECIMATORS_G => DISABLE_DECIMATORS_G,
             SDRAM_ADDR_WIDTH_G   => SDRAM_ADDR_WIDTH_G,
-            USE_SDRAM_BUF_G      => USE_SDRAM_BUF_G
+            USE_SDRAM_BUF_G      => USE_SDRAM_BUF_G,
+            AVG_DEPTH_G          => AVG_DEPTH_G,
+            AVG_LD_MAX_G         => AVG_LD_MAX_G
          )
          port map (
             adcClk       => adcClk,
@@ -302,7 +361,10 @@ begin
       U_ACQ_PARMS : entity work.CommandAcqParm
          generic map (
             CLOCK_FREQ_G => FIFO_FREQ_G,
-            MEM_DEPTH_G  => MEM_DEPTH_G
+            MEM_DEPTH_G  => MEM_DEPTH_G,
+            DBL_BUF_G    => not USE_SDRAM_BUF_G,
+            AVG_DEPTH_G  => AVG_DEPTH_G,
+            AVG_MAX_G    => 2**AVG_LD_MAX_G
          )
          port map (
             clk          => clk,
@@ -29,6 +29,10 @@ use     ieee.std_logic_1164.all;
 use     ieee.numeric_std.all;
 
 entity SimPty is
+   generic (
+      -- max. number of octets moved per call into the C layer
+      BURST_G : positive := 64
+   );
    port (
       clk    : in  std_logic;
       vldOb  : out std_logic;
@@ -46,62 +50,62 @@ end entity SimPty;
 
 architecture sim of SimPty is
 
-   procedure readPtyPoll_C(
-      variable vld : out integer;
-      variable dat : out integer
-   );
+   type IntArray is array (natural range 0 to BURST_G - 1) of integer;
 
-   procedure writePty_C(
-      variable vld : out integer;
-      constant dat : in  integer
+   procedure readPtyBurst_C(
+      variable cnt : out integer;
+      variable dat : out IntArray;
+      constant max : in  integer
    );
 
-   procedure writePtyPoll_C(
-      variable rdy : out integer
+   procedure writePtyBurst_C(
+      variable acc : out integer;
+      variable pnd : out integer;
+      constant dat : in  IntArray;
+      constant cnt : in  integer;
+      constant flu : in  integer
    );
 
+   attribute foreign of readPtyBurst_C  : procedure is "VHPIDIRECT readPtyBurst_C";
+   attribute foreign of writePtyBurst_C : procedure is "VHPIDIRECT writePtyBurst_C";
 
-   attribute foreign of readPtyPoll_C  : procedure is "VHPIDIRECT readPtyPoll_C";
-   attribute foreign of writePty_C     : procedure is "VHPIDIRECT writePty_C";
-   attribute foreign of writePtyPoll_C : procedure is "VHPIDIRECT writePtyPoll_C";
-
-   procedure readPtyPoll_C(
-      variable vld : out integer;
-      variable dat : out integer
-   ) is
-   begin
-     assert false report "should not be executed" severity failure;
-   end procedure readPtyPoll_C;
-
-   procedure writePty_C(
-      variable vld : out integer;
-      constant dat : in  integer
+   procedure readPtyBurst_C(
+      variable cnt : out integer;
+      variable dat : out IntArray;
+      constant max : in  integer
    ) is
    begin
      assert false report "should not be executed" severity failure;
-   end procedure writePty_C;
-
-   procedure writePtyPoll_C(
-      variable rdy : out integer
+   end procedure readPtyBurst_C;
+
+   procedure writePtyBurst_C(
+      variable acc : out integer;
+      variable pnd : out integer;
+      constant dat : in  IntArray;
+      constant cnt : in  integer;
+      constant flu : in  integer
    ) is
    begin
      assert false report "should not be executed" severity failure;
-   end procedure writePtyPoll_C;
-
+   end procedure writePtyBurst_C;
 
    signal rdDat : std_logic_vector(7 downto 0);
    signal rdVld : std_logic := '0';
    signal rdAb  : std_logic := '0';
 
-   signal wrRdy : std_logic := '0';
+   signal wrRdy : std_logic := '1';
    signal wrAb  : std_logic := '0';
 
 begin
 
+   -- fetch a burst of octets when the local buffer is exhausted
+   -- and hand them out one per cycle.
    P_RD : process ( clk ) is
       variable vld : std_logic;
-      variable vi  : integer;
-      variable di  : integer;
+      variable cnt : integer;
+      variable buf : IntArray;
+      variable idx : natural := 0;
+      variable lst : natural := 0;
    begin
       if ( rising_edge( clk ) ) then
          vld := rdVld;
@@ -112,49 +116,72 @@ begin
             vld := '0';
          end if;
          if ( vld = '0' ) then
-            readPtyPoll_C( vi, di );
-            if ( vi > 0 ) then
-report "Updating data "&integer'image(di);
-               rdDat <= std_logic_vector( to_unsigned( di, 8 ) );
-               vld := '1';
-            elsif ( vi < 0 ) then
-               rdAb <= '1';
+            if ( idx = lst ) then
+               readPtyBurst_C( cnt, buf, BURST_G );
+               idx := 0;
+               lst := 0;
+               if ( cnt > 0 ) then
+                  lst := cnt;
+               elsif ( cnt < 0 ) then
+                  rdAb <= '1';
+               end if;
+            end if;
+            if ( idx < lst ) then
+               rdDat <= std_logic_vector( to_unsigned( buf(idx), 8 ) );
+               idx   := idx + 1;
+               vld   := '1';
             end if;
          end if;
          rdVld <= vld;
       end if;
    end process P_RD;
 
+   -- collect octets locally; pass them on when the buffer is full or
+   -- the sender pauses (which also flushes the C layer) and keep
+   -- flushing while the C layer has data pending.
    P_WR : process ( clk ) is
-      variable rdy : std_logic;
-      variable ri  : integer;
-      variable st  : integer;
+      variable buf : IntArray;
+      variable cnt : natural := 0;
+      variable acc : integer;
+      variable pnd : integer := 0;
+      variable flu : integer;
    begin
       if ( rising_edge( clk ) ) then
          if ( abrtDon = '1' ) then
             wrAb <= '0';
          end if;
-         rdy := wrRdy;
-         if ( ( rdy and vldIb ) = '1' ) then
-            writePty_C( st, to_integer( unsigned( datIb ) ) );
-			if ( st < 0 ) then
-               wrAb <= '1';
-            end if;
-            rdy := '0';
+         if ( ( wrRdy and vldIb ) = '1' ) then
+            buf(cnt) := to_integer( unsigned( datIb ) );
+            cnt      := cnt + 1;
          end if;
-         if ( rdy = '0' ) then
-            writePtyPoll_C( ri );
-            if    ( ri > 0 ) then
-               rdy := '1';
-			elsif ( ri < 0 ) then
+         if ( ( cnt = BURST_G ) or ( ( vldIb = '0' ) and ( ( cnt > 0 ) or ( pnd > 0 ) ) ) ) then
+            if ( vldIb = '0' ) then
+               flu := 1;
+            else
+               flu := 0;
+            end if;
+            writePtyBurst_C( acc, pnd, buf, cnt, flu );
+            if ( acc < 0 ) then
                wrAb <= '1';
+               cnt  := 0;
+               pnd  := 0;
+            elsif ( acc > 0 ) then
+               for i in buf'range loop
+                  if ( i + acc < cnt ) then
+                     buf(i) := buf(i + acc);
+                  end if;
+               end loop;
+               cnt := cnt - acc;
             end if;
          end if;
-         wrRdy <= rdy;
+         if ( cnt < BURST_G ) then
+            wrRdy <= '1';
+         else
+            wrRdy <= '0';
+         end if;
       end if;
    end process P_WR;
 
-
    vldOb <= rdVld;
    datOb <= rdDat;
    abrt  <= rdAb or wrAb;
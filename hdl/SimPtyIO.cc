@@ -91,70 +91,212 @@ bail:
 
 #ifndef TEST
 
-static int theFD = simPtyCreate();
+/* Buffered PTY I/O.
+ *
+ * The PTY is accessed in bulk: received data are read into 'rx' as
+ * a block and handed to the simulation from memory; data written by
+ * the simulation are collected in 'tx' and written as a block when
+ * the simulation has nothing more to send (or the buffer is full).
+ *
+ * Set SIM_PTY_DEBUG=1 to print a line per block transferred to/from
+ * the PTY and SIM_PTY_DEBUG=2 to print every octet.
+ */
+
+#define SIM_PTY_BUFSZ 65536
+
+typedef struct SimPtyRing {
+	uint8_t  buf[SIM_PTY_BUFSZ];
+	size_t   hd;
+	size_t   tl;
+} SimPtyRing;
+
+static int        theFD = simPtyCreate();
+static SimPtyRing rx;
+static SimPtyRing tx;
+
+static int
+simPtyDebugLevel()
+{
+const char *s = getenv( "SIM_PTY_DEBUG" );
+	return s ? atoi( s ) : 0;
+}
+
+static int        ptyDebug = simPtyDebugLevel();
+
+static size_t
+ringUsed(const SimPtyRing *r)
+{
+	return r->tl - r->hd;
+}
+
+/* Read as much as fits; RETURNS -1 on error (the PTY has been reopened), 0 otherwise */
+static int
+rxFill()
+{
+ssize_t got;
+size_t  room;
+
+	if ( rx.hd == rx.tl ) {
+		rx.hd = rx.tl = 0;
+	}
+	if ( 0 == (room = sizeof(rx.buf) - rx.tl) ) {
+		return 0;
+	}
+	got = read( theFD, rx.buf + rx.tl, room );
+	if ( got > 0 ) {
+		if ( ptyDebug > 0 ) {
+			printf("READ %zd octets\n", got);
+		}
+		rx.tl += got;
+	} else if ( got < 0 && EAGAIN != errno ) {
+		/* If communication is interrupted we get EIO; this is a flag
+		 * permanently set (checked in linux' pty driver) until close/reopen :-(
+		 */
+		close( theFD );
+		theFD = simPtyCreate();
+		rx.hd = rx.tl = 0;
+		tx.hd = tx.tl = 0;
+		return -1;
+	}
+	return 0;
+}
+
+/* Write as much as the PTY accepts; RETURNS -1 on error, 0 otherwise */
+static int
+txDrain()
+{
+ssize_t put;
+
+	if ( tx.hd == tx.tl ) {
+		return 0;
+	}
+	put = write( theFD, tx.buf + tx.hd, tx.tl - tx.hd );
+	if ( put > 0 ) {
+		if ( ptyDebug > 0 ) {
+			printf("WROTE %zd octets\n", put);
+		}
+		tx.hd += put;
+		if ( tx.hd == tx.tl ) {
+			tx.hd = tx.tl = 0;
+		}
+	} else if ( put < 0 && EAGAIN != errno ) {
+		perror("WARNING: SimPtyIO failed to write");
+		return -1;
+	}
+	return 0;
+}
+
+/* Make room for at least one octet in 'tx'; RETURNS room or -1 on error */
+static ssize_t
+txRoom()
+{
+	if ( sizeof(tx.buf) == tx.tl ) {
+		if ( txDrain() ) {
+			return -1;
+		}
+		if ( tx.hd > 0 ) {
+			memmove( tx.buf, tx.buf + tx.hd, tx.tl - tx.hd );
+			tx.tl -= tx.hd;
+			tx.hd  = 0;
+		}
+	}
+	return sizeof(tx.buf) - tx.tl;
+}
 
 extern "C" {
 
+/* Single-octet access (served from the buffers) */
+
 void readPtyPoll_C(int *valid, int *data)
 {
-uint8_t oct;
-int     st;
-	st = read( theFD, &oct, 1 );
-	if ( 1 == st ) {
-		*valid = 1;
-		*data  = oct;
-printf("READ %x\n", oct);
-	} else if ( st < 0 && EAGAIN != errno  ) {
+	if ( 0 == ringUsed( &rx ) && rxFill() ) {
 		*valid = -1;
-		close( theFD );
-		theFD = simPtyCreate();
-//		*valid = 0;
-// if communication is interrupted we get EIO; this is a flag
-// permanently set (checked in linux' pty driver) until close/reopen :-(
-//		perror("readPtyPoll");
+		return;
+	}
+	if ( ringUsed( &rx ) ) {
+		*valid = 1;
+		*data  = rx.buf[rx.hd++];
+		if ( ptyDebug > 1 ) {
+			printf("READ %x\n", *data);
+		}
 	} else {
-		*valid =  0;
+		*valid = 0;
 	}
 }
 
 void writePty_C(int *valid, int data)
 {
-uint8_t oct = (uint8_t) data;
-int     put;
-	if ( 1 == (put = write( theFD, &oct, 1 )) ) {
-		*valid = 1;
-	} else {
+	if ( txRoom() <= 0 ) {
 		*valid = -1;
-		perror("WARNING: writePty_C failed to write");
+		return;
+	}
+	if ( ptyDebug > 1 ) {
+		printf("WRITE %x\n", data & 0xff);
 	}
+	tx.buf[tx.tl++] = (uint8_t) data;
+	*valid = 1;
 }
 
+/* Pushes buffered data out; ready as long as there is room in the buffer */
 void writePtyPoll_C(int *rdy)
 {
-fd_set         fds;
-int            st;
-struct timeval t;
+	if ( txDrain() ) {
+		*rdy = -1;
+		return;
+	}
+	*rdy = ( sizeof(tx.buf) != tx.tl || tx.hd > 0 ) ? 1 : 0;
+}
 
-	FD_ZERO( &fds );
-	FD_SET ( theFD, &fds );
+/* Block access
+ *
+ * readPtyBurst_C: store up to 'max' received octets in 'data'; '*cnt'
+ *                 is set to the number of octets or -1 on error.
+ */
+void readPtyBurst_C(int *cnt, int32_t *data, int max)
+{
+int i;
 
-	t.tv_sec  = 0;
-	t.tv_usec = 0;
+	if ( ringUsed( &rx ) < (size_t)max && rxFill() ) {
+		*cnt = -1;
+		return;
+	}
+	for ( i = 0; i < max && ringUsed( &rx ); i++ ) {
+		data[i] = rx.buf[rx.hd++];
+		if ( ptyDebug > 1 ) {
+			printf("READ %x\n", data[i]);
+		}
+	}
+	*cnt = i;
+}
 
-	st = select( theFD + 1, 0, &fds, 0, &t );
+/* writePtyBurst_C: queue up to 'cnt' octets from 'data'; the number accepted
+ *                  is stored in '*acc' (-1 on error). Queued data are written
+ *                  to the PTY if 'flush' is nonzero or the buffer is full.
+ *                  The number of octets still queued is stored in '*pend'.
+ */
+void writePtyBurst_C(int *acc, int *pend, const int32_t *data, int cnt, int flush)
+{
+ssize_t room;
+int     i;
 
-	if ( st <= 0 ) {
-		*rdy = 0;
-		if ( st < 0 ) {
-			perror("WARNING: writePtyPoll_C failed to select");
-			*rdy = -1;
+	if ( (room = txRoom()) < 0 ) {
+		*acc = -1;
+		*pend = 0;
+		return;
+	}
+	for ( i = 0; i < cnt && i < room; i++ ) {
+		if ( ptyDebug > 1 ) {
+			printf("WRITE %x\n", data[i] & 0xff);
 		}
-	} else {
-		*rdy = 1;
+		tx.buf[tx.tl++] = (uint8_t) data[i];
+	}
+	*acc = i;
+	if ( ( flush || i < cnt ) && txDrain() ) {
+		*acc = -1;
 	}
+	*pend = (int)ringUsed( &tx );
 }
 
-
 }
 
 #else
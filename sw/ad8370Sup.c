@@ -34,6 +34,8 @@
 #include "fwComm.h"
 #include "scopeSup.h"
 
+#define SHADOW FW_SHADOW_SPI( SPI_PGA )
+
 int
 ad8370Write(FWInfo *fw, int channel, uint8_t val)
 {
@@ -42,8 +44,10 @@ int     st;
 	buf[0] = fw_spireg_cmd_write( channel );
 	buf[1] = val;
 	if ( (st = bb_spi_xfer( fw, SPI_MODE0, SPI_PGA, buf, 0, 0, sizeof(buf)) ) < 0 ) {
+		fw_shadow_invalidate( fw, SHADOW, channel );
 		return st;
 	}
+	fw_shadow_set( fw, SHADOW, channel, val );
 	return 0;
 }
 
@@ -57,9 +61,20 @@ int     st;
 	if ( (st = bb_spi_xfer( fw, SPI_MODE0, SPI_PGA, buf, buf, 0, sizeof(buf)) ) < 0 ) {
 		return st;
 	}
+	fw_shadow_set( fw, SHADOW, channel, buf[1] );
 	return (int)buf[1];
 }
 
+static int
+cachedRead(FWInfo *fw, int channel)
+{
+int     st;
+	if ( (st = fw_shadow_get( fw, SHADOW, channel )) < 0 ) {
+		st = ad8370Read( fw, channel );
+	}
+	return st;
+}
+
 static const double VERNIER = 0.055744; /* magic values from datasheet */
 static const double PREGAIN = 7.079458;
 
@@ -108,7 +123,7 @@ unsigned       cod;
 float
 ad8370GetAttDb(FWInfo *fw, unsigned channel)
 {
-int     v  = ad8370Read( fw, channel );
+int     v  = cachedRead( fw, channel );
 int     hi;
 double  gain, att;
 uint8_t cod;
@@ -0,0 +1,256 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Benchmark of the bit-bang SPI codec kernels and of flash reads
+ * over the bit-bang path (at25 flash with the SPI controller disabled).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "fwComm.h"
+#include "at25Sup.h"
+#include "bbSpiCodec.h"
+
+static void usage(const char *nm)
+{
+	printf("usage: %s [-h] [-d usb-dev] [-s size] [-r repeat] [-a flash_addr] [-c]\n", nm);
+	printf("   -h           : this message.\n");
+	printf("   -d usb-dev   : device or transport URI, e.g., tcp:host:port or\n");
+	printf("                  sim: (in-process firmware model)\n");
+	printf("                  (default: $BBCLI_DEVICE or /dev/ttyACM0).\n");
+	printf("   -s size      : octets per flash read (default: 64kB; the codec\n");
+	printf("                  is exercised with 16 times this amount).\n");
+	printf("   -r repeat    : number of repetitions per measurement (default: 4).\n");
+	printf("   -a flash_addr: flash address to read from (default: 0).\n");
+	printf("   -c           : benchmark the codec only (no device is opened).\n");
+}
+
+static double
+now(void)
+{
+struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (double)t.tv_sec + 1.0E-9*(double)t.tv_nsec;
+}
+
+static const BBSpiKernel kerns[] = {
+	BB_SPI_KERNEL_LOOP,
+	BB_SPI_KERNEL_LUT,
+	BB_SPI_KERNEL_SSSE3,
+	BB_SPI_KERNEL_AVX2
+};
+
+/* layout used by the firmware in SPI mode 0 */
+static const BBSpiLayout lay = {
+	.idle     = 0xf0,
+	.sclk     = 0x02,
+	.mosiShft = 2,
+	.hizShft  = 6,
+	.misoShft = 3
+};
+
+static int
+benchCodec(size_t len, unsigned repeat)
+{
+uint8_t  *tbuf = malloc( len );
+uint8_t  *zbuf = malloc( len );
+uint8_t  *rbuf = malloc( len );
+uint8_t  *xref = malloc( 16*len );
+uint8_t  *xbuf = malloc( 16*len );
+int       rval = -1;
+unsigned  i, r;
+double    then, enc, dec;
+
+	if ( ! tbuf || ! zbuf || ! rbuf || ! xref || ! xbuf ) {
+		perror("No memory");
+		goto bail;
+	}
+	srand( 1 );
+	for ( i = 0; i < len; i++ ) {
+		tbuf[i] = rand();
+		zbuf[i] = rand();
+	}
+
+	/* reference encoding; MISO echoes MOSI */
+	bbSpiSelectKernel( BB_SPI_KERNEL_LOOP );
+	bbSpiEncode( xref, &lay, tbuf, zbuf, len );
+	for ( i = 0; i < 16*len; i++ ) {
+		xref[i] |= ( (xref[i] >> lay.mosiShft) & 1 ) << lay.misoShft;
+	}
+
+	printf("%8s %12s %12s\n", "kernel", "enc MB/s", "dec MB/s");
+	for ( i = 0; i < sizeof(kerns)/sizeof(kerns[0]); i++ ) {
+		if ( bbSpiSelectKernel( kerns[i] ) ) {
+			printf("%8s %12s %12s\n", bbSpiKernelName( kerns[i] ), "n/a", "n/a");
+			continue;
+		}
+		then = now();
+		for ( r = 0; r < repeat; r++ ) {
+			bbSpiEncode( xbuf, &lay, tbuf, zbuf, len );
+		}
+		enc = now() - then;
+		for ( r = 0; r < 16*len; r++ ) {
+			if ( (xbuf[r] | (xref[r] & (1 << lay.misoShft))) != xref[r] ) {
+				fprintf(stderr, "%s: encoder mismatch at sample %u\n", bbSpiKernelName( kerns[i] ), r);
+				goto bail;
+			}
+		}
+		memset( rbuf, 0, len );
+		then = now();
+		for ( r = 0; r < repeat; r++ ) {
+			bbSpiDecode( rbuf, &lay, xref, len );
+		}
+		dec = now() - then;
+		if ( memcmp( rbuf, tbuf, len ) ) {
+			fprintf(stderr, "%s: decoder mismatch\n", bbSpiKernelName( kerns[i] ));
+			goto bail;
+		}
+		printf("%8s %12.1f %12.1f\n", bbSpiKernelName( kerns[i] ),
+			(double)len*(double)repeat/enc/1.0E6,
+			(double)len*(double)repeat/dec/1.0E6);
+	}
+	rval = 0;
+
+bail:
+	free( xbuf );
+	free( xref );
+	free( rbuf );
+	free( zbuf );
+	free( tbuf );
+	return rval;
+}
+
+static int
+benchFlash(const char *devn, unsigned addr, size_t len, unsigned repeat)
+{
+FWInfo     *fw    = NULL;
+AT25Flash  *flash = NULL;
+uint8_t    *ref   = malloc( len );
+uint8_t    *buf   = malloc( len );
+int         rval  = -1;
+unsigned    i, r;
+int         st;
+double      then, secs;
+
+	if ( ! ref || ! buf ) {
+		perror("No memory");
+		goto bail;
+	}
+	if ( ! (fw = fw_open( devn, 115200 )) ) {
+		goto bail;
+	}
+	/* use the bit-bang path */
+	fw_disable_features( fw, FW_FEATURE_SPI_CONTROLLER );
+
+	if ( ! (flash = at25_open( fw, 0 )) ) {
+		goto bail;
+	}
+
+	printf("%8s %12s\n", "kernel", "read MB/s");
+	for ( i = 0; i < sizeof(kerns)/sizeof(kerns[0]); i++ ) {
+		if ( bbSpiSelectKernel( kerns[i] ) ) {
+			printf("%8s %12s\n", bbSpiKernelName( kerns[i] ), "n/a");
+			continue;
+		}
+		then = now();
+		for ( r = 0; r < repeat; r++ ) {
+			if ( (st = at25_spi_read( flash, addr, buf, len )) < 0 ) {
+				fprintf(stderr, "Flash read failed: %s\n", strerror(-st));
+				goto bail;
+			}
+		}
+		secs = now() - then;
+		if ( 0 == i ) {
+			memcpy( ref, buf, len );
+		} else if ( memcmp( ref, buf, len ) ) {
+			fprintf(stderr, "%s: flash data mismatch\n", bbSpiKernelName( kerns[i] ));
+			goto bail;
+		}
+		printf("%8s %12.3f\n", bbSpiKernelName( kerns[i] ), (double)len*(double)repeat/secs/1.0E6);
+	}
+	rval = 0;
+
+bail:
+	at25_close( flash );
+	fw_close( fw );
+	free( buf );
+	free( ref );
+	return rval;
+}
+
+int
+main(int argc, char **argv)
+{
+const char   *devn;
+unsigned      size      = 64*1024;
+unsigned      repeat    = 4;
+unsigned      addr      = 0;
+int           codecOnly = 0;
+unsigned     *u_p;
+int           opt;
+
+	if ( ! (devn = getenv( "BBCLI_DEVICE" )) ) {
+		devn = "/dev/ttyACM0";
+	}
+
+	while ( (opt = getopt(argc, argv, "a:cd:hr:s:")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'h': usage(argv[0]);                                                 return 0;
+			default : fprintf(stderr, "Unknown option -%c (use -h for help)\n", opt); return 1;
+			case 'a': u_p       = &addr;                                              break;
+			case 'c': codecOnly = 1;                                                  break;
+			case 'd': devn      = optarg;                                             break;
+			case 'r': u_p       = &repeat;                                            break;
+			case 's': u_p       = &size;                                              break;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr, "Unable to scan argument to option -%c -- should be a number\n", opt);
+			return 1;
+		}
+	}
+
+	if ( 0 == size || 0 == repeat ) {
+		fprintf(stderr, "Size and repeat must be > 0\n");
+		return 1;
+	}
+
+	if ( benchCodec( 16*(size_t)size, repeat ) ) {
+		return 1;
+	}
+	if ( ! codecOnly ) {
+		printf("\n");
+		if ( benchFlash( devn, addr, size, repeat ) ) {
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,294 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "bbSpiCodec.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Samples per octet */
+#define SPO 16
+
+/* bitTab[v] holds the 16 samples of octet 'v' with each bit
+ * of 'v' (MSB first) expanded into two consecutive octets
+ * which are 0 or 1. Since no carry can propagate between octets
+ * the table entries can be shifted into position (and combined)
+ * as 64-bit words.
+ */
+static uint64_t       bitTab[256][SPO/sizeof(uint64_t)];
+static pthread_once_t bitTabOnce = PTHREAD_ONCE_INIT;
+
+static void
+bitTabInit(void)
+{
+uint8_t  smpl[SPO];
+unsigned v, j;
+
+	for ( v = 0; v < 256; v++ ) {
+		for ( j = 0; j < 8; j++ ) {
+			smpl[2*j    ] = (v >> (7 - j)) & 1;
+			smpl[2*j + 1] = (v >> (7 - j)) & 1;
+		}
+		memcpy( bitTab[v], smpl, sizeof(smpl) );
+	}
+}
+
+static uint8_t
+idleBits(const BBSpiLayout *lay)
+{
+	return lay->idle & ~ ( (1 << lay->mosiShft) | (1 << lay->hizShft) );
+}
+
+static void
+encodeLoop(uint8_t *xbuf, const BBSpiLayout *lay, const uint8_t *tbuf, const uint8_t *zbuf, size_t len)
+{
+uint8_t  idle = idleBits( lay );
+uint8_t  bbo, v, z;
+size_t   i;
+int      j;
+
+	for ( i = 0; i < len; i++ ) {
+		v = tbuf ? tbuf[i] : 0;
+		z = zbuf ? zbuf[i] : 0;
+		for ( j = 0; j < 8; j++ ) {
+			bbo     = idle | ( ((v >> 7) & 1) << lay->mosiShft ) | ( ((z >> 7) & 1) << lay->hizShft );
+			*xbuf++ = bbo;
+			*xbuf++ = bbo ^ lay->sclk;
+			v     <<= 1;
+			z     <<= 1;
+		}
+	}
+}
+
+static void
+encodeLut(uint8_t *xbuf, const BBSpiLayout *lay, const uint8_t *tbuf, const uint8_t *zbuf, size_t len)
+{
+uint8_t  pat[sizeof(uint64_t)];
+uint64_t base, w;
+uint8_t  v, z;
+size_t   i;
+int      k;
+
+	/* idle pattern with SCLK toggling in every other sample */
+	for ( k = 0; k < sizeof(pat); k++ ) {
+		pat[k] = idleBits( lay ) ^ ( (k & 1) ? lay->sclk : 0 );
+	}
+	memcpy( &base, pat, sizeof(base) );
+
+	for ( i = 0; i < len; i++ ) {
+		v = tbuf ? tbuf[i] : 0;
+		z = zbuf ? zbuf[i] : 0;
+		for ( k = 0; k < SPO/sizeof(w); k++ ) {
+			w = base | ( bitTab[v][k] << lay->mosiShft ) | ( bitTab[z][k] << lay->hizShft );
+			memcpy( xbuf, &w, sizeof(w) );
+			xbuf += sizeof(w);
+		}
+	}
+}
+
+static void
+decodeLoop(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len)
+{
+uint8_t  v;
+size_t   i;
+int      j;
+
+	for ( i = 0; i < len; i++ ) {
+		v = 0;
+		for ( j = 1; j < SPO; j += 2 ) {
+			v = (v << 1) | ( (xbuf[j] >> lay->misoShft) & 1 );
+		}
+		xbuf   += SPO;
+		rbuf[i] = v;
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+/* Gather the second sample of every bit into the low half of
+ * a register in reverse order so that 'movemask' (after shifting
+ * MISO into the sign bit) yields the octet with the MSB in bit 7.
+ */
+#define GATHER_MISO -1, -1, -1, -1, -1, -1, -1, -1, 1, 3, 5, 7, 9, 11, 13, 15
+
+__attribute__((target("ssse3")))
+static void
+decodeSSSE3(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len)
+{
+const __m128i sel = _mm_set_epi8( GATHER_MISO );
+const __m128i cnt = _mm_cvtsi32_si128( 7 - lay->misoShft );
+__m128i       v0, v1;
+unsigned      msk;
+size_t        i;
+
+	for ( i = 0; i + 2 <= len; i += 2 ) {
+		v0  = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(xbuf        ) ), sel );
+		v1  = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(xbuf +   SPO) ), sel );
+		msk = _mm_movemask_epi8( _mm_sll_epi16( _mm_unpacklo_epi64( v0, v1 ), cnt ) );
+		rbuf[i    ] = (uint8_t)(msk     );
+		rbuf[i + 1] = (uint8_t)(msk >> 8);
+		xbuf       += 2*SPO;
+	}
+	decodeLoop( rbuf + i, lay, xbuf, len - i );
+}
+
+__attribute__((target("avx2")))
+static void
+decodeAVX2(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len)
+{
+const __m256i sel = _mm256_set_epi8( GATHER_MISO, GATHER_MISO );
+const __m128i cnt = _mm_cvtsi32_si128( 7 - lay->misoShft );
+__m256i       v0, v1, v;
+unsigned      msk;
+size_t        i;
+
+	for ( i = 0; i + 4 <= len; i += 4 ) {
+		v0  = _mm256_shuffle_epi8( _mm256_loadu_si256( (const __m256i*)(xbuf        ) ), sel );
+		v1  = _mm256_shuffle_epi8( _mm256_loadu_si256( (const __m256i*)(xbuf + 2*SPO) ), sel );
+		/* lanes hold octets (0, 2) and (1, 3); restore the order */
+		v   = _mm256_permute4x64_epi64( _mm256_unpacklo_epi64( v0, v1 ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		msk = _mm256_movemask_epi8( _mm256_sll_epi16( v, cnt ) );
+		rbuf[i    ] = (uint8_t)(msk      );
+		rbuf[i + 1] = (uint8_t)(msk >>  8);
+		rbuf[i + 2] = (uint8_t)(msk >> 16);
+		rbuf[i + 3] = (uint8_t)(msk >> 24);
+		xbuf       += 4*SPO;
+	}
+	decodeSSSE3( rbuf + i, lay, xbuf, len - i );
+}
+#endif
+
+static void encodeAuto(uint8_t *xbuf, const BBSpiLayout *lay, const uint8_t *tbuf, const uint8_t *zbuf, size_t len);
+static void decodeAuto(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len);
+
+static void        (*encodeFn)(uint8_t *, const BBSpiLayout *, const uint8_t *, const uint8_t *, size_t) = encodeAuto;
+static void        (*decodeFn)(uint8_t *, const BBSpiLayout *, const uint8_t *, size_t)                  = decodeAuto;
+static BBSpiKernel   codecKern                                                                            = BB_SPI_KERNEL_AUTO;
+
+static void
+encodeAuto(uint8_t *xbuf, const BBSpiLayout *lay, const uint8_t *tbuf, const uint8_t *zbuf, size_t len)
+{
+	bbSpiSelectKernel( BB_SPI_KERNEL_AUTO );
+	encodeFn( xbuf, lay, tbuf, zbuf, len );
+}
+
+static void
+decodeAuto(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len)
+{
+	bbSpiSelectKernel( BB_SPI_KERNEL_AUTO );
+	decodeFn( rbuf, lay, xbuf, len );
+}
+
+int
+bbSpiSelectKernel(BBSpiKernel kern)
+{
+	switch ( kern ) {
+		case BB_SPI_KERNEL_AUTO:
+			if ( 0 == bbSpiSelectKernel( BB_SPI_KERNEL_AVX2 ) ) {
+				return 0;
+			}
+			if ( 0 == bbSpiSelectKernel( BB_SPI_KERNEL_SSSE3 ) ) {
+				return 0;
+			}
+			return bbSpiSelectKernel( BB_SPI_KERNEL_LUT );
+
+		case BB_SPI_KERNEL_LOOP:
+			encodeFn = encodeLoop;
+			decodeFn = decodeLoop;
+			break;
+
+		case BB_SPI_KERNEL_LUT:
+			pthread_once( &bitTabOnce, bitTabInit );
+			encodeFn = encodeLut;
+			decodeFn = decodeLoop;
+			break;
+
+#ifdef HAVE_X86_SIMD
+		case BB_SPI_KERNEL_SSSE3:
+			if ( ! __builtin_cpu_supports( "ssse3" ) ) {
+				return -ENOTSUP;
+			}
+			pthread_once( &bitTabOnce, bitTabInit );
+			encodeFn = encodeLut;
+			decodeFn = decodeSSSE3;
+			break;
+
+		case BB_SPI_KERNEL_AVX2:
+			if ( ! __builtin_cpu_supports( "avx2" ) ) {
+				return -ENOTSUP;
+			}
+			pthread_once( &bitTabOnce, bitTabInit );
+			encodeFn = encodeLut;
+			decodeFn = decodeAVX2;
+			break;
+#endif
+
+		default:
+			return -ENOTSUP;
+	}
+	codecKern = kern;
+	return 0;
+}
+
+BBSpiKernel
+bbSpiGetKernel(void)
+{
+	if ( BB_SPI_KERNEL_AUTO == codecKern ) {
+		bbSpiSelectKernel( BB_SPI_KERNEL_AUTO );
+	}
+	return codecKern;
+}
+
+const char *
+bbSpiKernelName(BBSpiKernel kern)
+{
+	switch ( kern ) {
+		case BB_SPI_KERNEL_AUTO:  return "auto";
+		case BB_SPI_KERNEL_LOOP:  return "loop";
+		case BB_SPI_KERNEL_LUT:   return "lut";
+		case BB_SPI_KERNEL_SSSE3: return "ssse3";
+		case BB_SPI_KERNEL_AVX2:  return "avx2";
+		default:                  break;
+	}
+	return "unknown";
+}
+
+void
+bbSpiEncode(uint8_t *xbuf, const BBSpiLayout *lay, const uint8_t *tbuf, const uint8_t *zbuf, size_t len)
+{
+	encodeFn( xbuf, lay, tbuf, zbuf, len );
+}
+
+void
+bbSpiDecode(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len)
+{
+	decodeFn( rbuf, lay, xbuf, len );
+}
@@ -0,0 +1,97 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Conversion of SPI octets to/from bit-bang samples. Every bit
+ * occupies two samples (SCLK in its idle state, followed by SCLK
+ * toggled), MSB first, i.e., an octet expands into 16 samples.
+ */
+
+/* Sample layout; all other bits of 'idle' are passed through */
+typedef struct BBSpiLayout {
+	uint8_t        idle;      /* first sample of a '0' bit with hi-z clear */
+	uint8_t        sclk;      /* SCLK bit (toggled in the second sample)   */
+	unsigned       mosiShft;
+	unsigned       hizShft;
+	unsigned       misoShft;
+} BBSpiLayout;
+
+/* The 'loop' kernel expands every bit individually; all others
+ * use precomputed expansion tables for encoding and differ in the
+ * way MISO bits are compacted when decoding.
+ */
+typedef enum BBSpiKernel {
+	BB_SPI_KERNEL_AUTO,   /* best kernel supported by the CPU */
+	BB_SPI_KERNEL_LOOP,
+	BB_SPI_KERNEL_LUT,
+	BB_SPI_KERNEL_SSSE3,
+	BB_SPI_KERNEL_AVX2
+} BBSpiKernel;
+
+/* Select the kernel used by the routines below (the best available
+ * one is selected automatically on first use).
+ * RETURNS: 0 on success, -ENOTSUP if the kernel is not supported by
+ *          the CPU (or not compiled in).
+ */
+int
+bbSpiSelectKernel(BBSpiKernel kern);
+
+const char *
+bbSpiKernelName(BBSpiKernel kern);
+
+/* Return the currently selected kernel */
+BBSpiKernel
+bbSpiGetKernel(void);
+
+/* Expand 'len' octets from 'tbuf' (MOSI) and 'zbuf' (hi-z; a '1' bit
+ * sets the hi-z bit) into 16*len samples in 'xbuf'. Either of 'tbuf'
+ * and 'zbuf' may be NULL (all zero).
+ */
+void
+bbSpiEncode(uint8_t *xbuf, const BBSpiLayout *lay, const uint8_t *tbuf, const uint8_t *zbuf, size_t len);
+
+/* Collect 'len' octets from the MISO bits of 16*len samples in 'xbuf'
+ * (MISO is taken from the second sample of every bit).
+ */
+void
+bbSpiDecode(uint8_t *rbuf, const BBSpiLayout *lay, const uint8_t *xbuf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
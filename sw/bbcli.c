@@ -53,7 +53,7 @@
 
 static void usage(const char *nm)
 {
-	printf("usage: %s [-hvDI!?] [-d usb-dev] [-S SPI_flashCmd] [-a flash_addr] [-f flash_file] [-j|J json_file] [register] [values...]\n", nm);
+	printf("usage: %s [-hvbDI!?] [-d usb-dev] [-S SPI_flashCmd] [-a flash_addr] [-f flash_file] [-j|J json_file] [register] [values...]\n", nm);
 	printf("   -S cmd{,cmd}       : commands to execute on 25DF041 SPI flash (see below).\n");
 	printf("   -f flash-file      : file to write/verify when operating on SPI flash.\n");
 	printf("   -!                 : must be given in addition to flash-write/program command. This is a 'safety' feature.\n");
@@ -61,14 +61,17 @@ static void usage(const char *nm)
 	printf("   -a address         : start-address for SPI flash operations [0x%x].\n", FLASHADDR_DFLT);
 	printf("   -I                 : address I2C clock (5P49V5925). Supply register address and values (when writing).\n");
 	printf("   -D                 : address I2C DAC (47CVB02). Supply register address and values (when writing).\n");
+	printf("   -b                 : force bit-banged I2C, even if an I2C master is available.\n");
 	printf("   -d usb-device      : usb-device [/dev/ttyACM0]; you may also set the BBCLI_DEVICE env-var.\n");
+	printf("                        A transport URI may be given instead (tty:<device>, unix:<path>, tcp:<host>:<port>).\n");
+	printf("                        'sim:' connects to the (in-process) firmware model.\n");
 	printf("   -h                 : this message.\n");
 	printf("   -v                 : increase verbosity level.\n");
 	printf("   -V                 : dump firmware version.\n");
 	printf("   -B                 : dump ADC buffer (raw).\n");
 	printf("   -5 hdf5_filename   : dump ADC buffer (HDF5).\n");
 	printf("   -C <comment>       : add <comment> to the HDF5 data.\n");
-	printf("   -T [op=value]      : set acquisition parameter and trigger (op: 'level', 'autoMS', 'decim', 'src', 'edge', 'npts', 'nsmpl', 'factor', 'extTrgOE').\n");
+	printf("   -T [op=value]      : set acquisition parameter and trigger (op: 'level', 'autoMS', 'decim', 'src', 'edge', 'npts', 'nsmpl', 'nseg', 'navg', 'dblBuf', 'factor', 'extTrgOE').\n");
 	printf("                        NOTE: 'level' is normalized to int16 range; 'factor' to 2^%d!\n", ACQ_LD_SCALE_ONE);
 	printf("                              and may be appended with ':hysteresis'\n");
 	printf("                              (hysteresis always positive)\n");
@@ -410,6 +413,12 @@ int   badParm = 0;
 				pp->mask |= ACQ_PARAM_MSK_AUT;
 				break;
 			case 'D':
+				if ( 'B' == toupper( tok[1] ) ) {
+					if ( scanl( tok, eq, &v[0] ) ) goto bail;
+					pp->doubleBuffer = !! v[0];
+					pp->mask        |= ACQ_PARAM_MSK_DBL;
+					break;
+				}
 				if ( scanDecm( tok, eq, &v[0], &v[1] ) ) goto bail;
 				pp->cic0Decimation = (uint8_t)  v[0];
 				pp->cic1Decimation = (uint32_t) v[1];
@@ -473,6 +482,12 @@ int   badParm = 0;
 				if ( toupper( tok[1] ) == 'P' ) {
 					pp->npts      = (uint32_t) v[0];
 					pp->mask     |= ACQ_PARAM_MSK_NPT;
+				} else if ( toupper( tok[1] ) == 'S' && toupper( tok[2] ) == 'E' ) {
+					pp->nsegments = (uint32_t) v[0];
+					pp->mask     |= ACQ_PARAM_MSK_SEG;
+				} else if ( toupper( tok[1] ) == 'A' ) {
+					pp->naverage  = (uint32_t) v[0];
+					pp->mask     |= ACQ_PARAM_MSK_AVG;
 				} else {
 					pp->nsamples  = (uint32_t) v[0];
 					pp->mask     |= ACQ_PARAM_MSK_NSM;
@@ -637,10 +652,12 @@ const char                *h5nam     = NULL;
 ScopeH5Data               *h5d       = NULL;
 int                        h5st      = 0;
 const char                *h5comment = NULL;
+BufSegInfo                *segs      = NULL;
 const char                *jsonIFnam = NULL;
 const char                *jsonOFnam = NULL;
 ScopeParams               *settings  = NULL;
 int                        fpgaReconf = 0;
+int                        forceBBI2c = 0;
 FlashStdioProgressData     pd;
 
 	flash_stdio_progress_data_init( &pd );
@@ -649,7 +666,7 @@ FlashStdioProgressData     pd;
 		devn = "/dev/ttyACM0";
 	}
 
-	while ( (opt = getopt(argc, argv, "5:Aa:BC:Dd:Ff:GhIi:j:J:P:pR:S:T:VvX!?")) > 0 ) {
+	while ( (opt = getopt(argc, argv, "5:Aa:bBC:Dd:Ff:GhIi:j:J:P:pR:S:T:VvX!?")) > 0 ) {
 		u_p = 0;
 		switch ( opt ) {
             case 'h': usage(argv[0]);                                                 return 0;
@@ -661,6 +678,7 @@ FlashStdioProgressData     pd;
 			case 'A': dac  = 0; test_reg = TEST_ADC;                                  break;
 			case 'G': dac  = 0; test_reg = TEST_FEG;                                  break;
 			case 'B': dumpAdc = 1;                                                    break;
+			case 'b': forceBBI2c = 1;                                                 break;
 			case '5': dumpAdc = 2; h5nam = optarg;                                    break;
 			case 'F': dumpAdc = -1;                                                   break;
 			case 'p': dumpPrms= 1;                                                    break;
@@ -701,6 +719,10 @@ FlashStdioProgressData     pd;
 
 	fw_set_debug( fw, debug );
 
+	if ( forceBBI2c ) {
+		fw_disable_features( fw, FW_FEATURE_I2C_MASTER );
+	}
+
 	if ( ! (buf = malloc(buflen)) ) {
 		perror("No memory");
 		goto bail;
@@ -789,6 +811,9 @@ FlashStdioProgressData     pd;
 		printf("External Trigger   : %s\n", p.trigOutEn ? "OUTPUT" : "INPUT");
 		printf("N Samples          : %" PRIu32 "\n", p.nsamples  );
 		printf("N Pretrig samples  : %" PRIu32 "\n", p.npts      );
+		printf("N Segments         : %" PRIu32 "\n", p.nsegments > 1 ? p.nsegments : 1 );
+		printf("N Averages         : %" PRIu32 "\n", p.naverage > 1 ? p.naverage : 1 );
+		printf("Ping-pong buffer   : %s\n", p.doubleBuffer ? "on" : "off" );
 		printf("Autotrig timeout   : ");
 			if ( ACQ_PARAM_TIMEOUT_INF == p.autoTimeoutMS ) {
 				printf("<infinite>\n");
@@ -807,10 +832,14 @@ FlashStdioProgressData     pd;
 	if ( dumpAdc ) {
 		int      j;
 		uint16_t hdr;
+		AcqParams     acqp;
+		BufHdrExt     xhdr;
+		int           nsegs    = 0;
 		unsigned long nSamples = buf_get_size( scope );
-		uint8_t       fl       = buf_get_flags( scope );
+		unsigned      fl       = buf_get_flags( scope );
 		size_t        reqBufSz = nSamples * scope_get_num_channels( scope ) * sizeof(buf[0]);
-		if ( (fl & FW_BUF_FLG_16B) ) {
+		if ( (fl & (FW_BUF_FLG_16B | FW_BUF_FLG_AVG)) ) {
+			/* averages are read as 16-bit samples */
 			reqBufSz *= 2;
 		}
 		printBufInfo( stderr, scope );
@@ -823,28 +852,64 @@ FlashStdioProgressData     pd;
 					goto bail;
 				}
 			}
-			i = buf_read( scope, &hdr, buf, buflen );
+			acqp.mask = ACQ_PARAM_MSK_GET;
+			if ( acq_set_params( scope, 0, &acqp ) ) {
+				acqp.nsegments = 1;
+				acqp.naverage  = 1;
+			}
+			if ( dumpAdc > 1 && acqp.nsegments > 1 ) {
+				if ( ! (segs = calloc( acqp.nsegments, sizeof(*segs) )) ) {
+					fprintf(stderr, "Error: not enough memory\n");
+					goto bail;
+				}
+				nsegs = buf_read_segments( scope, &hdr, buf, buflen, segs, acqp.nsegments );
+				i     = nsegs > 0 ? nsegs * acqp.nsamples * scope_get_num_channels( scope ) : nsegs;
+				if ( i > 0 && (fl & FW_BUF_FLG_16B) ) {
+					i *= 2;
+				}
+			} else if ( acqp.naverage > 1 ) {
+				/* averages, scaled like 16-bit samples */
+				i   = buf_read_int16( scope, &hdr, (int16_t*)buf, buflen / sizeof(int16_t) );
+				fl |= FW_BUF_FLG_16B;
+			} else {
+				i = buf_read( scope, &hdr, buf, buflen );
+			}
 		} else {
 			i = buf_flush( scope );
 		}
 		if ( i > 0 ) {
 			fprintf(stderr, "ADC Data (got %d, header: 0x%04" PRIx16 ")\n", i, hdr);
+			if ( 0 == buf_get_ext_header( scope, &xhdr ) ) {
+				fprintf(stderr, "Acquisition #%" PRIu16 ", trigger @ %" PRIu64 " ADC clocks\n", xhdr.seq, xhdr.tstamp);
+			}
 			if ( dumpAdc > 1 ) {
 				ScopeH5SampleType dtyp = (fl & FW_BUF_FLG_16B) ? INT16LE_T : INT8_T;
 				int               ssiz = (INT8_T == dtyp ? sizeof(int8_t) : sizeof(int16_t));
 				int               prec = buf_get_sample_size( scope );
-				size_t            dims[2];
-				if ( prec < 0 ) {
+				size_t            dims[3];
+				if ( prec < 0 || ( hdr & FW_BUF_HDR_FLG_AVG ) ) {
+					/* averages have more resolution than the ADC */
 					prec = ssiz*8;
 				}
-				dims[1] = scope_get_num_channels( scope );
-				/* num-samples = nbytes */ 
-				dims[0] = i / dims[1] / ssiz;
-				h5d = scope_h5_create( h5nam, dtyp, 8*ssiz - prec, dims, sizeof(dims)/sizeof(dims[0]), buf );
+				if ( nsegs > 0 ) {
+					/* segments x samples x channels */
+					dims[0] = nsegs;
+					dims[1] = acqp.nsamples;
+					dims[2] = scope_get_num_channels( scope );
+					h5d = scope_h5_create( h5nam, dtyp, 8*ssiz - prec, dims, 3, buf );
+				} else {
+					dims[1] = scope_get_num_channels( scope );
+					/* num-samples = nbytes */ 
+					dims[0] = i / dims[1] / ssiz;
+					h5d = scope_h5_create( h5nam, dtyp, 8*ssiz - prec, dims, 2, buf );
+				}
 				if ( ! h5d ) {
 					goto bail;
 				}
-				h5st = scope_h5_add_bufhdr( h5d, hdr, scope_get_num_channels( scope ) );
+				h5st = scope_h5_add_bufhdr_ext( h5d, hdr, 0 == buf_get_ext_header( scope, &xhdr ) ? &xhdr : NULL, scope_get_num_channels( scope ) );
+				if ( ! h5st && nsegs > 0 ) {
+					h5st = scope_h5_add_segments( h5d, segs, nsegs );
+				}
 				if ( h5st ) {
 					goto bail;
 				}
@@ -1175,6 +1240,7 @@ bail:
 	if ( flash ) {
 		at25_close( flash );
 	}
+	free( segs );
 	if ( h5d ) {
 		scope_h5_close( h5d );
 		if ( h5st ) {
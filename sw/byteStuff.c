@@ -0,0 +1,354 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <string.h>
+#include <errno.h>
+
+#include "byteStuff.h"
+
+#define COMMA  BYTE_STUFF_COMMA
+#define ESCAP  BYTE_STUFF_ESCAP
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static size_t
+scanScalar(const uint8_t *buf, size_t len)
+{
+size_t i;
+	for ( i = 0; i < len; i++ ) {
+		if ( COMMA == buf[i] || ESCAP == buf[i] ) {
+			break;
+		}
+	}
+	return i;
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("sse2")))
+static size_t
+scanSSE2(const uint8_t *buf, size_t len)
+{
+const __m128i comma = _mm_set1_epi8( (char)COMMA );
+const __m128i escap = _mm_set1_epi8( (char)ESCAP );
+__m128i       v;
+unsigned      msk;
+size_t        i;
+
+	for ( i = 0; i + sizeof(v) <= len; i += sizeof(v) ) {
+		v   = _mm_loadu_si128( (const __m128i*)(buf + i) );
+		msk = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v, comma ), _mm_cmpeq_epi8( v, escap ) ) );
+		if ( msk ) {
+			return i + __builtin_ctz( msk );
+		}
+	}
+	return i + scanScalar( buf + i, len - i );
+}
+
+__attribute__((target("avx2")))
+static size_t
+scanAVX2(const uint8_t *buf, size_t len)
+{
+const __m256i comma = _mm256_set1_epi8( (char)COMMA );
+const __m256i escap = _mm256_set1_epi8( (char)ESCAP );
+__m256i       v;
+unsigned      msk;
+size_t        i;
+
+	for ( i = 0; i + sizeof(v) <= len; i += sizeof(v) ) {
+		v   = _mm256_loadu_si256( (const __m256i*)(buf + i) );
+		msk = _mm256_movemask_epi8( _mm256_or_si256( _mm256_cmpeq_epi8( v, comma ), _mm256_cmpeq_epi8( v, escap ) ) );
+		if ( msk ) {
+			return i + __builtin_ctz( msk );
+		}
+	}
+	return i + scanScalar( buf + i, len - i );
+}
+#endif
+
+static size_t scanAuto(const uint8_t *buf, size_t len);
+
+static size_t          (*scanFn)(const uint8_t *, size_t) = scanAuto;
+static ByteStuffKernel   scanKern                         = BYTE_STUFF_KERNEL_AUTO;
+
+static size_t
+scanAuto(const uint8_t *buf, size_t len)
+{
+	byteStuffSelectKernel( BYTE_STUFF_KERNEL_AUTO );
+	return scanFn( buf, len );
+}
+
+int
+byteStuffSelectKernel(ByteStuffKernel kern)
+{
+	switch ( kern ) {
+		case BYTE_STUFF_KERNEL_AUTO:
+			if ( 0 == byteStuffSelectKernel( BYTE_STUFF_KERNEL_AVX2 ) ) {
+				return 0;
+			}
+			if ( 0 == byteStuffSelectKernel( BYTE_STUFF_KERNEL_SSE2 ) ) {
+				return 0;
+			}
+			return byteStuffSelectKernel( BYTE_STUFF_KERNEL_SCALAR );
+
+		case BYTE_STUFF_KERNEL_SCALAR:
+			scanFn = scanScalar;
+			break;
+
+#ifdef HAVE_X86_SIMD
+		case BYTE_STUFF_KERNEL_SSE2:
+			if ( ! __builtin_cpu_supports( "sse2" ) ) {
+				return -ENOTSUP;
+			}
+			scanFn = scanSSE2;
+			break;
+
+		case BYTE_STUFF_KERNEL_AVX2:
+			if ( ! __builtin_cpu_supports( "avx2" ) ) {
+				return -ENOTSUP;
+			}
+			scanFn = scanAVX2;
+			break;
+#endif
+
+		default:
+			return -ENOTSUP;
+	}
+	scanKern = kern;
+	return 0;
+}
+
+ByteStuffKernel
+byteStuffGetKernel(void)
+{
+	if ( BYTE_STUFF_KERNEL_AUTO == scanKern ) {
+		byteStuffSelectKernel( BYTE_STUFF_KERNEL_AUTO );
+	}
+	return scanKern;
+}
+
+const char *
+byteStuffKernelName(ByteStuffKernel kern)
+{
+	switch ( kern ) {
+		case BYTE_STUFF_KERNEL_AUTO:   return "auto";
+		case BYTE_STUFF_KERNEL_SCALAR: return "scalar";
+		case BYTE_STUFF_KERNEL_SSE2:   return "sse2";
+		case BYTE_STUFF_KERNEL_AVX2:   return "avx2";
+		default:                       break;
+	}
+	return "unknown";
+}
+
+size_t
+byteStuffScan(const uint8_t *buf, size_t len)
+{
+	return scanFn( buf, len );
+}
+
+size_t
+byteStuffBuf(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t *plen)
+{
+size_t len = *plen;
+size_t got = 0;
+size_t put = 0;
+size_t lim, run;
+
+	while ( got < len && put < dstsz ) {
+		lim = len - got;
+		if ( lim > dstsz - put ) {
+			lim = dstsz - put;
+		}
+		run = scanFn( src + got, lim );
+		memcpy( dst + put, src + got, run );
+		got += run;
+		put += run;
+		if ( run == lim ) {
+			/* 'src' exhausted or 'dst' full */
+			continue;
+		}
+		/* special character; never split the escape sequence */
+		if ( dstsz - put < 2 ) {
+			break;
+		}
+		dst[put++] = ESCAP;
+		dst[put++] = src[got++];
+	}
+	*plen = got;
+	return put;
+}
+
+size_t
+byteDeStuffBuf(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t len, size_t *pput, int *pesc, int *peof)
+{
+size_t got = 0;
+size_t put = 0;
+size_t lim, run;
+
+	*peof = 0;
+
+	while ( got < len ) {
+		if ( *pesc ) {
+			/* escaped octet is data */
+			if ( dst ) {
+				if ( put >= dstsz ) {
+					break;
+				}
+				dst[put] = src[got];
+			}
+			put++;
+			got++;
+			*pesc = 0;
+		} else if ( COMMA == src[got] ) {
+			got++;
+			*peof = 1;
+			break;
+		} else if ( ESCAP == src[got] ) {
+			got++;
+			*pesc = 1;
+		} else {
+			lim = len - got;
+			if ( dst ) {
+				if ( put >= dstsz ) {
+					break;
+				}
+				if ( lim > dstsz - put ) {
+					lim = dstsz - put;
+				}
+			}
+			/* src[got] is not special, hence run >= 1 */
+			run = scanFn( src + got, lim );
+			if ( dst && dst + put != src + got ) {
+				memmove( dst + put, src + got, run );
+			}
+			got += run;
+			put += run;
+		}
+	}
+	*pput = put;
+	return got;
+}
+
+size_t
+cobsStuffBuf(uint8_t *dst, const uint8_t *src, size_t len)
+{
+size_t         put = 0;
+size_t         run;
+const uint8_t *q;
+
+	/* every frame has at least one block */
+	do {
+		run = ( len < BYTE_STUFF_COBS_MAXRUN ? len : BYTE_STUFF_COBS_MAXRUN );
+		if ( (q = memchr( src, COMMA, run )) ) {
+			run = q - src;
+		}
+		dst[put++] = ( q || run < BYTE_STUFF_COBS_MAXRUN ? run + 1 : 0xff ) ^ COMMA;
+		memcpy( dst + put, src, run );
+		put += run;
+		src += run;
+		len -= run;
+		if ( q ) {
+			/* implied by the code; a block must follow */
+			src++;
+			len--;
+		}
+	} while ( q || len > 0 );
+	return put;
+}
+
+/* cobsDeStuffBuf() state: octets left in the current block and whether
+ * a COMMA is implied before the next block
+ */
+#define COBS_ST_CNT_MSK 0xff
+#define COBS_ST_DLM     0x100
+
+size_t
+cobsDeStuffBuf(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t len, size_t *pput, int *pst, int *peof)
+{
+size_t         got = 0;
+size_t         put = 0;
+unsigned       cnt = (*pst & COBS_ST_CNT_MSK);
+int            dlm = !! (*pst & COBS_ST_DLM);
+size_t         lim;
+const uint8_t *q;
+uint8_t        c;
+
+	*peof = 0;
+
+	while ( got < len ) {
+		if ( COMMA == src[got] ) {
+			/* end of frame (or corrupted block); discard the implied COMMA */
+			got++;
+			cnt   = 0;
+			dlm   = 0;
+			*peof = 1;
+			break;
+		}
+		if ( 0 == cnt ) {
+			/* code octet; fetch it before storing the implied COMMA
+			 * which (when decoding in place) may occupy its location
+			 */
+			c = src[got] ^ COMMA;
+			if ( dlm ) {
+				if ( dst ) {
+					if ( put >= dstsz ) {
+						break;
+					}
+					dst[put] = COMMA;
+				}
+				put++;
+			}
+			got++;
+			cnt = c - 1;
+			dlm = ( 0xff != c );
+		} else {
+			lim = ( len - got < cnt ? len - got : cnt );
+			if ( dst ) {
+				if ( put >= dstsz ) {
+					break;
+				}
+				if ( lim > dstsz - put ) {
+					lim = dstsz - put;
+				}
+			}
+			/* data never contain COMMA unless the frame is corrupted */
+			if ( (q = memchr( src + got, COMMA, lim )) ) {
+				lim = q - (src + got);
+			}
+			if ( dst && dst + put != src + got ) {
+				memmove( dst + put, src + got, lim );
+			}
+			got += lim;
+			put += lim;
+			cnt -= lim;
+		}
+	}
+	*pst  = cnt | ( dlm ? COBS_ST_DLM : 0 );
+	*pput = put;
+	return got;
+}
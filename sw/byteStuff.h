@@ -0,0 +1,139 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Framing used by the firmware's ByteStuffer/ByteDeStuffer */
+#define BYTE_STUFF_COMMA 0xCA
+#define BYTE_STUFF_ESCAP 0x55
+
+/* Block-oriented (de-)stuffing kernels. The data are scanned for
+ * special characters (COMMA, ESCAP) in blocks (using SIMD instructions
+ * if the CPU supports them) and the clean runs in-between are copied
+ * with memcpy/memmove.
+ */
+typedef enum ByteStuffKernel {
+	BYTE_STUFF_KERNEL_AUTO,   /* best kernel supported by the CPU */
+	BYTE_STUFF_KERNEL_SCALAR,
+	BYTE_STUFF_KERNEL_SSE2,
+	BYTE_STUFF_KERNEL_AVX2
+} ByteStuffKernel;
+
+/* Select the kernel used by all routines below (the best available
+ * one is selected automatically on first use).
+ * RETURNS: 0 on success, -ENOTSUP if the kernel is not supported by
+ *          the CPU (or not compiled in).
+ */
+int
+byteStuffSelectKernel(ByteStuffKernel kern);
+
+const char *
+byteStuffKernelName(ByteStuffKernel kern);
+
+/* Return the currently selected kernel */
+ByteStuffKernel
+byteStuffGetKernel(void);
+
+/* RETURNS: index of the first COMMA or ESCAP character in 'buf' or
+ *          'len' if there is none.
+ */
+size_t
+byteStuffScan(const uint8_t *buf, size_t len);
+
+/* Stuff up to '*plen' octets from 'src' into 'dst' ('dstsz' octets).
+ * An escape sequence is never split; processing stops when 'src' is
+ * exhausted or 'dst' is full. Note that no terminating COMMA is
+ * appended.
+ *
+ * On return '*plen' holds the number of octets consumed from 'src'.
+ *
+ * RETURNS: number of octets stored in 'dst'.
+ */
+size_t
+byteStuffBuf(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t *plen);
+
+/* De-stuff up to 'len' octets from 'src' into 'dst' ('dstsz' octets).
+ * 'dst' may be identical to 'src' for in-place operation. If 'dst' is
+ * NULL then de-stuffed data are discarded (but still counted).
+ *
+ * Processing stops after a terminating COMMA has been consumed ('*peof'
+ * is set), when 'src' is exhausted or when 'dst' is full. The escape
+ * state is kept in '*pesc' (initialize to zero) so that a frame may be
+ * processed in multiple pieces.
+ *
+ * On return '*pput' holds the number of octets stored in 'dst'.
+ *
+ * RETURNS: number of octets consumed from 'src'.
+ */
+size_t
+byteDeStuffBuf(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t len, size_t *pput, int *pesc, int *peof);
+
+/* Alternative framing (consistent overhead byte stuffing, COBS) with
+ * bounded overhead: a frame is a sequence of blocks, each of which
+ * consists of a code octet 'n' (1..255, transmitted XORed with COMMA)
+ * followed by n-1 data octets. A COMMA is implied after every block
+ * with n < 255 except for the last one of the frame. Thus the data
+ * never contain COMMA and the overhead is at most one octet per
+ * BYTE_STUFF_COBS_MAXRUN octets (plus the terminating COMMA).
+ * Like with the ordinary framing a COMMA terminates the frame and a
+ * sequence of empty frames (COMMAs) resynchronizes the link.
+ */
+#define BYTE_STUFF_COBS_MAXRUN 254
+
+/* max. size of 'len' octets after COBS encoding (w/o COMMA) */
+#define BYTE_STUFF_COBS_MAXLEN(len) ( (len) + (len)/BYTE_STUFF_COBS_MAXRUN + 1 )
+
+/* COBS-encode the frame 'src' ('len' octets) into 'dst' which must
+ * have room for BYTE_STUFF_COBS_MAXLEN(len) octets. Note that no
+ * terminating COMMA is appended.
+ *
+ * RETURNS: number of octets stored in 'dst'.
+ */
+size_t
+cobsStuffBuf(uint8_t *dst, const uint8_t *src, size_t len);
+
+/* Decode COBS-encoded data; same semantics as byteDeStuffBuf() except
+ * for the decoder state '*pst' (initialize to zero) which replaces the
+ * escape state.
+ */
+size_t
+cobsDeStuffBuf(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t len, size_t *pput, int *pst, int *peof);
+
+#ifdef __cplusplus
+}
+#endif
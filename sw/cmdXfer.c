@@ -38,27 +38,68 @@
 #include <unistd.h>
 #include <string.h>
 #include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
 
 #include "cmdXfer.h"
+#include "byteStuff.h"
+#include "fwSim.h"
 
 #define MAXLEN 500
 
-#define COMMA  0xCA
-#define ESCAP  0x55
-
-static int fifoDebug = 0;
-
-typedef enum { RX, ESC, DONE } RxState;
+#define COMMA  BYTE_STUFF_COMMA
+#define ESCAP  BYTE_STUFF_ESCAP
+
+static int fifoDebug    = 0;
+static int fifoReadSize = FIFO_READ_SIZE_DFLT;
+
+/* framing of each link (indexed by fd; pselect() limits fds anyways) */
+static uint8_t fifoFraming[FD_SETSIZE];
+/* transport a link was opened with (NULL: TTY) */
+static const FifoTransportOps *fifoOps[FD_SETSIZE];
+
+typedef enum { TX_CMD, TX_DATA, TX_EOF, TX_DONE } TxPhase;
+
+/* Transmit progress of a single frame */
+typedef struct TxCursor {
+	TxPhase         phase;
+	size_t          idx;
+	size_t          off;
+	/* COBS: a block is open ('blk' octets left; ends with
+	 * an implied COMMA if 'dlm'), another block must follow
+	 */
+	int             cobs;
+	int             open;
+	int             dlm;
+	int             more;
+	size_t          blk;
+} TxCursor;
+
+/* Receive progress of a single frame */
+typedef struct RxCursor {
+	int             cobs;
+	int             esc;
+	int             done;
+	int             cmdReadback;
+	int             warned;
+	size_t          idx;
+	size_t          got;
+	size_t          tot;
+} RxCursor;
 
 /* Basic communication with the USB-FIFO (FT245), byte-stuffer/de-stuffer and command multiplexer in firmware */
 
-int fifoOpen(const char *devn, unsigned speed)
+static int
+ttyOpen(const char *devn, unsigned speed)
 {
 int                fd   = -1;
 char               msg[256];
 struct termios     atts;
-size_t             i,put;
-int                err  = 0;
+size_t             i;
+int                err;
 
     /* Special trick: open the TTY twice. If another program (minicom!)
      * already has the port opened (but w/o TIOCEXCL) then our first
@@ -128,29 +169,262 @@ int                err  = 0;
 	}
 */
 
-	for ( i = 0; i < 4; i++ ) {
-		msg[i] = COMMA;
+	return fd;
+
+bail:
+	err = -errno;
+	if ( fd >= 0 ) {
+		close( fd );
+	}
+	return err;
+}
+
+static ssize_t
+fdSend(int fd, const uint8_t *buf, size_t len)
+{
+	return write( fd, buf, len );
+}
+
+static ssize_t
+fdRecv(int fd, uint8_t *buf, size_t len)
+{
+	return read( fd, buf, len );
+}
+
+static int
+fdClose(int fd)
+{
+	fifoSetTransport( fd, NULL );
+	return close( fd ) ? -errno : 0;
+}
+
+static int
+sockOpenAddr(int domain, const struct sockaddr *sa, socklen_t salen, const char *path)
+{
+int  fd;
+int  err;
+int  one = 1;
+char msg[256];
+
+	if ( (fd = socket( domain, SOCK_STREAM, 0 )) < 0 ) {
+		err = -errno;
+		perror("unable to create socket");
+		return err;
+	}
+	if ( connect( fd, sa, salen ) ) {
+		err = -errno;
+		snprintf(msg, sizeof(msg), "unable to connect to '%s'", path);
+		perror(msg);
+		close( fd );
+		return err;
+	}
+	/* frames are small; don't let them wait for more data */
+	if ( AF_UNIX != domain && setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) ) ) {
+		perror("WARNING: setting TCP_NODELAY failed");
+	}
+	return fd;
+}
+
+static int
+unixOpen(const char *path, unsigned speed)
+{
+struct sockaddr_un sa;
+
+	if ( strlen( path ) >= sizeof(sa.sun_path) ) {
+		fprintf(stderr, "unix socket path '%s' too long\n", path);
+		return -ENAMETOOLONG;
+	}
+	memset( &sa, 0, sizeof(sa) );
+	sa.sun_family = AF_UNIX;
+	strcpy( sa.sun_path, path );
+	return sockOpenAddr( AF_UNIX, (struct sockaddr*)&sa, sizeof(sa), path );
+}
+
+/* 'path' is "host:port"; numerical IPv6 addresses must be enclosed in [] */
+static int
+tcpOpen(const char *path, unsigned speed)
+{
+char             host[256];
+const char      *port;
+size_t           hlen;
+struct addrinfo  hints, *res, *ai;
+int              st;
+int              fd = -ENOENT;
+
+	if ( ! (port = strrchr( path, ':' )) || ! port[1] ) {
+		fprintf(stderr, "tcp transport: port missing in '%s' (expected host:port)\n", path);
+		return -EINVAL;
+	}
+	hlen = port - path;
+	port++;
+	if ( hlen >= 2 && '[' == path[0] && ']' == path[hlen - 1] ) {
+		path++;
+		hlen -= 2;
+	}
+	if ( hlen >= sizeof(host) ) {
+		return -ENAMETOOLONG;
+	}
+	memcpy( host, path, hlen );
+	host[hlen] = 0;
+
+	memset( &hints, 0, sizeof(hints) );
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if ( (st = getaddrinfo( hlen ? host : NULL, port, &hints, &res )) ) {
+		fprintf(stderr, "tcp transport: unable to resolve '%s': %s\n", host, gai_strerror( st ));
+		return -EHOSTUNREACH;
+	}
+	for ( ai = res; ai; ai = ai->ai_next ) {
+		if ( (fd = sockOpenAddr( ai->ai_family, ai->ai_addr, ai->ai_addrlen, host )) >= 0 ) {
+			break;
+		}
+	}
+	freeaddrinfo( res );
+	return fd;
+}
+
+static ssize_t
+sockSend(int fd, const uint8_t *buf, size_t len)
+{
+	/* report a lost peer as EPIPE rather than dying from SIGPIPE */
+	return send( fd, buf, len, MSG_NOSIGNAL );
+}
+
+static ssize_t
+sockRecv(int fd, uint8_t *buf, size_t len)
+{
+	return recv( fd, buf, len, 0 );
+}
+
+const FifoTransportOps fifoTransportTty = {
+	.scheme = "tty",
+	.open   = ttyOpen,
+	.send   = fdSend,
+	.recv   = fdRecv,
+	.close  = fdClose,
+};
+
+const FifoTransportOps fifoTransportUnix = {
+	.scheme = "unix",
+	.open   = unixOpen,
+	.send   = sockSend,
+	.recv   = sockRecv,
+	.close  = fdClose,
+};
+
+const FifoTransportOps fifoTransportTcp = {
+	.scheme = "tcp",
+	.open   = tcpOpen,
+	.send   = sockSend,
+	.recv   = sockRecv,
+	.close  = fdClose,
+};
+
+#define MAX_TRANSPORTS 8
+
+static const FifoTransportOps *fifoTransports[MAX_TRANSPORTS] = {
+	&fifoTransportTty,
+	&fifoTransportUnix,
+	&fifoTransportTcp,
+	&fifoTransportSim,
+};
+
+int
+fifoTransportRegister(const FifoTransportOps *ops)
+{
+int i;
+
+	for ( i = 0; i < MAX_TRANSPORTS; i++ ) {
+		if ( ! fifoTransports[i] || 0 == strcmp( fifoTransports[i]->scheme, ops->scheme ) ) {
+			fifoTransports[i] = ops;
+			return 0;
+		}
+	}
+	return -ENOSPC;
+}
+
+const FifoTransportOps *
+fifoTransportFind(const char *uri, const char **ppath)
+{
+const char *col;
+size_t      l;
+int         i;
+
+	if ( (col = strchr( uri, ':' )) ) {
+		l = col - uri;
+		for ( i = 0; i < MAX_TRANSPORTS && fifoTransports[i]; i++ ) {
+			if ( strlen( fifoTransports[i]->scheme ) == l && 0 == strncmp( uri, fifoTransports[i]->scheme, l ) ) {
+				if ( ppath ) {
+					*ppath = col + 1;
+				}
+				return fifoTransports[i];
+			}
+		}
 	}
-	put = write( fd, msg, i );
-	if ( i != put ) {
+	/* plain device name */
+	if ( ppath ) {
+		*ppath = uri;
+	}
+	return &fifoTransportTty;
+}
+
+static int
+fifoSync(const FifoTransportOps *ops, int fd)
+{
+uint8_t msg[4];
+ssize_t put;
+
+	memset( msg, COMMA, sizeof(msg) );
+	put = ops->send( fd, msg, sizeof(msg) );
+	if ( sizeof(msg) != put ) {
 		perror("Writing syncing commas failed");
-		err = put < 0 ? -errno : -EIO;
-		goto bail;
+		return put < 0 ? -errno : -EIO;
 	}
+	return 0;
+}
+
+int
+fifoOpenURI(const char *uri, unsigned speed, const FifoTransportOps **pops)
+{
+const FifoTransportOps *ops  = fifoTransportFind( uri, &uri );
+int                     fd, st;
 
+	if ( (fd = ops->open( uri, speed )) < 0 ) {
+		return fd;
+	}
+	if ( (st = fifoSync( ops, fd )) ) {
+		ops->close( fd );
+		return st;
+	}
+	fifoSetFraming( fd, FIFO_FRAMING_STUFF );
+	fifoSetTransport( fd, ops );
+	if ( pops ) {
+		*pops = ops;
+	}
 	return fd;
+}
 
-bail:
-	if ( fd >= 0 ) {
+int fifoOpen(const char *devn, unsigned speed)
+{
+int fd, st;
+
+	if ( (fd = ttyOpen( devn, speed )) < 0 ) {
+		return fd;
+	}
+	if ( (st = fifoSync( &fifoTransportTty, fd )) ) {
 		close( fd );
+		return st;
 	}
-	return err ? err : -errno;
+	fifoSetFraming( fd, FIFO_FRAMING_STUFF );
+	fifoSetTransport( fd, &fifoTransportTty );
+	return fd;
 }
 
 int
 fifoClose( int fd )
 {
 	if ( fd >= 0 ) {
+		fifoSetTransport( fd, NULL );
 		close ( fd );
 	}
 	return 0;
@@ -206,6 +480,51 @@ int oldVal = fifoDebug;
 	return oldVal;
 }
 
+int
+fifoSetReadSize(int val)
+{
+int oldVal = fifoReadSize;
+	if ( val >= 0 ) {
+		fifoReadSize = val;
+	}
+	return oldVal;
+}
+
+int
+fifoSetFraming(int fd, FifoFraming framing)
+{
+int oldVal;
+
+	if ( fd < 0 || fd >= FD_SETSIZE ) {
+		return -EBADF;
+	}
+	oldVal = fifoFraming[fd];
+	fifoFraming[fd] = framing;
+	return oldVal;
+}
+
+FifoFraming
+fifoGetFraming(int fd)
+{
+	return ( fd < 0 || fd >= FD_SETSIZE ) ? FIFO_FRAMING_STUFF : (FifoFraming)fifoFraming[fd];
+}
+
+int
+fifoSetTransport(int fd, const FifoTransportOps *ops)
+{
+	if ( fd < 0 || fd >= FD_SETSIZE ) {
+		return -EBADF;
+	}
+	fifoOps[fd] = ops;
+	return 0;
+}
+
+const FifoTransportOps *
+fifoGetTransport(int fd)
+{
+	return ( fd < 0 || fd >= FD_SETSIZE || ! fifoOps[fd] ) ? &fifoTransportTty : fifoOps[fd];
+}
+
 int
 fifoXferFrame(int fd, uint8_t *cmdp, const uint8_t *tbuf, size_t tlen, uint8_t *rbuf, size_t rlen)
 {
@@ -223,62 +542,367 @@ rbufvec rvec[1];
 int
 fifoXferFrameVec(int fd, uint8_t *cmdp, const tbufvec *tbuf, size_t tcnt, const rbufvec *rbuf, size_t rcnt)
 {
+FifoXferReq req;
+int         st;
+
+	req.cmdp   = cmdp;
+	req.tbuf   = tbuf;
+	req.tcnt   = tcnt;
+	req.rbuf   = rbuf;
+	req.rcnt   = rcnt;
+	req.status = 0;
+
+	st = fifoXferFrameVecMultiOps( fifoGetTransport( fd ), fd, &req, 1, 1 );
+
+	return st < 0 ? st : req.status;
+}
+
+static void
+txStart(TxCursor *tx, const FifoXferReq *req)
+{
+	tx->phase = req->cmdp ? TX_CMD : TX_DATA;
+	tx->off   = 0;
+	tx->idx   = 0;
+	tx->open  = 0;
+	tx->dlm   = 0;
+	tx->blk   = 0;
+	/* every COBS frame has at least one block */
+	tx->more  = 1;
+	while ( tx->idx < req->tcnt && 0 == req->tbuf[tx->idx].len ) {
+		tx->idx++;
+	}
+}
+
+/* Contiguous octets of the frame (command followed by the tbufvecs)
+ * at the cursor position.
+ * RETURNS: pointer to the octets or NULL at the end of the frame.
+ */
+static const uint8_t *
+txChunk(const TxCursor *tx, const FifoXferReq *req, size_t *plen)
+{
+	if ( TX_CMD == tx->phase ) {
+		*plen = 1;
+		return req->cmdp;
+	}
+	if ( tx->idx >= req->tcnt ) {
+		*plen = 0;
+		return NULL;
+	}
+	*plen = req->tbuf[tx->idx].len - tx->off;
+	return req->tbuf[tx->idx].buf + tx->off;
+}
+
+/* Advance the cursor by 'n' octets of the current chunk */
+static void
+txAdvance(TxCursor *tx, const FifoXferReq *req, size_t n)
+{
+	if ( TX_CMD == tx->phase ) {
+		tx->phase = TX_DATA;
+		return;
+	}
+	tx->off += n;
+	if ( tx->off == req->tbuf[tx->idx].len ) {
+		tx->off = 0;
+		while ( ++tx->idx < req->tcnt && 0 == req->tbuf[tx->idx].len ) {
+			/* skip empty vectors */
+		}
+	}
+}
+
+/* Length of the COBS block starting at the cursor; '*pdlm' is set if
+ * it is terminated by a COMMA.
+ */
+static size_t
+txRun(const TxCursor *tx, const FifoXferReq *req, int *pdlm)
+{
+TxCursor       c = *tx;
+const uint8_t *p, *q;
+size_t         l;
+size_t         n = 0;
+
+	*pdlm = 0;
+	while ( n < BYTE_STUFF_COBS_MAXRUN && (p = txChunk( &c, req, &l )) ) {
+		if ( l > BYTE_STUFF_COBS_MAXRUN - n ) {
+			l = BYTE_STUFF_COBS_MAXRUN - n;
+		}
+		if ( (q = memchr( p, COMMA, l )) ) {
+			*pdlm = 1;
+			return n + (q - p);
+		}
+		n += l;
+		txAdvance( &c, req, l );
+	}
+	return n;
+}
+
+/* COBS version of txFill() */
+static size_t
+txFillCobs(TxCursor *tx, const FifoXferReq *req, uint8_t *dbuf, size_t dbufsz)
+{
+size_t         rval = 0;
+size_t         n;
+const uint8_t *p;
+
+	while ( TX_EOF != tx->phase && rval < dbufsz ) {
+		if ( tx->open ) {
+			if ( tx->blk > 0 ) {
+				p = txChunk( tx, req, &n );
+				if ( n > tx->blk ) {
+					n = tx->blk;
+				}
+				if ( n > dbufsz - rval ) {
+					n = dbufsz - rval;
+				}
+				memcpy( dbuf + rval, p, n );
+				txAdvance( tx, req, n );
+				rval    += n;
+				tx->blk -= n;
+			} else {
+				if ( tx->dlm ) {
+					/* implied by the code */
+					txAdvance( tx, req, 1 );
+				}
+				tx->more = tx->dlm;
+				tx->open = 0;
+			}
+		} else if ( tx->more || txChunk( tx, req, &n ) ) {
+			tx->blk    = txRun( tx, req, &tx->dlm );
+			dbuf[rval] = ( tx->dlm || tx->blk < BYTE_STUFF_COBS_MAXRUN ? tx->blk + 1 : 0xff ) ^ COMMA;
+			rval++;
+			tx->open   = 1;
+			tx->more   = 0;
+		} else {
+			tx->phase  = TX_EOF;
+		}
+	}
+	if ( TX_EOF == tx->phase && dbufsz - rval >= 1 ) {
+		dbuf[rval] = COMMA;
+		rval++;
+		tx->phase  = TX_DONE;
+	}
+	return rval;
+}
+
+/* Stuff as much of the frame as fits into 'dbuf'; the frame is
+ * complete once 'phase' reaches TX_DONE.
+ * RETURNS: number of octets stored in 'dbuf'.
+ */
+static size_t
+txFill(TxCursor *tx, const FifoXferReq *req, uint8_t *dbuf, size_t dbufsz)
+{
+size_t rval = 0;
+size_t n;
+
+	if ( tx->cobs ) {
+		return txFillCobs( tx, req, dbuf, dbufsz );
+	}
+
+	if ( TX_CMD == tx->phase && dbufsz - rval >= 2 ) {
+		rval     += stuff( dbuf + rval, dbufsz - rval, req->cmdp );
+		tx->phase = TX_DATA;
+	}
+	while ( TX_DATA == tx->phase && dbufsz - rval >= 2 ) {
+		if ( tx->idx >= req->tcnt ) {
+			tx->phase = TX_EOF;
+			break;
+		}
+		n        = req->tbuf[tx->idx].len - tx->off;
+		rval    += byteStuffBuf( dbuf + rval, dbufsz - rval, req->tbuf[tx->idx].buf + tx->off, &n );
+		tx->off += n;
+		if ( tx->off == req->tbuf[tx->idx].len ) {
+			tx->off = 0;
+			while ( ++tx->idx < req->tcnt && 0 == req->tbuf[tx->idx].len ) {
+				/* skip empty vectors */
+			}
+		}
+	}
+	if ( TX_EOF == tx->phase && dbufsz - rval >= 1 ) {
+		dbuf[rval] = COMMA;
+		rval++;
+		tx->phase  = TX_DONE;
+	}
+	return rval;
+}
+
+static void
+rxStart(RxCursor *rx, const FifoXferReq *req)
+{
+	rx->esc         = 0;
+	rx->done        = 0;
+	rx->cmdReadback = ( req->cmdp ? 1 : 0 );
+	rx->got         = 0;
+	rx->tot         = 0;
+	rx->idx         = 0;
+	while ( rx->idx < req->rcnt && 0 == req->rbuf[rx->idx].len ) {
+		rx->idx++;
+	}
+	rx->warned      = ( rx->idx >= req->rcnt );
+}
+
+/* De-stuff received octets into the frame's rbufvec; stops after
+ * the terminating COMMA ('done' is set).
+ * RETURNS: number of octets consumed.
+ */
+static size_t
+rxProcess(RxCursor *rx, FifoXferReq *req, const uint8_t *buf, size_t len)
+{
+size_t   j = 0;
+size_t   put;
+uint8_t *dst;
+size_t   room;
+
+	while ( j < len && ! rx->done ) {
+		if ( rx->cmdReadback ) {
+			dst  = req->cmdp;
+			room = 1;
+		} else if ( rx->idx < req->rcnt ) {
+			dst  = req->rbuf[rx->idx].buf + rx->got;
+			room = req->rbuf[rx->idx].len - rx->got;
+		} else {
+			/* discard */
+			dst  = NULL;
+			room = 0;
+		}
+		if ( rx->cobs ) {
+			j += cobsDeStuffBuf( dst, room, buf + j, len - j, &put, &rx->esc, &rx->done );
+		} else {
+			j += byteDeStuffBuf( dst, room, buf + j, len - j, &put, &rx->esc, &rx->done );
+		}
+		if ( 0 == put ) {
+			continue;
+		}
+		if ( rx->cmdReadback ) {
+			rx->cmdReadback = 0;
+		} else if ( rx->idx < req->rcnt ) {
+			rx->got += put;
+			if ( rx->got == req->rbuf[rx->idx].len ) {
+				rx->tot += rx->got;
+				rx->got  = 0;
+				while ( ++rx->idx < req->rcnt && 0 == req->rbuf[rx->idx].len ) {
+					/* skip empty vectors */
+				}
+			}
+		} else if ( ! rx->warned ) {
+			fprintf(stderr, "fifoXferFrame: RX buffer too small; truncating frame (got %zu)\n", rx->tot);
+			rx->warned = 1;
+		}
+	}
+	return j;
+}
+
+/* Does [p, p + len) overlap the command or any tbufvec of a frame that
+ * has not been stuffed completely ('reqs[tidx..nreqs-1]')?
+ */
+static int
+txOverlaps(const uint8_t *p, size_t len, const FifoXferReq *reqs, size_t tidx, size_t nreqs)
+{
+size_t k, i;
+
+	for ( k = tidx; k < nreqs; k++ ) {
+		if ( reqs[k].cmdp && reqs[k].cmdp >= p && reqs[k].cmdp < p + len ) {
+			return 1;
+		}
+		for ( i = 0; i < reqs[k].tcnt; i++ ) {
+			if ( reqs[k].tbuf[i].len && reqs[k].tbuf[i].buf < p + len && p < reqs[k].tbuf[i].buf + reqs[k].tbuf[i].len ) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* If the current frame ('reqs[ridx]') is receiving into a sufficiently
+ * large rbufvec then read directly into the caller's buffer; rxProcess()
+ * de-stuffs in place (the de-stuffed data never overtake the raw data).
+ * The raw data do overtake the request data, however, if the caller
+ * receives into (part of) a buffer which is still to be sent (the
+ * firmware may reply while the request is streaming in); such frames
+ * use the staging buffer.
+ * RETURNS: pointer into the caller's buffer or NULL if the staging
+ *          buffer should be used.
+ */
+static uint8_t *
+rxDirect(const RxCursor *rx, const FifoXferReq *reqs, size_t ridx, size_t tidx, size_t nreqs, size_t *plen)
+{
+const FifoXferReq *req = &reqs[ridx];
+size_t             room;
+uint8_t           *p;
+
+	if ( fifoReadSize < MAXLEN || rx->cmdReadback || rx->idx >= req->rcnt ) {
+		return NULL;
+	}
+	room = req->rbuf[rx->idx].len - rx->got;
+	if ( room < MAXLEN ) {
+		return NULL;
+	}
+	p = req->rbuf[rx->idx].buf + rx->got;
+	if ( txOverlaps( p, room, reqs, tidx, nreqs ) ) {
+		return NULL;
+	}
+	*plen = ( room < (size_t)fifoReadSize ? room : (size_t)fifoReadSize );
+	return p;
+}
+
+int
+fifoXferFrameVecMulti(int fd, FifoXferReq *reqs, size_t nreqs, size_t depth)
+{
+	return fifoXferFrameVecMultiOps( fifoGetTransport( fd ), fd, reqs, nreqs, depth );
+}
+
+int
+fifoXferFrameVecMultiOps(const FifoTransportOps *ops, int fd, FifoXferReq *reqs, size_t nreqs, size_t depth)
+{
 uint8_t         tbufs[MAXLEN];
 uint8_t         rbufs[MAXLEN];
-size_t          i, j, tlens, rlens, puts, put, got, tot, tidx, ridx, tlen, rlen;
+uint8_t        *rptr;
+size_t          rlen;
+size_t          j, tlens, puts, tidx, ridx;
+ssize_t         i;
 fd_set          rfds, tfds;
-RxState         state       = RX;
-int             warned;
-int             eofSent     = 0;
-int             cmdReadback = 0;
+TxCursor        tx;
+RxCursor        rx;
 struct timespec timeout;
+int             st;
+
+	if ( 0 == depth ) {
+		depth = FIFO_XFER_DEPTH_DFLT;
+	}
+
+	/* the framing must not change while frames are in flight */
+	tx.cobs = rx.cobs = ( FIFO_FRAMING_COBS == fifoGetFraming( fd ) );
 
 	tlens = 0;
-	rlens = sizeof(rbufs);
-	put   = got  = tot = 0;
 	puts  = 0;
 	tidx  = ridx = 0;
-    tlen  = 0;
-    while ( tidx < tcnt && 0 == (tlen = tbuf[tidx].len) ) {
-		tidx++;
-	}
-    while ( ridx < rcnt && 0 == (rlen = rbuf[ridx].len) ) {
-		ridx++;
-	}
-    warned = (0 == rlen ? 1 : 0);
 
-	if ( cmdp ) {
-		tlens      += stuff( tbufs + tlens, sizeof(tbufs) - tlens, cmdp );
-		cmdReadback = 1;
+	if ( nreqs > 0 ) {
+		txStart( &tx, &reqs[tidx] );
+		rxStart( &rx, &reqs[ridx] );
 	}
 
-	while ( ( ! eofSent ) || ( tlens > 0 ) || (DONE != state ) ) {
+	/* Replies arrive in the order the frames were sent (the firmware's
+	 * CommandMux handles one frame at a time) and are thus matched to
+	 * the requests by position. 'tidx' is the frame currently being
+	 * stuffed; frames ridx..tidx are in flight.
+	 */
+	while ( ( ridx < nreqs ) || ( tlens > 0 ) ) {
 		FD_ZERO( &rfds );
 		FD_ZERO( &tfds );
 
-		if ( ( 0 == tlens ) ) {
+		if ( 0 == tlens ) {
 			puts = 0;
-			if ( ( tlen > put ) ) {
-				while ( ( tlen > put ) && ( tlens < sizeof(tbufs) - 3 ) ) {
-					/* Stuff tbuf */
-					tlens += stuff( tbufs + tlens, sizeof(tbufs) - tlens, tbuf[tidx].buf + put );
-					put++;
-					while ( put == tlen && ++tidx < tcnt ) {
-						put  = 0;
-						tlen = tbuf[tidx].len;
-					}
+			while ( ( tidx < nreqs ) && ( tidx - ridx < depth ) && ( tlens < sizeof(tbufs) - 3 ) ) {
+				tlens += txFill( &tx, &reqs[tidx], tbufs + tlens, sizeof(tbufs) - tlens );
+				if ( TX_DONE == tx.phase && ++tidx < nreqs ) {
+					txStart( &tx, &reqs[tidx] );
 				}
-			} else if ( ! eofSent ) {
-				tbufs[tlens] = COMMA;
-				tlens++;
-				eofSent      = 1;
 			}
 		}
 
 		if ( tlens > 0 ) {
 			FD_SET( fd, &tfds );
 		}
-		if ( DONE != state ) {
+		if ( ridx < nreqs ) {
 			FD_SET( fd, &rfds );
 		}
 
@@ -289,7 +913,8 @@ struct timespec timeout;
 		if ( i <= 0 ) {
 			if ( 0 == i ) {
 				/* Timeout */
-				return -ETIMEDOUT;
+				st = -ETIMEDOUT;
+				goto fail;
 			}
 			perror("select failure");
 			goto bail;
@@ -299,7 +924,7 @@ struct timespec timeout;
 			if ( fifoDebug > 0 ) {
 				prb( "Sending:", tbufs+puts, tlens );
 			}
-			if ( (i = write(fd, tbufs + puts, tlens)) <= 0 ) {
+			if ( (i = ops->send(fd, tbufs + puts, tlens)) <= 0 ) {
 				perror("fifoXferFrame: writing FIFO failed");
 				if ( 0 == i ) {
 					errno = EIO;
@@ -310,7 +935,11 @@ struct timespec timeout;
 			tlens -= i;
 		}
 		if ( FD_ISSET( fd, &rfds ) ) {
-			if ( (i = read(fd, rbufs, rlens)) <= 0 ) {
+			if ( ! (rptr = rxDirect( &rx, reqs, ridx, tidx, nreqs, &rlen )) ) {
+				rptr = rbufs;
+				rlen = sizeof(rbufs);
+			}
+			if ( (i = ops->recv(fd, rptr, rlen)) <= 0 ) {
 				perror("fifoXferFrame: reading FIFO failed");
 				if ( 0 == i ) {
 					errno = EIO;
@@ -318,47 +947,32 @@ struct timespec timeout;
 				goto bail;
 			}
 			if ( fifoDebug > 0 ) {
-				prb( "Received:", rbufs, i );
+				prb( "Received:", rptr, i );
 			}
-			for ( j = 0; j < i; j++ ) {
-				if ( ESC != state && COMMA == rbufs[j] ) {
-					state = DONE;
-					if ( j + 1 < i ) {
-						fprintf(stderr, "fifoXferFrame: WARNING -- received comma but there are extra data\n");
-						break;
-					}
-				} else if ( ESC != state && ESCAP == rbufs[j] ) {
-					state = ESC;
-				} else {
-					state = RX;
-					if ( cmdReadback ) {
-						*cmdp = rbufs[j];
-						cmdReadback = 0;
-					} else {
-						if ( got >= rlen ) {
-							if ( ! warned ) {
-								fprintf(stderr, "fifoXferFrame: RX buffer too small; truncating frame (got %zu >= rlen %zu)\n", got, rlen);
-								warned = 1;
-							}
-						} else {
-							rbuf[ridx].buf[got] = rbufs[j];
-							got++;
-							while ( got == rlen && ++ridx < rcnt ) {
-                                tot += got;
-								got  = 0;
-								rlen = rbuf[ridx].len;
-							}
-						}
+			for ( j = 0; j < i; ) {
+				if ( ridx >= nreqs ) {
+					fprintf(stderr, "fifoXferFrame: WARNING -- received comma but there are extra data\n");
+					break;
+				}
+				j += rxProcess( &rx, &reqs[ridx], rptr + j, i - j );
+				if ( rx.done ) {
+					reqs[ridx].status = rx.tot + rx.got;
+					if ( ++ridx < nreqs ) {
+						rxStart( &rx, &reqs[ridx] );
 					}
 				}
 			}
 		}
 	}
 
-	tot += got;
-
-	return tot;
+	return 0;
 
 bail:
-	return -errno;
+	st = -errno;
+fail:
+	/* frames that have not completed share the fate of the link */
+	for ( ; ridx < nreqs; ridx++ ) {
+		reqs[ridx].status = st;
+	}
+	return st;
 }
@@ -31,6 +31,7 @@
 #else
 #include <stdint.h>
 #endif
+#include <sys/types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,11 +41,94 @@ int fifoOpen(const char *devn, unsigned speed);
 
 int fifoClose(int fd);
 
+/* Transport backends.
+ *
+ * All backends are file-descriptor based (so that the transfer routines
+ * may pselect() on them) but may open, send, receive and close in their
+ * own way (e.g., no termios on sockets).
+ *
+ *   open:  open 'path' (the URI with the scheme stripped; 'speed' is
+ *          only meaningful for TTYs); RETURNS fd or negative errno.
+ *   send:  semantics of write(2).
+ *   recv:  semantics of read(2).
+ *   close: RETURNS 0 or negative errno.
+ */
+typedef struct FifoTransportOps {
+	const char *scheme;
+	int       (*open) (const char *path, unsigned speed);
+	ssize_t   (*send) (int fd, const uint8_t *buf, size_t len);
+	ssize_t   (*recv) (int fd, uint8_t *buf, size_t len);
+	int       (*close)(int fd);
+} FifoTransportOps;
+
+/* "tty:/dev/ttyACM0" */
+extern const FifoTransportOps fifoTransportTty;
+/* "unix:/path/to/socket" */
+extern const FifoTransportOps fifoTransportUnix;
+/* "tcp:host:port" (numerical IPv6 addresses must be enclosed in []) */
+extern const FifoTransportOps fifoTransportTcp;
+/* "sim:" (in-process firmware model) is declared in fwSim.h */
+
+/* Register an additional backend (or replace the one with the same scheme).
+ * RETURNS: 0 or -ENOSPC if the table is full.
+ */
+int fifoTransportRegister(const FifoTransportOps *ops);
+
+/* Find the backend for 'uri' ("<scheme>:<path>"); a uri without a known
+ * scheme is considered a TTY device name. A pointer to the path portion
+ * is stored in '*ppath' (if non-NULL).
+ */
+const FifoTransportOps *fifoTransportFind(const char *uri, const char **ppath);
+
+/* Open the link described by 'uri' (see fifoTransportFind()) and synchronize
+ * the de-stuffer in the firmware. The transport is returned in '*pops'.
+ * The link must be closed with (*pops)->close().
+ * RETURNS: file descriptor or negative errno.
+ */
+int fifoOpenURI(const char *uri, unsigned speed, const FifoTransportOps **pops);
+
+/* Transport associated with a link by fifoOpenURI() or fifoOpen(); the
+ * transfer routines which take no 'ops' argument use it. Backends reset
+ * the association when closing. fifoGetTransport() returns
+ * fifoTransportTty for a descriptor without an association.
+ * fifoSetTransport() returns 0 or -EBADF.
+ */
+int fifoSetTransport(int fd, const FifoTransportOps *ops);
+
+const FifoTransportOps *fifoGetTransport(int fd);
+
 /* set new debug level and return the previous one; if 'val < 0' then
  * the current level is unchanged (and returned).
  */
 int fifoSetDebug(int val);
 
+/* Set the max. number of octets read with a single system call when
+ * receiving into a large caller buffer (which is then de-stuffed in
+ * place, avoiding a staging copy). Small buffers are always received
+ * via an internal staging buffer. A value smaller than 500 disables
+ * reading into the caller's buffer.
+ * Returns the previous value; if 'val < 0' then the current value is
+ * unchanged (and returned).
+ */
+#define FIFO_READ_SIZE_DFLT 65536
+
+int fifoSetReadSize(int val);
+
+/* Framing of a link: COMMA/ESCAP byte-stuffing (default) or COBS
+ * (see byteStuff.h). The framing must match the firmware's; it is
+ * negotiated by fw_set_framing() (fwComm.h) and reset to stuffing
+ * by fifoOpen()/fifoOpenURI().
+ * fifoSetFraming() returns the previous framing or -EBADF.
+ */
+typedef enum FifoFraming {
+	FIFO_FRAMING_STUFF = 0,
+	FIFO_FRAMING_COBS  = 1
+} FifoFraming;
+
+int fifoSetFraming(int fd, FifoFraming framing);
+
+FifoFraming fifoGetFraming(int fd);
+
 typedef struct rbufvec {
 	uint8_t *buf;
 	size_t   len;
@@ -61,6 +145,43 @@ int fifoXferFrame(int fd, uint8_t *cmdp, const uint8_t *tbuf, size_t tlen, uint8
 
 int fifoXferFrameVec(int fd, uint8_t *cmdp, const tbufvec *tbuf, size_t tcnt, const rbufvec *rbuf, size_t rcnt);
 
+/* Pipelined transfer of multiple frames.
+ *
+ * Each request describes one frame (same semantics as the arguments
+ * of fifoXferFrameVec(); '*cmdp' is overwritten with the command
+ * read back from the firmware). Up to 'depth' frames are sent ahead
+ * of the replies (0 selects FIFO_XFER_DEPTH_DFLT; 1 is equivalent to
+ * a sequence of fifoXferFrameVec() calls). Since the firmware processes
+ * frames strictly in order the replies are matched to the requests
+ * by position.
+ *
+ * On return the 'status' of every request holds the number of bytes
+ * received or a negative error code.
+ *
+ * RETURNS: 0 if all frames were completed or the (negative) error code
+ *          which aborted the transfer (e.g., -ETIMEDOUT); all frames
+ *          still outstanding at this point have their 'status' set to
+ *          the same value.
+ */
+#define FIFO_XFER_DEPTH_DFLT 8
+
+typedef struct FifoXferReq {
+	uint8_t       *cmdp;
+	const tbufvec *tbuf;
+	size_t         tcnt;
+	const rbufvec *rbuf;
+	size_t         rcnt;
+	int            status;
+} FifoXferReq;
+
+int fifoXferFrameVecMulti(int fd, FifoXferReq *reqs, size_t nreqs, size_t depth);
+
+/* Same as fifoXferFrameVecMulti() but using the I/O routines of transport 'ops'
+ * (fifoXferFrameVecMulti() uses the transport associated with 'fd'; see
+ * fifoGetTransport()).
+ */
+int fifoXferFrameVecMultiOps(const FifoTransportOps *ops, int fd, FifoXferReq *reqs, size_t nreqs, size_t depth);
+
 #ifdef __cplusplus
 }
 #endif
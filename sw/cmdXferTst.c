@@ -0,0 +1,170 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Transfer tests using a loopback transport which echoes the (raw)
+ * stream while the frame is still being sent - as the firmware does
+ * with commands such as bit-bang SPI. Such a reply is a valid frame
+ * with the contents of the request (including the command readback).
+ */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "cmdXfer.h"
+#include "byteStuff.h"
+
+#define NELMS  100000
+#define ECHOSZ 64
+
+static void *
+echoThread(void *arg)
+{
+int     fd = (int)(intptr_t)arg;
+uint8_t buf[ECHOSZ];
+ssize_t got;
+
+	while ( (got = read( fd, buf, sizeof(buf) )) > 0 ) {
+		if ( write( fd, buf, got ) != got ) {
+			break;
+		}
+	}
+	close( fd );
+	return NULL;
+}
+
+static int
+echoOpen(const char *path, unsigned speed)
+{
+int       sv[2];
+pthread_t tid;
+
+	if ( socketpair( AF_UNIX, SOCK_STREAM, 0, sv ) ) {
+		return -errno;
+	}
+	if ( pthread_create( &tid, NULL, echoThread, (void*)(intptr_t)sv[1] ) ) {
+		close( sv[0] );
+		close( sv[1] );
+		return -EAGAIN;
+	}
+	pthread_detach( tid );
+	return sv[0];
+}
+
+static ssize_t
+echoSend(int fd, const uint8_t *buf, size_t len)
+{
+	return write( fd, buf, len );
+}
+
+static ssize_t
+echoRecv(int fd, uint8_t *buf, size_t len)
+{
+	return read( fd, buf, len );
+}
+
+static int
+echoClose(int fd)
+{
+	fifoSetTransport( fd, NULL );
+	return close( fd ) ? -errno : 0;
+}
+
+static const FifoTransportOps echoTransport = {
+	.scheme = "echo",
+	.open   = echoOpen,
+	.send   = echoSend,
+	.recv   = echoRecv,
+	.close  = echoClose,
+};
+
+/* data which (mostly) need escaping expand when stuffed */
+static void
+fill(uint8_t *buf, size_t len)
+{
+size_t i;
+	for ( i = 0; i < len; i++ ) {
+		buf[i] = ( i % 7 ) ? ( ( i & 1 ) ? BYTE_STUFF_COMMA : BYTE_STUFF_ESCAP ) : (uint8_t)i;
+	}
+}
+
+static void
+xfer(int fd, FifoFraming framing)
+{
+uint8_t *buf, *ref, *rbuf;
+uint8_t  cmd = 0x5a;
+
+	assert( (buf  = malloc( NELMS )) );
+	assert( (ref  = malloc( NELMS )) );
+	assert( (rbuf = malloc( NELMS )) );
+	fill( ref, NELMS );
+	assert( fifoSetFraming( fd, framing ) >= 0 );
+
+	/* separate buffers */
+	memcpy( buf, ref, NELMS );
+	memset( rbuf, 0, NELMS );
+	assert( NELMS == fifoXferFrame( fd, &cmd, buf, NELMS, rbuf, NELMS ) );
+	assert( 0 == memcmp( rbuf, ref, NELMS ) );
+
+	/* the reply overwrites the request */
+	memcpy( buf, ref, NELMS );
+	assert( NELMS == fifoXferFrame( fd, &cmd, buf, NELMS, buf, NELMS ) );
+	assert( 0 == memcmp( buf, ref, NELMS ) );
+
+	free( buf );
+	free( ref );
+	free( rbuf );
+}
+
+int
+main(int argc, char **argv)
+{
+const FifoTransportOps *ops;
+int                     fd, n;
+uint8_t                 c;
+
+	assert( 0 == fifoTransportRegister( &echoTransport ) );
+	assert( (fd = fifoOpenURI( "echo:", 0, &ops )) >= 0 );
+	assert( ops == &echoTransport && fifoGetTransport( fd ) == &echoTransport );
+	/* consume the echo of the synchronizing COMMAs */
+	for ( n = 0; n < 4; n++ ) {
+		assert( 1 == ops->recv( fd, &c, 1 ) && BYTE_STUFF_COMMA == c );
+	}
+
+	xfer( fd, FIFO_FRAMING_STUFF );
+	xfer( fd, FIFO_FRAMING_COBS  );
+
+	assert( 0 == ops->close( fd ) );
+	printf("%s Test PASSED\n", argv[0]);
+	return 0;
+}
@@ -0,0 +1,351 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Micro-benchmark (and consistency check) of the sample conversion,
+ * unpacking, accumulation and statistics kernels
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "sampleConv.h"
+#include "sampleAccum.h"
+#include "sampleStats.h"
+
+#define MAX_CH 3
+
+static void usage(const char *nm)
+{
+	printf("usage: %s [-h] [-s nsamples] [-r repeat]\n", nm);
+	printf("   -h           : this message.\n");
+	printf("   -s nsamples  : samples per channel (default: 1M).\n");
+	printf("   -r repeat    : number of repetitions per measurement (default: 10).\n");
+}
+
+/* Compare the results of two accumulators; 'f?' and 'e?' are scratch
+ * arrays of (at least) nsamples elements per channel.
+ * RETURNS: 0 if identical.
+ */
+static int
+accumCmp(SampleAccum *a, SampleAccum *b, float * const fa[], float * const fb[], int16_t * const ea[], int16_t * const eb[])
+{
+unsigned nch = sampleAccumGetNumChannels( a );
+size_t   n   = sampleAccumGetNumSamples( a );
+unsigned c, what;
+
+	if ( sampleAccumGetCount( a ) != sampleAccumGetCount( b ) ) {
+		return -1;
+	}
+	for ( what = 0; what < 4; what++ ) {
+		switch ( what ) {
+			case 0:
+				sampleAccumGetMean( a, fa );
+				sampleAccumGetMean( b, fb );
+				break;
+			case 1:
+				sampleAccumGetRms( a, fa );
+				sampleAccumGetRms( b, fb );
+				break;
+			case 2:
+				sampleAccumGetEnvelope( a, ea, NULL );
+				sampleAccumGetEnvelope( b, eb, NULL );
+				break;
+			default:
+				sampleAccumGetEnvelope( a, NULL, ea );
+				sampleAccumGetEnvelope( b, NULL, eb );
+				break;
+		}
+		for ( c = 0; c < nch; c++ ) {
+			if ( what < 2 ? memcmp( fa[c], fb[c], sizeof(*fa[c]) * n ) : memcmp( ea[c], eb[c], sizeof(*ea[c]) * n ) ) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int
+statsCmp(const SampleStats *a, const SampleStats *b, unsigned nch)
+{
+unsigned c;
+	for ( c = 0; c < nch; c++ ) {
+		if (    a[c].count != b[c].count || a[c].mean != b[c].mean || a[c].var != b[c].var || a[c].rms != b[c].rms
+		     || a[c].min   != b[c].min   || a[c].max  != b[c].max  || a[c].overrange != b[c].overrange ) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* Acquisition 'r' to be accumulated: the source shifted by 'r' (mod 2) elements */
+static const void *
+accumSrc(const int16_t *src, int wide, unsigned r)
+{
+	return wide ? (const void*)(src + (r & 1)) : (const void*)((const int8_t*)src + (r & 1));
+}
+
+static double
+now(void)
+{
+struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (double)t.tv_sec + 1.0E-9*(double)t.tv_nsec;
+}
+
+int
+main(int argc, char **argv)
+{
+static const SampleConvKernel kerns[] = {
+	SAMPLE_CONV_KERNEL_SCALAR,
+	SAMPLE_CONV_KERNEL_SSE2,
+	SAMPLE_CONV_KERNEL_AVX2,
+};
+static const float  fscl[MAX_CH] = { 1.0/32767.0, 2.5/32767.0, 0.5/127.0 };
+static const float  foff[MAX_CH] = { 0.01, -0.2, 0.0 };
+static const double dscl[MAX_CH] = { 1.0/32767.0, 2.5/32767.0, 0.5/127.0 };
+static const double doff[MAX_CH] = { 0.01, -0.2, 0.0 };
+unsigned  size   = 1024*1024;
+unsigned  repeat = 10;
+unsigned *u_p;
+int       opt;
+int       rval   = 1;
+int16_t  *src    = NULL;
+float    *fref[MAX_CH] = { 0 }, *fdst[MAX_CH] = { 0 };
+double   *dref[MAX_CH] = { 0 }, *ddst[MAX_CH] = { 0 };
+uint8_t  *uref   = NULL, *udst = NULL;
+int16_t  *eref[MAX_CH] = { 0 }, *edst[MAX_CH] = { 0 };
+SampleAccum *aref = NULL, *adst = NULL;
+SampleStats  sref[MAX_CH], sdst[MAX_CH];
+int          lo, hi;
+unsigned  nch, k, r, c, i, bits;
+int       wide, dbl;
+double    then, t;
+
+	while ( (opt = getopt(argc, argv, "hr:s:")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'h': usage(argv[0]);                                                 return 0;
+			default : fprintf(stderr, "Unknown option -%c (use -h for help)\n", opt); return 1;
+			case 's': u_p = &size;                                                    break;
+			case 'r': u_p = &repeat;                                                  break;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr, "Unable to scan argument to option -%c -- should be a number\n", opt);
+			goto bail;
+		}
+	}
+
+	if ( ! (src = malloc( sizeof(*src) * MAX_CH * size )) ) {
+		perror("No memory");
+		goto bail;
+	}
+	for ( c = 0; c < MAX_CH; c++ ) {
+		fref[c] = malloc( sizeof(*fref[c]) * size );
+		fdst[c] = malloc( sizeof(*fdst[c]) * size );
+		dref[c] = malloc( sizeof(*dref[c]) * size );
+		ddst[c] = malloc( sizeof(*ddst[c]) * size );
+		eref[c] = malloc( sizeof(*eref[c]) * size );
+		edst[c] = malloc( sizeof(*edst[c]) * size );
+		if ( ! fref[c] || ! fdst[c] || ! dref[c] || ! ddst[c] || ! eref[c] || ! edst[c] ) {
+			perror("No memory");
+			goto bail;
+		}
+	}
+	if ( ! (uref = malloc( 2 * MAX_CH * size )) || ! (udst = malloc( 2 * MAX_CH * size )) ) {
+		perror("No memory");
+		goto bail;
+	}
+	for ( i = 0; i < MAX_CH * size; i++ ) {
+		src[i] = random();
+	}
+
+	printf("%-5s %-4s %-6s %-8s %12s\n", "bits", "chns", "output", "kernel", "MSmpl/s");
+	for ( wide = 0; wide < 2; wide++ ) {
+		for ( nch = 1; nch <= MAX_CH; nch++ ) {
+			for ( dbl = 0; dbl < 2; dbl++ ) {
+				sampleConvSelectKernel( SAMPLE_CONV_KERNEL_SCALAR );
+				if ( dbl ) {
+					sampleConvDbl( dref, src, wide, nch, size, dscl, doff );
+				} else {
+					sampleConvFlt( fref, src, wide, nch, size, fscl, foff );
+				}
+				for ( k = 0; k < sizeof(kerns)/sizeof(kerns[0]); k++ ) {
+					if ( sampleConvSelectKernel( kerns[k] ) ) {
+						/* not supported by this CPU */
+						continue;
+					}
+					t = 0.0;
+					for ( r = 0; r < repeat; r++ ) {
+						then = now();
+						if ( dbl ) {
+							sampleConvDbl( ddst, src, wide, nch, size, dscl, doff );
+						} else {
+							sampleConvFlt( fdst, src, wide, nch, size, fscl, foff );
+						}
+						t   += now() - then;
+					}
+					for ( c = 0; c < nch; c++ ) {
+						if ( dbl ? memcmp( ddst[c], dref[c], sizeof(*ddst[c]) * size ) : memcmp( fdst[c], fref[c], sizeof(*fdst[c]) * size ) ) {
+							fprintf(stderr, "FAILED: %s kernel mismatch (%u-bit, %u channels, channel %u)\n",
+								sampleConvKernelName( kerns[k] ), wide ? 16 : 8, nch, c);
+							goto bail;
+						}
+					}
+					printf("%-5u %-4u %-6s %-8s %12.1f\n",
+						wide ? 16 : 8,
+						nch,
+						dbl ? "double" : "float",
+						sampleConvKernelName( kerns[k] ),
+						1.0E-6*(double)size*(double)nch*(double)repeat/t);
+				}
+			}
+		}
+	}
+
+	/* unpack the (random) source as if it held packed samples */
+	for ( bits = 9; bits < 16; bits++ ) {
+		sampleConvSelectKernel( SAMPLE_CONV_KERNEL_SCALAR );
+		sampleUnpack( uref, (const uint8_t*)src, bits, size );
+		for ( k = 0; k < sizeof(kerns)/sizeof(kerns[0]); k++ ) {
+			if ( sampleConvSelectKernel( kerns[k] ) ) {
+				continue;
+			}
+			t = 0.0;
+			for ( r = 0; r < repeat; r++ ) {
+				then = now();
+				sampleUnpack( udst, (const uint8_t*)src, bits, size );
+				t   += now() - then;
+			}
+			if ( memcmp( udst, uref, 2 * size ) ) {
+				fprintf(stderr, "FAILED: %s kernel mismatch (unpacking %u-bit)\n",
+					sampleConvKernelName( kerns[k] ), bits);
+				goto bail;
+			}
+			printf("%-5u %-4s %-6s %-8s %12.1f\n",
+				bits,
+				"-",
+				"unpack",
+				sampleConvKernelName( kerns[k] ),
+				1.0E-6*(double)size*(double)repeat/t);
+		}
+	}
+
+	/* accumulate 'repeat' acquisitions of size - 1 samples */
+	for ( wide = 0; wide < 2 && size > 1; wide++ ) {
+		for ( nch = 1; nch <= MAX_CH; nch++ ) {
+			sampleConvSelectKernel( SAMPLE_CONV_KERNEL_SCALAR );
+			sampleAccumDestroy( aref );
+			if ( ! (aref = sampleAccumCreate( nch, size - 1 )) ) {
+				perror("No memory");
+				goto bail;
+			}
+			for ( r = 0; r < repeat; r++ ) {
+				sampleAccumAdd( aref, accumSrc( src, wide, r ), wide, nch * (size - 1) );
+			}
+			for ( k = 0; k < sizeof(kerns)/sizeof(kerns[0]); k++ ) {
+				if ( sampleConvSelectKernel( kerns[k] ) ) {
+					continue;
+				}
+				sampleAccumDestroy( adst );
+				if ( ! (adst = sampleAccumCreate( nch, size - 1 )) ) {
+					perror("No memory");
+					goto bail;
+				}
+				t = 0.0;
+				for ( r = 0; r < repeat; r++ ) {
+					then = now();
+					sampleAccumAdd( adst, accumSrc( src, wide, r ), wide, nch * (size - 1) );
+					t   += now() - then;
+				}
+				if ( accumCmp( aref, adst, fref, fdst, eref, edst ) ) {
+					fprintf(stderr, "FAILED: %s kernel mismatch (accumulating %u-bit, %u channels)\n",
+						sampleConvKernelName( kerns[k] ), wide ? 16 : 8, nch);
+					goto bail;
+				}
+				printf("%-5u %-4u %-6s %-8s %12.1f\n",
+					wide ? 16 : 8,
+					nch,
+					"accum",
+					sampleConvKernelName( kerns[k] ),
+					1.0E-6*(double)(size - 1)*(double)nch*(double)repeat/t);
+			}
+		}
+	}
+
+	/* statistics; count the 1/16 of the samples closest to the rails as overrange */
+	for ( wide = 0; wide < 2; wide++ ) {
+		lo = wide ? -28672 : -112;
+		hi = wide ?  28672 :  112;
+		for ( nch = 1; nch <= MAX_CH; nch++ ) {
+			sampleConvSelectKernel( SAMPLE_CONV_KERNEL_SCALAR );
+			sampleStats( sref, src, wide, nch, size, lo, hi );
+			for ( k = 0; k < sizeof(kerns)/sizeof(kerns[0]); k++ ) {
+				if ( sampleConvSelectKernel( kerns[k] ) ) {
+					continue;
+				}
+				t = 0.0;
+				for ( r = 0; r < repeat; r++ ) {
+					then = now();
+					sampleStats( sdst, src, wide, nch, size, lo, hi );
+					t   += now() - then;
+				}
+				if ( statsCmp( sref, sdst, nch ) ) {
+					fprintf(stderr, "FAILED: %s kernel mismatch (statistics %u-bit, %u channels)\n",
+						sampleConvKernelName( kerns[k] ), wide ? 16 : 8, nch);
+					goto bail;
+				}
+				printf("%-5u %-4u %-6s %-8s %12.1f\n",
+					wide ? 16 : 8,
+					nch,
+					"stats",
+					sampleConvKernelName( kerns[k] ),
+					1.0E-6*(double)size*(double)nch*(double)repeat/t);
+			}
+		}
+	}
+
+	rval = 0;
+
+bail:
+	sampleConvSelectKernel( SAMPLE_CONV_KERNEL_AUTO );
+	sampleAccumDestroy( adst );
+	sampleAccumDestroy( aref );
+	for ( c = 0; c < MAX_CH; c++ ) {
+		free( edst[c] );
+		free( eref[c] );
+		free( ddst[c] );
+		free( dref[c] );
+		free( fdst[c] );
+		free( fref[c] );
+	}
+	free( udst );
+	free( uref );
+	free( src );
+	return rval;
+}
@@ -35,77 +35,75 @@
 /* could go into the FWInfo struct */
 #define SLA 0xc2
 
+#define SHADOW      FW_SHADOW_I2C( SLA )
+#define REG_GAIN_ST 0x0a /* gain and status (POR, EEPROM write) */
+
+void
+dac47cxInit(FWInfo *fw)
+{
+	fw_shadow_set_volatile( fw, SHADOW, REG_GAIN_ST );
+}
+
+/* Always reads the device (and refreshes the register shadow) */
 int
 dac47cxReadReg(FWInfo *fw, unsigned reg, uint16_t *val)
 {
+uint8_t     cmd;
 uint8_t     buf[2];
 int         st;
 
-	buf[0] = SLA;
-	buf[1] = ( 0x06 | ( (reg & 0x1f) << 3 ) );
-	if ( (st = bb_i2c_start( fw, 0      )) < 0 ) return st;
-	if ( (st = bb_i2c_write( fw, buf, 2 )) < 0 ) goto bail;
-	if ( 0 == st ) {
-		/* NAK on first byte */
-		st = -ENODEV;
-		goto bail;
+	cmd    = ( 0x06 | ( (reg & 0x1f) << 3 ) );
+	buf[0] = buf[1] = 0xff;
+	st     = fw_i2c_xfer( fw, SLA, &cmd, 1, buf, 2 );
+	*val   = ( buf[0] << 8 ) | buf[1];
+	if ( st < 0 ) {
+		return st;
 	}
-	if ( (st = bb_i2c_start( fw, 1      )) < 0 ) goto bail;
-	buf[0] = SLA | I2C_READ;
-	if ( (st = bb_i2c_write( fw, buf, 1 )) < 0 ) goto bail;
-	if ( (st = bb_i2c_read ( fw, buf, 2 )) < 0 ) goto bail;
-
-	st = 0;
+	fw_shadow_set( fw, SHADOW, reg & 0x1f, *val );
+	return 0;
+}
 
-bail:
-	bb_i2c_stop ( fw );
-	*val = ( buf[0] << 8 ) | buf[1];
-	return st;
+static int
+cachedReadReg(FWInfo *fw, unsigned reg, uint16_t *val)
+{
+int         st;
+	if ( (st = fw_shadow_get( fw, SHADOW, reg & 0x1f )) < 0 ) {
+		return dac47cxReadReg( fw, reg, val );
+	}
+	*val = (uint16_t)st;
+	return 0;
 }
 
 int
 dac47cxWriteReg(FWInfo *fw, unsigned reg, uint16_t val)
 {
-uint8_t     buf[4];
+uint8_t     buf[3];
 int         st;
 
-	buf[0] = SLA;
-	buf[1] = ( 0x00 | ( (reg & 0x1f) << 3 ) );
-	buf[2] = ( val >> 8 ) & 0xff;
-	buf[3] = ( val >> 0 ) & 0xff;
-	if ( (st = bb_i2c_start( fw, 0      )) < 0 ) return st;
-	if ( (st = bb_i2c_write( fw, buf, 4 )) < 0 ) return st;
-	if ( 0 == st ) {
-		/* NAK on first byte */
-		st = -ENODEV;
-		goto bail;
+	buf[0] = ( 0x00 | ( (reg & 0x1f) << 3 ) );
+	buf[1] = ( val >> 8 ) & 0xff;
+	buf[2] = ( val >> 0 ) & 0xff;
+	st     = fw_i2c_xfer( fw, SLA, buf, 3, NULL, 0 );
+	if ( st < 0 ) {
+		fw_shadow_invalidate( fw, SHADOW, reg & 0x1f );
+		return st;
 	}
-	st = 0;
-bail:
-	bb_i2c_stop ( fw );
-	return st;
+	fw_shadow_set( fw, SHADOW, reg & 0x1f, val );
+	return 0;
 }
 
 int
 dac47cxReset(FWInfo *fw)
 {
-uint8_t     buf[2];
+uint8_t     buf[1];
 int         st;
 
-	buf[0] = 0x00; /* special address */
-	buf[1] = 0x06;
-	if ( (st = bb_i2c_start( fw, 0 ))       < 0 ) return st;
-	if ( (st = bb_i2c_write( fw, buf, 2 ))  < 0 ) goto bail;
-	if ( 0 == st ) {
-		/* NAK on first byte */
-		st = -ENODEV;
-		goto bail;
-	}
-	st = 0;
-
-bail:
-	bb_i2c_stop ( fw );
-	return st;
+	buf[0] = 0x06;
+	/* special (general call) address */
+	st     = fw_i2c_xfer( fw, 0x00, buf, 1, NULL, 0 );
+	/* registers are back at their power-up values */
+	fw_shadow_invalidate( fw, SHADOW, FW_SHADOW_ALL );
+	return st < 0 ? st : 0;
 }
 
 #define REG_VREF 8
@@ -164,7 +162,7 @@ int st;
 		fprintf(stderr, "Error -- dac47cxGet(): invalid channel\n");
 		return -EINVAL;
 	}
-	if ( (st = dac47cxReadReg( fw, REG_VAL0 + channel, val )) < 0 ) return st;
+	if ( (st = cachedReadReg( fw, REG_VAL0 + channel, val )) < 0 ) return st;
 	return 0;
 }
 
@@ -36,6 +36,12 @@ struct FWInfo;
 
 typedef struct FWInfo FWInfo;
 
+/* Exclude the status register from the register shadow;
+ * call once after fw_open() (scope_open() does).
+ */
+void
+dac47cxInit(FWInfo *fw);
+
 int
 dac47cxReset(FWInfo *fw);
 
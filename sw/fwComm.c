@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "cmdXfer.h"
+#include "bbSpiCodec.h"
 #include "fwComm.h"
 #include "at24EepromSup.h"
 #include "scopeSup.h"
@@ -69,6 +70,7 @@
 #define BITS_FW_CMD_BB_API_4        0x04
 #define BITS_FW_CMD_ADCBUF_API_4    0x05
 #define BITS_FW_CMD_ACQPRM_API_4    0x06
+#define BITS_FW_CMD_I2C_API_4       0x07
 
 /* All versions must use the same BITS_FW_CMD_VER */
 static uint8_t mapCmdGeneric(FWCmd aCmd)
@@ -96,6 +98,12 @@ static uint8_t mapCmdApiV3(FWCmd aCmd)
         case FW_CMD_APP_REG_WR8    : return BITS_FW_CMD_APP_REG_API_3;
         case FW_CMD_GEN_REG_RD8    : return BITS_FW_CMD_UNSUPPORTED;
         case FW_CMD_GEN_REG_WR8    : return BITS_FW_CMD_UNSUPPORTED;
+        case FW_CMD_I2C            : return BITS_FW_CMD_UNSUPPORTED;
+        case FW_CMD_APP_REG_VEC    : return BITS_FW_CMD_APP_REG_API_3;
+        case FW_CMD_GEN_REG_VEC    : return BITS_FW_CMD_UNSUPPORTED;
+		case FW_CMD_ADC_BUF_WAIT   : return BITS_FW_CMD_ADCBUF_API_3;
+		case FW_CMD_ADC_BUF_RANGE  : return BITS_FW_CMD_ADCBUF_API_3;
+		case FW_CMD_ADC_BUF_RANGE_WAIT: return BITS_FW_CMD_ADCBUF_API_3;
 		default:
 			fprintf(stderr, "mapCmdApiV3() -- illegal switch case\n");
 			abort();
@@ -117,6 +125,12 @@ static uint8_t mapCmdApiV4(FWCmd aCmd)
         case FW_CMD_APP_REG_WR8    : return BITS_FW_CMD_APP_REG_API_4;
         case FW_CMD_GEN_REG_RD8    : return BITS_FW_CMD_GEN_REG_API_4;
         case FW_CMD_GEN_REG_WR8    : return BITS_FW_CMD_GEN_REG_API_4;
+        case FW_CMD_I2C            : return BITS_FW_CMD_I2C_API_4;
+        case FW_CMD_APP_REG_VEC    : return BITS_FW_CMD_APP_REG_API_4;
+        case FW_CMD_GEN_REG_VEC    : return BITS_FW_CMD_GEN_REG_API_4;
+		case FW_CMD_ADC_BUF_WAIT   : return BITS_FW_CMD_ADCBUF_API_4;
+		case FW_CMD_ADC_BUF_RANGE  : return BITS_FW_CMD_ADCBUF_API_4;
+		case FW_CMD_ADC_BUF_RANGE_WAIT: return BITS_FW_CMD_ADCBUF_API_4;
 		default:
 			fprintf(stderr, "mapCmdApiV4() -- illegal switch case\n");
 			abort();
@@ -138,6 +152,12 @@ static uint8_t mapCmdGenericApiV4(FWCmd aCmd)
         case FW_CMD_APP_REG_WR8    : return BITS_FW_CMD_UNSUPPORTED;
         case FW_CMD_GEN_REG_RD8    : return BITS_FW_CMD_GEN_REG_API_4;
         case FW_CMD_GEN_REG_WR8    : return BITS_FW_CMD_GEN_REG_API_4;
+        case FW_CMD_I2C            : return BITS_FW_CMD_UNSUPPORTED;
+        case FW_CMD_APP_REG_VEC    : return BITS_FW_CMD_UNSUPPORTED;
+        case FW_CMD_GEN_REG_VEC    : return BITS_FW_CMD_GEN_REG_API_4;
+		case FW_CMD_ADC_BUF_WAIT   : return BITS_FW_CMD_UNSUPPORTED;
+		case FW_CMD_ADC_BUF_RANGE  : return BITS_FW_CMD_UNSUPPORTED;
+		case FW_CMD_ADC_BUF_RANGE_WAIT: return BITS_FW_CMD_UNSUPPORTED;
 		default:
 			fprintf(stderr, "mapCmdGenericApiV4() -- illegal switch case\n");
 			abort();
@@ -160,9 +180,20 @@ static uint8_t mapCmdGenericApiV4(FWCmd aCmd)
 #define BITS_FW_CMD_ADCFLUSH    (1<<4)
 #define BITS_FW_CMD_MEMSIZE     (2<<4)
 #define BITS_FW_CMD_SMPLFREQ    (3<<4) /* API vers 3 */
+/* modifier of the read command: hold the reply until the acquisition
+ * is complete (or a firmware timeout expires); ignored by older
+ * firmware (check FW_BUF_FLG_WAIT).
+ */
+#define BITS_FW_CMD_ADCWAIT     (4<<4)
+/* modifier of the read command: offset and count follow the command
+ * (check FW_BUF_FLG_RANGE). Modifier of the memsize command: request
+ * a byte of extended flags (ignored by older firmware).
+ */
+#define BITS_FW_CMD_ADCRANGE    (8<<4)
 
 #define BITS_FW_CMD_REG_RD8     (0<<4)
 #define BITS_FW_CMD_REG_WR8     (1<<4)
+#define BITS_FW_CMD_REG_VEC     (2<<4)
 
 #define GEN_REG_VERSION_OFF         0
 #define GEN_REG_VERSION_1           0x01
@@ -171,8 +202,21 @@ static uint8_t mapCmdGenericApiV4(FWCmd aCmd)
 #define GEN_REG_RECONF_REQUEST_OFF  4
 #define GEN_REG_RECONF_MAGIC        0x3a
 
+/* Register shadow of a board peripheral */
+#define SHADOW_NREGS    256
+#define SHADOW_VALID    (1<<0)
+#define SHADOW_VOLATILE (1<<1)
+
+typedef struct FWShadowDev {
+	struct FWShadowDev *next;
+	unsigned            dev;
+	uint16_t            val[SHADOW_NREGS];
+	uint8_t             flg[SHADOW_NREGS];
+} FWShadowDev;
+
 struct FWInfo {
 	int             fd;
+	const FifoTransportOps *ops;
 	int             debug;
 	int             ownFd;
 	uint32_t        gitHash;
@@ -181,6 +225,8 @@ struct FWInfo {
 	uint64_t        features;
 	uint8_t       (*mapCmd)(FWCmd);
     uint8_t         reconfig;
+	FWShadowDev    *shadow;
+	int             shadowOff;
 };
 
 static int
@@ -189,6 +235,12 @@ fw_xfer_bb(FWInfo *fw, uint8_t subcmd, const uint8_t *tbuf, uint8_t *rbuf, size_
 static int
 __bb_spi_cs(FWInfo *fw, SPIMode mode, uint8_t subcmd, uint8_t lastval);
 
+static int
+__fw_has_i2c_master(FWInfo *fw);
+
+static int
+__fw_has_reg_vec(FWInfo *fw);
+
 void
 fw_set_debug(FWInfo *fw, int level)
 {
@@ -208,6 +260,8 @@ unsigned long sup = (1<<SPI_NONE) | (1<<SPI_FLASH) | (1<<SPI_ADC);
 		case 2:
         case 3:
 			sup |= (1<<SPI_PGA);                break;
+		case 255: /* simulation */
+			sup |= (1<<SPI_FEG);                break;
 		default:
 			fprintf(stderr, "spi_get_subcmd(): unsupported board/hw version %i\n", fw->brdVers);
 			return -ENOTSUP;
@@ -238,6 +292,9 @@ fw_get_cmd(FWInfo *fw, FWCmd aCmd)
 		case FW_CMD_VERSION      : return cmd;
 		case FW_CMD_ADC_BUF      : return cmd;
 		case FW_CMD_ADC_FLUSH    : return cmd | BITS_FW_CMD_ADCFLUSH;
+		case FW_CMD_ADC_BUF_WAIT : return cmd | BITS_FW_CMD_ADCWAIT;
+		case FW_CMD_ADC_BUF_RANGE: return cmd | BITS_FW_CMD_ADCRANGE;
+		case FW_CMD_ADC_BUF_RANGE_WAIT: return cmd | BITS_FW_CMD_ADCRANGE | BITS_FW_CMD_ADCWAIT;
 		case FW_CMD_BB_OFF       : return cmd | BITS_FW_CMD_BB_NONE;
 		case FW_CMD_BB_SPI       : return cmd | BITS_FW_CMD_BB_FLASH;
 		case FW_CMD_BB_I2C       : return cmd | BITS_FW_CMD_BB_I2C;
@@ -247,6 +304,9 @@ fw_get_cmd(FWInfo *fw, FWCmd aCmd)
         case FW_CMD_GEN_REG_WR8  : return cmd | BITS_FW_CMD_REG_WR8;
         case FW_CMD_APP_REG_RD8  : return cmd | BITS_FW_CMD_REG_RD8;
         case FW_CMD_APP_REG_WR8  : return cmd | BITS_FW_CMD_REG_WR8;
+        case FW_CMD_GEN_REG_VEC  : return cmd | BITS_FW_CMD_REG_VEC;
+        case FW_CMD_APP_REG_VEC  : return cmd | BITS_FW_CMD_REG_VEC;
+		case FW_CMD_I2C          : return cmd;
 		default:
 			fprintf(stderr, "fw_get_cmd() -- illegal switch case\n");
 			abort();
@@ -265,6 +325,95 @@ fw_disable_features(FWInfo *fw, uint64_t mask)
 	fw->features &= ~mask;
 }
 
+static FWShadowDev *
+shadowFind(FWInfo *fw, unsigned dev, int create)
+{
+FWShadowDev *d;
+
+	for ( d = fw->shadow; d; d = d->next ) {
+		if ( dev == d->dev ) {
+			return d;
+		}
+	}
+	if ( create && (d = calloc( 1, sizeof(*d) )) ) {
+		d->dev     = dev;
+		d->next    = fw->shadow;
+		fw->shadow = d;
+	}
+	return d;
+}
+
+int
+fw_shadow_get(FWInfo *fw, unsigned dev, unsigned reg)
+{
+FWShadowDev *d;
+
+	if ( fw->shadowOff || reg >= SHADOW_NREGS || ! (d = shadowFind( fw, dev, 0 )) ) {
+		return -ENOENT;
+	}
+	return ( SHADOW_VALID == d->flg[reg] ) ? d->val[reg] : -ENOENT;
+}
+
+void
+fw_shadow_set(FWInfo *fw, unsigned dev, unsigned reg, unsigned val)
+{
+FWShadowDev *d;
+
+	if ( fw->shadowOff || reg >= SHADOW_NREGS || ! (d = shadowFind( fw, dev, 1 )) ) {
+		return;
+	}
+	if ( ! (d->flg[reg] & SHADOW_VOLATILE) ) {
+		d->val[reg]  = val;
+		d->flg[reg] |= SHADOW_VALID;
+	}
+}
+
+void
+fw_shadow_invalidate(FWInfo *fw, unsigned dev, unsigned reg)
+{
+FWShadowDev *d;
+unsigned     i;
+
+	for ( d = fw->shadow; d; d = d->next ) {
+		if ( FW_SHADOW_ALL == dev || dev == d->dev ) {
+			for ( i = 0; i < SHADOW_NREGS; i++ ) {
+				if ( FW_SHADOW_ALL == reg || i == reg ) {
+					d->flg[i] &= ~SHADOW_VALID;
+				}
+			}
+		}
+	}
+}
+
+void
+fw_shadow_set_volatile(FWInfo *fw, unsigned dev, unsigned reg)
+{
+FWShadowDev *d;
+
+	if ( reg < SHADOW_NREGS && (d = shadowFind( fw, dev, 1 )) ) {
+		d->flg[reg] = SHADOW_VOLATILE;
+	}
+}
+
+void
+fw_shadow_enable(FWInfo *fw, int enable)
+{
+	if ( (fw->shadowOff = ! enable) ) {
+		fw_shadow_invalidate( fw, FW_SHADOW_ALL, FW_SHADOW_ALL );
+	}
+}
+
+static void
+shadowFree(FWInfo *fw)
+{
+FWShadowDev *d;
+
+	while ( (d = fw->shadow) ) {
+		fw->shadow = d->next;
+		free( d );
+	}
+}
+
 static int64_t
 __fw_get_version(FWInfo *fw)
 {
@@ -284,27 +433,73 @@ int64_t rval;
 	return rval;
 }
 
+/* The VERSION command takes an optional parameter octet
+ * (FW_VERSION_PARM_xxx) requesting a framing mode; firmware which
+ * supports this appends a capability octet (FW_VERSION_CAP_xxx) to
+ * the version and switches the framing once the reply has been sent.
+ * Old firmware ignores the parameter.
+ */
+#define FW_VERSION_LEN        6
+#define FW_VERSION_PARM_COBS  (1<<0)
+#define FW_VERSION_CAP_COBS   (1<<0)
+
+int
+fw_set_framing(FWInfo *fw, int cobs)
+{
+uint8_t  parm = ( cobs ? FW_VERSION_PARM_COBS : 0 );
+uint8_t  rep[FW_VERSION_LEN + 2];
+tbufvec  tvec[1];
+rbufvec  rvec[1];
+int      st;
+
+	tvec[0].buf = &parm;
+	tvec[0].len = sizeof(parm);
+	rvec[0].buf = rep;
+	rvec[0].len = sizeof(rep);
+	/* single frame; the new framing applies to the next one */
+	st = fw_xfer_vec( fw, fw_get_cmd( fw, FW_CMD_VERSION ), tvec, 1, rvec, 1 );
+	if ( st < 0 ) {
+		return st;
+	}
+	if ( st <= FW_VERSION_LEN || ! (rep[FW_VERSION_LEN] & FW_VERSION_CAP_COBS) ) {
+		/* old firmware; framing unchanged */
+		return cobs ? -ENOTSUP : 0;
+	}
+	fifoSetFraming( fw->fd, cobs ? FIFO_FRAMING_COBS : FIFO_FRAMING_STUFF );
+	return 0;
+}
+
+static FWInfo *
+fw_open_ops(int fd, const FifoTransportOps *ops);
+
 FWInfo *
 fw_open(const char *devn, unsigned speed)
 {
-int     fd = fifoOpen( devn, speed );
-FWInfo *rv;
+const FifoTransportOps *ops;
+int                     fd = fifoOpenURI( devn, speed, &ops );
+FWInfo                 *rv;
 
 	if ( fd < 0 ) {
 		return 0;
 	}
 
-	rv = fw_open_fd( fd );
+	rv = fw_open_ops( fd, ops );
 	if ( rv ) {
 		rv->ownFd = 1;
 	} else {
-		close( fd );
+		ops->close( fd );
 	}
 	return rv;
 }
 
 FWInfo *
 fw_open_fd(int fd)
+{
+	return fw_open_ops( fd, fifoGetTransport( fd ) );
+}
+
+static FWInfo *
+fw_open_ops(int fd, const FifoTransportOps *ops)
 {
 FWInfo  *fw;
 int64_t  vers;
@@ -315,6 +510,7 @@ int64_t  vers;
 	}
 
 	fw->fd             = fd;
+	fw->ops            = ops;
 	fw->debug          = 0;
 	fw->ownFd          = 0;
 	fw->features       = 0;
@@ -357,6 +553,18 @@ int64_t  vers;
 		fw->features |= FW_FEATURE_SPI_CONTROLLER;
 	}
 
+	if ( __fw_has_i2c_master( fw ) ) {
+		fw->features |= FW_FEATURE_I2C_MASTER;
+	}
+
+	if ( __fw_has_reg_vec( fw ) ) {
+		fw->features |= FW_FEATURE_REG_VEC;
+	}
+
+	if ( 0 == fw_set_framing( fw, 1 ) ) {
+		fw->features |= FW_FEATURE_COBS;
+	}
+
 	return fw;
 
 bail:
@@ -380,8 +588,9 @@ uint8_t v = SPI_MASK | I2C_MASK;
 			}
 		}
 		if ( fw->ownFd ) {
-			fifoClose( fw->fd );
+			fw->ops->close( fw->fd );
 		}
+		shadowFree( fw );
 		free( fw );
 	}
 }
@@ -435,21 +644,47 @@ int     st;
     return st < 0 ? st : 0;
 }
 
+/* Single frame over the transport of 'fw' */
+static int
+__fw_xfer_vec(FWInfo *fw, uint8_t *cmdp, const tbufvec *tbuf, size_t tcnt, const rbufvec *rbuf, size_t rcnt)
+{
+FifoXferReq req;
+int         st;
+
+	req.cmdp   = cmdp;
+	req.tbuf   = tbuf;
+	req.tcnt   = tcnt;
+	req.rbuf   = rbuf;
+	req.rcnt   = rcnt;
+	req.status = 0;
+
+	st = fifoXferFrameVecMultiOps( fw->ops, fw->fd, &req, 1, 1 );
+
+	return st < 0 ? st : req.status;
+}
+
 /* Caution: fw_xfer is called from fw_open and not all fields are initialized yet
- *          (but fd is).
+ *          (but fd and ops are).
  */
 int
 fw_xfer(FWInfo *fw, uint8_t cmd, const uint8_t *tbuf, uint8_t *rbuf, size_t len)
 {
 uint8_t cmdLoc = cmd;
 int     st;
+tbufvec tvec[1];
+rbufvec rvec[1];
 
 	/* if fw_get_cmd() resolves to an unsupported command this get caught here */
 	if ( BITS_FW_CMD_UNSUPPORTED == cmd ) {
 		return -ENOTSUP;
 	}
 
-	st = fifoXferFrame( fw->fd, &cmdLoc, tbuf, tbuf ? len : 0, rbuf, rbuf ? len : 0 );
+	tvec[0].buf = tbuf;
+	tvec[0].len = len;
+	rvec[0].buf = rbuf;
+	rvec[0].len = len;
+
+	st = __fw_xfer_vec( fw, &cmdLoc, tvec, ( tbuf && len ) ? 1 : 0, rvec, ( rbuf && len ) ? 1 : 0 );
 	if ( BITS_FW_CMD_UNSUPPORTED == cmdLoc ) {
 		st = -ENOTSUP;
 	}
@@ -467,13 +702,36 @@ int     st;
 		return -ENOTSUP;
 	}
 
-	st = fifoXferFrameVec( fw->fd, &cmdLoc, tbuf, tcnt, rbuf, rcnt );
+	st = __fw_xfer_vec( fw, &cmdLoc, tbuf, tcnt, rbuf, rcnt );
 	if ( BITS_FW_CMD_UNSUPPORTED == cmdLoc ) {
 		st = -ENOTSUP;
 	}
 	return st;
 }
 
+int
+fw_xfer_vec_multi(FWInfo *fw, FifoXferReq *reqs, size_t nreqs, size_t depth)
+{
+size_t i;
+int    st;
+
+	/* if fw_get_cmd() resolves to an unsupported command this get caught here */
+	for ( i = 0; i < nreqs; i++ ) {
+		if ( reqs[i].cmdp && BITS_FW_CMD_UNSUPPORTED == *reqs[i].cmdp ) {
+			return -ENOTSUP;
+		}
+	}
+
+	st = fifoXferFrameVecMultiOps( fw->ops, fw->fd, reqs, nreqs, depth );
+
+	for ( i = 0; i < nreqs; i++ ) {
+		if ( reqs[i].status >= 0 && reqs[i].cmdp && BITS_FW_CMD_UNSUPPORTED == *reqs[i].cmdp ) {
+			reqs[i].status = -ENOTSUP;
+		}
+	}
+	return st;
+}
+
 static void pr_i2c_dbg(uint8_t tbyte, uint8_t rbyte)
 {
 	printf("Writing %02x - got %02x (%d %d - %d %d)\n", tbyte, rbyte,
@@ -481,10 +739,13 @@ static void pr_i2c_dbg(uint8_t tbyte, uint8_t rbyte)
 			!!(rbyte & (1<<SCL_SHFT)) , !!(rbyte & (1<<SDA_SHFT)));
 }
 
+static uint8_t
+bb_i2c_level(int scl, int sda);
+
 static int
 bb_i2c_set(FWInfo *fw, int scl, int sda)
 {
-uint8_t bbbyte =  ((scl ? 1 : 0) << SCL_SHFT) | ((sda ? 1 : 0) << SDA_SHFT) | I2C_MASK;
+uint8_t bbbyte =  bb_i2c_level( scl, sda );
 uint8_t x = bbbyte;
 int     st;
 
@@ -570,83 +831,28 @@ int     st;
 	return lastval;
 }
 
-#define BUF_BRK 1024
-
-/* work buffer is assumed to have space for stretch*2*8*len octets */
-static void
-shift_into_buf(uint8_t *xbuf, SPIMode mode, unsigned stretch, const uint8_t *tbuf, const uint8_t *zbuf, size_t len)
-{
-int      i,j,k;
-uint8_t  bbo;
-uint8_t *p;
-uint8_t  z,v;
-uint8_t  msk;
-
-	p = xbuf;
-
-	msk = SPI_MASK & ~ (1 << CS_SHFT);
-	if ( SPI_MODE3 == mode || SPI_MODE1 == mode ) {
-		msk |= ( 1 << SCLK_SHFT );
-	}
-
-	for ( i = 0; i < len; i++ ) {
-		v = tbuf ? tbuf[i] : 0;
-		z = zbuf ? zbuf[i] : 0;
-		for ( j = 0; j < 8; j++ ) {
-			bbo = ( (((v & 0x80) ? 1 : 0) << MOSI_SHFT) | msk );
-			if ( ! (z & 0x80) ) {
-				bbo &= ~(1 << HIZ_SHFT);
-			}
-			for ( k = 0; k < stretch; k++ ) {
-				*p = bbo;
-				++p;
-			}
-            bbo     ^= (1 << SCLK_SHFT);
-			for ( k = 0; k < stretch; k++ ) {
-				*p = bbo;
-				++p;
-			}
-			v      <<= 1;
-			z      <<= 1;
-		}
-	}
-}
-
-static void
-shift_outof_buf(uint8_t *xbuf, unsigned stretch, uint8_t *rbuf, size_t len)
-{
-int      i,j;
-uint8_t *p;
-uint8_t  v;
-
-	p = xbuf;
-
-	for ( i = 0; i < len; i++ ) {
-		v = 0;
-		for ( j = 0; j < 2*8; j += 2 ) {
-			v   = (v << 1 ) | ( (p[stretch*j + 2*stretch - 1] & (1 << MISO_SHFT)) ? 1 : 0 );
-		}
-
-		p += stretch * j;
-		rbuf[i] = v;
-	}
-}
+#define BUF_BRK  1024 /* octets per bit-bang frame */
+#define BUF_PIPE 4    /* bit-bang frames in flight   */
 
 int
 bb_spi_xfer_vec(FWInfo *fw, SPIMode mode, SPIDev type, const struct bb_vec *vec, size_t nelms)
 {
-int               stretch = 1;
-uint8_t           buf[BUF_BRK*8*2*stretch];
+uint8_t          *buf  = NULL;
 int               el;
 int               rval = 0;
 uint8_t           subcmd;
+uint8_t           cmds[BUF_PIPE];
+FifoXferReq       reqs[BUF_PIPE];
+tbufvec           tvec[BUF_PIPE];
+rbufvec           rvec[BUF_PIPE];
+size_t            xlen[BUF_PIPE];
 size_t            work;
-size_t            xlen;
-size_t            stretchlen;
+size_t            n, k;
 const uint8_t    *tbuf;
 uint8_t          *rbuf;
 const uint8_t    *zbuf;
 uint8_t           last;
+BBSpiLayout       lay;
 int               st;
 
 	if ( ( el = spi_get_subcmd( fw, type ) ) < 0 ) {
@@ -655,10 +861,23 @@ int               st;
 	}
 	subcmd = (uint8_t) el;
 
+	lay.idle     = SPI_MASK & ~ (1 << CS_SHFT);
+	if ( SPI_MODE3 == mode || SPI_MODE1 == mode ) {
+		lay.idle |= ( 1 << SCLK_SHFT );
+	}
+	lay.sclk     = ( 1 << SCLK_SHFT );
+	lay.mosiShft = MOSI_SHFT;
+	lay.hizShft  = HIZ_SHFT;
+	lay.misoShft = MISO_SHFT;
+
+	if ( ! (buf = malloc( BUF_PIPE * BUF_BRK * 8 * 2 )) ) {
+		return -ENOMEM;
+	}
 
 	/* assert CS */
 	if ( (el = __bb_spi_cs( fw, mode, subcmd, SPI_MASK | (1 << CS_SHFT) )) < 0 ) {
-		return el;
+		rval = el;
+		goto bail;
 	}
 	last = el;
 
@@ -672,37 +891,61 @@ int               st;
 		rval += work;
 
 		while ( work > 0 ) {
-			xlen = work > BUF_BRK ? BUF_BRK : work;
-
-		    stretchlen = xlen * 2 * 8 * stretch;
-
-			shift_into_buf( buf, mode, stretch, tbuf, zbuf, xlen );
+			/* Encode up to BUF_PIPE frames and send them back-to-back so that
+			 * the link and the firmware are busy with one frame while the
+			 * next one is in transit.
+			 */
+			for ( n = 0; n < BUF_PIPE && work > 0; n++ ) {
+				xlen[n] = work > BUF_BRK ? BUF_BRK : work;
+
+				bbSpiEncode( buf + n * BUF_BRK * 8 * 2, &lay, tbuf, zbuf, xlen[n] );
+
+				cmds[n]        = fw_get_cmd( fw, FW_CMD_BB_OFF ) | subcmd;
+				tvec[n].buf    = buf + n * BUF_BRK * 8 * 2;
+				tvec[n].len    = xlen[n] * 8 * 2;
+				rvec[n].buf    = buf + n * BUF_BRK * 8 * 2;
+				rvec[n].len    = xlen[n] * 8 * 2;
+				reqs[n].cmdp   = cmds + n;
+				reqs[n].tbuf   = tvec + n;
+				reqs[n].tcnt   = 1;
+				reqs[n].rbuf   = rvec + n;
+				reqs[n].rcnt   = 1;
+				reqs[n].status = 0;
+
+				if ( tbuf ) tbuf += xlen[n];
+				if ( zbuf ) zbuf += xlen[n];
+				work            -= xlen[n];
+			}
 
 			/* keep a copy of the last bbo */
-			last = buf[stretchlen - 1];
+			last = tvec[n - 1].buf[tvec[n - 1].len - 1];
 
-			if ( (st = fw_xfer_bb( fw, subcmd, buf, buf, stretchlen ) ) < 0 ) {
-				fprintf(stderr, "bb_spi_xfer_vec(): fw_xfer_bb failed\n");
-				return st;
+			st = fw_xfer_vec_multi( fw, reqs, n, n );
+			for ( k = 0; k < n && st >= 0; k++ ) {
+				st = reqs[k].status;
+			}
+			if ( st < 0 ) {
+				fprintf(stderr, "bb_spi_xfer_vec(): bit-bang transfer failed\n");
+				rval = st;
+				goto bail;
 			}
 
 			if ( rbuf ) {
-
-				shift_outof_buf( buf, stretch, rbuf, xlen );
-
-				rbuf += xlen;
+				for ( k = 0; k < n; k++ ) {
+					bbSpiDecode( rbuf, &lay, rvec[k].buf, xlen[k] );
+					rbuf += xlen[k];
+				}
 			}
-			if ( tbuf ) tbuf += xlen;
-			if ( zbuf ) zbuf += xlen;
-			work             -= xlen;
 		}
 	}
 
 	/* deassert CS */
 	if ( (st = __bb_spi_cs( fw, mode, subcmd, last )) < 0 ) {
-		return st;
+		rval = st;
 	}
 
+bail:
+	free( buf );
 	return rval;
 }
 
@@ -720,36 +963,84 @@ size_t nelms = 0;
 	return bb_spi_xfer_vec(fw, mode, type, vec, nelms);
 }
 
-/* XFER 9 bits (lsbit is ACK) */
-static int
-bb_i2c_xfer(FWInfo *fw, uint16_t val)
+/* Bit-bang samples of an i2c bus condition / byte (9 bits; lsbit is ACK) */
+#define I2C_START_SAMPLES    2
+#define I2C_RESTART_SAMPLES  4
+#define I2C_STOP_SAMPLES     2
+#define I2C_BYTE_SAMPLES     (3*9)
+
+static uint8_t
+bb_i2c_level(int scl, int sda)
 {
-int i,st;
-uint8_t xbuf[3*9];
-uint8_t rbuf[3*9];
+	return ((scl ? 1 : 0) << SCL_SHFT) | ((sda ? 1 : 0) << SDA_SHFT) | I2C_MASK;
+}
+
+static uint8_t *
+bb_i2c_put_start(uint8_t *p, int restart)
+{
+	if ( restart ) {
+		*p++ = bb_i2c_level( 0, 1 );
+		*p++ = bb_i2c_level( 1, 1 );
+	}
+	*p++ = bb_i2c_level( 1, 0 );
+	*p++ = bb_i2c_level( 0, 0 );
+	return p;
+}
+
+static uint8_t *
+bb_i2c_put_stop(uint8_t *p)
+{
+	*p++ = bb_i2c_level( 1, 0 );
+	*p++ = bb_i2c_level( 1, 1 );
+	return p;
+}
+
+static uint8_t *
+bb_i2c_put_byte(uint8_t *p, uint16_t val)
+{
+int i;
 	for ( i = 0; i < 3*9; i+= 3 ) {
 		uint8_t sda = (((val & (1<<8)) ? 1 : 0) << SDA_SHFT);
-		xbuf[i + 0] = (I2C_MASK | (0 << SCL_SHFT) | sda);
-		if ( i == 7*3 ) xbuf[i+0] &= 0x7f;
-		xbuf[i + 1] = (I2C_MASK | (1 << SCL_SHFT) | sda);
-		xbuf[i + 2] = (I2C_MASK | (0 << SCL_SHFT) | sda);
+		p[i + 0] = (I2C_MASK | (0 << SCL_SHFT) | sda);
+		if ( i == 7*3 ) p[i+0] &= 0x7f;
+		p[i + 1] = (I2C_MASK | (1 << SCL_SHFT) | sda);
+		p[i + 2] = (I2C_MASK | (0 << SCL_SHFT) | sda);
 		val <<= 1;
 	}
+	return p + I2C_BYTE_SAMPLES;
+}
+
+static uint16_t
+bb_i2c_get_byte(const uint8_t *p)
+{
+int      i;
+uint16_t val = 0;
+	for ( i = 0; i < 3*9; i+= 3 ) {
+		val = (val<<1) | ( ( p[i+2] & ( 1 << SDA_SHFT ) ) ? 1 : 0 );
+	}
+	return val & 0x1FF;
+}
+
+/* XFER 9 bits (lsbit is ACK) */
+static int
+bb_i2c_xfer(FWInfo *fw, uint16_t val)
+{
+int i,st;
+uint8_t xbuf[I2C_BYTE_SAMPLES];
+uint8_t rbuf[I2C_BYTE_SAMPLES];
+
+	bb_i2c_put_byte( xbuf, val );
 	if ( (st = fw_xfer_bb( fw, BITS_FW_CMD_BB_I2C, xbuf, rbuf, sizeof(xbuf))) < 0 ) {
 		fprintf(stderr, "bb_i2c_xfer failed\n");
 		return st;
 	}
-	val = 0;
-	for ( i = 0; i < 3*9; i+= 3 ) {
-		val = (val<<1) | ( ( rbuf[i+2] & ( 1 << SDA_SHFT ) ) ? 1 : 0 );
-	}
 	if ( fw->debug ) {
 		for ( i = 0; i < 3*9; i++ ) {
 			pr_i2c_dbg(xbuf[i], rbuf[i]);
 		}
 	}
 
-	return val & 0x1FF;
+	return bb_i2c_get_byte( rbuf );
 }
 
 int
@@ -790,50 +1081,226 @@ size_t   i;
 	return len;
 }
 
-int
-bb_i2c_rw_a8(FWInfo *fw, uint8_t sla, uint8_t addr, uint8_t *data, size_t len)
+/* Status word of the i2c master command (see CommandI2c.vhd) */
+#define I2C_STA_NAK      (1<<15)
+#define I2C_STA_ACK_MSK  (I2C_STA_NAK - 1)
+
+/* A frame consisting of the command byte only is answered by an (aborted)
+ * status without any bus activity.
+ */
+static int
+__fw_has_i2c_master(FWInfo *fw)
 {
-uint8_t buf[3];
-int     wrl;
-int     rval = -1;
-int     st;
+uint8_t  sta[2];
+rbufvec  rvec[1];
 
-    wrl        = 0;
-	buf[wrl++] = sla & ~I2C_READ;
-	buf[wrl++] = addr;
-	if ( (rval = bb_i2c_start( fw, 0 )) < 0 )
-		return rval;
-	if ( (rval = bb_i2c_write( fw, buf, wrl )) < wrl ) {
-		if ( rval >= 0 ) {
-			/* NAK on first byte => -ENODEV */
-			rval = (0 == rval ? -ENODEV : -EIO );
+	rvec[0].buf = sta;
+	rvec[0].len = sizeof(sta);
+	return (int)sizeof(sta) == fw_xfer_vec( fw, fw_get_cmd( fw, FW_CMD_I2C ), NULL, 0, rvec, 1 );
+}
+
+/* The write data are passed as a prefix (e.g., a register address) and
+ * a payload; a transaction with 'rlen > 0' returns 'rlen', otherwise
+ * the number of (prefix + payload) bytes ACKed.
+ */
+static int
+fw_i2c_xfer_hw(FWInfo *fw, uint8_t sla, const uint8_t *wpre, size_t plen, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+uint8_t  hdr[3];
+uint8_t  sta[2];
+tbufvec  tvec[3];
+rbufvec  rvec[2];
+size_t   tcnt = 0;
+size_t   rcnt = 0;
+unsigned stat, acks;
+int      st;
+
+	hdr[0] = sla & ~I2C_READ;
+	hdr[1] = (rlen >> 0) & 0xff;
+	hdr[2] = (rlen >> 8) & 0xff;
+
+	tvec[tcnt].buf   = hdr;
+	tvec[tcnt++].len = sizeof(hdr);
+	if ( plen ) {
+		tvec[tcnt].buf   = wpre;
+		tvec[tcnt++].len = plen;
+	}
+	if ( wlen ) {
+		tvec[tcnt].buf   = wbuf;
+		tvec[tcnt++].len = wlen;
+	}
+	if ( rlen ) {
+		rvec[rcnt].buf   = rbuf;
+		rvec[rcnt++].len = rlen;
+	}
+	rvec[rcnt].buf   = sta;
+	rvec[rcnt++].len = sizeof(sta);
+
+	if ( (st = fw_xfer_vec( fw, fw_get_cmd( fw, FW_CMD_I2C ), tvec, tcnt, rvec, rcnt )) < 0 ) {
+		return st;
+	}
+	if ( (size_t)st != rlen + sizeof(sta) ) {
+		fprintf(stderr, "fw_i2c_xfer: unexpected reply length (%d)\n", st);
+		return -EIO;
+	}
+	stat = ( sta[1] << 8 ) | sta[0];
+	acks = ( stat & I2C_STA_ACK_MSK );
+	if ( fw->debug ) {
+		printf("fw_i2c_xfer(sla 0x%02x, wlen %zu, rlen %zu): status 0x%04x\n", sla, plen + wlen, rlen, stat);
+	}
+	if ( ( stat & I2C_STA_NAK ) ) {
+		if ( 0 == acks ) {
+			return -ENODEV;
+		}
+		if ( rlen ) {
+			return -EIO;
 		}
-		goto bail;
 	}
-	if ( !!(sla & I2C_READ) ) {
-		if ( (rval = bb_i2c_start( fw, 1 )) < 0 ) {
+	if ( rlen ) {
+		return rlen;
+	}
+	/* don't count the address */
+	return acks - 1;
+}
+
+/* The entire transaction is compiled into a single vector of bit-bang
+ * samples which is sent in as few frames as the firmware FIFO permits;
+ * ACK/NAK and read data are decoded from the returned samples. Once a
+ * NAK has been seen the remaining frames (except for the STOP) are
+ * skipped.
+ */
+static int
+fw_i2c_xfer_bb(FWInfo *fw, uint8_t sla, const uint8_t *wpre, size_t plen, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+size_t   nwr     = 1 + plen + wlen;       /* bytes written, including the address */
+int      restart = ( rlen && nwr > 1 );
+size_t   rdOff   = I2C_START_SAMPLES + nwr * I2C_BYTE_SAMPLES;
+size_t   tot;
+size_t   off, xlen, i, dec, acks;
+uint8_t *xbuf, *sbuf, *p;
+uint16_t v;
+int      nak     = 0;
+int      rval;
+
+	if ( restart ) {
+		rdOff += I2C_RESTART_SAMPLES + I2C_BYTE_SAMPLES;
+	}
+	tot = rdOff + rlen * I2C_BYTE_SAMPLES + I2C_STOP_SAMPLES;
+
+	if ( ! (xbuf = calloc( 2, tot )) ) {
+		return -ENOMEM;
+	}
+	sbuf = xbuf + tot;
+
+	p = bb_i2c_put_start( xbuf, 0 );
+	p = bb_i2c_put_byte ( p, ( ( ( rlen && ! restart ) ? (sla | I2C_READ) : (sla & ~I2C_READ) ) << 1 ) | I2C_NAK );
+	for ( i = 0; i < plen; i++ ) {
+		p = bb_i2c_put_byte( p, ( wpre[i] << 1 ) | I2C_NAK );
+	}
+	for ( i = 0; i < wlen; i++ ) {
+		p = bb_i2c_put_byte( p, ( wbuf[i] << 1 ) | I2C_NAK );
+	}
+	if ( restart ) {
+		p = bb_i2c_put_start( p, 1 );
+		p = bb_i2c_put_byte ( p, ( (sla | I2C_READ) << 1 ) | I2C_NAK );
+	}
+	for ( i = 0; i < rlen; i++ ) {
+		/* ACK all but the last byte */
+		p = bb_i2c_put_byte( p, ( 0xff << 1 ) | ( i == rlen - 1 ? I2C_NAK : 0 ) );
+	}
+	p = bb_i2c_put_stop( p );
+
+	/* decode the written bytes as their samples arrive */
+	acks = 0;
+	dec  = 0;
+	for ( off = 0; off < tot; off += xlen ) {
+		xlen = tot - off;
+		if ( xlen > MAXDEPTH ) {
+			xlen = MAXDEPTH;
+		}
+		if ( (rval = fw_xfer_bb( fw, BITS_FW_CMD_BB_I2C, xbuf + off, sbuf + off, xlen )) < 0 ) {
+			fprintf(stderr, "fw_i2c_xfer_bb: fw_xfer_bb failed\n");
 			goto bail;
 		}
-		buf[0] = sla;
-		if ( (rval = bb_i2c_write( fw, buf, 1 )) < 1 ) {
-			if ( rval >= 0 ) {
-				rval = -EIO;
+		while ( ! nak && dec < nwr + restart && I2C_START_SAMPLES + (dec + 1) * I2C_BYTE_SAMPLES + ( dec >= nwr ? I2C_RESTART_SAMPLES : 0 ) <= off + xlen ) {
+			v = bb_i2c_get_byte( sbuf + I2C_START_SAMPLES + dec * I2C_BYTE_SAMPLES + ( dec >= nwr ? I2C_RESTART_SAMPLES : 0 ) );
+			if ( ( v & I2C_NAK ) ) {
+				nak = 1;
+			} else {
+				acks++;
+			}
+			dec++;
+		}
+		if ( nak && off + xlen < tot - I2C_STOP_SAMPLES ) {
+			/* skip to the STOP; make sure SCL is low before SDA is pulled low */
+			xlen = tot - I2C_STOP_SAMPLES - off;
+			xbuf[tot - I2C_STOP_SAMPLES - 1] = bb_i2c_level( 0, 1 );
+			if ( (rval = fw_xfer_bb( fw, BITS_FW_CMD_BB_I2C, xbuf + tot - I2C_STOP_SAMPLES - 1, sbuf + tot - I2C_STOP_SAMPLES - 1, 1 )) < 0 ) {
+				goto bail;
 			}
-			goto bail;
 		}
-		rval = bb_i2c_read( fw, data, len );
-	} else {
-		rval = bb_i2c_write( fw, data, len );
 	}
 
-bail:
-	/* attempt to stop */
-	if ( (st = bb_i2c_stop( fw )) < 0 && rval >= 0 ) {
-		rval = st;
+	if ( fw->debug ) {
+		printf("fw_i2c_xfer_bb(sla 0x%02x, wlen %zu, rlen %zu):\n", sla, plen + wlen, rlen);
+		for ( i = 0; i < tot; i++ ) {
+			pr_i2c_dbg(xbuf[i], sbuf[i]);
+		}
 	}
+
+	if ( nak ) {
+		rval = ( 0 == acks ) ? -ENODEV : ( rlen ? -EIO : (int)acks - 1 );
+		goto bail;
+	}
+
+	for ( i = 0; i < rlen; i++ ) {
+		rbuf[i] = ( bb_i2c_get_byte( sbuf + rdOff + i * I2C_BYTE_SAMPLES ) >> 1 ) & 0xff;
+	}
+	rval = rlen ? (int)rlen : (int)(acks - 1);
+
+bail:
+	free( xbuf );
 	return rval;
 }
 
+static int
+__fw_i2c_xfer(FWInfo *fw, uint8_t sla, const uint8_t *wpre, size_t plen, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+	/* the status word counts the address bytes, too */
+	if (    !! (fw->features & FW_FEATURE_I2C_MASTER)
+	     && plen + wlen + 2 <= I2C_STA_ACK_MSK
+	     && rlen <= 0xffff ) {
+		return fw_i2c_xfer_hw( fw, sla, wpre, plen, wbuf, wlen, rbuf, rlen );
+	}
+	return fw_i2c_xfer_bb( fw, sla, wpre, plen, wbuf, wlen, rbuf, rlen );
+}
+
+int
+fw_i2c_xfer(FWInfo *fw, uint8_t sla, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+	return __fw_i2c_xfer( fw, sla, NULL, 0, wbuf, wlen, rbuf, rlen );
+}
+
+int
+bb_i2c_rw_a8(FWInfo *fw, uint8_t sla, uint8_t addr, uint8_t *data, size_t len)
+{
+int     rval;
+
+	if ( !!(sla & I2C_READ) ) {
+		rval = __fw_i2c_xfer( fw, sla, &addr, 1, NULL, 0, data, len );
+		return rval < 0 ? rval : (int)len;
+	}
+	/* drivers update the shadow after a successful write */
+	for ( rval = 0; rval < (int)len; rval++ ) {
+		fw_shadow_invalidate( fw, FW_SHADOW_I2C( sla ), (uint8_t)(addr + rval) );
+	}
+	if ( (rval = __fw_i2c_xfer( fw, sla, &addr, 1, data, len, NULL, 0 )) < 0 ) {
+		return rval;
+	}
+	/* NAK on address byte => -EIO; otherwise count payload bytes only */
+	return rval < 1 ? -EIO : rval - 1;
+}
+
 static int
 bb_i2c_rw_reg(FWInfo *fw, uint8_t sla, uint8_t reg, int val)
 {
@@ -878,15 +1345,18 @@ __fw_has_buf(FWInfo *fw, size_t *psz, unsigned *pflg)
 uint8_t  buf[4];
 long     rval;
 int      ret = BUF_SIZE_FAILED;
-uint8_t  cmd = fw_get_cmd(fw, FW_CMD_ADC_BUF ) | BITS_FW_CMD_MEMSIZE;
+uint8_t  cmd = fw_get_cmd(fw, FW_CMD_ADC_BUF ) | BITS_FW_CMD_MEMSIZE | BITS_FW_CMD_ADCRANGE;
 size_t   sz  = 0;
 unsigned flg = 0;
 
 	rval = fw_xfer( fw, cmd, 0, buf, sizeof(buf) );
 
 	switch ( rval ) {
+		case 4:
+			flg = (uint8_t)buf[3] << 8;
+			/* fall through */
 		case 3:
-			flg = (uint8_t)buf[2];
+			flg |= (uint8_t)buf[2];
 			/* fall through */
 		case 2: /* older fw version has no flags */
 			sz = 512UL * ((size_t)((buf[1]<<8) | buf[0]) + 1);
@@ -1037,6 +1507,166 @@ fw_reg_write(FWInfo *fw, uint32_t addr, const uint8_t *buf, size_t len, unsigned
 	return (1 != st ) || status ? -EIO : len;
 }
 
+/* Vector tuples: control byte (direction and count - 1), address, [data] */
+#define REG_VEC_CTL_WR  0x80
+#define REG_VEC_MAXLEN  128
+
+/* Probe for vector support by reading the version register; old
+ * firmware rejects the unknown subcommand with a bare (error) status.
+ */
+static int
+__fw_has_reg_vec(FWInfo *fw)
+{
+uint8_t  req[2];
+uint8_t  rep[2];
+tbufvec  tvec[1];
+rbufvec  rvec[1];
+
+	req[0]      = 0x00; /* read, 1 byte */
+	req[1]      = GEN_REG_VERSION_OFF;
+	tvec[0].buf = req;
+	tvec[0].len = sizeof(req);
+	rvec[0].buf = rep;
+	rvec[0].len = sizeof(rep);
+	return (int)sizeof(rep) == fw_xfer_vec( fw, fw_get_cmd( fw, FW_CMD_GEN_REG_VEC ), tvec, 1, rvec, 1 ) && 0 == rep[1];
+}
+
+int
+fw_reg_xfer_vec(FWInfo *fw, const struct reg_vec *vec, size_t nelms)
+{
+int          packed = !! ( fw->features & FW_FEATURE_REG_VEC );
+size_t       ntup   = 0;
+size_t       nfrm   = 0;
+size_t       nt     = 0;
+size_t       nr     = 0;
+size_t       i, off, n;
+uint8_t     *hdrs   = NULL;
+uint8_t     *stas   = NULL;
+uint8_t     *cmds   = NULL;
+size_t      *rlen   = NULL;
+tbufvec     *tvec   = NULL;
+rbufvec     *rvec   = NULL;
+FifoXferReq *reqs   = NULL;
+uint8_t     *h;
+int          app, curApp = -1;
+int          rval   = 0;
+int          st;
+
+	for ( i = 0; i < nelms; i++ ) {
+		if ( ( ! vec[i].tbuf == ! vec[i].rbuf ) || 0 == vec[i].len || vec[i].addr >= 256 || (vec[i].addr + vec[i].len) > 256 ) {
+			return -EINVAL;
+		}
+		ntup += packed ? (vec[i].len + REG_VEC_MAXLEN - 1)/REG_VEC_MAXLEN : 1;
+		rval += vec[i].len;
+	}
+	if ( 0 == ntup ) {
+		return 0;
+	}
+
+	/* at most one frame per tuple; each has a header, data and a status */
+	hdrs = malloc( 2 * ntup );
+	stas = malloc( ntup );
+	cmds = malloc( ntup );
+	rlen = malloc( ntup * sizeof(*rlen) );
+	tvec = malloc( 2 * ntup * sizeof(*tvec) );
+	rvec = malloc( 2 * ntup * sizeof(*rvec) );
+	reqs = malloc( ntup * sizeof(*reqs) );
+	if ( ! hdrs || ! stas || ! cmds || ! rlen || ! tvec || ! rvec || ! reqs ) {
+		rval = -ENOMEM;
+		goto bail;
+	}
+
+	h = hdrs;
+	for ( i = 0; i < nelms; i++ ) {
+		app = ( (vec[i].flags & REG_FLG_ASPC_MSK) == REG_FLG_APP );
+		for ( off = 0; off < vec[i].len; off += n ) {
+			n = vec[i].len - off;
+			if ( packed && n > REG_VEC_MAXLEN ) {
+				n = REG_VEC_MAXLEN;
+			}
+			if ( ! packed || app != curApp ) {
+				/* start a new frame; terminate the previous one with its status */
+				if ( nfrm > 0 ) {
+					rvec[nr].buf = &stas[nfrm - 1];
+					rvec[nr].len = 1;
+					nr++;
+					reqs[nfrm - 1].rcnt++;
+				}
+				if ( packed ) {
+					cmds[nfrm] = fw_get_cmd( fw, app ? FW_CMD_APP_REG_VEC : FW_CMD_GEN_REG_VEC );
+				} else if ( vec[i].tbuf ) {
+					cmds[nfrm] = fw_get_cmd( fw, app ? FW_CMD_APP_REG_WR8 : FW_CMD_GEN_REG_WR8 );
+				} else {
+					cmds[nfrm] = fw_get_cmd( fw, app ? FW_CMD_APP_REG_RD8 : FW_CMD_GEN_REG_RD8 );
+				}
+				reqs[nfrm].cmdp   = &cmds[nfrm];
+				reqs[nfrm].tbuf   = &tvec[nt];
+				reqs[nfrm].tcnt   = 0;
+				reqs[nfrm].rbuf   = &rvec[nr];
+				reqs[nfrm].rcnt   = 0;
+				reqs[nfrm].status = 0;
+				rlen[nfrm]        = 1;
+				nfrm++;
+				curApp = app;
+			}
+			/* header: vector tuple or address [+ count] of a single access */
+			tvec[nt].buf = h;
+			if ( packed ) {
+				*h++ = ( vec[i].tbuf ? REG_VEC_CTL_WR : 0 ) | (uint8_t)(n - 1);
+				*h++ = (uint8_t)(vec[i].addr + off);
+				tvec[nt].len = 2;
+			} else {
+				*h++ = (uint8_t)(vec[i].addr + off);
+				*h++ = (uint8_t)(n - 1);
+				tvec[nt].len = vec[i].tbuf ? 1 : 2;
+			}
+			nt++;
+			reqs[nfrm - 1].tcnt++;
+			if ( vec[i].tbuf ) {
+				tvec[nt].buf = vec[i].tbuf + off;
+				tvec[nt].len = n;
+				nt++;
+				reqs[nfrm - 1].tcnt++;
+			} else {
+				rvec[nr].buf = vec[i].rbuf + off;
+				rvec[nr].len = n;
+				nr++;
+				reqs[nfrm - 1].rcnt++;
+				rlen[nfrm - 1] += n;
+			}
+		}
+	}
+	rvec[nr].buf = &stas[nfrm - 1];
+	rvec[nr].len = 1;
+	nr++;
+	reqs[nfrm - 1].rcnt++;
+
+	if ( (st = fw_xfer_vec_multi( fw, reqs, nfrm, nfrm )) < 0 ) {
+		rval = st;
+		goto bail;
+	}
+	for ( i = 0; i < nfrm; i++ ) {
+		if ( reqs[i].status < 0 ) {
+			rval = reqs[i].status;
+			goto bail;
+		}
+		if ( rlen[i] != reqs[i].status || stas[i] ) {
+			rval = -EIO;
+			goto bail;
+		}
+	}
+
+bail:
+	free( reqs );
+	free( rvec );
+	free( tvec );
+	free( rlen );
+	free( cmds );
+	free( stas );
+	free( hdrs );
+	return rval;
+}
+
 int
 fw_reconfigure_fpga_supported(FWInfo *fw)
 {
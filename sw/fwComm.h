@@ -37,7 +37,7 @@ typedef struct FWInfo FWInfo;
 
 /* FW_CMD_APP_REG_xx addresses application-register space */
 /* FW_CMD_GEN_REG_xx addresses generic-register space */
-typedef enum   FWCmd  { FW_CMD_VERSION, FW_CMD_ADC_BUF, FW_CMD_ADC_FLUSH, FW_CMD_BB_OFF, FW_CMD_BB_I2C, FW_CMD_BB_SPI, FW_CMD_ACQ_PARMS, FW_CMD_SPI, FW_CMD_APP_REG_RD8, FW_CMD_APP_REG_WR8, FW_CMD_GEN_REG_RD8, FW_CMD_GEN_REG_WR8 } FWCmd;
+typedef enum   FWCmd  { FW_CMD_VERSION, FW_CMD_ADC_BUF, FW_CMD_ADC_FLUSH, FW_CMD_BB_OFF, FW_CMD_BB_I2C, FW_CMD_BB_SPI, FW_CMD_ACQ_PARMS, FW_CMD_SPI, FW_CMD_APP_REG_RD8, FW_CMD_APP_REG_WR8, FW_CMD_GEN_REG_RD8, FW_CMD_GEN_REG_WR8, FW_CMD_I2C, FW_CMD_APP_REG_VEC, FW_CMD_GEN_REG_VEC, FW_CMD_ADC_BUF_WAIT, FW_CMD_ADC_BUF_RANGE, FW_CMD_ADC_BUF_RANGE_WAIT } FWCmd;
 
 typedef enum   SPIDev { SPI_NONE, SPI_FLASH, SPI_ADC, SPI_PGA, SPI_FEG, SPI_VGA, SPI_VGB } SPIDev;
 
@@ -83,6 +83,9 @@ fw_get_api_function(FWInfo *fw);
 
 #define FW_FEATURE_SPI_CONTROLLER (1ULL<<0)
 #define FW_FEATURE_ADC            (1ULL<<1)
+#define FW_FEATURE_I2C_MASTER     (1ULL<<2)
+#define FW_FEATURE_REG_VEC        (1ULL<<3)
+#define FW_FEATURE_COBS           (1ULL<<4)
 
 uint64_t
 fw_get_features(FWInfo *fw);
@@ -91,6 +94,56 @@ fw_get_features(FWInfo *fw);
 void
 fw_disable_features(FWInfo *fw, uint64_t mask);
 
+/* Switch the link framing between COMMA/ESCAP stuffing (cobs = 0)
+ * and COBS (cobs != 0; bounded overhead of 1 octet per 254). The
+ * firmware advertises COBS support by FW_FEATURE_COBS and fw_open()
+ * enables it automatically. Must not be called while other transfers
+ * on the link are in progress.
+ * RETURNS: 0 on success, -ENOTSUP if the firmware does not support
+ *          COBS, other negative errno on error.
+ */
+int
+fw_set_framing(FWInfo *fw, int cobs);
+
+/* Register shadow (write-through cache) of board peripherals.
+ *
+ * Drivers look up a register with fw_shadow_get() before reading the
+ * device and record every value they read or successfully write with
+ * fw_shadow_set(). Devices are identified by a key (FW_SHADOW_I2C(),
+ * FW_SHADOW_SPI()), registers by a number < 256; values are up to
+ * 16 bits wide. Raw register accessors (for debugging) always read
+ * the device.
+ */
+#define FW_SHADOW_I2C(sla)  ((unsigned)(sla) & 0xfe)   /* 8-bit i2c address */
+#define FW_SHADOW_SPI(type) (0x100 | (unsigned)(type)) /* SPIDev            */
+#define FW_SHADOW_ALL       (~0U)
+
+/* RETURNS: cached value or -ENOENT if the register is not cached */
+int
+fw_shadow_get(FWInfo *fw, unsigned dev, unsigned reg);
+
+void
+fw_shadow_set(FWInfo *fw, unsigned dev, unsigned reg, unsigned val);
+
+/* Invalidate a register (or all registers of a device/all devices
+ * with FW_SHADOW_ALL), e.g., after a device reset.
+ */
+void
+fw_shadow_invalidate(FWInfo *fw, unsigned dev, unsigned reg);
+
+/* Exclude a (status) register from caching; drivers mark their
+ * volatile registers once when they are initialized. The mark
+ * persists across fw_shadow_invalidate() and fw_shadow_enable().
+ */
+void
+fw_shadow_set_volatile(FWInfo *fw, unsigned dev, unsigned reg);
+
+/* Enable (default) or disable the shadow; disabling discards all
+ * cached values (but not the volatile marks).
+ */
+void
+fw_shadow_enable(FWInfo *fw, int enable);
+
 /* set 'I2C_READ' when writing the i2c address */
 #define I2C_READ (1<<0)
 
@@ -132,6 +185,24 @@ bb_i2c_write_reg(FWInfo *fw, uint8_t sla, uint8_t reg, uint8_t val);
 int
 bb_i2c_rw_a8(FWInfo *fw, uint8_t sla, uint8_t addr, uint8_t *data, size_t len);
 
+/* Combined i2c transaction: START, write 'sla' (the R/W bit is ignored)
+ * followed by 'wlen' bytes from 'wbuf' and, if 'rlen' is nonzero, a
+ * (repeated) START, 'sla | I2C_READ' and reading 'rlen' bytes into 'rbuf'
+ * (if 'wlen' is zero then the read is started right away). A STOP
+ * terminates the transaction.
+ * The firmware's i2c master is used if available (FW_FEATURE_I2C_MASTER);
+ * bit-banging otherwise.
+ *
+ * SLA is 7-bit address LEFT SHIFTED by 1 bit
+ *
+ * RETURNS: 'rlen' if 'rlen' is nonzero, the number of bytes written and
+ *          ACKed by the slave otherwise or a negative status on error;
+ *          -ENODEV if the slave does not ACK its address, -EIO if a
+ *          NAK aborts a read transaction.
+ */
+int
+fw_i2c_xfer(FWInfo *fw, uint8_t sla, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
+
 /* Access to raw bit-bang states (for board debugging) */
 int
 bb_spi_raw(FWInfo *fw, SPIDev type, int clk, int mosi, int cs, int hiz);
@@ -163,6 +234,18 @@ fw_xfer(FWInfo *fw, uint8_t cmd, const uint8_t *tbuf, uint8_t *rbuf, size_t len)
 int
 fw_xfer_vec(FWInfo *fw, uint8_t cmd, const tbufvec *tbuf, size_t tcnt, const rbufvec *rbuf, size_t rcnt);
 
+/*
+ * Pipelined transfer of several frames with up to 'depth' commands
+ * in flight (see fifoXferFrameVecMulti()). Note that the commands
+ * pointed to by 'reqs[i].cmdp' are overwritten by the readback.
+ * The status of requests that hit an unsupported command is set
+ * to -ENOTSUP.
+ *
+ * RETURNS: 0 if all frames were completed, negative error otherwise.
+ */
+int
+fw_xfer_vec_multi(FWInfo *fw, FifoXferReq *reqs, size_t nreqs, size_t depth);
+
 uint8_t
 fw_spireg_cmd_read(unsigned ch);
 
@@ -180,6 +263,29 @@ fw_reg_read(FWInfo *fw, uint32_t addr, uint8_t *buf, size_t len, unsigned flags)
 int
 fw_reg_write(FWInfo *fw, uint32_t addr, const uint8_t *buf, size_t len, unsigned flags);
 
+/* Scatter/gather register access; every element reads ('rbuf') or
+ * writes ('tbuf'; exactly one of the two must be non-NULL) 'len'
+ * registers starting at 'addr' in the space selected by 'flags'.
+ * The elements are executed in order.
+ * If the firmware supports it (FW_FEATURE_REG_VEC) then consecutive
+ * elements addressing the same space are packed into a single frame
+ * and processing stops at the first failing element. Otherwise, each
+ * element is sent as an individual (pipelined) read or write command.
+ *
+ * RETURN: total number of bytes transferred or negative error code
+ *         (-EIO if any element failed).
+ */
+typedef struct reg_vec {
+	uint32_t       addr;
+	const uint8_t *tbuf;
+	uint8_t       *rbuf;
+	size_t         len;
+	unsigned       flags;
+} reg_vec;
+
+int
+fw_reg_xfer_vec(FWInfo *fw, const struct reg_vec *vec, size_t nelms);
+
 /* Check if FPGA reconfiguration is supported by firmware;
  * RETURN 0 if support is available, negative status otherwise
  */
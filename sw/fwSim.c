@@ -0,0 +1,1944 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "cmdXfer.h"
+#include "byteStuff.h"
+#include "fwSim.h"
+
+/* Command set of the scope firmware (API version 4);
+ * see hdl/CommandMuxPkg.vhd.
+ */
+#define CMD_VER            0x00
+#define CMD_SPI            0x01
+#define CMD_GEN_REG        0x02
+#define CMD_APP_REG        0x03
+#define CMD_BB             0x04
+#define CMD_ADC            0x05
+#define CMD_ACQ            0x06
+#define CMD_I2C            0x07
+#define CMD_ERR            0xff
+
+#define CMD_IDX(c)         ((c) & 0x0f)
+#define CMD_SUB(c)         (((c) >> 4) & 0x0f)
+
+#define API_VERSION        0x14 /* scope function, API version 4 */
+
+#define SUB_REG_RD8        0
+#define SUB_REG_WR8        1
+#define SUB_REG_VEC        2
+#define REG_VEC_WR         0x80
+
+#define SUB_ADC_READ       0
+#define SUB_ADC_FLUSH      1
+#define SUB_ADC_MSIZE      2
+#define SUB_ADC_SFREQ      3
+#define SUB_ADC_WAIT       4   /* modifier of SUB_ADC_READ */
+#define SUB_ADC_RANGE      8   /* modifier of SUB_ADC_READ; followed by offset, count[, bucket] */
+#define ADC_WAIT_MS        100 /* timeout of a read-wait (MaxAdc WAIT_TIMEOUT_G; ADC_XFLG_HOLD) */
+#define ADC_FLG_WAIT       0x10
+#define ADC_FLG_RANGE      0x20
+#define ADC_FLG_PEAK       0x40
+#define ADC_FLG_SEG        0x80
+/* segmented acquisition: trailer (in sample words) following each segment */
+#define ADC_SEG_TRL        4
+#define ADC_XFLG_XHDR      0x01 /* extended flags (MSIZE with SUB_ADC_RANGE) */
+#define ADC_XFLG_DBL       0x02
+#define ADC_XFLG_PACK      0x04
+#define ADC_XFLG_AVG       0x08
+#define ADC_XFLG_HOLD_SHF  4    /* read-wait timeout in units of ADC_XFLG_HOLD_MS (rounded up) */
+#define ADC_XFLG_HOLD_MS   10
+#define ADC_XFLG_HOLD      ( ( ( ADC_WAIT_MS + ADC_XFLG_HOLD_MS - 1 ) / ADC_XFLG_HOLD_MS ) << ADC_XFLG_HOLD_SHF )
+#define ADC_HDR_HLF        0x02 /* 2nd header byte: half of the ping-pong buffer */
+#define ADC_HDR_AVG        0x04 /* 2nd header byte: sums of averaged acquisitions */
+#define ADC_AVG_MAX        256  /* max. number of averaged acquisitions (MaxAdc AVG_LD_MAX_G) */
+#define ADC_OPT_XHDR       0x01 /* range-read option: extended header       */
+#define ADC_OPT_PACK       0x02 /* range-read option: packed samples        */
+#define ADC_XHDR_LEN       8    /* sequence number, trigger timestamp       */
+
+#define SUB_BB_NONE        0
+#define SUB_BB_ROM         1
+#define SUB_BB_I2C         4
+#define SUB_BB_FEG         5
+
+/* bit-bang bits */
+#define BB_CSB             (1<<0)
+#define BB_SCLK            (1<<1)
+#define BB_MOSI            (1<<2)
+#define BB_MISO            (1<<3)
+#define BB_SDA             (1<<4)
+#define BB_SCL             (1<<5)
+#define BB_HIZ             (1<<6)
+
+/* I2C devices */
+#define I2C_SLA_GCALL      0x00
+#define I2C_SLA_DAC        0xc2 /* 47CVB02 */
+#define I2C_SLA_CLK        0xd4 /* 5P49V5925 */
+#define I2C_READ           0x01
+
+/* status of the i2c master command */
+#define I2C_STA_NAK        0x8000
+
+#define DAC_NUM_REGS       32
+#define DAC_CMD_READ       0x06
+#define DAC_MAX_TICKS      0xfff
+
+/* acquisition parameters (layout V2 + number of segments + number of averages) */
+#define ACQ_LEN            28
+#define ACQ_LEN_V3         26
+#define ACQ_LEN_V2         24
+#define ACQ_MSK_SRC        (1<<0)
+#define ACQ_MSK_EDG        (1<<1)
+#define ACQ_MSK_LVL        (1<<2)
+#define ACQ_MSK_NPT        (1<<3)
+#define ACQ_MSK_AUT        (1<<4)
+#define ACQ_MSK_DCM        (1<<5)
+#define ACQ_MSK_SCL        (1<<6)
+#define ACQ_MSK_NSM        (1<<7)
+#define ACQ_MSK_TGO        (1<<8)
+#define ACQ_MSK_SEG        (1<<9)
+#define ACQ_MSK_DBL        (1<<10)
+#define ACQ_MSK_AVG        (1<<11)
+
+#define ACQ_SRC_CHA        0
+#define ACQ_SRC_CHB        1
+#define ACQ_SRC_EXT        2
+
+#define AUTO_TIMEOUT_NEVER 0xffff
+
+/* registers */
+#define GEN_REG_VERSION_1  0x01
+#define APP_REG_CLK_CSR    4
+#define APP_REG_CLK_LOCKED 0x01
+#define REG_SPACE          256
+
+/* Flash (matches the 'SIMULATED' entry in at25Sup.c) */
+#define FLASH_SIZE         (64*1024)
+#define FLASH_PAGE_SIZE    256
+#define FLASH_ST_WEL       0x02
+
+#define FLASH_OP_PAGE_WRITE 0x02
+#define FLASH_OP_STATUS_WR  0x01
+#define FLASH_OP_WRITE_DIS  0x04
+#define FLASH_OP_STATUS     0x05
+#define FLASH_OP_WRITE_ENA  0x06
+#define FLASH_OP_FAST_READ  0x0b
+#define FLASH_OP_ERASE_4K   0x20
+#define FLASH_OP_ERASE_32K  0x52
+#define FLASH_OP_ERASE_ALL  0x60
+#define FLASH_OP_ID         0x9f
+#define FLASH_OP_ERASE_64K  0xd8
+
+/* discard frames longer than this */
+#define FRAME_MAXLEN       (16*1024*1024)
+
+typedef enum { FL_IDLE, FL_ADDR, FL_DUMMY, FL_READ, FL_PROG, FL_ID, FL_STATUS, FL_IGNORE } FlashState;
+
+typedef struct SimFlash {
+	uint8_t    mem[FLASH_SIZE];
+	uint8_t    pgbuf[FLASH_PAGE_SIZE];
+	FlashState state;
+	uint8_t    op;
+	uint8_t    status;
+	uint32_t   addr;
+	unsigned   cnt;
+	int        pending;
+} SimFlash;
+
+/* Byte-level interface of a SPI device; 'peek' returns the
+ * octet the device shifts out during the next byte-slot (it
+ * must not depend on the octet shifted in).
+ */
+typedef struct SimSpiDev {
+	uint8_t  (*peek)    (void *dev);
+	void     (*put)     (void *dev, uint8_t in);
+	void     (*deselect)(void *dev);
+} SimSpiDev;
+
+/* Adaptor between bit-banged (mode 0) SPI signals and a
+ * byte-level device.
+ */
+typedef struct SimSpiBits {
+	const SimSpiDev *ops;
+	void            *dev;
+	int              lcsb;
+	int              lsclk;
+	uint8_t          sr;
+	uint8_t          out;
+	int              obit;
+	unsigned         nbits;
+	int              reload;
+} SimSpiBits;
+
+typedef struct SimSpiReg {
+	uint8_t          reg;
+	uint8_t          pend;
+	int              wr;
+} SimSpiReg;
+
+/* Byte-level interface of an I2C slave */
+typedef struct SimI2cDev {
+	uint8_t          sla;
+	/* called after the address has been acknowledged */
+	void           (*start)(void *dev, int rd);
+	/* RETURNS: 0 to acknowledge */
+	int            (*write)(void *dev, uint8_t b);
+	uint8_t        (*read) (void *dev);
+	void            *dev;
+} SimI2cDev;
+
+typedef enum { I2C_IDLE, I2C_ADDR, I2C_WRITE, I2C_READ_DATA, I2C_IGNORE } I2cState;
+
+/* Decodes the (bit-banged) bus as seen by the slaves */
+typedef struct SimI2cBus {
+	const SimI2cDev *devs;
+	unsigned         ndevs;
+	const SimI2cDev *cur;
+	I2cState         state;
+	int              lscl;
+	int              lsda;
+	unsigned         nbit;
+	uint8_t          sr;
+	uint8_t          tx;
+	int              sdaOut;
+} SimI2cBus;
+
+/* 47CVB02 dual DAC */
+typedef struct SimDac {
+	uint16_t         regs[DAC_NUM_REGS];
+	unsigned         ptr;
+	unsigned         cnt;
+	int              rd;
+} SimDac;
+
+/* Generic device with 256 8-bit registers and an auto-incremented pointer */
+typedef struct SimI2cRegs {
+	uint8_t          regs[256];
+	uint8_t          ptr;
+	int              havePtr;
+} SimI2cRegs;
+
+typedef struct SimAcqParams {
+	uint32_t         mask;
+	uint8_t          src;
+	int              rising;
+	int              tgo;
+	int16_t          level;
+	uint32_t         npts;
+	uint32_t         nsm;     /* nsamples - 1 */
+	uint16_t         autoMS;
+	uint32_t         dcm;     /* decm0 - 1 at bit 20, decm1 - 1 at bits 0..19 */
+	uint32_t         scl;
+	uint16_t         hyst;
+	uint16_t         nseg;    /* nsegments - 1 */
+	int              dbl;     /* ping-pong buffer */
+	uint16_t         navg;    /* naverage - 1 */
+} SimAcqParams;
+
+struct FWSim {
+	FWSimConfig      cfg;
+	uint8_t          genRegs[REG_SPACE];
+	uint8_t          genWMsk[REG_SPACE];
+	uint8_t          genVld [REG_SPACE];
+	uint8_t          appRegs[REG_SPACE];
+	uint8_t          appWMsk[REG_SPACE];
+	uint8_t          appVld [REG_SPACE];
+	SimFlash         flash;
+	SimSpiReg        fegReg;
+	SimSpiBits       romBits;
+	SimSpiBits       fegBits;
+	SimDac           dac;
+	SimI2cRegs       clk;
+	SimI2cDev        i2cDevs[3];
+	SimI2cBus        i2c;
+	SimAcqParams     acq;
+	struct timespec  armed;
+	/* ping-pong mode: when the reader last released a half and
+	 * the half holding the next acquisition
+	 */
+	struct timespec  released;
+	int              hlf;
+	uint16_t         seq;
+	uint32_t         rnd;
+	/* framing requested by the last VERSION command (-1: none) */
+	int              framing;
+	uint8_t         *rep;
+	size_t           repCap;
+};
+
+static uint8_t
+flashPeek(void *dev)
+{
+SimFlash *f = (SimFlash*)dev;
+	switch ( f->state ) {
+		case FL_ID:
+			return ( f->cnt < 5 ) ? (uint8_t)(0xdeadbeef00ULL >> (8*(4 - f->cnt))) : 0x00;
+		case FL_STATUS:
+			return f->status;
+		case FL_READ:
+			return f->mem[ f->addr & (FLASH_SIZE - 1) ];
+		default:
+			break;
+	}
+	return 0xff;
+}
+
+static void
+flashPut(void *dev, uint8_t in)
+{
+SimFlash *f = (SimFlash*)dev;
+uint32_t  base;
+
+	switch ( f->state ) {
+		case FL_IDLE:
+			f->op      = in;
+			f->addr    = 0;
+			f->cnt     = 0;
+			f->pending = 0;
+			switch ( in ) {
+				case FLASH_OP_ID:         f->state = FL_ID;                      break;
+				case FLASH_OP_STATUS:     f->state = FL_STATUS;                  break;
+				case FLASH_OP_WRITE_ENA:  f->status |=  FLASH_ST_WEL; f->state = FL_IGNORE; break;
+				case FLASH_OP_WRITE_DIS:  f->status &= ~FLASH_ST_WEL; f->state = FL_IGNORE; break;
+				case FLASH_OP_ERASE_ALL:  f->pending = 1; f->state = FL_IGNORE;  break;
+				case FLASH_OP_FAST_READ:
+				case FLASH_OP_PAGE_WRITE:
+				case FLASH_OP_ERASE_4K:
+				case FLASH_OP_ERASE_32K:
+				case FLASH_OP_ERASE_64K:  f->state = FL_ADDR;                    break;
+				/* status write (protection bits are not modeled), resume, reset, ... */
+				default:                  f->state = FL_IGNORE;                  break;
+			}
+			break;
+
+		case FL_ADDR:
+			f->addr = (f->addr << 8) | in;
+			if ( ++f->cnt < 3 ) {
+				break;
+			}
+			f->addr &= FLASH_SIZE - 1;
+			switch ( f->op ) {
+				case FLASH_OP_FAST_READ:
+					f->state = FL_DUMMY;
+					break;
+				case FLASH_OP_PAGE_WRITE:
+					base = f->addr & ~(FLASH_PAGE_SIZE - 1);
+					memcpy( f->pgbuf, f->mem + base, FLASH_PAGE_SIZE );
+					f->state = FL_PROG;
+					break;
+				default:
+					f->pending = 1;
+					f->state   = FL_IGNORE;
+					break;
+			}
+			break;
+
+		case FL_DUMMY:
+			f->state = FL_READ;
+			break;
+
+		case FL_READ:
+			f->addr = (f->addr + 1) & (FLASH_SIZE - 1);
+			break;
+
+		case FL_PROG:
+			/* programming can only clear bits */
+			f->pgbuf[ f->addr & (FLASH_PAGE_SIZE - 1) ] &= in;
+			f->addr  = (f->addr & ~(FLASH_PAGE_SIZE - 1)) | ((f->addr + 1) & (FLASH_PAGE_SIZE - 1));
+			f->pending = 1;
+			break;
+
+		case FL_ID:
+			f->cnt++;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void
+flashDeselect(void *dev)
+{
+SimFlash *f = (SimFlash*)dev;
+uint32_t  sz = 0;
+
+	if ( f->pending && (f->status & FLASH_ST_WEL) ) {
+		switch ( f->op ) {
+			case FLASH_OP_PAGE_WRITE:
+				memcpy( f->mem + (f->addr & ~(FLASH_PAGE_SIZE - 1)), f->pgbuf, FLASH_PAGE_SIZE );
+				break;
+			case FLASH_OP_ERASE_4K:  sz =  4*1024;     break;
+			case FLASH_OP_ERASE_32K: sz = 32*1024;     break;
+			case FLASH_OP_ERASE_64K: sz = 64*1024;     break;
+			case FLASH_OP_ERASE_ALL: sz = FLASH_SIZE;  break;
+			default:
+				break;
+		}
+		if ( sz ) {
+			if ( sz > FLASH_SIZE ) {
+				sz = FLASH_SIZE;
+			}
+			memset( f->mem + (f->addr & ~(sz - 1)), 0xff, sz );
+		}
+		f->status &= ~FLASH_ST_WEL;
+	}
+	f->pending = 0;
+	f->state   = FL_IDLE;
+}
+
+static const SimSpiDev simFlashOps = {
+	peek     : flashPeek,
+	put      : flashPut,
+	deselect : flashDeselect,
+};
+
+/* 8-bit register with a SPI interface (hdl/SpiReg.vhd); loaded when
+ * CS is asserted and written when CS is deasserted.
+ */
+static uint8_t
+spiRegPeek(void *dev)
+{
+	return ((SimSpiReg*)dev)->reg;
+}
+
+static void
+spiRegPut(void *dev, uint8_t in)
+{
+SimSpiReg *r = (SimSpiReg*)dev;
+	r->pend = in;
+	r->wr   = 1;
+}
+
+static void
+spiRegDeselect(void *dev)
+{
+SimSpiReg *r = (SimSpiReg*)dev;
+	if ( r->wr ) {
+		r->reg = r->pend;
+		r->wr  = 0;
+	}
+}
+
+static const SimSpiDev simSpiRegOps = {
+	peek     : spiRegPeek,
+	put      : spiRegPut,
+	deselect : spiRegDeselect,
+};
+
+static void
+spiBitsInit(SimSpiBits *b, const SimSpiDev *ops, void *dev)
+{
+	memset( b, 0, sizeof(*b) );
+	b->ops   = ops;
+	b->dev   = dev;
+	b->lcsb  = 1;
+}
+
+/* RETURNS: MISO */
+static int
+spiBitsStep(SimSpiBits *b, uint8_t bbo)
+{
+int csb  = !! (bbo & BB_CSB);
+int sclk = !! (bbo & BB_SCLK);
+
+	if ( csb ) {
+		if ( ! b->lcsb ) {
+			b->ops->deselect( b->dev );
+		}
+		b->lcsb  = 1;
+		b->lsclk = sclk;
+		return 1;
+	}
+	if ( b->lcsb ) {
+		b->out    = b->ops->peek( b->dev );
+		b->obit   = 7;
+		b->nbits  = 0;
+		b->reload = 0;
+	} else if ( sclk && ! b->lsclk ) {
+		b->sr = (b->sr << 1) | !! (bbo & BB_MOSI);
+		if ( 8 == ++b->nbits ) {
+			b->ops->put( b->dev, b->sr );
+			b->nbits  = 0;
+			b->reload = 1;
+		}
+	} else if ( ! sclk && b->lsclk ) {
+		if ( b->reload ) {
+			b->out    = b->ops->peek( b->dev );
+			b->obit   = 7;
+			b->reload = 0;
+		} else if ( b->obit > 0 ) {
+			b->obit--;
+		}
+	}
+	b->lcsb  = 0;
+	b->lsclk = sclk;
+	return (b->out >> b->obit) & 1;
+}
+
+static void
+dacReset(SimDac *d)
+{
+	memset( d->regs, 0, sizeof(d->regs) );
+	/* mid-scale */
+	d->regs[0] = (DAC_MAX_TICKS + 1)/2;
+	d->regs[1] = (DAC_MAX_TICKS + 1)/2;
+}
+
+static void
+dacStart(void *dev, int rd)
+{
+SimDac *d = (SimDac*)dev;
+	/* the register pointer is retained across a repeated start */
+	d->cnt = 0;
+	d->rd  = rd;
+}
+
+static int
+dacWrite(void *dev, uint8_t b)
+{
+SimDac *d = (SimDac*)dev;
+	switch ( d->cnt++ ) {
+		case 0:
+			d->ptr = (b >> 3) & (DAC_NUM_REGS - 1);
+			/* nothing else to do for a read command */
+			break;
+		case 1:
+			d->regs[d->ptr] = (b << 8);
+			break;
+		default:
+			d->regs[d->ptr] |= b;
+			if ( d->ptr < 2 ) {
+				d->regs[d->ptr] &= DAC_MAX_TICKS;
+			}
+			/* next command */
+			d->cnt = 0;
+			break;
+	}
+	return 0;
+}
+
+static uint8_t
+dacRead(void *dev)
+{
+SimDac *d = (SimDac*)dev;
+	return ( 0 == (d->cnt++ & 1) ) ? (d->regs[d->ptr] >> 8) : (d->regs[d->ptr] & 0xff);
+}
+
+/* general call; only 'reset' (0x06) is implemented */
+static void
+gcallStart(void *dev, int rd)
+{
+}
+
+static int
+gcallWrite(void *dev, uint8_t b)
+{
+	if ( 0x06 == b ) {
+		dacReset( (SimDac*)dev );
+	}
+	return 0;
+}
+
+static uint8_t
+gcallRead(void *dev)
+{
+	return 0xff;
+}
+
+static void
+i2cRegsStart(void *dev, int rd)
+{
+SimI2cRegs *r = (SimI2cRegs*)dev;
+	r->havePtr = rd;
+}
+
+static int
+i2cRegsWrite(void *dev, uint8_t b)
+{
+SimI2cRegs *r = (SimI2cRegs*)dev;
+	if ( ! r->havePtr ) {
+		r->ptr     = b;
+		r->havePtr = 1;
+	} else {
+		r->regs[r->ptr++] = b;
+	}
+	return 0;
+}
+
+static uint8_t
+i2cRegsRead(void *dev)
+{
+SimI2cRegs *r = (SimI2cRegs*)dev;
+	return r->regs[r->ptr++];
+}
+
+static const SimI2cDev *
+i2cFind(const SimI2cBus *b, uint8_t sla)
+{
+unsigned i;
+
+	for ( i = 0; i < b->ndevs; i++ ) {
+		if ( b->devs[i].sla == (sla & ~I2C_READ) ) {
+			return &b->devs[i];
+		}
+	}
+	return NULL;
+}
+
+/* Process one bit-bang step; the slave drives SDA from the rising edge of
+ * SCL for the duration of the bit (the host samples after the falling edge).
+ * RETURNS: SDA as driven by the slaves (1: released).
+ */
+static int
+i2cStep(SimI2cBus *b, uint8_t bbo)
+{
+int      scl = !! (bbo & BB_SCL);
+int      sda = !! (bbo & BB_SDA);
+
+	if ( scl && b->lscl && sda != b->lsda ) {
+		/* START (SDA falling) or STOP (SDA rising) */
+		b->state  = sda ? I2C_IDLE : I2C_ADDR;
+		b->nbit   = 0;
+		b->sdaOut = 1;
+	} else if ( scl && ! b->lscl && I2C_IDLE != b->state ) {
+		if ( b->nbit < 8 ) {
+			b->sr     = (b->sr << 1) | sda;
+			b->sdaOut = ( I2C_READ_DATA == b->state ) ? ((b->tx >> (7 - b->nbit)) & 1) : 1;
+			b->nbit++;
+		} else {
+			/* ACK slot */
+			b->nbit   = 0;
+			b->sdaOut = 1;
+			switch ( b->state ) {
+				case I2C_ADDR:
+					b->state = I2C_IGNORE;
+					if ( (b->cur = i2cFind( b, b->sr )) ) {
+						b->sdaOut = 0;
+						b->cur->start( b->cur->dev, !! (b->sr & I2C_READ) );
+						if ( (b->sr & I2C_READ) ) {
+							b->state = I2C_READ_DATA;
+							b->tx    = b->cur->read( b->cur->dev );
+						} else {
+							b->state = I2C_WRITE;
+						}
+					}
+					break;
+				case I2C_WRITE:
+					b->sdaOut = !! b->cur->write( b->cur->dev, b->sr );
+					break;
+				case I2C_READ_DATA:
+					if ( sda ) {
+						/* master NAK */
+						b->state = I2C_IGNORE;
+					} else {
+						b->tx    = b->cur->read( b->cur->dev );
+					}
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	b->lscl = scl;
+	b->lsda = sda;
+	return b->sdaOut;
+}
+
+static uint32_t
+getLE(const uint8_t **bufp, int len)
+{
+int      i;
+uint32_t rv = 0;
+
+	for ( i = len - 1; i >= 0; i-- ) {
+		rv = (rv << 8) | (*bufp)[i];
+	}
+	(*bufp) += len;
+	return rv;
+}
+
+static void
+putLE(uint8_t **bufp, uint32_t val, int len)
+{
+int i;
+
+	for ( i = 0; i < len; i++ ) {
+		**bufp  = (val & 0xff);
+		val   >>= 8;
+		(*bufp)++;
+	}
+}
+
+static uint32_t
+xorshift(uint32_t *s)
+{
+uint32_t x = *s;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x <<  5;
+	return (*s = x);
+}
+
+static void
+simArm(FWSim *sim)
+{
+	clock_gettime( CLOCK_MONOTONIC, &sim->armed );
+	sim->released = sim->armed;
+	sim->hlf      = 0;
+}
+
+/* The current acquisition was read or flushed. In ping-pong mode the
+ * next one was started (into the other half) as soon as the current
+ * one was complete - unless the reader still held the other half.
+ */
+static void
+simNext(FWSim *sim)
+{
+struct timespec t;
+
+	if ( ! sim->acq.dbl ) {
+		simArm( sim );
+		return;
+	}
+	sim->hlf ^= 1;
+	if ( AUTO_TIMEOUT_NEVER == sim->acq.autoMS ) {
+		clock_gettime( CLOCK_MONOTONIC, &sim->armed );
+		return;
+	}
+	t          = sim->armed;
+	t.tv_sec  += sim->acq.autoMS / 1000;
+	t.tv_nsec += (sim->acq.autoMS % 1000) * 1000000L;
+	if ( t.tv_nsec >= 1000000000L ) {
+		t.tv_sec  += 1;
+		t.tv_nsec -= 1000000000L;
+	}
+	if ( t.tv_sec < sim->released.tv_sec || ( t.tv_sec == sim->released.tv_sec && t.tv_nsec < sim->released.tv_nsec ) ) {
+		t = sim->released;
+	}
+	sim->armed = t;
+	clock_gettime( CLOCK_MONOTONIC, &sim->released );
+}
+
+static int
+simReserve(FWSim *sim, size_t len)
+{
+uint8_t *p;
+
+	if ( len > sim->repCap ) {
+		if ( ! (p = realloc( sim->rep, len )) ) {
+			return -ENOMEM;
+		}
+		sim->rep    = p;
+		sim->repCap = len;
+	}
+	return 0;
+}
+
+void
+fwSimConfigInit(FWSimConfig *cfg)
+{
+	memset( cfg, 0, sizeof(*cfg) );
+	cfg->boardVersion = 255;
+	cfg->gitHash      = 0;
+	cfg->memDepth     = 8192;
+	cfg->adcBits      = 10;
+	cfg->adcFreqMHz   = 130;
+	cfg->seed         = 0x12345678;
+}
+
+int
+fwSimConfigParse(FWSimConfig *cfg, const char *str)
+{
+char          key[32];
+const char   *val;
+const char   *end;
+char         *ep;
+unsigned long v;
+size_t        l;
+
+	while ( str && *str ) {
+		if ( ! (end = strchr( str, ',' )) ) {
+			end = str + strlen( str );
+		}
+		if ( ! (val = memchr( str, '=', end - str )) || (l = val - str) >= sizeof(key) ) {
+			fprintf(stderr, "fwSim: invalid setting '%.*s' (expected key=value)\n", (int)(end - str), str);
+			return -EINVAL;
+		}
+		memcpy( key, str, l );
+		key[l] = 0;
+		val++;
+		v = strtoul( val, &ep, 0 );
+		if ( ep != end ) {
+			fprintf(stderr, "fwSim: invalid value for '%s'\n", key);
+			return -EINVAL;
+		}
+		if        ( 0 == strcmp( key, "board" ) && v <= 255 ) {
+			cfg->boardVersion = v;
+		} else if ( 0 == strcmp( key, "git"   ) && v <= 0xffffffffUL ) {
+			cfg->gitHash      = v;
+		} else if ( 0 == strcmp( key, "depth" ) && v >= 512 && v <= 512*65536UL && 0 == v % 512 ) {
+			cfg->memDepth     = v;
+		} else if ( 0 == strcmp( key, "bits"  ) && v >= 8 && v <= 16 ) {
+			cfg->adcBits      = v;
+		} else if ( 0 == strcmp( key, "freq"  ) && v >= 1 && v <= 255 ) {
+			cfg->adcFreqMHz   = v;
+		} else if ( 0 == strcmp( key, "seed"  ) && v != 0 && v <= 0xffffffffUL ) {
+			cfg->seed         = v;
+		} else {
+			fprintf(stderr, "fwSim: invalid setting '%.*s'\n", (int)(end - str), str);
+			return -EINVAL;
+		}
+		str = *end ? end + 1 : end;
+	}
+	return 0;
+}
+
+static void
+setReg(uint8_t *vld, uint8_t *wmsk, uint8_t *regs, unsigned addr, uint8_t wm, uint8_t val)
+{
+	vld [addr] = 1;
+	wmsk[addr] = wm;
+	regs[addr] = val;
+}
+
+FWSim *
+fwSimCreate(const FWSimConfig *cfg)
+{
+FWSim   *sim;
+unsigned i;
+
+	if ( ! (sim = calloc( 1, sizeof(*sim) )) ) {
+		perror("fwSimCreate(): no memory");
+		return NULL;
+	}
+	if ( cfg ) {
+		sim->cfg = *cfg;
+	} else {
+		fwSimConfigInit( &sim->cfg );
+	}
+	sim->rnd     = sim->cfg.seed ? sim->cfg.seed : 1;
+	sim->framing = -1;
+
+	/* generic registers (hdl/CommandGenRegs.vhd); not reconfigurable */
+	setReg( sim->genVld, sim->genWMsk, sim->genRegs, 0, 0x00, GEN_REG_VERSION_1 );
+	setReg( sim->genVld, sim->genWMsk, sim->genRegs, 1, 0xff, 0x00 );
+	setReg( sim->genVld, sim->genWMsk, sim->genRegs, 2, 0xff, 0x00 );
+	setReg( sim->genVld, sim->genWMsk, sim->genRegs, 3, 0x00, 0x00 );
+	setReg( sim->genVld, sim->genWMsk, sim->genRegs, 4, 0x00, 0x00 );
+	for ( i = 0; i < 4; i++ ) {
+		setReg( sim->genVld, sim->genWMsk, sim->genRegs,  8 + i, 0xff, 0x00 );
+		setReg( sim->genVld, sim->genWMsk, sim->genRegs, 16 + i, 0x00, 0x00 );
+	}
+
+	/* application registers; LED_CR0/1, USR_CSR, CLK_CSR and the waveform generator */
+	for ( i = 0; i < 3; i++ ) {
+		setReg( sim->appVld, sim->appWMsk, sim->appRegs, i, 0xff, 0x00 );
+	}
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, APP_REG_CLK_CSR, 0x00, APP_REG_CLK_LOCKED );
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, FW_SIM_REG_PERIOD_OFF + 0, 0xff, (1000 >>  0) & 0xff );
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, FW_SIM_REG_PERIOD_OFF + 1, 0xff, (1000 >>  8) & 0xff );
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, FW_SIM_REG_PERIOD_OFF + 2, 0xff, (1000 >> 16) & 0xff );
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, FW_SIM_REG_AMPL_OFF,       0xff, 80 );
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, FW_SIM_REG_NOISE_OFF,      0xff,  2 );
+	setReg( sim->appVld, sim->appWMsk, sim->appRegs, FW_SIM_REG_PHASE_OFF,      0xff, 64 );
+
+	memset( sim->flash.mem, 0xff, sizeof(sim->flash.mem) );
+	sim->flash.state = FL_IDLE;
+	spiBitsInit( &sim->romBits, &simFlashOps,  &sim->flash  );
+	spiBitsInit( &sim->fegBits, &simSpiRegOps, &sim->fegReg );
+
+	dacReset( &sim->dac );
+	sim->i2cDevs[0].sla   = I2C_SLA_DAC;
+	sim->i2cDevs[0].start = dacStart;
+	sim->i2cDevs[0].write = dacWrite;
+	sim->i2cDevs[0].read  = dacRead;
+	sim->i2cDevs[0].dev   = &sim->dac;
+	sim->i2cDevs[1].sla   = I2C_SLA_GCALL;
+	sim->i2cDevs[1].start = gcallStart;
+	sim->i2cDevs[1].write = gcallWrite;
+	sim->i2cDevs[1].read  = gcallRead;
+	sim->i2cDevs[1].dev   = &sim->dac;
+	sim->i2cDevs[2].sla   = I2C_SLA_CLK;
+	sim->i2cDevs[2].start = i2cRegsStart;
+	sim->i2cDevs[2].write = i2cRegsWrite;
+	sim->i2cDevs[2].read  = i2cRegsRead;
+	sim->i2cDevs[2].dev   = &sim->clk;
+	sim->i2c.devs         = sim->i2cDevs;
+	sim->i2c.ndevs        = sizeof(sim->i2cDevs)/sizeof(sim->i2cDevs[0]);
+	sim->i2c.lscl         = 1;
+	sim->i2c.lsda         = 1;
+	sim->i2c.sdaOut       = 1;
+
+	/* firmware defaults (hdl/CommandAcqParm.vhd) */
+	sim->acq.src     = ACQ_SRC_CHA;
+	sim->acq.rising  = 1;
+	sim->acq.nsm     = sim->cfg.memDepth - 1;
+	sim->acq.autoMS  = 200;
+	sim->acq.scl     = 1 << 16;
+	sim->acq.hyst    = 1024;
+	simArm( sim );
+
+	return sim;
+}
+
+void
+fwSimDestroy(FWSim *sim)
+{
+	if ( sim ) {
+		free( sim->rep );
+		free( sim );
+	}
+}
+
+/* An optional parameter octet requests a framing mode (bit 0: COBS)
+ * which becomes effective after the reply; the capability octet
+ * appended to the version announces COBS support.
+ */
+static size_t
+cmdVersion(FWSim *sim, const uint8_t *req, size_t len, uint8_t *rep)
+{
+	rep[1] = sim->cfg.boardVersion;
+	rep[2] = API_VERSION;
+	rep[3] = (sim->cfg.gitHash >> 24) & 0xff;
+	rep[4] = (sim->cfg.gitHash >> 16) & 0xff;
+	rep[5] = (sim->cfg.gitHash >>  8) & 0xff;
+	rep[6] = (sim->cfg.gitHash >>  0) & 0xff;
+	if ( 0 == len ) {
+		return 7;
+	}
+	sim->framing = ( req[0] & 0x01 ) ? FIFO_FRAMING_COBS : FIFO_FRAMING_STUFF;
+	rep[7]       = 0x01;
+	return 8;
+}
+
+/* SPI controller; CS is asserted for the duration of the frame */
+static size_t
+cmdSpi(FWSim *sim, const uint8_t *req, size_t len, uint8_t *rep)
+{
+size_t i;
+
+	for ( i = 0; i < len; i++ ) {
+		rep[1 + i] = flashPeek( &sim->flash );
+		flashPut( &sim->flash, req[i] );
+	}
+	flashDeselect( &sim->flash );
+	return 1 + len;
+}
+
+/* hdl/CommandReg.vhd */
+static size_t
+cmdReg(FWSim *sim, const uint8_t *vld, const uint8_t *wmsk, uint8_t *regs, uint8_t sub, const uint8_t *req, size_t len)
+{
+uint8_t *rep = sim->rep;
+size_t   i, n, got, put;
+unsigned a;
+int      wr, err;
+
+	switch ( sub ) {
+		case SUB_REG_RD8:
+			if ( 2 != len ) {
+				break;
+			}
+			n = (size_t)req[1] + 1;
+			for ( i = 0; i < n; i++ ) {
+				a = (req[0] + i) & (REG_SPACE - 1);
+				if ( ! vld[a] ) {
+					/* failing read terminates the reply */
+					rep[1 + i] = 0xff;
+					return 2 + i;
+				}
+				rep[1 + i] = regs[a];
+			}
+			rep[1 + n] = 0x00;
+			return 2 + n;
+
+		case SUB_REG_WR8:
+			if ( len < 2 ) {
+				break;
+			}
+			for ( i = 1; i < len; i++ ) {
+				a = (req[0] + i - 1) & (REG_SPACE - 1);
+				if ( ! vld[a] ) {
+					break;
+				}
+				regs[a] = (req[i] & wmsk[a]) | (regs[a] & ~wmsk[a]);
+			}
+			rep[1] = ( i < len ) ? 0xff : 0x00;
+			return 2;
+
+		case SUB_REG_VEC:
+			/* a 2-octet read tuple yields up to 128 octets */
+			if ( simReserve( sim, 2 + 64*len ) ) {
+				return 0;
+			}
+			rep = sim->rep;
+			put = 1;
+			got = 0;
+			err = ( 0 == len );
+			while ( ! err && got < len ) {
+				if ( got + 2 > len ) {
+					/* incomplete tuple */
+					err = 1;
+					break;
+				}
+				n    = (req[got] & ~REG_VEC_WR) + 1;
+				wr   = !! (req[got] & REG_VEC_WR);
+				a    = req[got + 1];
+				got += 2;
+				for ( i = 0; i < n && ! err; i++, a++ ) {
+					a &= (REG_SPACE - 1);
+					if ( wr ) {
+						if ( got >= len || ! vld[a] ) {
+							err = 1;
+						} else {
+							regs[a] = (req[got++] & wmsk[a]) | (regs[a] & ~wmsk[a]);
+						}
+					} else if ( ! vld[a] ) {
+						/* failing read produces an all-ones octet */
+						rep[put++] = 0xff;
+						err        = 1;
+					} else {
+						rep[put++] = regs[a];
+					}
+				}
+			}
+			/* the rest of a failing request is discarded */
+			rep[put] = err ? 0xff : 0x00;
+			return put + 1;
+
+		default:
+			break;
+	}
+	rep[1] = 0xff;
+	return 2;
+}
+
+static size_t
+cmdBitBang(FWSim *sim, uint8_t sub, const uint8_t *req, size_t len, uint8_t *rep)
+{
+size_t  i;
+uint8_t bbo, bbi;
+int     miso;
+
+	for ( i = 0; i < len; i++ ) {
+		bbo  = req[i];
+		/* CS of devices which are not selected remains deasserted */
+		miso = spiBitsStep( &sim->romBits, SUB_BB_ROM == sub ? bbo : (bbo | BB_CSB) );
+		if ( SUB_BB_FEG == sub ) {
+			miso = spiBitsStep( &sim->fegBits, bbo );
+		} else {
+			spiBitsStep( &sim->fegBits, bbo | BB_CSB );
+			if ( SUB_BB_ROM != sub ) {
+				miso = 0;
+			}
+		}
+		switch ( sub ) {
+			case SUB_BB_NONE:
+				bbi = bbo;
+				break;
+			case SUB_BB_I2C:
+				/* open-drain bus */
+				bbi = i2cStep( &sim->i2c, bbo ) ? bbo : (bbo & ~BB_SDA);
+				break;
+			default:
+				bbi = ( bbo & ~(BB_MISO | BB_HIZ) ) | ( miso ? BB_MISO : 0 );
+				break;
+		}
+		rep[1 + i] = bbi;
+	}
+	return 1 + len;
+}
+
+/* Transaction-level i2c master (see hdl/CommandI2c.vhd):
+ *   request: sla, nrdLo, nrdHi, wdata...
+ *   reply  : rdata[nrd], staLo, staHi
+ * The reply is stored in sim->rep (which may be reallocated).
+ */
+static size_t
+cmdI2c(FWSim *sim, const uint8_t *req, size_t len)
+{
+const SimI2cDev *dev;
+uint8_t         *rep;
+size_t           rlen = 1;
+size_t           nrd  = 0;
+size_t           i;
+unsigned         acks = 0;
+unsigned         sta  = I2C_STA_NAK;
+
+	if ( len >= 3 ) {
+		nrd = req[1] | (req[2] << 8);
+	}
+	if ( simReserve( sim, 1 + nrd + 2 ) ) {
+		return 0;
+	}
+	rep = sim->rep;
+
+	if ( len >= 3 && (dev = i2cFind( &sim->i2c, req[0] )) ) {
+		sta = 0;
+		acks++;
+		dev->start( dev->dev, ( 3 == len && nrd > 0 ) );
+		for ( i = 3; i < len; i++ ) {
+			if ( dev->write( dev->dev, req[i] ) ) {
+				sta = I2C_STA_NAK;
+				break;
+			}
+			acks++;
+		}
+		if ( ! sta && nrd > 0 ) {
+			if ( len > 3 ) {
+				/* repeated start */
+				dev->start( dev->dev, 1 );
+				acks++;
+			}
+			for ( i = 0; i < nrd; i++ ) {
+				rep[rlen++] = dev->read( dev->dev );
+			}
+		}
+	}
+	/* aborted */
+	while ( rlen < 1 + nrd ) {
+		rep[rlen++] = 0xff;
+	}
+	sta |= acks;
+	rep[rlen++] = (sta >> 0) & 0xff;
+	rep[rlen++] = (sta >> 8) & 0xff;
+	return rlen;
+}
+
+static uint32_t
+simDecimation(const SimAcqParams *p)
+{
+uint32_t d0 = ((p->dcm >> 20) & 0xf) + 1;
+uint32_t d1 = ( p->dcm & 0xfffff    ) + 1;
+	return d0 > 1 ? d0 * d1 : 1;
+}
+
+static double
+simAmplitude(FWSim *sim)
+{
+	return (double)sim->appRegs[FW_SIM_REG_AMPL_OFF] / 100.0;
+}
+
+/* Determine if data are available and the phase (of channel A) at the trigger point.
+ * RETURNS: 0 if not ready, 1 if triggered, 2 if auto-triggered.
+ */
+static int
+simReady(FWSim *sim, double *pphi)
+{
+struct timespec now;
+double          ampl  = simAmplitude( sim );
+double          lvl   = (double)sim->acq.level / 32768.0;
+double          phi, offs;
+long            msecs;
+
+	offs = 2.0*M_PI*(double)sim->appRegs[FW_SIM_REG_PHASE_OFF]/256.0;
+	if ( ACQ_SRC_EXT != sim->acq.src && fabs( lvl ) < ampl ) {
+		/* the trigger channel crosses the level; place the crossing at the trigger point */
+		phi = asin( lvl/ampl );
+		if ( ! sim->acq.rising ) {
+			phi = M_PI - phi;
+		}
+		if ( ACQ_SRC_CHB == sim->acq.src ) {
+			phi -= offs;
+		}
+		*pphi = phi;
+		return 1;
+	}
+	if ( AUTO_TIMEOUT_NEVER == sim->acq.autoMS ) {
+		return 0;
+	}
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	msecs = (now.tv_sec - sim->armed.tv_sec) * 1000L + (now.tv_nsec - sim->armed.tv_nsec) / 1000000L;
+	if ( msecs < (long)sim->acq.autoMS ) {
+		return 0;
+	}
+	*pphi = 2.0*M_PI*(double)(xorshift( &sim->rnd ) & 0xffff)/65536.0;
+	return 2;
+}
+
+/* Hold a read-wait until the (auto-)trigger fires or the timeout expires */
+static int
+simWait(FWSim *sim, double *pphi)
+{
+struct timespec now, t;
+long            msecs;
+int             st;
+
+	if ( (st = simReady( sim, pphi )) || AUTO_TIMEOUT_NEVER == sim->acq.autoMS ) {
+		if ( ! st ) {
+			t.tv_sec  = ADC_WAIT_MS / 1000;
+			t.tv_nsec = (ADC_WAIT_MS % 1000) * 1000000L;
+			clock_nanosleep( CLOCK_MONOTONIC, 0, &t, NULL );
+		}
+		return st;
+	}
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	msecs = (long)sim->acq.autoMS - ( (now.tv_sec - sim->armed.tv_sec) * 1000L + (now.tv_nsec - sim->armed.tv_nsec) / 1000000L );
+	if ( msecs > ADC_WAIT_MS ) {
+		msecs = ADC_WAIT_MS;
+	}
+	if ( msecs > 0 ) {
+		t.tv_sec  = msecs / 1000;
+		t.tv_nsec = (msecs % 1000) * 1000000L + 1000000L;
+		clock_nanosleep( CLOCK_MONOTONIC, 0, &t, NULL );
+	}
+	return simReady( sim, pphi );
+}
+
+/* Generate a sample of channel 'ch' (right-adjusted, clipped to 'fs');
+ * overrange is flagged in '*povr'.
+ */
+static long
+simSample(FWSim *sim, double ampl, double phi, long fs, int ch, uint8_t *povr)
+{
+long noise = sim->appRegs[FW_SIM_REG_NOISE_OFF];
+long v     = lrint( ampl * sin( phi ) );
+
+	if ( noise ) {
+		v += (long)(xorshift( &sim->rnd ) % (2*noise + 1)) - noise;
+	}
+	if ( v > fs ) {
+		v      = fs;
+		*povr |= (1<<ch);
+	} else if ( v < -fs - 1 ) {
+		v      = -fs - 1;
+		*povr |= (1<<ch);
+	}
+	return v;
+}
+
+/* Replace the 'cnt' 16-bit (left-adjusted, little-endian) words at 'p'
+ * by their upper 'bits' bits, concatenated LSB-first (in place).
+ * RETURNS: pointer past the last (zero-padded) byte.
+ */
+static uint8_t *
+simPack(uint8_t *p, uint32_t cnt, unsigned bits)
+{
+const uint8_t *src = p;
+uint32_t       acc = 0;
+unsigned       nb  = 0;
+uint32_t       i;
+
+	for ( i = 0; i < cnt; i++, src += 2 ) {
+		acc |= (uint32_t)( ( src[0] | (src[1] << 8) ) >> (16 - bits) ) << nb;
+		nb  += bits;
+		while ( nb >= 8 ) {
+			*p++  = acc & 0xff;
+			acc >>= 8;
+			nb   -= 8;
+		}
+	}
+	if ( nb ) {
+		*p++ = acc & 0xff;
+	}
+	return p;
+}
+
+/* Replace the 'cnt' samples (both channels) at 'p' by the per-channel
+ * minimum and maximum of each bucket of 'bkt' samples (in place).
+ * RETURNS: pointer past the last min/max pair.
+ */
+static uint8_t *
+simPeak(uint8_t *p, int wide, uint32_t cnt, uint32_t bkt)
+{
+unsigned  ssz = wide ? 2 : 1;
+uint8_t  *src = p;
+uint8_t  *dst = p;
+uint8_t   mn[2][2], mx[2][2];
+long      vmn[2], vmx[2], v;
+uint32_t  i, k;
+int       ch;
+
+	for ( i = 0; i < cnt; i += bkt ) {
+		for ( k = 0; k < bkt && i + k < cnt; k++ ) {
+			for ( ch = 0; ch < 2; ch++ ) {
+				v = wide ? (int16_t)(src[0] | (src[1] << 8)) : (int8_t)src[0];
+				if ( 0 == k || v < vmn[ch] ) {
+					vmn[ch] = v;
+					memcpy( mn[ch], src, ssz );
+				}
+				if ( 0 == k || v > vmx[ch] ) {
+					vmx[ch] = v;
+					memcpy( mx[ch], src, ssz );
+				}
+				src += ssz;
+			}
+		}
+		/* 'dst' never overtakes 'src' since 'bkt' > 1; the last bucket
+		 * may hold a single sample (space was reserved for it).
+		 */
+		for ( ch = 0; ch < 2; ch++, dst += ssz ) {
+			memcpy( dst, mn[ch], ssz );
+		}
+		for ( ch = 0; ch < 2; ch++, dst += ssz ) {
+			memcpy( dst, mx[ch], ssz );
+		}
+	}
+	return dst;
+}
+
+/* Read samples 'first'..'first' + 'cnt' - 1 ('cnt' == 0: up to the end);
+ * 'first' < 0 selects an ordinary (full) read. A bucket size 'bkt' > 1
+ * selects peak-detect mode (min/max per bucket); 'xhdr' appends the
+ * extended header (sequence number and trigger timestamp) and 'pack'
+ * requests packed samples (ignored in peak-detect mode).
+ * In averaging mode the sums (32-bit, little-endian) of 'navg' + 1
+ * acquisitions (which differ in their noise only) are read; peak-detect
+ * and packing are ignored.
+ * A segmented acquisition (like MaxAdc.vhd) consists of as many segments
+ * as fit into memory, each followed by a trailer; the triggers of
+ * consecutive segments are spaced by (multiples of) the sine period.
+ */
+static size_t
+cmdAdcRead(FWSim *sim, int wait, long first, uint32_t cnt, uint32_t bkt, int xhdr, int pack)
+{
+unsigned  bits  = sim->cfg.adcBits;
+int       wide  = bits > 8;
+unsigned  ssz   = sim->acq.navg ? 8 : ( wide ? 4 : 2 );
+long      fs    = (1L << (bits - 1)) - 1;
+uint32_t  n     = sim->acq.nsm + 1;
+uint32_t  dec   = simDecimation( &sim->acq );
+uint32_t  per   = sim->appRegs[FW_SIM_REG_PERIOD_OFF] | (sim->appRegs[FW_SIM_REG_PERIOD_OFF+1] << 8) | (sim->appRegs[FW_SIM_REG_PERIOD_OFF+2] << 16);
+double    ampl  = simAmplitude( sim ) * (double)fs;
+size_t    hlen  = 3 + ( xhdr ? ADC_XHDR_LEN : 0 );
+uint32_t  seglen = n;
+uint32_t  nseg  = 1;
+uint32_t  tot;
+uint32_t  spc;
+uint64_t  ts0, ts;
+long      gfirst;
+uint32_t  gcnt;
+struct timespec now;
+double    w, ph[2];
+double    t;
+uint8_t  *p;
+uint8_t   ovr   = 0;
+uint8_t   sovr  = 0;
+uint32_t  i, j, seg, r;
+long      v;
+int       ch, st;
+
+	if ( 0 == (st = wait ? simWait( sim, &ph[0] ) : simReady( sim, &ph[0] )) ) {
+		if ( first >= 0 ) {
+			/* range reads report 'no data' with an empty header */
+			sim->rep[1] = sim->rep[2] = 0;
+			return 3;
+		}
+		return 1;
+	}
+	sim->seq++;
+	if ( sim->acq.nseg ) {
+		seglen = n + ADC_SEG_TRL;
+		nseg   = ( sim->acq.dbl ? sim->cfg.memDepth/2 : sim->cfg.memDepth ) / seglen;
+		if ( nseg > (uint32_t)sim->acq.nseg + 1 ) {
+			nseg = (uint32_t)sim->acq.nseg + 1;
+		}
+		if ( nseg < 1 ) {
+			nseg = 1;
+		}
+	}
+	tot = nseg * seglen;
+	if ( first < 0 ) {
+		first = 0;
+	} else if ( first >= tot ) {
+		/* the last sample is never skipped */
+		first = tot - 1;
+	}
+	if ( 0 == cnt || cnt > tot - first ) {
+		cnt = tot - first;
+	}
+	if ( per < 2 ) {
+		per = 2;
+	}
+	w     = 2.0*M_PI/(double)per;
+	ph[1] = ph[0] + 2.0*M_PI*(double)sim->appRegs[FW_SIM_REG_PHASE_OFF]/256.0;
+
+	/* segments: trigger spacing (samples) and timestamp (ADC clocks) */
+	if ( 1 == st ) {
+		spc = ( ( seglen + per - 1 ) / per ) * per;
+	} else {
+		spc = (uint32_t)( (uint64_t)sim->acq.autoMS * sim->cfg.adcFreqMHz * 1000 / dec );
+		if ( spc < seglen ) {
+			spc = seglen;
+		}
+	}
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	ts0 = ( (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec ) * sim->cfg.adcFreqMHz / 1000;
+
+	/* a segmented acquisition is generated entirely (the trailers
+	 * depend on all samples of a segment)
+	 */
+	gfirst = nseg > 1 ? 0   : first;
+	gcnt   = nseg > 1 ? tot : cnt;
+
+	if ( simReserve( sim, hlen + ((size_t)gcnt + 2)*ssz ) ) {
+		return 1;
+	}
+	p = sim->rep + hlen;
+	for ( i = gfirst; i < gfirst + gcnt; i++ ) {
+		seg = i / seglen;
+		j   = i % seglen;
+		if ( j >= n ) {
+			/* trailer */
+			ts = ( ts0 + (uint64_t)seg * spc * dec ) & 0xffffffffffffULL;
+			switch ( j - n ) {
+				case 0:  v = sovr | ( ( 2 == st ) ? 0x100 : 0 ); break;
+				case 1:  v = (ts >>  0) & 0xffff;                break;
+				case 2:  v = (ts >> 16) & 0xffff;                break;
+				default: v = (ts >> 32) & 0xffff;                break;
+			}
+			if ( wide ) {
+				*p++ = 0;
+				*p++ = (v >> 0) & 0xff;
+				*p++ = 0;
+				*p++ = (v >> 8) & 0xff;
+			} else {
+				*p++ = (v >> 0) & 0xff;
+				*p++ = (v >> 8) & 0xff;
+			}
+			continue;
+		}
+		if ( 0 == j ) {
+			sovr = 0;
+		}
+		t = ((double)j - (double)sim->acq.npts + (double)seg * (double)spc) * (double)dec;
+		for ( ch = 0; ch < 2; ch++ ) {
+			if ( sim->acq.navg ) {
+				for ( r = 0, v = 0; r <= sim->acq.navg; r++ ) {
+					v += simSample( sim, ampl, ph[ch] + w*t, fs, ch, &sovr );
+				}
+				putLE( &p, (uint32_t)v, 4 );
+				continue;
+			}
+			v = simSample( sim, ampl, ph[ch] + w*t, fs, ch, &sovr );
+			if ( wide ) {
+				/* left-adjusted, little-endian */
+				v <<= (16 - bits);
+				*p++ = (v >> 0) & 0xff;
+				*p++ = (v >> 8) & 0xff;
+			} else {
+				*p++ = v & 0xff;
+			}
+		}
+		ovr |= sovr;
+	}
+	if ( gfirst != first ) {
+		memmove( sim->rep + hlen, sim->rep + hlen + (size_t)first * ssz, (size_t)cnt * ssz );
+	}
+	p = sim->rep + hlen + (size_t)cnt * ssz;
+	if ( sim->acq.navg ) {
+		/* sums are neither peak-detected nor packed */
+	} else if ( bkt > 1 ) {
+		p = simPeak( sim->rep + hlen, wide, cnt, bkt );
+	} else if ( pack && wide && bits < 16 ) {
+		p = simPack( sim->rep + hlen, 2*cnt, bits );
+	}
+	sim->rep[1] = ovr;
+	sim->rep[2] = ( ( 2 == st ) ? 1 : 0 ) | ( sim->hlf ? ADC_HDR_HLF : 0 ) | ( sim->acq.navg ? ADC_HDR_AVG : 0 );
+	if ( xhdr ) {
+		ts = ts0 & 0xffffffffffffULL;
+		for ( i = 0; i < 2; i++ ) {
+			sim->rep[3 + i] = ( sim->seq >> (8*i) ) & 0xff;
+		}
+		for ( i = 0; i < 6; i++ ) {
+			sim->rep[5 + i] = ( ts >> (8*i) ) & 0xff;
+		}
+	}
+	simNext( sim );
+	return p - sim->rep;
+}
+
+static size_t
+cmdAdc(FWSim *sim, uint8_t sub, const uint8_t *req, size_t len, uint8_t *rep)
+{
+uint32_t n;
+long     first;
+uint32_t cnt;
+uint32_t bkt;
+uint32_t opt;
+double   phi;
+
+	if ( SUB_ADC_READ == ( sub & ~(SUB_ADC_WAIT | SUB_ADC_RANGE) ) ) {
+		first = -1;
+		cnt   = 0;
+		bkt   = 0;
+		opt   = 0;
+		if ( ( sub & SUB_ADC_RANGE ) ) {
+			if ( len < 8 ) {
+				return 1;
+			}
+			first = getLE( &req, 4 );
+			cnt   = getLE( &req, 4 );
+			if ( len >= 12 ) {
+				bkt = getLE( &req, 4 );
+			}
+			if ( len >= 16 ) {
+				opt = getLE( &req, 4 );
+			}
+		}
+		return cmdAdcRead( sim, !! (sub & SUB_ADC_WAIT), first, cnt, bkt, !! (opt & ADC_OPT_XHDR), !! (opt & ADC_OPT_PACK) );
+	}
+
+	switch ( sub ) {
+
+		case SUB_ADC_FLUSH:
+			/* the discarded acquisition is counted */
+			if ( simReady( sim, &phi ) ) {
+				sim->seq++;
+				simNext( sim );
+			} else {
+				simArm( sim );
+			}
+			return 1;
+
+		case SUB_ADC_MSIZE:
+			n      = sim->cfg.memDepth/512 - 1;
+			rep[1] = (n >> 0) & 0xff;
+			rep[2] = (n >> 8) & 0xff;
+			rep[3] = ( sim->cfg.adcBits > 8 ) ? (1 | ((sim->cfg.adcBits - 9) << 1)) : 0;
+			rep[3] |= ADC_FLG_WAIT | ADC_FLG_RANGE | ADC_FLG_PEAK | ADC_FLG_SEG;
+			return 4;
+
+		case SUB_ADC_MSIZE | SUB_ADC_RANGE:
+			cmdAdc( sim, SUB_ADC_MSIZE, req, len, rep );
+			rep[4] = ADC_XFLG_XHDR | ADC_XFLG_DBL | ADC_XFLG_AVG | ADC_XFLG_HOLD;
+			if ( sim->cfg.adcBits > 8 && sim->cfg.adcBits < 16 ) {
+				rep[4] |= ADC_XFLG_PACK;
+			}
+			return 5;
+
+		case SUB_ADC_SFREQ:
+			rep[1] = sim->cfg.adcFreqMHz;
+			return 2;
+
+		default:
+			break;
+	}
+	return 1;
+}
+
+static void
+acqPack(const SimAcqParams *p, uint8_t *buf)
+{
+	putLE( &buf, p->mask, 4 );
+	putLE( &buf, (p->src & 7) | (p->rising ? (1<<3) : 0) | (p->tgo ? (1<<4) : 0) | (p->dbl ? (1<<5) : 0), 1 );
+	putLE( &buf, (uint16_t)p->level, 2 );
+	putLE( &buf, p->npts,   3 );
+	putLE( &buf, p->nsm,    3 );
+	putLE( &buf, p->autoMS, 2 );
+	putLE( &buf, p->dcm,    3 );
+	putLE( &buf, p->scl,    4 );
+	putLE( &buf, p->hyst,   2 );
+	putLE( &buf, p->nseg,   2 );
+	putLE( &buf, p->navg,   2 );
+}
+
+static void
+acqUnpack(SimAcqParams *p, const uint8_t *buf, size_t len)
+{
+uint8_t v8;
+
+	p->mask   = getLE( &buf, 4 );
+	v8        = getLE( &buf, 1 );
+	p->src    = v8 & 7;
+	p->rising = !! (v8 & (1<<3));
+	p->tgo    = !! (v8 & (1<<4));
+	p->dbl    = !! (v8 & (1<<5));
+	p->level  = (int16_t)getLE( &buf, 2 );
+	p->npts   = getLE( &buf, 3 );
+	p->nsm    = getLE( &buf, 3 );
+	p->autoMS = getLE( &buf, 2 );
+	p->dcm    = getLE( &buf, 3 );
+	p->scl    = getLE( &buf, 4 );
+	p->hyst   = getLE( &buf, 2 );
+	/* older hosts omit the number of segments/averages */
+	p->nseg   = len >= ACQ_LEN_V3 ? getLE( &buf, 2 ) : 0;
+	p->navg   = len >= ACQ_LEN    ? getLE( &buf, 2 ) : 0;
+}
+
+/* hdl/CommandAcqParm.vhd; the reply holds the previous parameters */
+static size_t
+cmdAcq(FWSim *sim, const uint8_t *req, size_t len, uint8_t *rep)
+{
+SimAcqParams  n;
+SimAcqParams *p = &sim->acq;
+size_t        rlen;
+
+	if ( len > ACQ_LEN ) {
+		len = ACQ_LEN;
+	}
+	/* the reply is as long as the request */
+	if ( len >= ACQ_LEN ) {
+		rlen = ACQ_LEN;
+	} else {
+		rlen = len < ACQ_LEN_V3 ? ACQ_LEN_V2 : ACQ_LEN_V3;
+	}
+	acqPack( p, rep + 1 );
+	memcpy( rep + 1, req, len < 4 ? len : 4 );
+
+	if ( len < ACQ_LEN_V2 ) {
+		/* incomplete frame; nothing is applied */
+		return 1 + rlen;
+	}
+	acqUnpack( &n, req, len );
+
+	if ( (n.mask & ACQ_MSK_SRC) ) p->src    = n.src > ACQ_SRC_EXT ? ACQ_SRC_EXT : n.src;
+	if ( (n.mask & ACQ_MSK_TGO) ) p->tgo    = n.tgo;
+	if ( (n.mask & ACQ_MSK_EDG) ) p->rising = n.rising;
+	if ( (n.mask & ACQ_MSK_LVL) ) {
+		p->level = n.level;
+		p->hyst  = n.hyst;
+	}
+	if ( (n.mask & ACQ_MSK_NPT) ) p->npts   = n.npts;
+	if ( (n.mask & ACQ_MSK_AUT) ) p->autoMS = n.autoMS;
+	if ( (n.mask & ACQ_MSK_DCM) ) p->dcm    = n.dcm;
+	if ( (n.mask & ACQ_MSK_SCL) ) p->scl    = n.scl;
+	if ( (n.mask & ACQ_MSK_NSM) ) p->nsm    = n.nsm;
+	if ( (n.mask & ACQ_MSK_SEG) && len >= ACQ_LEN_V3 ) p->nseg = n.nseg;
+	if ( (n.mask & ACQ_MSK_DBL) ) p->dbl    = n.dbl;
+	if ( (n.mask & ACQ_MSK_AVG) && len >= ACQ_LEN    ) p->navg = n.navg;
+
+	if ( 0 == (p->dcm & (0xf << 20)) ) {
+		p->dcm = 0;
+	}
+	if ( p->nsm > sim->cfg.memDepth - 1 ) {
+		p->nsm = sim->cfg.memDepth - 1;
+	}
+	if ( p->dbl && p->nsm > sim->cfg.memDepth/2 - 1 ) {
+		/* each half holds an acquisition */
+		p->nsm = sim->cfg.memDepth/2 - 1;
+	}
+	if ( p->navg ) {
+		if ( p->navg > ADC_AVG_MAX - 1 ) {
+			p->navg = ADC_AVG_MAX - 1;
+		}
+		/* the accumulator memory is as deep as the sample memory;
+		 * thus nsm needs no further clipping
+		 */
+		p->nseg = 0;
+	}
+	if ( p->npts > p->nsm ) {
+		p->npts = p->nsm;
+	}
+	if ( p->nseg ) {
+		/* segments are recorded from the trigger on */
+		p->npts = 0;
+	}
+	if ( ACQ_SRC_EXT == p->src ) {
+		p->tgo = 0;
+	}
+	p->mask = 0;
+	if ( n.mask ) {
+		simArm( sim );
+	}
+	return 1 + rlen;
+}
+
+size_t
+fwSimProcessFrame(FWSim *sim, const uint8_t *req, size_t len, const uint8_t **prep)
+{
+uint8_t  cmd;
+uint8_t *rep;
+size_t   rlen;
+
+	if ( 0 == len ) {
+		return 0;
+	}
+	cmd = req[0];
+	req++;
+	len--;
+
+	/* large enough for all replies except ADC data */
+	if ( simReserve( sim, 2 + (len > ACQ_LEN ? len : ACQ_LEN) + 256 ) ) {
+		return 0;
+	}
+	rep    = sim->rep;
+	rep[0] = cmd;
+
+	switch ( CMD_IDX( cmd ) ) {
+		case CMD_VER:     rlen = cmdVersion( sim, req, len, rep );                                              break;
+		case CMD_SPI:     rlen = cmdSpi( sim, req, len, rep );                                                  break;
+		case CMD_GEN_REG: rlen = cmdReg( sim, sim->genVld, sim->genWMsk, sim->genRegs, CMD_SUB( cmd ), req, len );  break;
+		case CMD_APP_REG: rlen = cmdReg( sim, sim->appVld, sim->appWMsk, sim->appRegs, CMD_SUB( cmd ), req, len );  break;
+		case CMD_BB:      rlen = cmdBitBang( sim, CMD_SUB( cmd ) & 7, req, len, rep );                          break;
+		case CMD_ADC:     rlen = cmdAdc( sim, CMD_SUB( cmd ), req, len, rep );                                  break;
+		case CMD_ACQ:     rlen = cmdAcq( sim, req, len, rep );                                                  break;
+		case CMD_I2C:     rlen = cmdI2c( sim, req, len );                                                       break;
+		default:
+			rep[0] = CMD_ERR;
+			rlen   = 1;
+			break;
+	}
+	/* cmdAdcRead, cmdReg and cmdI2c may have reallocated */
+	*prep = sim->rep;
+	return rlen;
+}
+
+static int
+writeAll(int fd, const uint8_t *buf, size_t len)
+{
+ssize_t put;
+
+	while ( len > 0 ) {
+		if ( (put = send( fd, buf, len, MSG_NOSIGNAL )) < 0 ) {
+			if ( ENOTSOCK == errno ) {
+				put = write( fd, buf, len );
+			}
+		}
+		if ( put < 0 ) {
+			if ( EINTR == errno ) {
+				continue;
+			}
+			return -errno;
+		}
+		buf += put;
+		len -= put;
+	}
+	return 0;
+}
+
+int
+fwSimServe(FWSim *sim, int fd)
+{
+uint8_t        ibuf[16384];
+uint8_t       *frm    = NULL;
+size_t         frmCap = 0;
+size_t         frmLen = 0;
+uint8_t       *obuf   = NULL;
+size_t         obufSz = 0;
+const uint8_t *rep;
+const uint8_t *p;
+uint8_t       *np;
+size_t         rlen, used, put, l, need;
+ssize_t        got;
+int            esc    = 0;
+int            cobs   = 0;
+int            eof;
+int            drop   = 0;
+int            st     = 0;
+
+	for ( ;; ) {
+		if ( (got = read( fd, ibuf, sizeof(ibuf) )) <= 0 ) {
+			if ( got < 0 && EINTR == errno ) {
+				continue;
+			}
+			/* EIO: PTY master without a slave */
+			st = ( got < 0 && EIO != errno ) ? -errno : 0;
+			goto bail;
+		}
+		p = ibuf;
+		while ( got > 0 ) {
+			if ( frmCap - frmLen < (size_t)got && ! drop ) {
+				need = frmLen + got;
+				if ( need > FRAME_MAXLEN || ! (np = realloc( frm, 2*need )) ) {
+					fprintf(stderr, "fwSimServe: frame too long; dropping\n");
+					drop = 1;
+				} else {
+					frm    = np;
+					frmCap = 2*need;
+				}
+			}
+			eof  = 0;
+			if ( cobs ) {
+				used = cobsDeStuffBuf( drop ? NULL : frm + frmLen, drop ? (size_t)got : frmCap - frmLen, p, got, &put, &esc, &eof );
+			} else {
+				used = byteDeStuffBuf( drop ? NULL : frm + frmLen, drop ? (size_t)got : frmCap - frmLen, p, got, &put, &esc, &eof );
+			}
+			p   += used;
+			got -= used;
+			if ( ! drop ) {
+				frmLen += put;
+			}
+			if ( ! eof ) {
+				continue;
+			}
+			esc = 0;
+			if ( ! drop && 0 == frmLen ) {
+				/* empty frame (resync) resets the framing */
+				cobs = 0;
+			}
+			sim->framing = -1;
+			if ( ! drop && (rlen = fwSimProcessFrame( sim, frm, frmLen, &rep )) > 0 ) {
+				if ( obufSz < 2*rlen + 1 ) {
+					if ( ! (np = realloc( obuf, 2*rlen + 1 )) ) {
+						st = -ENOMEM;
+						goto bail;
+					}
+					obuf   = np;
+					obufSz = 2*rlen + 1;
+				}
+				if ( cobs ) {
+					put = cobsStuffBuf( obuf, rep, rlen );
+				} else {
+					l   = rlen;
+					put = byteStuffBuf( obuf, obufSz - 1, rep, &l );
+				}
+				obuf[put++] = BYTE_STUFF_COMMA;
+				if ( (st = writeAll( fd, obuf, put )) ) {
+					goto bail;
+				}
+			}
+			if ( sim->framing >= 0 ) {
+				cobs = ( FIFO_FRAMING_COBS == sim->framing );
+			}
+			frmLen = 0;
+			drop   = 0;
+		}
+	}
+
+bail:
+	free( frm );
+	free( obuf );
+	return st;
+}
+
+/* In-process transport */
+
+typedef struct SimConn {
+	struct SimConn *next;
+	int             fd;
+	int             srvFd;
+	FWSim          *sim;
+	pthread_t       thread;
+} SimConn;
+
+static SimConn         *simConns   = NULL;
+static pthread_mutex_t  simConnMtx = PTHREAD_MUTEX_INITIALIZER;
+
+static void *
+simThread(void *arg)
+{
+SimConn *c = (SimConn*)arg;
+int      st;
+
+	if ( (st = fwSimServe( c->sim, c->srvFd )) ) {
+		fprintf(stderr, "fwSim: server terminated: %s\n", strerror( -st ));
+	}
+	return NULL;
+}
+
+static int
+simOpen(const char *path, unsigned speed)
+{
+FWSimConfig cfg;
+SimConn    *c;
+int         sv[2];
+int         st;
+
+	fwSimConfigInit( &cfg );
+	if ( (st = fwSimConfigParse( &cfg, path )) ) {
+		return st;
+	}
+	if ( ! (c = calloc( 1, sizeof(*c) )) ) {
+		return -ENOMEM;
+	}
+	if ( ! (c->sim = fwSimCreate( &cfg )) ) {
+		st = -ENOMEM;
+		goto bail;
+	}
+	if ( socketpair( AF_UNIX, SOCK_STREAM, 0, sv ) ) {
+		st = -errno;
+		perror("fwSim: socketpair failed");
+		goto bail;
+	}
+	c->fd    = sv[0];
+	c->srvFd = sv[1];
+	if ( (st = pthread_create( &c->thread, NULL, simThread, c )) ) {
+		st = -st;
+		close( c->fd );
+		close( c->srvFd );
+		goto bail;
+	}
+	pthread_mutex_lock( &simConnMtx );
+	c->next  = simConns;
+	simConns = c;
+	pthread_mutex_unlock( &simConnMtx );
+	return c->fd;
+
+bail:
+	fwSimDestroy( c->sim );
+	free( c );
+	return st;
+}
+
+static ssize_t
+simSend(int fd, const uint8_t *buf, size_t len)
+{
+	return send( fd, buf, len, MSG_NOSIGNAL );
+}
+
+static ssize_t
+simRecv(int fd, uint8_t *buf, size_t len)
+{
+	return recv( fd, buf, len, 0 );
+}
+
+static int
+simClose(int fd)
+{
+SimConn **pp, *c = NULL;
+
+	fifoSetTransport( fd, NULL );
+	pthread_mutex_lock( &simConnMtx );
+	for ( pp = &simConns; *pp; pp = &(*pp)->next ) {
+		if ( (*pp)->fd == fd ) {
+			c   = *pp;
+			*pp = c->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock( &simConnMtx );
+
+	if ( ! c ) {
+		return close( fd ) ? -errno : 0;
+	}
+	/* the server sees EOF and terminates */
+	shutdown( fd, SHUT_RDWR );
+	pthread_join( c->thread, NULL );
+	close( c->srvFd );
+	close( fd );
+	fwSimDestroy( c->sim );
+	free( c );
+	return 0;
+}
+
+const FifoTransportOps fifoTransportSim = {
+	.scheme = "sim",
+	.open   = simOpen,
+	.send   = simSend,
+	.recv   = simRecv,
+	.close  = simClose,
+};
@@ -0,0 +1,120 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+/* Software model of the scope firmware.
+ *
+ * The model implements the CommandMux/ByteStuffer framing (including
+ * the COBS mode which is negotiated by the VERSION command) and the
+ * scope command set (version, SPI controller with a flash model,
+ * generic and application registers, bit-bang, i2c master, ADC memory
+ * and acquisition parameters) at the protocol level; it is a behavioral
+ * model, not a cycle-accurate one. ADC data are produced by a
+ * waveform generator (a sine wave plus noise on both channels) which
+ * is controlled by application registers (see below). Averaging mode
+ * sums (up to 256) acquisitions which differ only in their noise.
+ *
+ * The model reports board version 255 ("simulator") so that the
+ * host library treats it like the GHDL simulation.
+ *
+ * The model can be used in-process by means of the "sim:" transport
+ * (e.g., 'bbcli -d sim:') or served on a PTY or socket by 'fwSimSrv'.
+ */
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+#include "cmdXfer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application registers of the waveform generator */
+#define FW_SIM_REG_PERIOD_OFF 10  /* sine period in ADC samples (24-bit, little-endian) */
+#define FW_SIM_REG_AMPL_OFF   13  /* amplitude in percent of full-scale                 */
+#define FW_SIM_REG_NOISE_OFF  14  /* noise amplitude in ADC ticks (peak)                */
+#define FW_SIM_REG_PHASE_OFF  15  /* phase of channel B rel. to A in 1/256 periods      */
+
+typedef struct FWSimConfig {
+	uint8_t       boardVersion;
+	uint32_t      gitHash;
+	unsigned      memDepth;    /* samples per channel; multiple of 512 */
+	unsigned      adcBits;     /* 8..16                                */
+	unsigned      adcFreqMHz;
+	uint32_t      seed;        /* noise generator seed                 */
+} FWSimConfig;
+
+typedef struct FWSim FWSim;
+
+/* Initialize a configuration with defaults */
+void
+fwSimConfigInit(FWSimConfig *cfg);
+
+/* Parse a comma-separated list of "key=value" settings into 'cfg'.
+ * Keys: 'board', 'git', 'depth', 'bits', 'freq' and 'seed'.
+ * RETURNS: 0 on success, -EINVAL on a syntax error or invalid value.
+ */
+int
+fwSimConfigParse(FWSimConfig *cfg, const char *str);
+
+/* Create a model instance; 'cfg' may be NULL (defaults).
+ * RETURNS: new instance or NULL (error message printed).
+ */
+FWSim *
+fwSimCreate(const FWSimConfig *cfg);
+
+void
+fwSimDestroy(FWSim *sim);
+
+/* Process a single de-stuffed frame 'req' ('len' octets) and store
+ * the (unstuffed) reply in '*prep' (which remains owned by the model
+ * and is valid until the next call).
+ * RETURNS: length of the reply (0 if the frame is to be ignored).
+ */
+size_t
+fwSimProcessFrame(FWSim *sim, const uint8_t *req, size_t len, const uint8_t **prep);
+
+/* Serve the byte-stuffed protocol on 'fd' until end-of-file or
+ * an error occurs.
+ * RETURNS: 0 on end-of-file, negative errno on error.
+ */
+int
+fwSimServe(FWSim *sim, int fd);
+
+/* "sim:[key=value[,key=value]]" - creates a model instance which is
+ * served by a thread on one end of a socketpair; closing the fd
+ * terminates the thread and destroys the instance.
+ */
+extern const FifoTransportOps fifoTransportSim;
+
+#ifdef __cplusplus
+}
+#endif
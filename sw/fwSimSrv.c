@@ -0,0 +1,189 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Serve the firmware model on a PTY or a socket */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+
+#include "fwSim.h"
+
+static void usage(const char *nm)
+{
+	printf("usage: %s [-h] [-c config] [-u path | -t port]\n", nm);
+	printf("   -h           : this message.\n");
+	printf("   -c config    : model configuration; comma-separated list of\n");
+	printf("                  key=value with keys: board, git, depth, bits,\n");
+	printf("                  freq, seed (e.g., 'depth=4096,bits=8').\n");
+	printf("   -u path      : serve on a unix socket.\n");
+	printf("   -t port      : serve on a TCP port.\n");
+	printf("\n");
+	printf("By default a PTY is created and the name of its slave is printed;\n");
+	printf("use it as the device, e.g., 'bbcli -d /dev/pts/N'. Socket clients\n");
+	printf("use 'unix:path' or 'tcp:host:port'. Connections are served one at\n");
+	printf("a time; the model state persists across connections.\n");
+}
+
+static int
+servePty(FWSim *sim)
+{
+int            fd, sfd;
+const char    *nm;
+struct termios tios;
+
+	if ( (fd = posix_openpt( O_RDWR | O_NOCTTY )) < 0 || grantpt( fd ) || unlockpt( fd ) || ! (nm = ptsname( fd )) ) {
+		perror("unable to create PTY");
+		return 1;
+	}
+	/* keep the slave open (in raw mode); the master would see EIO
+	 * whenever no client has it open.
+	 */
+	if ( (sfd = open( nm, O_RDWR | O_NOCTTY )) < 0 ) {
+		perror("unable to open PTY slave");
+		return 1;
+	}
+	if ( 0 == tcgetattr( sfd, &tios ) ) {
+		cfmakeraw( &tios );
+		tcsetattr( sfd, TCSANOW, &tios );
+	}
+	printf("%s\n", nm);
+	fflush( stdout );
+	return fwSimServe( sim, fd ) ? 1 : 0;
+}
+
+static int
+serveSocket(FWSim *sim, const char *path, int port)
+{
+struct sockaddr_un  su;
+struct sockaddr_in6 si;
+struct sockaddr    *sa;
+socklen_t           salen;
+int                 sd, fd, st;
+int                 one = 1;
+
+	if ( path ) {
+		if ( strlen( path ) >= sizeof(su.sun_path) ) {
+			fprintf(stderr, "unix socket path '%s' too long\n", path);
+			return 1;
+		}
+		memset( &su, 0, sizeof(su) );
+		su.sun_family = AF_UNIX;
+		strcpy( su.sun_path, path );
+		unlink( path );
+		sa    = (struct sockaddr*)&su;
+		salen = sizeof(su);
+	} else {
+		memset( &si, 0, sizeof(si) );
+		si.sin6_family = AF_INET6;
+		si.sin6_addr   = in6addr_any;
+		si.sin6_port   = htons( port );
+		sa    = (struct sockaddr*)&si;
+		salen = sizeof(si);
+	}
+	if ( (sd = socket( sa->sa_family, SOCK_STREAM, 0 )) < 0 ) {
+		perror("unable to create socket");
+		return 1;
+	}
+	if ( ! path ) {
+		setsockopt( sd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) );
+	}
+	if ( bind( sd, sa, salen ) || listen( sd, 1 ) ) {
+		perror("unable to bind/listen");
+		close( sd );
+		return 1;
+	}
+	for ( ;; ) {
+		if ( (fd = accept( sd, NULL, NULL )) < 0 ) {
+			if ( EINTR == errno ) {
+				continue;
+			}
+			perror("accept failed");
+			break;
+		}
+		if ( (st = fwSimServe( sim, fd )) ) {
+			fprintf(stderr, "connection terminated: %s\n", strerror( -st ));
+		}
+		close( fd );
+	}
+	close( sd );
+	return 1;
+}
+
+int
+main(int argc, char **argv)
+{
+FWSimConfig  cfg;
+FWSim       *sim  = NULL;
+const char  *path = NULL;
+int          port = -1;
+int          opt;
+int          rval = 1;
+
+	fwSimConfigInit( &cfg );
+
+	while ( (opt = getopt(argc, argv, "c:ht:u:")) > 0 ) {
+		switch ( opt ) {
+			case 'h': usage(argv[0]);                                                 return 0;
+			default : fprintf(stderr, "Unknown option -%c (use -h for help)\n", opt); return 1;
+			case 'c':
+				if ( fwSimConfigParse( &cfg, optarg ) ) {
+					goto bail;
+				}
+				break;
+			case 'u': path = optarg;                                                  break;
+			case 't':
+				if ( 1 != sscanf(optarg, "%i", &port) || port <= 0 || port > 65535 ) {
+					fprintf(stderr, "Invalid port number\n");
+					goto bail;
+				}
+				break;
+		}
+	}
+
+	if ( ! (sim = fwSimCreate( &cfg )) ) {
+		goto bail;
+	}
+
+	if ( path || port > 0 ) {
+		rval = serveSocket( sim, path, port );
+	} else {
+		rval = servePty( sim );
+	}
+
+bail:
+	fwSimDestroy( sim );
+	return rval;
+}
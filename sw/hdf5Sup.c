@@ -817,6 +817,16 @@ double      fullScaleClicks;
 		return st;
 	}
 
+	u[0] = p->acqParams.nsegments > 1 ? p->acqParams.nsegments : 1;
+	if ( (st = scope_h5_add_uint_attr( h5d, SCOPE_KEY_NSEGMENTS, u, 1 )) < 0 ) {
+		return st;
+	}
+
+	u[0] = p->acqParams.naverage > 1 ? p->acqParams.naverage : 1;
+	if ( (st = scope_h5_add_uint_attr( h5d, SCOPE_KEY_NAVERAGE, u, 1 )) < 0 ) {
+		return st;
+	}
+
 	if ( (st = scope_h5_add_trigger_source( h5d, p->acqParams.src, p->acqParams.rising )) < 0 ) {
 		return st;
 	}
@@ -898,12 +908,31 @@ scope_h5_add_acq_parameters(ScopePvt *scp, ScopeH5Data *h5d)
 
 int
 scope_h5_add_bufhdr(ScopeH5Data *h5d, unsigned bufHdr, unsigned numChannels)
+{
+	return scope_h5_add_bufhdr_ext( h5d, bufHdr, NULL, numChannels );
+}
+
+int
+scope_h5_add_bufhdr_ext(ScopeH5Data *h5d, unsigned bufHdr, const BufHdrExt *xhdr, unsigned numChannels)
 {
 #ifndef CONFIG_WITH_HDF5
 	return -ENOTSUP;
 #else
 int      chnl;
 int      st;
+unsigned seq;
+double   d;
+	if ( xhdr ) {
+		seq = xhdr->seq;
+		if ( (st = scope_h5_add_uint_attr( h5d, SCOPE_KEY_ACQ_SEQ, &seq, 1 )) < 0 ) {
+			return st;
+		}
+		/* exact up to 2^53 ADC clocks */
+		d = (double)xhdr->tstamp;
+		if ( (st = scope_h5_add_double_attr( h5d, SCOPE_KEY_TRG_TSTAMP, &d, 1 )) < 0 ) {
+			return st;
+		}
+	}
 	if ( numChannels >= 8 ) {
 		return -EINVAL;
 	} else {
@@ -924,3 +953,40 @@ int      st;
 #endif
 }
 
+int
+scope_h5_add_segments(ScopeH5Data *h5d, const BufSegInfo *info, unsigned nsegs)
+{
+#ifndef CONFIG_WITH_HDF5
+	return -ENOTSUP;
+#else
+unsigned *u;
+double   *d;
+unsigned  i;
+int       st = -ENOMEM;
+
+	if ( 0 == nsegs ) {
+		return -EINVAL;
+	}
+	u = malloc( sizeof(*u) * nsegs );
+	d = malloc( sizeof(*d) * nsegs );
+	if ( ! u || ! d ) {
+		goto bail;
+	}
+	for ( i = 0; i < nsegs; ++i ) {
+		u[i] = info[i].hdr;
+		/* exact up to 2^53 ADC clocks */
+		d[i] = (double)info[i].tstamp;
+	}
+	if ( (st = scope_h5_add_uint_attr( h5d, SCOPE_KEY_SEG_HDR, u, nsegs )) < 0 ) {
+		goto bail;
+	}
+	if ( (st = scope_h5_add_double_attr( h5d, SCOPE_KEY_SEG_TSTAMP, d, nsegs )) < 0 ) {
+		goto bail;
+	}
+	st = 0;
+bail:
+	free( u );
+	free( d );
+	return st;
+#endif
+}
@@ -140,6 +140,18 @@ scope_h5_add_scope_parameters(ScopeH5Data *h5d, const ScopeParams *p);
 int
 scope_h5_add_bufhdr(ScopeH5Data *h5d, unsigned bufHdr, unsigned numChannels);
 
+/* Like scope_h5_add_bufhdr(); also stores the extended header
+ * (sequence number and trigger timestamp) unless 'xhdr' is NULL.
+ */
+int
+scope_h5_add_bufhdr_ext(ScopeH5Data *h5d, unsigned bufHdr, const BufHdrExt *xhdr, unsigned numChannels);
+
+/* Per-segment buffer headers and trigger time-stamps (ADC clock
+ * ticks) of a segmented acquisition (see buf_read_segments()).
+ */
+int
+scope_h5_add_segments(ScopeH5Data *h5d, const BufSegInfo *info, unsigned nsegs);
+
 int
 scope_h5_add_date(ScopeH5Data *h5d, time_t when );
 
@@ -202,6 +202,27 @@ scope_json_save(ScopePvt *scp, const char * filename, const ScopeParams *setting
 		}
 	}
 
+	if ( !! (settings->acqParams.mask & ACQ_PARAM_MSK_SEG ) ) {
+		if ( json_object_set_new( top, SCOPE_KEY_NSEGMENTS , json_integer( settings->acqParams.nsegments ) ) ) {
+			st = -ENOMEM;
+			goto bail;
+		}
+	}
+
+	if ( !! (settings->acqParams.mask & ACQ_PARAM_MSK_DBL ) ) {
+		if ( json_object_set_new( top, SCOPE_KEY_DBL_BUF   , json_integer( !! settings->acqParams.doubleBuffer ) ) ) {
+			st = -ENOMEM;
+			goto bail;
+		}
+	}
+
+	if ( !! (settings->acqParams.mask & ACQ_PARAM_MSK_AVG ) ) {
+		if ( json_object_set_new( top, SCOPE_KEY_NAVERAGE  , json_integer( settings->acqParams.naverage > 1 ? settings->acqParams.naverage : 1 ) ) ) {
+			st = -ENOMEM;
+			goto bail;
+		}
+	}
+
 	if ( !! (settings->acqParams.mask & ACQ_PARAM_MSK_AUT ) ) {
 		if ( json_object_set_new( top, SCOPE_KEY_AUTOTRG_MS, json_integer( settings->acqParams.autoTimeoutMS ) ) ) {
 			st = -ENOMEM;
@@ -581,6 +602,44 @@ scope_json_load(ScopePvt *scp, const char * filename, ScopeParams *settings)
 		settings->acqParams.mask      |= ACQ_PARAM_MSK_NSM;
 	}
 
+	st = jget_int( top, SCOPE_KEY_NSEGMENTS , &ival, SCLR, QUIET );
+	if ( -ENOKEY != st ) {
+		if ( st ) {
+			goto bail;
+		}
+		if ( ival < 1 ) {
+			fprintf(stderr, "%s: WARNING - increasing number of segments to 1.\n", __func__);
+			ival = 1;
+		}
+		/* clipped to what fits by acq_set_params() */
+		settings->acqParams.nsegments  = ival;
+		settings->acqParams.mask      |= ACQ_PARAM_MSK_SEG;
+	}
+
+	st = jget_int( top, SCOPE_KEY_DBL_BUF   , &ival, SCLR, QUIET );
+	if ( -ENOKEY != st ) {
+		if ( st ) {
+			goto bail;
+		}
+		/* nsamples is clipped by acq_set_params() */
+		settings->acqParams.doubleBuffer = !! ival;
+		settings->acqParams.mask        |= ACQ_PARAM_MSK_DBL;
+	}
+
+	st = jget_int( top, SCOPE_KEY_NAVERAGE  , &ival, SCLR, QUIET );
+	if ( -ENOKEY != st ) {
+		if ( st ) {
+			goto bail;
+		}
+		if ( ival < 1 ) {
+			fprintf(stderr, "%s: WARNING - increasing number of averages to 1.\n", __func__);
+			ival = 1;
+		}
+		/* clipped by the firmware */
+		settings->acqParams.naverage   = ival;
+		settings->acqParams.mask      |= ACQ_PARAM_MSK_AVG;
+	}
+
 	st = jget_int( top, SCOPE_KEY_NPTS      , &ival, SCLR, QUIET );
 	if ( -ENOKEY != st ) {
 		if ( st ) {
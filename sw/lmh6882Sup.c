@@ -34,6 +34,9 @@
 #include "fwComm.h"
 #include "scopeSup.h"
 
+#define SHADOW FW_SHADOW_SPI( SPI_PGA )
+
+/* Always reads the device (and refreshes the register shadow) */
 int
 lmh6882ReadReg(FWInfo *fw, uint8_t reg)
 {
@@ -44,9 +47,20 @@ int     st;
 	if ( ( st = bb_spi_xfer( fw, SPI_MODE0, SPI_PGA, buf, buf, 0, sizeof(buf)) ) < 0 ) {
 		return st;
 	}
+	fw_shadow_set( fw, SHADOW, reg & 0xf, buf[1] );
 	return buf[1];	
 }
 
+static int
+cachedReadReg(FWInfo *fw, uint8_t reg)
+{
+int     st;
+	if ( (st = fw_shadow_get( fw, SHADOW, reg & 0xf )) < 0 ) {
+		st = lmh6882ReadReg( fw, reg );
+	}
+	return st;
+}
+
 int
 lmh6882WriteReg(FWInfo *fw, uint8_t reg, uint8_t val)
 {
@@ -55,8 +69,10 @@ int     st;
 	buf[0] = 0x00 | ( reg & 0xf );
 	buf[1] = val;
 	if ( ( st = bb_spi_xfer( fw, SPI_MODE0, SPI_PGA, buf, buf, 0, sizeof(buf)) ) < 0 ) {
+		fw_shadow_invalidate( fw, SHADOW, reg & 0xf );
 		return st;
 	}
+	fw_shadow_set( fw, SHADOW, reg & 0xf, val );
 	return 0;
 }
 
@@ -73,7 +89,7 @@ int v;
 	if ( channel > 1 ) {
 		return (float)-EINVAL;
 	}
-	if ( ( v = lmh6882ReadReg( fw, PGA_REG_ATT_CHA + channel ) ) < 0 ) {
+	if ( ( v = cachedReadReg( fw, PGA_REG_ATT_CHA + channel ) ) < 0 ) {
 		return (float)v;
 	}
 	return ((float)v)/4.0;
@@ -106,7 +122,7 @@ lmh6882Power(FWInfo *fw, int state)
 {
 int v, ov, st;
 
-	ov = lmh6882ReadReg( fw, PGA_REG_PWR_CTL );
+	ov = cachedReadReg( fw, PGA_REG_PWR_CTL );
 	if ( ov < 0 ) {
 		return ov;
 	}
@@ -69,6 +69,19 @@ cdef extern from "fwComm.h":
   int            fw_reg_read(FWInfo *, uint32_t, uint8_t *, size_t, unsigned) nogil
   int            fw_reg_write(FWInfo *, uint32_t, uint8_t *, size_t, unsigned) nogil
 
+  ctypedef struct reg_vec:
+    uint32_t       addr
+    const uint8_t *tbuf
+    uint8_t       *rbuf
+    size_t         len
+    unsigned       flags
+
+  int            fw_reg_xfer_vec(FWInfo *, const reg_vec *, size_t) nogil
+
+  unsigned       FW_SHADOW_ALL
+  void           fw_shadow_invalidate(FWInfo *, unsigned dev, unsigned reg) nogil
+  void           fw_shadow_enable(FWInfo *, int enable) nogil
+
   int            bb_spi_raw(FWInfo *, SPIDev, int clk, int mosi, int cs, int hiz) nogil
   int            bb_i2c_read_reg(FWInfo *, uint8_t sla, uint8_t reg) nogil
   int            bb_i2c_write_reg(FWInfo *, uint8_t sla, uint8_t reg, uint8_t val) nogil
@@ -154,6 +167,20 @@ cdef extern from "versaClkSup.h":
   int            versaClkReadReg(FWInfo *fw, unsigned reg) nogil
   int            versaClkWriteReg(FWInfo *fw, unsigned reg, uint8_t val) nogil
 
+cdef extern from "sampleStats.h":
+  int            SAMPLE_STATS_MAX_CH
+
+  ctypedef struct SampleStats:
+    size_t        count
+    double        mean
+    double        var
+    double        rms
+    int16_t       min
+    int16_t       max
+    size_t        overrange
+
+  int            sampleStats(SampleStats *st, const void *src, int wide, unsigned nch, size_t nsmpl, int ovrLo, int ovrHi) nogil
+
 cdef extern from "scopeSup.h":
   ctypedef struct ScopePvt:
     pass
@@ -176,6 +203,17 @@ cdef extern from "scopeSup.h":
     uint8_t       cic0Shift
     uint8_t       cic1Shift
     int32_t       scale
+    uint32_t      nsegments
+    int           doubleBuffer
+    uint32_t      naverage
+
+  struct BufSegInfo:
+    uint16_t      hdr
+    uint64_t      tstamp
+
+  struct BufHdrExt:
+    uint16_t      seq
+    uint64_t      tstamp
 
   ScopePvt      *scope_open(FWInfo *fw) nogil
   void           scope_close(ScopePvt *) nogil
@@ -189,15 +227,30 @@ cdef extern from "scopeSup.h":
   int            scope_init(ScopePvt *, int force) nogil
   unsigned long  buf_get_size(ScopePvt *) nogil
   double         buf_get_sampling_freq(ScopePvt *) nogil
-  uint8_t        buf_get_flags(ScopePvt *) nogil
+  unsigned       buf_get_flags(ScopePvt *) nogil
   int            buf_flush(ScopePvt *) nogil
   int            buf_read(ScopePvt *, uint16_t *hdr, uint8_t *buf, size_t len) nogil
   int            buf_read_flt(ScopePvt *, uint16_t *hdr, float *buf, size_t len) nogil
+  int            buf_read_avg(ScopePvt *, uint16_t *hdr, int32_t *buf, size_t nelms) nogil
+  int            buf_wait_triggered(ScopePvt *, int timeoutMs) nogil
+  int            buf_read_range(ScopePvt *, uint16_t *hdr, uint8_t *buf, size_t len, unsigned long offset, unsigned long count) nogil
+  int            buf_read_overview(ScopePvt *, uint16_t *hdr, uint8_t *buf, size_t len, unsigned long offset, unsigned long count, unsigned long nbuckets) nogil
+  int            buf_set_ext_header(ScopePvt *, int enable) nogil
+  int            buf_get_ext_header(ScopePvt *, BufHdrExt *xhdr) nogil
+  int            buf_set_packed(ScopePvt *, int enable) nogil
+  int            buf_read_segments(ScopePvt *, uint16_t *hdr, uint8_t *buf, size_t len, BufSegInfo *info, unsigned maxsegs) nogil
+  int            buf_read_volts_flt(ScopePvt *, uint16_t *hdr, float **dst, size_t nsmpl) nogil
+  int            buf_read_volts_dbl(ScopePvt *, uint16_t *hdr, double **dst, size_t nsmpl) nogil
+  int            buf_compute_stats(ScopePvt *, SampleStats *st, const void *buf, int wide, size_t nsmpl) nogil
+  unsigned       scope_get_num_channels(ScopePvt *) nogil
   int            ACQ_PARAM_TIMEOUT_INF
   int            acq_set_params(ScopePvt *, AcqParams *set, AcqParams *get) nogil
   int            acq_set_level(ScopePvt *, int16_t level, uint16_t hysteresis) nogil
   int            acq_set_npts(ScopePvt *, int32_t npts) nogil
   int            acq_set_nsamples(ScopePvt *, int32_t nsamples) nogil
+  int            acq_set_nsegments(ScopePvt *, uint32_t nsegments) nogil
+  int            acq_set_double_buffer(ScopePvt *, int enable) nogil
+  int            acq_set_naverage(ScopePvt *, uint32_t naverage) nogil
   int            acq_set_decimation(ScopePvt *, uint8_t cic0Decimation, uint32_t cic1Decimation) nogil
   int            acq_set_source(ScopePvt *, TriggerSource src, int rising) nogil
   int            acq_set_autoTimeoutMs(ScopePvt *, uint32_t timeout) nogil
@@ -217,3 +270,18 @@ cdef extern from "scopeSup.h":
   int            fecGetAttDb(ScopePvt *, unsigned channel, double *att) nogil
   int            fecSetAttDb(ScopePvt *, unsigned channel, double att) nogil
   void           fecClose(ScopePvt *) nogil
+
+cdef extern from "sampleAccum.h":
+  ctypedef struct SampleAccum:
+    pass
+
+  SampleAccum   *sampleAccumCreate(unsigned nch, size_t nsmpl) nogil
+  void           sampleAccumDestroy(SampleAccum *) nogil
+  void           sampleAccumReset(SampleAccum *) nogil
+  unsigned long  sampleAccumGetCount(SampleAccum *) nogil
+  unsigned       sampleAccumGetNumChannels(SampleAccum *) nogil
+  size_t         sampleAccumGetNumSamples(SampleAccum *) nogil
+  int            sampleAccumAdd(SampleAccum *, const void *src, int wide, size_t nelms) nogil
+  int            sampleAccumGetMean(SampleAccum *, float **dst) nogil
+  int            sampleAccumGetRms(SampleAccum *, float **dst) nogil
+  int            sampleAccumGetEnvelope(SampleAccum *, int16_t **min, int16_t **max) nogil
@@ -31,8 +31,9 @@ from cpython.exc cimport *
 from cpython     cimport *
 from time        import  sleep
 from libc.string cimport strdup
-from libc.stdlib cimport free
+from libc.stdlib cimport free, calloc
 from libc.string cimport strerror
+from libc.math   cimport sqrt
 
 cdef extern from "pthread.h":
   ctypedef struct pthread_mutexattr_t
@@ -57,6 +58,7 @@ cdef extern from "pthread.h":
   int pthread_cond_destroy(pthread_cond_t *)
 
 import numpy
+import errno
 
 cdef class Mtx:
   cdef pthread_mutex_t _mtx
@@ -207,6 +209,10 @@ cdef class LED(FwDev):
   def setVal(self, name, val):
     pass
 
+  def setVals(self, vals):
+    for name, val in vals.items():
+      self.setVal( name, val )
+
 cdef class LEDv1(LED):
 
   cdef uint8_t _led[3]
@@ -269,6 +275,36 @@ cdef class LEDv1(LED):
     with self._mgr as fw, nogil:
       fw_reg_write( fw, adr, buf, 1, REG_FLG_APP )
 
+  def setVals(self, vals):
+    """Set several LEDs ('vals' maps names to values); all modified
+       registers are written with a single command
+    """
+    cdef reg_vec vec[3]
+    cdef size_t  n = 0
+    cdef int     st
+    old = [ self._led[adr] for adr in range(3) ]
+    for name, val in vals.items():
+      idx = self.ledMap[name]
+      adr = int(idx / 8)
+      msk = (1<<(idx % 8))
+      if val:
+        self._led[adr] |=  msk
+      else:
+        self._led[adr] &= ~msk
+    for adr in range(3):
+      if self._led[adr] != old[adr]:
+        vec[n].addr  = self.ledBase + adr
+        vec[n].tbuf  = &self._led[adr]
+        vec[n].rbuf  = NULL
+        vec[n].len   = 1
+        vec[n].flags = REG_FLG_APP
+        n += 1
+    if n > 0:
+      with self._mgr as fw, nogil:
+        st = fw_reg_xfer_vec( fw, vec, n )
+      if ( st < 0 ):
+        raise IOError("LEDv1.setVals()")
+
 
 cdef class VersaClk(FwDev):
 
@@ -657,6 +693,99 @@ cdef class FEC(ScopeDev):
       raise RuntimeError("Front-End 'getDACRangeHi' failed")
     return st > 0
 
+# Accumulation of acquisitions (interleaved samples of 'nch' channels
+# as filled by FwComm.read()); the results are numpy arrays with one
+# row per channel (shape (nch, nsmpl)) in the units of the samples.
+cdef class Accumulator:
+  cdef SampleAccum    *_acc
+
+  def __cinit__(self, unsigned nch, size_t nsmpl, *args, **kwargs):
+    self._acc = sampleAccumCreate( nch, nsmpl )
+    if ( self._acc == NULL ):
+      raise MemoryError("Accumulator: creation failed")
+
+  def __dealloc__(self):
+    sampleAccumDestroy( self._acc )
+
+  def reset(self):
+    sampleAccumReset( self._acc )
+
+  def getCount(self):
+    return sampleAccumGetCount( self._acc )
+
+  # Add the first nch*nsmpl samples held in 'pyb' (e.g., a buffer
+  # created by FwComm.mkBuf())
+  def add(self, pyb):
+    cdef Py_buffer b
+    cdef int       st
+    cdef size_t    nelms = sampleAccumGetNumChannels( self._acc ) * sampleAccumGetNumSamples( self._acc )
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS ) ):
+      raise ValueError("Accumulator.add arg must support buffer protocol")
+    if ( ( b.itemsize != 1 and b.itemsize != 2 ) or b.len // b.itemsize < nelms ):
+      PyBuffer_Release( &b )
+      raise ValueError("Accumulator.add arg buffer itemsize must be 1 or 2 and hold all samples")
+    with nogil:
+      st = sampleAccumAdd( self._acc, b.buf, b.itemsize == 2, nelms )
+    PyBuffer_Release( &b )
+    if ( st == -errno.ERANGE ):
+      raise OverflowError("Accumulator.add: too many acquisitions; reset first")
+    if ( st < 0 ):
+      raise ValueError("Accumulator.add: failed")
+
+  cdef mkRows(self, dtype, Py_buffer *b, void **rows):
+    cdef unsigned nch   = sampleAccumGetNumChannels( self._acc )
+    cdef size_t   nsmpl = sampleAccumGetNumSamples( self._acc )
+    cdef unsigned ch
+    a = numpy.empty( (nch, nsmpl), dtype = dtype )
+    PyObject_GetBuffer( a, b, PyBUF_C_CONTIGUOUS | PyBUF_WRITEABLE )
+    for ch in range( nch ):
+      rows[ch] = (<uint8_t*>b.buf) + ch*nsmpl*b.itemsize
+    return a
+
+  cdef getFlt(self, int rms):
+    cdef Py_buffer b
+    cdef int       st
+    cdef float   **fp = <float**>calloc( sampleAccumGetNumChannels( self._acc ), sizeof(float*) )
+    if ( fp == NULL ):
+      raise MemoryError("Accumulator")
+    a = self.mkRows( 'float32', &b, <void**>fp )
+    with nogil:
+      if ( rms ):
+        st = sampleAccumGetRms( self._acc, fp )
+      else:
+        st = sampleAccumGetMean( self._acc, fp )
+    PyBuffer_Release( &b )
+    free( fp )
+    if ( st < 0 ):
+      raise ValueError("Accumulator: no data")
+    return a
+
+  def mean(self):
+    return self.getFlt( 0 )
+
+  # RMS noise (deviation from the mean) of each sample
+  def rms(self):
+    return self.getFlt( 1 )
+
+  # RETURNS: (min, max) arrays (int16)
+  def envelope(self):
+    cdef Py_buffer  bmin, bmax
+    cdef int        st
+    cdef unsigned   nch = sampleAccumGetNumChannels( self._acc )
+    cdef int16_t  **mn  = <int16_t**>calloc( 2*nch, sizeof(int16_t*) )
+    if ( mn == NULL ):
+      raise MemoryError("Accumulator")
+    amin = self.mkRows( 'int16', &bmin, <void**>mn )
+    amax = self.mkRows( 'int16', &bmax, <void**>(mn + nch) )
+    with nogil:
+      st = sampleAccumGetEnvelope( self._acc, mn, mn + nch )
+    PyBuffer_Release( &bmin )
+    PyBuffer_Release( &bmax )
+    free( mn )
+    if ( st < 0 ):
+      raise ValueError("Accumulator: no data")
+    return amin, amax
+
 cdef class FwComm:
   cdef FwMgr           _mgr
   cdef ScopeDev        _scp
@@ -667,7 +796,7 @@ cdef class FwComm:
   cdef LED             _led
   cdef Max195xxADC     _adc
   cdef int             _bufsz
-  cdef uint8_t         _bufflags
+  cdef unsigned        _bufflags
   cdef AcqParams       _parmCache
   cdef Mtx             _syncMtx
   cdef Cond            _asyncEvt
@@ -726,8 +855,12 @@ cdef class FwComm:
             numIter -= 1
           if ( numIter == 0 ):
             break
-          # avoid busy polling if there is no data
-          sleep(0.01)
+          # block until data are ready rather than polling
+          try:
+            self.waitTriggered( 0.05 )
+          except Exception as e:
+            print("Exception in waitTriggered (ignoring): ", e)
+            sleep(0.01)
       callback( rv, hdr, pyb )
     return NULL
 
@@ -781,6 +914,17 @@ cdef class FwComm:
     with self._mgr as fw, nogil:
       fw_set_debug( fw, level )
 
+  # Discard the register shadow of all board peripherals
+  # (e.g., after they have been accessed behind our back)
+  def invalidateShadow(self):
+    with self._mgr as fw, nogil:
+      fw_shadow_invalidate( fw, FW_SHADOW_ALL, FW_SHADOW_ALL )
+
+  def enableShadow(self, bool on = True):
+    cdef int val = on
+    with self._mgr as fw, nogil:
+      fw_shadow_enable( fw, val )
+
   def init( self, force = False ):
     cdef int st,forceVal
     forceVal = force
@@ -923,6 +1067,20 @@ cdef class FwComm:
       st = buf_flush( scp )
     return st
 
+  # Block until an acquisition is available (returns True) or
+  # 'timeout' seconds expire (returns False); wait forever if
+  # timeout < 0. The acquisition is handed out by the next 'read'.
+  def waitTriggered(self, float timeout = -1.0):
+    cdef int st
+    cdef int ms = -1
+    if ( timeout >= 0.0 ):
+      ms = int( 1000.0 * timeout )
+    with self._scp as scp, nogil:
+      st = buf_wait_triggered( scp, ms )
+    if ( st < 0 ):
+      PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
+    return st > 0
+
   def read(self, pyb):
     cdef Py_buffer b
     cdef int       rv
@@ -934,7 +1092,7 @@ cdef class FwComm:
         rv = buf_read( scp, &hdr, <uint8_t*>b.buf, b.len )
     elif ( b.itemsize == sizeof(float) ):
       with self._scp as scp, nogil:
-        rv = buf_read_flt( scp, &hdr, <float*>b.buf, b.len )
+        rv = buf_read_flt( scp, &hdr, <float*>b.buf, b.len // sizeof(float) )
     else:
       PyBuffer_Release( &b )
       raise ValueError("FwComm.read arg buffer itemsize must be 1,2 or {:d}".format(sizeof(float)))
@@ -943,6 +1101,204 @@ cdef class FwComm:
       PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
     return rv, hdr
 
+  # Read the (interleaved, 32-bit) sums of an averaged acquisition;
+  # raises NotImplementedError if averaging is off and OSError
+  # if the data were acquired before averaging was enabled.
+  def readAvg(self, pyb):
+    cdef Py_buffer b
+    cdef int       rv
+    cdef uint16_t  hdr
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS | PyBUF_WRITEABLE ) ):
+      raise ValueError("FwComm.readAvg arg must support buffer protocol")
+    if ( b.itemsize != sizeof(int32_t) ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.readAvg arg buffer itemsize must be {:d}".format(sizeof(int32_t)))
+    with self._scp as scp, nogil:
+      rv = buf_read_avg( scp, &hdr, <int32_t*>b.buf, b.len // sizeof(int32_t) )
+    PyBuffer_Release( &b )
+    if ( rv == -errno.ENOTSUP ):
+      raise NotImplementedError("FwComm.readAvg(): averaging is off")
+    if ( rv < 0 ):
+      PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
+    return rv, hdr
+
+  # Read 'count' samples (0: as many as fit) of each channel starting
+  # at sample 'offset'; only this region is transferred if the firmware
+  # supports it. The buffer holds raw (interleaved) samples as with 'read'.
+  def readRange(self, pyb, unsigned long offset, unsigned long count = 0):
+    cdef Py_buffer b
+    cdef int       rv
+    cdef uint16_t  hdr
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS | PyBUF_WRITEABLE ) ):
+      raise ValueError("FwComm.readRange arg must support buffer protocol")
+    if ( b.itemsize != 1 and b.itemsize != 2 ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.readRange arg buffer itemsize must be 1 or 2")
+    with self._scp as scp, nogil:
+      rv = buf_read_range( scp, &hdr, <uint8_t*>b.buf, b.len, offset, count )
+    PyBuffer_Release( &b )
+    if ( rv < 0 ):
+      PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
+    return rv, hdr
+
+  # Read a min/max overview of 'count' samples (0: acquisition length)
+  # starting at 'offset' into 'pyb'; each of (at most) 'nbuckets' buckets
+  # yields its minimum followed by its maximum (as two raw samples).
+  # RETURNS: (number of bytes read, header)
+  def readOverview(self, pyb, unsigned long nbuckets, unsigned long offset = 0, unsigned long count = 0):
+    cdef Py_buffer b
+    cdef int       rv
+    cdef uint16_t  hdr
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS | PyBUF_WRITEABLE ) ):
+      raise ValueError("FwComm.readOverview arg must support buffer protocol")
+    if ( b.itemsize != 1 and b.itemsize != 2 ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.readOverview arg buffer itemsize must be 1 or 2")
+    with self._scp as scp, nogil:
+      rv = buf_read_overview( scp, &hdr, <uint8_t*>b.buf, b.len, offset, count, nbuckets )
+    PyBuffer_Release( &b )
+    if ( rv < 0 ):
+      PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
+    return rv, hdr
+
+  # Enable/disable the extended header (enabled by default if the
+  # firmware supports it).
+  def setExtHeader(self, bool enable):
+    cdef int st, val
+    # bool is a python object and cannot be used w/o gil
+    val = enable
+    with self._scp as scp, nogil:
+      st = buf_set_ext_header( scp, val )
+    if ( st < 0 ):
+      raise NotImplementedError("FwComm.setExtHeader(): not supported by firmware")
+
+  # Enable/disable packed transfer of the samples (on by default if
+  # the firmware supports it); transparent to the read methods.
+  def setPackedTransfer(self, bool enable):
+    cdef int st, val
+    val = enable
+    with self._scp as scp, nogil:
+      st = buf_set_packed( scp, val )
+    if ( st < 0 ):
+      raise NotImplementedError("FwComm.setPackedTransfer(): not supported by firmware")
+
+  # Extended header of the acquisition read last.
+  # RETURNS: (sequence number, trigger timestamp in ADC clock ticks)
+  #          or None if not available
+  def getExtHeader(self):
+    cdef BufHdrExt x
+    cdef int       st
+    with self._scp as scp, nogil:
+      st = buf_get_ext_header( scp, &x )
+    if ( st < 0 ):
+      return None
+    return x.seq, x.tstamp
+
+  # Read a segmented acquisition; the segments (without trailers) are
+  # stored back-to-back in 'pyb' (raw, interleaved samples as with 'read').
+  # RETURNS: (number of segments, header, list of (segment header,
+  #          trigger time-stamp in ADC clock ticks))
+  def readSegments(self, pyb, unsigned maxsegs = 65536):
+    cdef Py_buffer   b
+    cdef int         rv
+    cdef int         i
+    cdef uint16_t    hdr
+    cdef BufSegInfo *info
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS | PyBUF_WRITEABLE ) ):
+      raise ValueError("FwComm.readSegments arg must support buffer protocol")
+    if ( b.itemsize != 1 and b.itemsize != 2 ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.readSegments arg buffer itemsize must be 1 or 2")
+    info = <BufSegInfo*>calloc( maxsegs if maxsegs > 0 else 1, sizeof(BufSegInfo) )
+    if ( info == NULL ):
+      PyBuffer_Release( &b )
+      raise MemoryError("FwComm.readSegments")
+    with self._scp as scp, nogil:
+      rv = buf_read_segments( scp, &hdr, <uint8_t*>b.buf, b.len, info, maxsegs )
+    PyBuffer_Release( &b )
+    segs = [ (info[i].hdr, info[i].tstamp) for i in range( rv ) ]
+    free( info )
+    if ( rv < 0 ):
+      PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
+    return rv, hdr, segs
+
+  # Read an acquisition converted to volts into a C-contiguous
+  # float32 or float64 array with one row per channel (e.g., a
+  # numpy array of shape (numChannels, nsamples)).
+  # RETURNS: (number of samples per channel, header)
+  def readVolts(self, pyb):
+    cdef Py_buffer b
+    cdef int       rv
+    cdef uint16_t  hdr
+    cdef unsigned  nch, ch
+    cdef size_t    nsmpl
+    cdef float    *fp[16]
+    cdef double   *dp[16]
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS | PyBUF_WRITEABLE ) ):
+      raise ValueError("FwComm.readVolts arg must support buffer protocol")
+    with self._scp as scp, nogil:
+      nch = scope_get_num_channels( scp )
+    if ( nch < 1 or nch > 16 or b.itemsize < 1 or 0 != ( b.len // b.itemsize ) % nch ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.readVolts arg buffer must hold the same number of samples for each channel")
+    nsmpl = ( b.len // b.itemsize ) // nch
+    if   ( b.itemsize == sizeof(float) ):
+      for ch in range( nch ):
+        fp[ch] = (<float*>b.buf) + ch*nsmpl
+      with self._scp as scp, nogil:
+        rv = buf_read_volts_flt( scp, &hdr, fp, nsmpl )
+    elif ( b.itemsize == sizeof(double) ):
+      for ch in range( nch ):
+        dp[ch] = (<double*>b.buf) + ch*nsmpl
+      with self._scp as scp, nogil:
+        rv = buf_read_volts_dbl( scp, &hdr, dp, nsmpl )
+    else:
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.readVolts arg buffer itemsize must be {:d} or {:d}".format(sizeof(float), sizeof(double)))
+    PyBuffer_Release( &b )
+    if ( rv < 0 ):
+      PyErr_SetFromErrnoWithFilenameObject(OSError, self.mgr().name())
+    return rv, hdr
+
+  # Compute per-channel statistics of the first 'nsmpl' samples (0: all
+  # samples) held in 'pyb' (raw samples as obtained by 'read') in a
+  # single pass.
+  # RETURNS: list with a dictionary ('count', 'mean', 'var', 'std',
+  # 'rms', 'min', 'max', 'overrange') for each channel.
+  def stats(self, pyb, size_t nsmpl = 0):
+    cdef Py_buffer   b
+    cdef int         rv
+    cdef unsigned    nch, ch
+    cdef SampleStats st[16]
+    if ( not PyObject_CheckBuffer( pyb ) or 0 != PyObject_GetBuffer( pyb, &b, PyBUF_C_CONTIGUOUS ) ):
+      raise ValueError("FwComm.stats arg must support buffer protocol")
+    with self._scp as scp, nogil:
+      nch = scope_get_num_channels( scp )
+    if ( nch < 1 or nch > 16 or ( b.itemsize != 1 and b.itemsize != 2 ) ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.stats arg buffer itemsize must be 1 or 2")
+    if ( 0 == nsmpl ):
+      nsmpl = ( b.len // b.itemsize ) // nch
+    elif ( nsmpl * nch > b.len // b.itemsize ):
+      PyBuffer_Release( &b )
+      raise ValueError("FwComm.stats arg buffer too small")
+    with self._scp as scp, nogil:
+      rv = buf_compute_stats( scp, st, b.buf, b.itemsize == 2, nsmpl )
+    PyBuffer_Release( &b )
+    if ( rv < 0 ):
+      raise ValueError("FwComm.stats failed with status {:d}".format(rv))
+    rval = []
+    for ch in range( nch ):
+      rval.append( { 'count'     : st[ch].count,
+                     'mean'      : st[ch].mean,
+                     'var'       : st[ch].var,
+                     'std'       : sqrt( st[ch].var ),
+                     'rms'       : st[ch].rms,
+                     'min'       : st[ch].min,
+                     'max'       : st[ch].max,
+                     'overrange' : st[ch].overrange } )
+    return rval
+
   def acqGetTriggerLevelPercent(self):
     return 100.0 * float(self._parmCache.level) / 32767.0
 
@@ -993,6 +1349,65 @@ cdef class FwComm:
   def acqGetNSamples(self):
     return self._parmCache.nsamples
 
+  # The library clips the number of segments to what fits into the
+  # buffer and disables pre-trigger samples; re-read the settings.
+  def acqSetNSegments(self, int n):
+    cdef int st
+    if ( n < 1 ):
+      raise ValueError("acqSetNSegments(): # segments out of range")
+    if ( self.acqGetNSegments() == n ):
+      return
+    with self._scp as scp, nogil:
+      st = acq_set_nsegments( scp, n )
+      if ( st >= 0 ):
+        st = acq_set_params( scp, NULL, &self._parmCache )
+    if ( st < 0 ):
+      raise IOError("acqSetNSegments()")
+
+  def acqGetNSegments(self):
+    return self._parmCache.nsegments if self._parmCache.nsegments > 1 else 1
+
+  # Average 'n' acquisitions in the firmware (1: off); the firmware
+  # clips 'n' and the number of samples and the library disables
+  # segmented mode; re-read the settings.
+  def acqSetNAverage(self, int n):
+    cdef int st
+    if ( n < 1 ):
+      raise ValueError("acqSetNAverage(): # averages out of range")
+    if ( self.acqGetNAverage() == n ):
+      return
+    with self._scp as scp, nogil:
+      st = acq_set_naverage( scp, n )
+      if ( st >= 0 ):
+        st = acq_set_params( scp, NULL, &self._parmCache )
+    if ( st < 0 ):
+      if ( st == -errno.ENOTSUP ):
+        raise NotImplementedError("acqSetNAverage(): not supported by firmware")
+      raise IOError("acqSetNAverage()")
+
+  def acqGetNAverage(self):
+    return self._parmCache.naverage if self._parmCache.naverage > 1 else 1
+
+  # Ping-pong buffering; the library clips the number of samples
+  # to half of the buffer; re-read the settings.
+  def acqSetDoubleBuffer(self, bool enable):
+    cdef int st, val
+    if ( self.acqGetDoubleBuffer() == enable ):
+      return
+    # bool is a python object and cannot be used w/o gil
+    val = enable
+    with self._scp as scp, nogil:
+      st = acq_set_double_buffer( scp, val )
+      if ( st >= 0 ):
+        st = acq_set_params( scp, NULL, &self._parmCache )
+    if ( st < 0 ):
+      if ( st == -errno.ENOTSUP ):
+        raise NotImplementedError("acqSetDoubleBuffer(): not supported by firmware")
+      raise IOError("acqSetDoubleBuffer()")
+
+  def acqGetDoubleBuffer(self):
+    return bool( self._parmCache.doubleBuffer )
+
   def acqGetDecimation(self):
     return self._parmCache.cic0Decimation, self._parmCache.cic1Decimation
 
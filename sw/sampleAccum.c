@@ -0,0 +1,335 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+
+#include "sampleAccum.h"
+#include "sampleConv.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* All arrays are interleaved like the source */
+struct SampleAccum {
+	unsigned       nch;
+	size_t         nsmpl;
+	size_t         nelms;
+	unsigned long  count;
+	int32_t       *sum;
+	uint64_t      *sqs;
+	int16_t       *min;
+	int16_t       *max;
+};
+
+static inline int32_t
+smpl(const void *src, int wide, size_t idx)
+{
+	return wide ? ((const int16_t*)src)[idx] : ((const int8_t*)src)[idx];
+}
+
+/* accumulate elements 'i0'..'nelms'-1 */
+static void
+accScalar(SampleAccum *acc, const void *src, int wide, size_t i0)
+{
+size_t  i;
+int32_t v;
+	for ( i = i0; i < acc->nelms; i++ ) {
+		v             = smpl( src, wide, i );
+		acc->sum[i]  += v;
+		acc->sqs[i]  += (uint64_t)(v*v);
+		if ( v < acc->min[i] ) {
+			acc->min[i] = v;
+		}
+		if ( v > acc->max[i] ) {
+			acc->max[i] = v;
+		}
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("sse2")))
+static inline void
+addEpi32SSE2(int32_t *p, __m128i v)
+{
+	_mm_storeu_si128( (__m128i*)p, _mm_add_epi32( _mm_loadu_si128( (const __m128i*)p ), v ) );
+}
+
+__attribute__((target("sse2")))
+static inline void
+addEpi64SSE2(uint64_t *p, __m128i v)
+{
+	_mm_storeu_si128( (__m128i*)p, _mm_add_epi64( _mm_loadu_si128( (const __m128i*)p ), v ) );
+}
+
+/* 8 samples per iteration; the 32-bit squares are assembled from
+ * the low and high halves of the 16-bit products and zero-extended
+ * to 64-bit.
+ */
+__attribute__((target("sse2")))
+static void
+accSSE2(SampleAccum *acc, const void *src, int wide)
+{
+const uint8_t *s = (const uint8_t*)src;
+__m128i        z = _mm_setzero_si128();
+__m128i        v, lo, hi, q, *p;
+size_t         i;
+
+	for ( i = 0; i + 8 <= acc->nelms; i += 8 ) {
+		if ( wide ) {
+			v = _mm_loadu_si128( (const __m128i*)(s + 2*i) );
+		} else {
+			v = _mm_loadl_epi64( (const __m128i*)(s + i) );
+			v = _mm_srai_epi16( _mm_unpacklo_epi8( v, v ), 8 );
+		}
+		p = (__m128i*)(acc->min + i);
+		_mm_storeu_si128( p, _mm_min_epi16( _mm_loadu_si128( p ), v ) );
+		p = (__m128i*)(acc->max + i);
+		_mm_storeu_si128( p, _mm_max_epi16( _mm_loadu_si128( p ), v ) );
+
+		addEpi32SSE2( acc->sum + i,     _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 ) );
+		addEpi32SSE2( acc->sum + i + 4, _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 ) );
+
+		lo = _mm_mullo_epi16( v, v );
+		hi = _mm_mulhi_epi16( v, v );
+		q  = _mm_unpacklo_epi16( lo, hi );
+		addEpi64SSE2( acc->sqs + i,     _mm_unpacklo_epi32( q, z ) );
+		addEpi64SSE2( acc->sqs + i + 2, _mm_unpackhi_epi32( q, z ) );
+		q  = _mm_unpackhi_epi16( lo, hi );
+		addEpi64SSE2( acc->sqs + i + 4, _mm_unpacklo_epi32( q, z ) );
+		addEpi64SSE2( acc->sqs + i + 6, _mm_unpackhi_epi32( q, z ) );
+	}
+	accScalar( acc, src, wide, i );
+}
+
+__attribute__((target("avx2")))
+static inline void
+addEpi32AVX2(int32_t *p, __m256i v)
+{
+	_mm256_storeu_si256( (__m256i*)p, _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*)p ), v ) );
+}
+
+__attribute__((target("avx2")))
+static inline void
+addEpi64AVX2(uint64_t *p, __m128i v)
+{
+	_mm256_storeu_si256( (__m256i*)p, _mm256_add_epi64( _mm256_loadu_si256( (const __m256i*)p ), _mm256_cvtepu32_epi64( v ) ) );
+}
+
+/* Same as accSSE2 but 16 samples per iteration; widening with
+ * vpmovsx/vpmovzx preserves the order across 128-bit lanes.
+ */
+__attribute__((target("avx2")))
+static void
+accAVX2(SampleAccum *acc, const void *src, int wide)
+{
+const uint8_t *s = (const uint8_t*)src;
+__m256i        v, l, h, *p;
+size_t         i;
+
+	for ( i = 0; i + 16 <= acc->nelms; i += 16 ) {
+		if ( wide ) {
+			v = _mm256_loadu_si256( (const __m256i*)(s + 2*i) );
+		} else {
+			v = _mm256_cvtepi8_epi16( _mm_loadu_si128( (const __m128i*)(s + i) ) );
+		}
+		p = (__m256i*)(acc->min + i);
+		_mm256_storeu_si256( p, _mm256_min_epi16( _mm256_loadu_si256( p ), v ) );
+		p = (__m256i*)(acc->max + i);
+		_mm256_storeu_si256( p, _mm256_max_epi16( _mm256_loadu_si256( p ), v ) );
+
+		l = _mm256_cvtepi16_epi32( _mm256_castsi256_si128( v ) );
+		h = _mm256_cvtepi16_epi32( _mm256_extracti128_si256( v, 1 ) );
+		addEpi32AVX2( acc->sum + i,     l );
+		addEpi32AVX2( acc->sum + i + 8, h );
+
+		l = _mm256_mullo_epi32( l, l );
+		h = _mm256_mullo_epi32( h, h );
+		addEpi64AVX2( acc->sqs + i,      _mm256_castsi256_si128( l ) );
+		addEpi64AVX2( acc->sqs + i +  4, _mm256_extracti128_si256( l, 1 ) );
+		addEpi64AVX2( acc->sqs + i +  8, _mm256_castsi256_si128( h ) );
+		addEpi64AVX2( acc->sqs + i + 12, _mm256_extracti128_si256( h, 1 ) );
+	}
+	accScalar( acc, src, wide, i );
+}
+#endif
+
+SampleAccum *
+sampleAccumCreate(unsigned nch, size_t nsmpl)
+{
+SampleAccum *acc;
+
+	if ( 0 == nch || 0 == nsmpl ) {
+		return NULL;
+	}
+	if ( ! (acc = calloc( 1, sizeof(*acc) )) ) {
+		return NULL;
+	}
+	acc->nch   = nch;
+	acc->nsmpl = nsmpl;
+	acc->nelms = nch * nsmpl;
+	acc->sum   = malloc( acc->nelms * sizeof(*acc->sum) );
+	acc->sqs   = malloc( acc->nelms * sizeof(*acc->sqs) );
+	acc->min   = malloc( acc->nelms * sizeof(*acc->min) );
+	acc->max   = malloc( acc->nelms * sizeof(*acc->max) );
+	if ( ! acc->sum || ! acc->sqs || ! acc->min || ! acc->max ) {
+		sampleAccumDestroy( acc );
+		return NULL;
+	}
+	sampleAccumReset( acc );
+	return acc;
+}
+
+void
+sampleAccumDestroy(SampleAccum *acc)
+{
+	if ( acc ) {
+		free( acc->sum );
+		free( acc->sqs );
+		free( acc->min );
+		free( acc->max );
+		free( acc );
+	}
+}
+
+void
+sampleAccumReset(SampleAccum *acc)
+{
+size_t i;
+	acc->count = 0;
+	for ( i = 0; i < acc->nelms; i++ ) {
+		acc->sum[i] = 0;
+		acc->sqs[i] = 0;
+		acc->min[i] = INT16_MAX;
+		acc->max[i] = INT16_MIN;
+	}
+}
+
+unsigned long
+sampleAccumGetCount(SampleAccum *acc)
+{
+	return acc->count;
+}
+
+unsigned
+sampleAccumGetNumChannels(SampleAccum *acc)
+{
+	return acc->nch;
+}
+
+size_t
+sampleAccumGetNumSamples(SampleAccum *acc)
+{
+	return acc->nsmpl;
+}
+
+int
+sampleAccumAdd(SampleAccum *acc, const void *src, int wide, size_t nelms)
+{
+	if ( nelms != acc->nelms ) {
+		return -EINVAL;
+	}
+	if ( acc->count >= SAMPLE_ACCUM_MAX_COUNT ) {
+		return -ERANGE;
+	}
+	switch ( sampleConvGetKernel() ) {
+#ifdef HAVE_X86_SIMD
+		case SAMPLE_CONV_KERNEL_AVX2: accAVX2( acc, src, wide );      break;
+		case SAMPLE_CONV_KERNEL_SSE2: accSSE2( acc, src, wide );      break;
+#endif
+		default:                      accScalar( acc, src, wide, 0 ); break;
+	}
+	acc->count++;
+	return 0;
+}
+
+int
+sampleAccumGetMean(SampleAccum *acc, float * const dst[])
+{
+double   scl;
+unsigned c;
+size_t   i;
+
+	if ( 0 == acc->count ) {
+		return -ENODATA;
+	}
+	scl = 1.0/(double)acc->count;
+	for ( c = 0; c < acc->nch; c++ ) {
+		for ( i = 0; i < acc->nsmpl; i++ ) {
+			dst[c][i] = (float)( (double)acc->sum[i*acc->nch + c] * scl );
+		}
+	}
+	return 0;
+}
+
+int
+sampleAccumGetRms(SampleAccum *acc, float * const dst[])
+{
+uint64_t n = acc->count;
+int64_t  s;
+unsigned c;
+size_t   i, k;
+
+	if ( 0 == n ) {
+		return -ENODATA;
+	}
+	/* n^2 * variance = n * sum(x^2) - sum(x)^2 is computed exactly;
+	 * both terms are < 2^63 thanks to SAMPLE_ACCUM_MAX_COUNT
+	 */
+	for ( c = 0; c < acc->nch; c++ ) {
+		for ( i = 0; i < acc->nsmpl; i++ ) {
+			k = i*acc->nch + c;
+			s = acc->sum[k];
+			dst[c][i] = (float)( sqrt( (double)( n * acc->sqs[k] - (uint64_t)(s*s) ) ) / (double)n );
+		}
+	}
+	return 0;
+}
+
+int
+sampleAccumGetEnvelope(SampleAccum *acc, int16_t * const min[], int16_t * const max[])
+{
+unsigned c;
+size_t   i;
+
+	if ( 0 == acc->count ) {
+		return -ENODATA;
+	}
+	for ( c = 0; c < acc->nch; c++ ) {
+		for ( i = 0; i < acc->nsmpl; i++ ) {
+			if ( min ) {
+				min[c][i] = acc->min[i*acc->nch + c];
+			}
+			if ( max ) {
+				max[c][i] = acc->max[i*acc->nch + c];
+			}
+		}
+	}
+	return 0;
+}
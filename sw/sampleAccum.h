@@ -0,0 +1,114 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Accumulation of acquisitions (e.g., for averaging on the host or
+ * for an envelope display). Every acquisition which is added updates
+ * the running sum, the sum of squares and the minimum and maximum
+ * of each sample. The samples are interleaved (as produced by the ADC
+ * memory, i.e., what buf_read()/buf_read_int16() store and what the
+ * slots of a ScopeStream hold): sample 'i' of channel 'c' at index
+ * i*nch + c. Samples are signed 8-bit or, if 'wide' is nonzero, 16-bit
+ * in host byte order; the results are in the same units.
+ *
+ * The kernel (SIMD or scalar) is the one selected for the sample
+ * conversion (see sampleConv.h).
+ *
+ * The routines are not thread-safe; a callback of the stream reader
+ * may add acquisitions while other threads retrieve results only if
+ * the user serializes access.
+ */
+
+/* The (32-bit) sums limit the number of acquisitions */
+#define SAMPLE_ACCUM_MAX_COUNT 65536
+
+typedef struct SampleAccum SampleAccum;
+
+/* Create an accumulator for 'nsmpl' samples of 'nch' channels.
+ * RETURNS: new (reset) accumulator or NULL (no memory or invalid args).
+ */
+SampleAccum *
+sampleAccumCreate(unsigned nch, size_t nsmpl);
+
+void
+sampleAccumDestroy(SampleAccum *acc);
+
+/* Discard all accumulated acquisitions */
+void
+sampleAccumReset(SampleAccum *acc);
+
+/* RETURNS: number of acquisitions accumulated since the last reset */
+unsigned long
+sampleAccumGetCount(SampleAccum *acc);
+
+unsigned
+sampleAccumGetNumChannels(SampleAccum *acc);
+
+size_t
+sampleAccumGetNumSamples(SampleAccum *acc);
+
+/* Add an acquisition; 'nelms' (samples of all channels) must match
+ * the size of the accumulator.
+ * RETURNS: 0 on success, -EINVAL if 'nelms' does not match, -ERANGE
+ *          if SAMPLE_ACCUM_MAX_COUNT acquisitions have been added
+ *          already (the accumulator is not modified).
+ */
+int
+sampleAccumAdd(SampleAccum *acc, const void *src, int wide, size_t nelms);
+
+/* The results are stored planar (one array of 'nsmpl' elements per
+ * channel).
+ * RETURNS: 0 on success, -ENODATA if nothing has been accumulated.
+ */
+
+/* Mean of each sample */
+int
+sampleAccumGetMean(SampleAccum *acc, float * const dst[]);
+
+/* RMS deviation from the mean (i.e., the noise) of each sample */
+int
+sampleAccumGetRms(SampleAccum *acc, float * const dst[]);
+
+/* Envelope; 'min' or 'max' may be NULL */
+int
+sampleAccumGetEnvelope(SampleAccum *acc, int16_t * const min[], int16_t * const max[]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,496 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <string.h>
+#include <errno.h>
+
+#include "sampleConv.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static inline int32_t
+smpl(const void *src, int wide, size_t idx)
+{
+	return wide ? ((const int16_t*)src)[idx] : ((const int8_t*)src)[idx];
+}
+
+/* convert samples 'i0'..'nsmpl'-1 */
+static void
+fltScalar(float * const dst[], const void *src, int wide, unsigned nch, size_t i0, size_t nsmpl, const float scl[], const float off[])
+{
+unsigned c;
+size_t   i;
+	for ( c = 0; c < nch; c++ ) {
+		for ( i = i0; i < nsmpl; i++ ) {
+			dst[c][i] = (float)smpl( src, wide, i*nch + c ) * scl[c] + off[c];
+		}
+	}
+}
+
+static void
+dblScalar(double * const dst[], const void *src, int wide, unsigned nch, size_t i0, size_t nsmpl, const double scl[], const double off[])
+{
+unsigned c;
+size_t   i;
+	for ( c = 0; c < nch; c++ ) {
+		for ( i = i0; i < nsmpl; i++ ) {
+			dst[c][i] = (double)smpl( src, wide, i*nch + c ) * scl[c] + off[c];
+		}
+	}
+}
+
+static void
+fltScalar0(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[])
+{
+	fltScalar( dst, src, wide, nch, 0, nsmpl, scl, off );
+}
+
+static void
+dblScalar0(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[])
+{
+	dblScalar( dst, src, wide, nch, 0, nsmpl, scl, off );
+}
+
+/* unpack words 'i0'..'nwords'-1; 'i0' must be a multiple of 8 */
+static void
+unpkScalar(uint8_t *dst, const uint8_t *src, unsigned bits, size_t i0, size_t nwords)
+{
+uint32_t acc = 0;
+unsigned nb  = 0;
+uint16_t w;
+size_t   i;
+
+	src += i0*bits/8;
+	dst += 2*i0;
+	for ( i = i0; i < nwords; i++ ) {
+		while ( nb < bits ) {
+			acc |= (uint32_t)*src++ << nb;
+			nb  += 8;
+		}
+		w      = (uint16_t)( acc << (16 - bits) );
+		acc  >>= bits;
+		nb    -= bits;
+		*dst++ = (w >> 0) & 0xff;
+		*dst++ = (w >> 8) & 0xff;
+	}
+}
+
+static void
+unpkScalar0(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords)
+{
+	unpkScalar( dst, src, bits, 0, nwords );
+}
+
+/* Within a group of 8 words (which occupies 'bits' octets) word 'k'
+ * starts at bit k*bits. For 9, 10 and 12 bits every word is contained
+ * in the two octets at (k*bits)/8; these are gathered into a 16-bit
+ * lane and left-adjusted by a multiplication (a per-lane shift) and
+ * masking.
+ */
+static int
+unpkTables(unsigned bits, uint8_t shf[16], uint16_t mul[8])
+{
+unsigned k, b;
+
+	if ( 9 != bits && 10 != bits && 12 != bits ) {
+		return -ENOTSUP;
+	}
+	for ( k = 0; k < 8; k++ ) {
+		b          = k*bits;
+		shf[2*k  ] = (b >> 3);
+		shf[2*k+1] = (b >> 3) + 1;
+		mul[k]     = 1 << (16 - bits - (b & 7));
+	}
+	return 0;
+}
+
+#ifdef HAVE_X86_SIMD
+/* Load 4 samples of 1 or 2 channels starting at sample 'i' and
+ * sign-extend to 32-bit. Pairs of interleaved samples are split
+ * by shifting the 32-bit lanes - no shuffles are needed.
+ */
+__attribute__((target("sse2")))
+static inline void
+ld4SSE2(const uint8_t *src, int wide, unsigned nch, size_t i, __m128i *pa, __m128i *pb)
+{
+__m128i  v;
+int32_t  w;
+	if ( 1 == nch ) {
+		if ( wide ) {
+			v   = _mm_loadl_epi64( (const __m128i*)(src + 2*i) );
+			*pa = _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 );
+		} else {
+			memcpy( &w, src + i, sizeof(w) );
+			v   = _mm_unpacklo_epi8( _mm_cvtsi32_si128( w ), _mm_cvtsi32_si128( w ) );
+			*pa = _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 24 );
+		}
+		return;
+	}
+	if ( wide ) {
+		v = _mm_loadu_si128( (const __m128i*)(src + 4*i) );
+	} else {
+		v = _mm_loadl_epi64( (const __m128i*)(src + 2*i) );
+		v = _mm_srai_epi16( _mm_unpacklo_epi8( v, v ), 8 );
+	}
+	*pa = _mm_srai_epi32( _mm_slli_epi32( v, 16 ), 16 );
+	*pb = _mm_srai_epi32( v, 16 );
+}
+
+__attribute__((target("sse2")))
+static inline void
+stFltSSE2(float *dst, __m128i v, __m128 scl, __m128 off)
+{
+	_mm_storeu_ps( dst, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( v ), scl ), off ) );
+}
+
+__attribute__((target("sse2")))
+static inline void
+stDblSSE2(double *dst, __m128i v, __m128d scl, __m128d off)
+{
+	_mm_storeu_pd( dst,     _mm_add_pd( _mm_mul_pd( _mm_cvtepi32_pd( v ), scl ), off ) );
+	_mm_storeu_pd( dst + 2, _mm_add_pd( _mm_mul_pd( _mm_cvtepi32_pd( _mm_unpackhi_epi64( v, v ) ), scl ), off ) );
+}
+
+__attribute__((target("sse2")))
+static void
+fltSSE2(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[])
+{
+__m128i a, b;
+__m128  sa, sb, oa, ob;
+size_t  i;
+
+	if ( nch < 1 || nch > 2 ) {
+		fltScalar( dst, src, wide, nch, 0, nsmpl, scl, off );
+		return;
+	}
+	sa = _mm_set1_ps( scl[0] );
+	oa = _mm_set1_ps( off[0] );
+	sb = _mm_set1_ps( scl[nch - 1] );
+	ob = _mm_set1_ps( off[nch - 1] );
+	for ( i = 0; i + 4 <= nsmpl; i += 4 ) {
+		ld4SSE2( src, wide, nch, i, &a, &b );
+		stFltSSE2( dst[0] + i, a, sa, oa );
+		if ( 2 == nch ) {
+			stFltSSE2( dst[1] + i, b, sb, ob );
+		}
+	}
+	fltScalar( dst, src, wide, nch, i, nsmpl, scl, off );
+}
+
+__attribute__((target("sse2")))
+static void
+dblSSE2(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[])
+{
+__m128i a, b;
+__m128d sa, sb, oa, ob;
+size_t  i;
+
+	if ( nch < 1 || nch > 2 ) {
+		dblScalar( dst, src, wide, nch, 0, nsmpl, scl, off );
+		return;
+	}
+	sa = _mm_set1_pd( scl[0] );
+	oa = _mm_set1_pd( off[0] );
+	sb = _mm_set1_pd( scl[nch - 1] );
+	ob = _mm_set1_pd( off[nch - 1] );
+	for ( i = 0; i + 4 <= nsmpl; i += 4 ) {
+		ld4SSE2( src, wide, nch, i, &a, &b );
+		stDblSSE2( dst[0] + i, a, sa, oa );
+		if ( 2 == nch ) {
+			stDblSSE2( dst[1] + i, b, sb, ob );
+		}
+	}
+	dblScalar( dst, src, wide, nch, i, nsmpl, scl, off );
+}
+
+/* Same as ld4SSE2 but 8 samples */
+__attribute__((target("avx2")))
+static inline void
+ld8AVX2(const uint8_t *src, int wide, unsigned nch, size_t i, __m256i *pa, __m256i *pb)
+{
+__m256i  v;
+	if ( 1 == nch ) {
+		if ( wide ) {
+			*pa = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)(src + 2*i) ) );
+		} else {
+			*pa = _mm256_cvtepi8_epi32( _mm_loadl_epi64( (const __m128i*)(src + i) ) );
+		}
+		return;
+	}
+	if ( wide ) {
+		v = _mm256_loadu_si256( (const __m256i*)(src + 4*i) );
+	} else {
+		v = _mm256_cvtepi8_epi16( _mm_loadu_si128( (const __m128i*)(src + 2*i) ) );
+	}
+	*pa = _mm256_srai_epi32( _mm256_slli_epi32( v, 16 ), 16 );
+	*pb = _mm256_srai_epi32( v, 16 );
+}
+
+__attribute__((target("avx2")))
+static inline void
+stFltAVX2(float *dst, __m256i v, __m256 scl, __m256 off)
+{
+	_mm256_storeu_ps( dst, _mm256_add_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( v ), scl ), off ) );
+}
+
+__attribute__((target("avx2")))
+static inline void
+stDblAVX2(double *dst, __m256i v, __m256d scl, __m256d off)
+{
+	_mm256_storeu_pd( dst,     _mm256_add_pd( _mm256_mul_pd( _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) ), scl ), off ) );
+	_mm256_storeu_pd( dst + 4, _mm256_add_pd( _mm256_mul_pd( _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) ), scl ), off ) );
+}
+
+__attribute__((target("avx2")))
+static void
+fltAVX2(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[])
+{
+__m256i a, b;
+__m256  sa, sb, oa, ob;
+size_t  i;
+
+	if ( nch < 1 || nch > 2 ) {
+		fltScalar( dst, src, wide, nch, 0, nsmpl, scl, off );
+		return;
+	}
+	sa = _mm256_set1_ps( scl[0] );
+	oa = _mm256_set1_ps( off[0] );
+	sb = _mm256_set1_ps( scl[nch - 1] );
+	ob = _mm256_set1_ps( off[nch - 1] );
+	for ( i = 0; i + 8 <= nsmpl; i += 8 ) {
+		ld8AVX2( src, wide, nch, i, &a, &b );
+		stFltAVX2( dst[0] + i, a, sa, oa );
+		if ( 2 == nch ) {
+			stFltAVX2( dst[1] + i, b, sb, ob );
+		}
+	}
+	fltScalar( dst, src, wide, nch, i, nsmpl, scl, off );
+}
+
+__attribute__((target("avx2")))
+static void
+dblAVX2(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[])
+{
+__m256i a, b;
+__m256d sa, sb, oa, ob;
+size_t  i;
+
+	if ( nch < 1 || nch > 2 ) {
+		dblScalar( dst, src, wide, nch, 0, nsmpl, scl, off );
+		return;
+	}
+	sa = _mm256_set1_pd( scl[0] );
+	oa = _mm256_set1_pd( off[0] );
+	sb = _mm256_set1_pd( scl[nch - 1] );
+	ob = _mm256_set1_pd( off[nch - 1] );
+	for ( i = 0; i + 8 <= nsmpl; i += 8 ) {
+		ld8AVX2( src, wide, nch, i, &a, &b );
+		stDblAVX2( dst[0] + i, a, sa, oa );
+		if ( 2 == nch ) {
+			stDblAVX2( dst[1] + i, b, sb, ob );
+		}
+	}
+	dblScalar( dst, src, wide, nch, i, nsmpl, scl, off );
+}
+
+__attribute__((target("ssse3")))
+static void
+unpkSSSE3(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords)
+{
+uint8_t  shf[16];
+uint16_t mul[8];
+size_t   slen = ( nwords*bits + 7 )/8;
+__m128i  vs, vm, vk, v;
+size_t   i;
+
+	if ( unpkTables( bits, shf, mul ) ) {
+		unpkScalar( dst, src, bits, 0, nwords );
+		return;
+	}
+	vs = _mm_loadu_si128( (const __m128i*)shf );
+	vm = _mm_loadu_si128( (const __m128i*)mul );
+	vk = _mm_set1_epi16( (int16_t)(0xffff << (16 - bits)) );
+	/* 16 octets are loaded but only 'bits' consumed */
+	for ( i = 0; i + 8 <= nwords && i*bits/8 + 16 <= slen; i += 8 ) {
+		v = _mm_loadu_si128( (const __m128i*)(src + i*bits/8) );
+		v = _mm_and_si128( _mm_mullo_epi16( _mm_shuffle_epi8( v, vs ), vm ), vk );
+		_mm_storeu_si128( (__m128i*)(dst + 2*i), v );
+	}
+	unpkScalar( dst, src, bits, i, nwords );
+}
+
+/* Same as unpkSSSE3 but two groups of 8 words */
+__attribute__((target("avx2")))
+static void
+unpkAVX2(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords)
+{
+uint8_t  shf[16];
+uint16_t mul[8];
+size_t   slen = ( nwords*bits + 7 )/8;
+__m256i  vs, vm, vk, v;
+size_t   i;
+const uint8_t *s;
+
+	if ( unpkTables( bits, shf, mul ) ) {
+		unpkScalar( dst, src, bits, 0, nwords );
+		return;
+	}
+	vs = _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i*)shf ) );
+	vm = _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i*)mul ) );
+	vk = _mm256_set1_epi16( (int16_t)(0xffff << (16 - bits)) );
+	for ( i = 0; i + 16 <= nwords && i*bits/8 + bits + 16 <= slen; i += 16 ) {
+		s = src + i*bits/8;
+		v = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)s ) ),
+		                             _mm_loadu_si128( (const __m128i*)(s + bits) ), 1 );
+		v = _mm256_and_si256( _mm256_mullo_epi16( _mm256_shuffle_epi8( v, vs ), vm ), vk );
+		_mm256_storeu_si256( (__m256i*)(dst + 2*i), v );
+	}
+	unpkScalar( dst, src, bits, i, nwords );
+}
+#endif
+
+typedef void (*FltFn)(float * const [], const void *, int, unsigned, size_t, const float [], const float []);
+typedef void (*DblFn)(double * const [], const void *, int, unsigned, size_t, const double [], const double []);
+typedef void (*UnpkFn)(uint8_t *, const uint8_t *, unsigned, size_t);
+
+static void fltAuto(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[]);
+static void dblAuto(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[]);
+static void unpkAuto(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords);
+
+static FltFn             fltFn    = fltAuto;
+static DblFn             dblFn    = dblAuto;
+static UnpkFn            unpkFn   = unpkAuto;
+static SampleConvKernel  convKern = SAMPLE_CONV_KERNEL_AUTO;
+
+static void
+fltAuto(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[])
+{
+	sampleConvSelectKernel( SAMPLE_CONV_KERNEL_AUTO );
+	fltFn( dst, src, wide, nch, nsmpl, scl, off );
+}
+
+static void
+dblAuto(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[])
+{
+	sampleConvSelectKernel( SAMPLE_CONV_KERNEL_AUTO );
+	dblFn( dst, src, wide, nch, nsmpl, scl, off );
+}
+
+static void
+unpkAuto(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords)
+{
+	sampleConvSelectKernel( SAMPLE_CONV_KERNEL_AUTO );
+	unpkFn( dst, src, bits, nwords );
+}
+
+int
+sampleConvSelectKernel(SampleConvKernel kern)
+{
+	switch ( kern ) {
+		case SAMPLE_CONV_KERNEL_AUTO:
+			if ( 0 == sampleConvSelectKernel( SAMPLE_CONV_KERNEL_AVX2 ) ) {
+				return 0;
+			}
+			if ( 0 == sampleConvSelectKernel( SAMPLE_CONV_KERNEL_SSE2 ) ) {
+				return 0;
+			}
+			return sampleConvSelectKernel( SAMPLE_CONV_KERNEL_SCALAR );
+
+		case SAMPLE_CONV_KERNEL_SCALAR:
+			fltFn  = fltScalar0;
+			dblFn  = dblScalar0;
+			unpkFn = unpkScalar0;
+			break;
+
+#ifdef HAVE_X86_SIMD
+		case SAMPLE_CONV_KERNEL_SSE2:
+			if ( ! __builtin_cpu_supports( "sse2" ) ) {
+				return -ENOTSUP;
+			}
+			fltFn  = fltSSE2;
+			dblFn  = dblSSE2;
+			unpkFn = __builtin_cpu_supports( "ssse3" ) ? unpkSSSE3 : unpkScalar0;
+			break;
+
+		case SAMPLE_CONV_KERNEL_AVX2:
+			if ( ! __builtin_cpu_supports( "avx2" ) ) {
+				return -ENOTSUP;
+			}
+			fltFn  = fltAVX2;
+			dblFn  = dblAVX2;
+			unpkFn = unpkAVX2;
+			break;
+#endif
+
+		default:
+			return -ENOTSUP;
+	}
+	convKern = kern;
+	return 0;
+}
+
+SampleConvKernel
+sampleConvGetKernel(void)
+{
+	if ( SAMPLE_CONV_KERNEL_AUTO == convKern ) {
+		sampleConvSelectKernel( SAMPLE_CONV_KERNEL_AUTO );
+	}
+	return convKern;
+}
+
+const char *
+sampleConvKernelName(SampleConvKernel kern)
+{
+	switch ( kern ) {
+		case SAMPLE_CONV_KERNEL_AUTO:   return "auto";
+		case SAMPLE_CONV_KERNEL_SCALAR: return "scalar";
+		case SAMPLE_CONV_KERNEL_SSE2:   return "sse2";
+		case SAMPLE_CONV_KERNEL_AVX2:   return "avx2";
+		default:                        break;
+	}
+	return "unknown";
+}
+
+void
+sampleConvFlt(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[])
+{
+	fltFn( dst, src, wide, nch, nsmpl, scl, off );
+}
+
+void
+sampleConvDbl(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[])
+{
+	dblFn( dst, src, wide, nch, nsmpl, scl, off );
+}
+
+void
+sampleUnpack(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords)
+{
+	unpkFn( dst, src, bits, nwords );
+}
@@ -0,0 +1,92 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Conversion of raw ADC samples to scaled, planar (one array per
+ * channel) floating-point data. The samples are read from an
+ * interleaved buffer (as produced by the ADC memory: sample 'i' of
+ * channel 'c' at index i*nch + c) and converted
+ *
+ *   dst[c][i] = src[i*nch + c] * scl[c] + off[c]
+ *
+ * in a single pass. Samples are signed 8-bit or, if 'wide' is
+ * nonzero, 16-bit in host byte order. The SIMD kernels handle one
+ * and two channels; other channel counts use the scalar code.
+ */
+typedef enum SampleConvKernel {
+	SAMPLE_CONV_KERNEL_AUTO,   /* best kernel supported by the CPU */
+	SAMPLE_CONV_KERNEL_SCALAR,
+	SAMPLE_CONV_KERNEL_SSE2,
+	SAMPLE_CONV_KERNEL_AVX2
+} SampleConvKernel;
+
+/* Select the kernel used by the routines below (the best available
+ * one is selected automatically on first use).
+ * RETURNS: 0 on success, -ENOTSUP if the kernel is not supported by
+ *          the CPU (or not compiled in).
+ */
+int
+sampleConvSelectKernel(SampleConvKernel kern);
+
+const char *
+sampleConvKernelName(SampleConvKernel kern);
+
+/* Return the currently selected kernel */
+SampleConvKernel
+sampleConvGetKernel(void);
+
+void
+sampleConvFlt(float * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const float scl[], const float off[]);
+
+void
+sampleConvDbl(double * const dst[], const void *src, int wide, unsigned nch, size_t nsmpl, const double scl[], const double off[]);
+
+/* Expand 'nwords' packed samples of 'bits' bits (9..15) as transferred
+ * by the ADC memory in packed mode (concatenated LSB-first) into
+ * left-adjusted, little-endian 16-bit words at 'dst', i.e., the format
+ * of an ordinary 16-bit readout. 'src' must hold (nwords*bits + 7)/8
+ * octets. The SIMD kernels handle 9, 10 and 12 bits (the SSE2 kernel
+ * uses SSSE3 if available); other sizes use the scalar code.
+ */
+void
+sampleUnpack(uint8_t *dst, const uint8_t *src, unsigned bits, size_t nwords);
+
+#ifdef __cplusplus
+}
+#endif
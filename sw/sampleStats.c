@@ -0,0 +1,309 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <errno.h>
+#include <math.h>
+
+#include "sampleStats.h"
+#include "sampleConv.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Max. number of elements of a block; the integer sums of a block
+ * are exact (no overflow of the 32-bit lanes and n*sum(x^2) < 2^63).
+ */
+#define BLK_ELMS 32768
+
+/* Exact sums of a block (per channel) */
+typedef struct StatBlk {
+	int64_t   s;
+	uint64_t  q;
+	int       min;
+	int       max;
+	uint64_t  novr;
+} StatBlk;
+
+static inline int32_t
+smpl(const void *src, int wide, size_t idx)
+{
+	return wide ? ((const int16_t*)src)[idx] : ((const int8_t*)src)[idx];
+}
+
+/* process elements 'i0'..'nelms'-1; 'i0' must be a multiple of 'nch';
+ * 'lo' + 1 and 'hi' - 1 must be in the 16-bit range
+ */
+static void
+blkScalar(StatBlk b[], const void *src, int wide, unsigned nch, size_t i0, size_t nelms, int lo, int hi)
+{
+unsigned c;
+size_t   i;
+int32_t  v;
+	for ( c = 0; c < nch; c++ ) {
+		for ( i = i0 + c; i < nelms; i += nch ) {
+			v         = smpl( src, wide, i );
+			b[c].s   += v;
+			b[c].q   += (uint64_t)(v*v);
+			if ( v < b[c].min ) {
+				b[c].min = v;
+			}
+			if ( v > b[c].max ) {
+				b[c].max = v;
+			}
+			if ( v <= lo || v >= hi ) {
+				b[c].novr++;
+			}
+		}
+	}
+}
+
+/* Fold the SIMD lanes into the channels; lane 'k' holds elements
+ * with the parity of 'k' (i.e., channel k % nch for 1 or 2 channels).
+ */
+static void
+blkFold(StatBlk b[], unsigned nch, const int32_t *s, unsigned ns, const uint64_t *q, unsigned nq, const int16_t *mn, const int16_t *mx, const int16_t *ovr, unsigned n16)
+{
+unsigned k;
+	for ( k = 0; k < ns; k++ ) {
+		b[k % nch].s += s[k];
+	}
+	for ( k = 0; k < nq; k++ ) {
+		b[k % nch].q += q[k];
+	}
+	for ( k = 0; k < n16; k++ ) {
+		if ( mn[k] < b[k % nch].min ) {
+			b[k % nch].min = mn[k];
+		}
+		if ( mx[k] > b[k % nch].max ) {
+			b[k % nch].max = mx[k];
+		}
+		b[k % nch].novr += (uint16_t)ovr[k];
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+/* 8 elements per iteration; same scheme as the accumulation kernel
+ * (sampleAccum.c) but all lanes of equal parity are summed up.
+ */
+__attribute__((target("sse2")))
+static void
+blkSSE2(StatBlk b[], const void *src, int wide, unsigned nch, size_t i0, size_t nelms, int lo, int hi)
+{
+const uint8_t *p  = (const uint8_t*)src;
+__m128i        z  = _mm_setzero_si128();
+__m128i        vh = _mm_set1_epi16( (int16_t)( hi - 1 ) );
+__m128i        vl = _mm_set1_epi16( (int16_t)( lo + 1 ) );
+__m128i        vs = z, vq = z, vo = z;
+__m128i        vmn = _mm_set1_epi16( INT16_MAX );
+__m128i        vmx = _mm_set1_epi16( INT16_MIN );
+__m128i        v, l, h, q;
+int32_t        s[4];
+uint64_t       qq[2];
+int16_t        mn[8], mx[8], ovr[8];
+size_t         i;
+
+	if ( nch < 1 || nch > 2 ) {
+		blkScalar( b, src, wide, nch, i0, nelms, lo, hi );
+		return;
+	}
+	for ( i = i0; i + 8 <= nelms; i += 8 ) {
+		if ( wide ) {
+			v = _mm_loadu_si128( (const __m128i*)(p + 2*i) );
+		} else {
+			v = _mm_loadl_epi64( (const __m128i*)(p + i) );
+			v = _mm_srai_epi16( _mm_unpacklo_epi8( v, v ), 8 );
+		}
+		vmn = _mm_min_epi16( vmn, v );
+		vmx = _mm_max_epi16( vmx, v );
+		vo  = _mm_sub_epi16( vo, _mm_or_si128( _mm_cmpgt_epi16( v, vh ), _mm_cmplt_epi16( v, vl ) ) );
+		vs  = _mm_add_epi32( vs, _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 ) );
+		vs  = _mm_add_epi32( vs, _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 ) );
+		l   = _mm_mullo_epi16( v, v );
+		h   = _mm_mulhi_epi16( v, v );
+		q   = _mm_unpacklo_epi16( l, h );
+		vq  = _mm_add_epi64( vq, _mm_unpacklo_epi32( q, z ) );
+		vq  = _mm_add_epi64( vq, _mm_unpackhi_epi32( q, z ) );
+		q   = _mm_unpackhi_epi16( l, h );
+		vq  = _mm_add_epi64( vq, _mm_unpacklo_epi32( q, z ) );
+		vq  = _mm_add_epi64( vq, _mm_unpackhi_epi32( q, z ) );
+	}
+	_mm_storeu_si128( (__m128i*)s,   vs  );
+	_mm_storeu_si128( (__m128i*)qq,  vq  );
+	_mm_storeu_si128( (__m128i*)mn,  vmn );
+	_mm_storeu_si128( (__m128i*)mx,  vmx );
+	_mm_storeu_si128( (__m128i*)ovr, vo  );
+	blkFold( b, nch, s, 4, qq, 2, mn, mx, ovr, 8 );
+	blkScalar( b, src, wide, nch, i, nelms, lo, hi );
+}
+
+/* Same as blkSSE2 but 16 elements per iteration */
+__attribute__((target("avx2")))
+static void
+blkAVX2(StatBlk b[], const void *src, int wide, unsigned nch, size_t i0, size_t nelms, int lo, int hi)
+{
+const uint8_t *p  = (const uint8_t*)src;
+__m256i        z  = _mm256_setzero_si256();
+__m256i        vh = _mm256_set1_epi16( (int16_t)( hi - 1 ) );
+__m256i        vl = _mm256_set1_epi16( (int16_t)( lo + 1 ) );
+__m256i        vs = z, vq = z, vo = z;
+__m256i        vmn = _mm256_set1_epi16( INT16_MAX );
+__m256i        vmx = _mm256_set1_epi16( INT16_MIN );
+__m256i        v, l, h;
+int32_t        s[8];
+uint64_t       qq[4];
+int16_t        mn[16], mx[16], ovr[16];
+size_t         i;
+
+	if ( nch < 1 || nch > 2 ) {
+		blkScalar( b, src, wide, nch, i0, nelms, lo, hi );
+		return;
+	}
+	for ( i = i0; i + 16 <= nelms; i += 16 ) {
+		if ( wide ) {
+			v = _mm256_loadu_si256( (const __m256i*)(p + 2*i) );
+		} else {
+			v = _mm256_cvtepi8_epi16( _mm_loadu_si128( (const __m128i*)(p + i) ) );
+		}
+		vmn = _mm256_min_epi16( vmn, v );
+		vmx = _mm256_max_epi16( vmx, v );
+		vo  = _mm256_sub_epi16( vo, _mm256_or_si256( _mm256_cmpgt_epi16( v, vh ), _mm256_cmpgt_epi16( vl, v ) ) );
+		l   = _mm256_cvtepi16_epi32( _mm256_castsi256_si128( v ) );
+		h   = _mm256_cvtepi16_epi32( _mm256_extracti128_si256( v, 1 ) );
+		vs  = _mm256_add_epi32( vs, _mm256_add_epi32( l, h ) );
+		l   = _mm256_mullo_epi32( l, l );
+		h   = _mm256_mullo_epi32( h, h );
+		vq  = _mm256_add_epi64( vq, _mm256_cvtepu32_epi64( _mm256_castsi256_si128( l ) ) );
+		vq  = _mm256_add_epi64( vq, _mm256_cvtepu32_epi64( _mm256_extracti128_si256( l, 1 ) ) );
+		vq  = _mm256_add_epi64( vq, _mm256_cvtepu32_epi64( _mm256_castsi256_si128( h ) ) );
+		vq  = _mm256_add_epi64( vq, _mm256_cvtepu32_epi64( _mm256_extracti128_si256( h, 1 ) ) );
+	}
+	_mm256_storeu_si256( (__m256i*)s,   vs  );
+	_mm256_storeu_si256( (__m256i*)qq,  vq  );
+	_mm256_storeu_si256( (__m256i*)mn,  vmn );
+	_mm256_storeu_si256( (__m256i*)mx,  vmx );
+	_mm256_storeu_si256( (__m256i*)ovr, vo  );
+	blkFold( b, nch, s, 8, qq, 4, mn, mx, ovr, 16 );
+	blkScalar( b, src, wide, nch, i, nelms, lo, hi );
+}
+#endif
+
+/* Merge the block 'b' (of 'n' samples) into 'st'; 'st->var' holds
+ * the sum of squared deviations until the end.
+ */
+static void
+statsMerge(SampleStats *st, const StatBlk *b, uint64_t n)
+{
+double   m, d;
+uint64_t tot;
+
+	if ( 0 == n ) {
+		return;
+	}
+	m        = (double)b->s / (double)n;
+	d        = m - st->mean;
+	tot      = st->count + n;
+	st->mean += d * (double)n / (double)tot;
+	st->var  += (double)( n * b->q - (uint64_t)(b->s * b->s) ) / (double)n
+	          + d * d * (double)st->count * (double)n / (double)tot;
+	st->count = tot;
+	if ( b->min < st->min ) {
+		st->min = b->min;
+	}
+	if ( b->max > st->max ) {
+		st->max = b->max;
+	}
+	st->overrange += b->novr;
+}
+
+int
+sampleStats(SampleStats st[], const void *src, int wide, unsigned nch, size_t nsmpl, int ovrLo, int ovrHi)
+{
+StatBlk  b[SAMPLE_STATS_MAX_CH];
+size_t   nelms = nch * nsmpl;
+size_t   blk, off, n;
+unsigned c;
+
+	if ( nch < 1 || nch > SAMPLE_STATS_MAX_CH ) {
+		return -EINVAL;
+	}
+	if ( ovrLo < INT16_MIN - 1 ) {
+		ovrLo = INT16_MIN - 1;
+	} else if ( ovrLo > INT16_MAX - 1 ) {
+		ovrLo = INT16_MAX - 1;
+	}
+	if ( ovrHi > INT16_MAX + 1 ) {
+		ovrHi = INT16_MAX + 1;
+	} else if ( ovrHi < INT16_MIN + 1 ) {
+		ovrHi = INT16_MIN + 1;
+	}
+	for ( c = 0; c < nch; c++ ) {
+		st[c].count     = 0;
+		st[c].mean      = 0.0;
+		st[c].var       = 0.0;
+		st[c].min       = INT16_MAX;
+		st[c].max       = INT16_MIN;
+		st[c].overrange = 0;
+	}
+	blk = ( BLK_ELMS / nch ) * nch;
+	for ( off = 0; off < nelms; off += n ) {
+		n = nelms - off < blk ? nelms - off : blk;
+		for ( c = 0; c < nch; c++ ) {
+			b[c].s    = 0;
+			b[c].q    = 0;
+			b[c].min  = INT16_MAX;
+			b[c].max  = INT16_MIN;
+			b[c].novr = 0;
+		}
+		switch ( sampleConvGetKernel() ) {
+#ifdef HAVE_X86_SIMD
+			case SAMPLE_CONV_KERNEL_AVX2:
+				blkAVX2( b, (const uint8_t*)src + off * (wide ? 2 : 1), wide, nch, 0, n, ovrLo, ovrHi );
+				break;
+			case SAMPLE_CONV_KERNEL_SSE2:
+				blkSSE2( b, (const uint8_t*)src + off * (wide ? 2 : 1), wide, nch, 0, n, ovrLo, ovrHi );
+				break;
+#endif
+			default:
+				blkScalar( b, (const uint8_t*)src + off * (wide ? 2 : 1), wide, nch, 0, n, ovrLo, ovrHi );
+				break;
+		}
+		for ( c = 0; c < nch; c++ ) {
+			statsMerge( &st[c], &b[c], n / nch );
+		}
+	}
+	for ( c = 0; c < nch; c++ ) {
+		if ( 0 == st[c].count ) {
+			st[c].min = st[c].max = 0;
+			st[c].rms = 0.0;
+			continue;
+		}
+		st[c].var /= (double)st[c].count;
+		st[c].rms  = sqrt( st[c].var + st[c].mean * st[c].mean );
+	}
+	return 0;
+}
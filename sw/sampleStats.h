@@ -0,0 +1,77 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-channel statistics of an acquisition computed in a single pass
+ * over interleaved samples (sample 'i' of channel 'c' at index
+ * i*nch + c; signed 8-bit or, if 'wide' is nonzero, 16-bit in host
+ * byte order). The results are in the units of the samples.
+ *
+ * The samples are summed up exactly (integers) in blocks which are
+ * combined by the (Welford/Chan) update of mean and variance, i.e.,
+ * the results do not suffer from cancellation. The kernel (SIMD or
+ * scalar) is the one selected for the sample conversion (see
+ * sampleConv.h); the SIMD kernels handle one and two channels.
+ */
+
+#define SAMPLE_STATS_MAX_CH 16
+
+typedef struct SampleStats {
+	size_t        count;
+	double        mean;
+	double        var;       /* variance (population)                 */
+	double        rms;       /* root-mean-square (including the mean) */
+	int16_t       min;
+	int16_t       max;
+	size_t        overrange; /* samples <= ovrLo or >= ovrHi           */
+} SampleStats;
+
+/* Compute the statistics of 'nsmpl' samples of each of 'nch' channels
+ * into 'st[0..nch-1]'; samples <= 'ovrLo' or >= 'ovrHi' are counted as
+ * overrange ('ovrLo' = INT16_MIN - 1 and 'ovrHi' = INT16_MAX + 1 count
+ * nothing).
+ * RETURNS: 0 on success, -EINVAL if 'nch' is 0 or exceeds
+ *          SAMPLE_STATS_MAX_CH.
+ */
+int
+sampleStats(SampleStats st[], const void *src, int wide, unsigned nch, size_t nsmpl, int ovrLo, int ovrHi);
+
+#ifdef __cplusplus
+}
+#endif
@@ -79,12 +79,13 @@ class Buf(object):
       for m in self._mem[1:]:
         m[0::2] = self._mem[0][0::2]
 
-  def updateY(self, buf, hdr):
+  # 'stats': per-channel statistics of 'buf' (as computed by FwComm.stats)
+  def updateY(self, buf, hdr, stats):
     stride = len(self._mem)
     for idx in range(stride):
       self._mem[idx][1::2] = buf[:,idx]
-      self._mean[idx] = np.mean(buf[:,idx])
-      self._std[idx]  = np.std(buf[:,idx])
+      self._mean[idx] = stats[idx]['mean']
+      self._std[idx]  = stats[idx]['std']
     self._hdr = hdr
 
   def getCurv(self, idx):
@@ -652,7 +653,7 @@ class Reader(QtCore.QThread):
       self._readDone.acquire()
       # flip buffer
       ridx        = self.readAsync()
-      b.updateY( self._rbuf[ ridx ], self._bufhdr[ ridx ] )
+      b.updateY( self._rbuf[ ridx ], self._bufhdr[ ridx ], self._fw.stats( self._rbuf[ ridx ] ) )
       with self._lck:
         npts = self._npts
         scal = self._scal
@@ -37,6 +37,7 @@
 
 #include "fwComm.h"
 #include "scopeSup.h"
+#include "sampleStats.h"
 #include "max195xxSup.h"
 #include "unitData.h"
 
@@ -44,11 +45,8 @@ static int
 pollRead(ScopePvt *scp, uint16_t *hdr, int16_t *buf, size_t nElms)
 {
 int             st;
-struct timespec wai;
-	wai.tv_sec = 0;
-	wai.tv_nsec = 100UL*1000UL*1000UL;
-	while ( 0 == (st = buf_read_int16( scp, hdr, buf, nElms )) ) {
-		clock_nanosleep( CLOCK_REALTIME, 0, &wai, NULL );
+	if ( (st = buf_wait_triggered( scp, -1 )) > 0 ) {
+		st = buf_read_int16( scp, hdr, buf, nElms );
 	}
 	if ( st > 0 ) {
 		unsigned ch;
@@ -85,9 +83,10 @@ measure(ScopePvt *scp, size_t nSamples, int16_t *buf, double pgaAttDb, double da
 {
 unsigned nChannels = scope_get_num_channels( scp );
 size_t   nElms     = nSamples * nChannels;
-int      ch,n;
+int      ch;
 int      st;
 uint16_t bufHdr;
+SampleStats stats[SAMPLE_STATS_MAX_CH];
 
 	if ( isnan(pgaAttDb) ) {
 		pgaAttDb = 40.0;
@@ -126,13 +125,15 @@ uint16_t bufHdr;
 		goto bail;
 	}
 
+	st = buf_compute_stats( scp, stats, buf, 1, nSamples );
+	if ( st < 0 ) {
+		fprintf( stderr, "Error; buf_compute_stats() failed: %s\n", strerror(-st));
+		goto bail;
+	}
+
 	for ( ch = 0; ch < nChannels; ++ch ) {
-		double sum = 0;
-		for ( n = ch; n < nElms; n += nChannels ) {
-			sum += (double)buf[n];
-		}
 		/* not volt yet; just counts! */
-		result[ch] = sum / (double)nSamples;
+		result[ch] = stats[ch].mean;
 	}
 
 bail:
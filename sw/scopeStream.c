@@ -0,0 +1,395 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "scopeSup.h"
+#include "scopeStream.h"
+
+#define MIN_POLL_US      20
+#define DFLT_MAX_POLL_US 1000
+
+struct ScopeStream {
+	ScopePvt          *scp;
+	ScopeStreamConfig  cfg;
+	pthread_t          thread;
+	pthread_mutex_t    mtx;
+	pthread_cond_t     cnd;
+	int                stop;
+	int                hold;
+	unsigned           holdMs;
+	int                efd;
+	ScopeStreamSlot   *slots;
+	uint8_t           *mem;
+	/* free slots (stack) */
+	unsigned          *freeLst;
+	unsigned           nfree;
+	/* filled slots (fifo) */
+	unsigned          *rdyQ;
+	unsigned           rdyHd;
+	unsigned           nrdy;
+	uint64_t           seq;
+	ScopeStreamStats   stats;
+};
+
+void
+scope_stream_config_init(ScopeStreamConfig *cfg)
+{
+	memset( cfg, 0, sizeof(*cfg) );
+	cfg->nslots    = 4;
+	cfg->maxPollUs = DFLT_MAX_POLL_US;
+}
+
+static void
+usleepFor(unsigned us)
+{
+struct timespec t;
+	t.tv_sec  = us / 1000000;
+	t.tv_nsec = (us % 1000000) * 1000;
+	clock_nanosleep( CLOCK_MONOTONIC, 0, &t, NULL );
+}
+
+static int
+readSlot(ScopeStream *s, ScopeStreamSlot *slot)
+{
+int st;
+	if ( s->cfg.fwMtx ) {
+		pthread_mutex_lock( s->cfg.fwMtx );
+	}
+	if ( s->hold ) {
+		/* a single request which the firmware holds until the
+		 * acquisition completes (or its own timeout expires)
+		 */
+		st = buf_read_wait( s->scp, &slot->hdr, slot->buf, s->cfg.slotSize, s->holdMs );
+	} else {
+		st = buf_read( s->scp, &slot->hdr, slot->buf, s->cfg.slotSize );
+	}
+	if ( s->cfg.fwMtx ) {
+		pthread_mutex_unlock( s->cfg.fwMtx );
+	}
+	return st;
+}
+
+/* must hold the lock */
+static void
+releaseSlot(ScopeStream *s, unsigned idx)
+{
+	s->freeLst[ s->nfree++ ] = idx;
+	pthread_cond_broadcast( &s->cnd );
+}
+
+/* must hold the lock; the eventfd is readable while nrdy > 0 */
+static void
+setReady(ScopeStream *s, unsigned nrdy)
+{
+uint64_t v = 1;
+	if ( ( 0 == s->nrdy ) != ( 0 == nrdy ) ) {
+		if ( nrdy ) {
+			if ( write( s->efd, &v, sizeof(v) ) < 0 ) {
+				/* counter cannot overflow; nothing to do */
+			}
+		} else {
+			if ( read( s->efd, &v, sizeof(v) ) < 0 ) {
+				/* already clear */
+			}
+		}
+	}
+	s->nrdy = nrdy;
+}
+
+static void *
+readerThread(void *arg)
+{
+ScopeStream     *s = (ScopeStream*)arg;
+ScopeStreamSlot *slot;
+unsigned         idx;
+unsigned         pollUs;
+int              st;
+
+	for ( ;; ) {
+		pthread_mutex_lock( &s->mtx );
+		if ( ! s->stop && 0 == s->nfree && 0 == s->nrdy ) {
+			/* all slots held by consumers */
+			s->stats.stalls++;
+			while ( ! s->stop && 0 == s->nfree && 0 == s->nrdy ) {
+				pthread_cond_wait( &s->cnd, &s->mtx );
+			}
+		}
+		if ( s->stop ) {
+			pthread_mutex_unlock( &s->mtx );
+			break;
+		}
+		if ( s->nfree ) {
+			idx = s->freeLst[ --s->nfree ];
+		} else {
+			/* recycle the oldest unconsumed acquisition */
+			idx      = s->rdyQ[ s->rdyHd ];
+			s->rdyHd = ( s->rdyHd + 1 ) % s->cfg.nslots;
+			setReady( s, s->nrdy - 1 );
+			s->stats.overruns++;
+		}
+		pthread_mutex_unlock( &s->mtx );
+
+		slot   = &s->slots[idx];
+		pollUs = MIN_POLL_US;
+		/* reading a buffer re-arms the trigger */
+		while ( 0 == (st = readSlot( s, slot )) ) {
+			if ( __atomic_load_n( &s->stop, __ATOMIC_RELAXED ) ) {
+				break;
+			}
+			pthread_mutex_lock( &s->mtx );
+			s->stats.polls++;
+			pthread_mutex_unlock( &s->mtx );
+			if ( s->hold ) {
+				/* the device was busy for the entire hold time; let
+				 * other users of 'fwMtx' in before the next request
+				 * (the mutex is not fair)
+				 */
+				if ( s->cfg.fwMtx ) {
+					usleepFor( MIN_POLL_US );
+				}
+				continue;
+			}
+			usleepFor( pollUs );
+			if ( (pollUs <<= 1) > s->cfg.maxPollUs ) {
+				pollUs = s->cfg.maxPollUs;
+			}
+		}
+
+		if ( st < 0 ) {
+			pthread_mutex_lock( &s->mtx );
+			s->stats.errors++;
+			s->stats.lastError = st;
+			releaseSlot( s, idx );
+			pthread_mutex_unlock( &s->mtx );
+			usleepFor( s->cfg.maxPollUs );
+			continue;
+		}
+		if ( 0 == st ) {
+			/* stopped */
+			pthread_mutex_lock( &s->mtx );
+			releaseSlot( s, idx );
+			pthread_mutex_unlock( &s->mtx );
+			continue;
+		}
+
+		slot->len = st;
+		slot->seq = s->seq++;
+		clock_gettime( CLOCK_MONOTONIC, &slot->stamp );
+
+		if ( s->cfg.callback ) {
+			s->cfg.callback( s->cfg.closure, slot );
+		}
+
+		pthread_mutex_lock( &s->mtx );
+		s->stats.acquisitions++;
+		if ( s->cfg.callback ) {
+			releaseSlot( s, idx );
+		} else {
+			s->rdyQ[ (s->rdyHd + s->nrdy) % s->cfg.nslots ] = idx;
+			setReady( s, s->nrdy + 1 );
+			pthread_cond_broadcast( &s->cnd );
+		}
+		pthread_mutex_unlock( &s->mtx );
+	}
+	return NULL;
+}
+
+ScopeStream *
+scope_stream_start(ScopePvt *scp, const ScopeStreamConfig *cfg)
+{
+ScopeStream        *s = NULL;
+pthread_condattr_t  ca;
+unsigned            i;
+int                 elsz;
+int                 st;
+
+	if ( ! scp || ! cfg || cfg->nslots < 2 ) {
+		fprintf(stderr, "scope_stream_start: invalid arguments\n");
+		return NULL;
+	}
+
+	if ( ! (s = calloc( 1, sizeof(*s) )) ) {
+		perror("scope_stream_start(): no memory");
+		return NULL;
+	}
+	s->scp  = scp;
+	s->cfg  = *cfg;
+	s->holdMs = buf_get_wait_hold_ms( scp );
+	s->hold   = ( s->holdMs > 0 );
+	if ( (s->efd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC )) < 0 ) {
+		perror("scope_stream_start(): unable to create eventfd");
+		free( s );
+		return NULL;
+	}
+	if ( 0 == s->cfg.slotSize ) {
+		elsz             = (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 2 : 1;
+		s->cfg.slotSize  = buf_get_size( scp ) * scope_get_num_channels( scp ) * elsz;
+	}
+	if ( 0 == s->cfg.maxPollUs ) {
+		s->cfg.maxPollUs = DFLT_MAX_POLL_US;
+	}
+
+	s->slots   = calloc( s->cfg.nslots, sizeof(*s->slots) );
+	s->freeLst = calloc( s->cfg.nslots, sizeof(*s->freeLst) );
+	s->rdyQ    = calloc( s->cfg.nslots, sizeof(*s->rdyQ) );
+	if ( ! s->slots || ! s->freeLst || ! s->rdyQ
+	     || posix_memalign( (void**)&s->mem, 64, s->cfg.nslots * s->cfg.slotSize ) ) {
+		perror("scope_stream_start(): no memory");
+		goto bail;
+	}
+	for ( i = 0; i < s->cfg.nslots; ++i ) {
+		s->slots[i].buf = s->mem + i * s->cfg.slotSize;
+		s->freeLst[i]   = s->cfg.nslots - 1 - i;
+	}
+	s->nfree = s->cfg.nslots;
+
+	pthread_mutex_init( &s->mtx, NULL );
+	pthread_condattr_init( &ca );
+	pthread_condattr_setclock( &ca, CLOCK_MONOTONIC );
+	pthread_cond_init( &s->cnd, &ca );
+	pthread_condattr_destroy( &ca );
+
+	/* discard a stale acquisition */
+	if ( s->cfg.fwMtx ) {
+		pthread_mutex_lock( s->cfg.fwMtx );
+	}
+	st = buf_flush( scp );
+	if ( s->cfg.fwMtx ) {
+		pthread_mutex_unlock( s->cfg.fwMtx );
+	}
+	if ( st < 0 ) {
+		fprintf(stderr, "scope_stream_start: flushing buffer failed: %s\n", strerror( -st ));
+		goto bail_sync;
+	}
+
+	if ( (st = pthread_create( &s->thread, NULL, readerThread, s )) ) {
+		fprintf(stderr, "scope_stream_start: unable to create thread: %s\n", strerror( st ));
+		goto bail_sync;
+	}
+	return s;
+
+bail_sync:
+	pthread_cond_destroy( &s->cnd );
+	pthread_mutex_destroy( &s->mtx );
+bail:
+	free( s->mem );
+	free( s->rdyQ );
+	free( s->freeLst );
+	free( s->slots );
+	close( s->efd );
+	free( s );
+	return NULL;
+}
+
+int
+scope_stream_stop(ScopeStream *s)
+{
+int st;
+	if ( ! s ) {
+		return 0;
+	}
+	pthread_mutex_lock( &s->mtx );
+	__atomic_store_n( &s->stop, 1, __ATOMIC_RELAXED );
+	pthread_cond_broadcast( &s->cnd );
+	pthread_mutex_unlock( &s->mtx );
+	pthread_join( s->thread, NULL );
+
+	st = s->stats.lastError;
+	pthread_cond_destroy( &s->cnd );
+	pthread_mutex_destroy( &s->mtx );
+	free( s->mem );
+	free( s->rdyQ );
+	free( s->freeLst );
+	free( s->slots );
+	close( s->efd );
+	free( s );
+	return st;
+}
+
+int
+scope_stream_get(ScopeStream *s, ScopeStreamSlot **pslot, int timeoutMs)
+{
+struct timespec abst;
+int             st = 0;
+
+	if ( s->cfg.callback ) {
+		return -EINVAL;
+	}
+	if ( timeoutMs >= 0 ) {
+		clock_gettime( CLOCK_MONOTONIC, &abst );
+		abst.tv_sec  += timeoutMs / 1000;
+		abst.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+		if ( abst.tv_nsec >= 1000000000L ) {
+			abst.tv_nsec -= 1000000000L;
+			abst.tv_sec++;
+		}
+	}
+	pthread_mutex_lock( &s->mtx );
+	while ( 0 == s->nrdy ) {
+		if ( timeoutMs < 0 ) {
+			pthread_cond_wait( &s->cnd, &s->mtx );
+		} else if ( ETIMEDOUT == pthread_cond_timedwait( &s->cnd, &s->mtx, &abst ) ) {
+			if ( 0 == s->nrdy ) {
+				st = -ETIMEDOUT;
+				goto bail;
+			}
+		}
+	}
+	*pslot   = &s->slots[ s->rdyQ[ s->rdyHd ] ];
+	s->rdyHd = ( s->rdyHd + 1 ) % s->cfg.nslots;
+	setReady( s, s->nrdy - 1 );
+bail:
+	pthread_mutex_unlock( &s->mtx );
+	return st;
+}
+
+void
+scope_stream_put(ScopeStream *s, ScopeStreamSlot *slot)
+{
+	pthread_mutex_lock( &s->mtx );
+	releaseSlot( s, slot - s->slots );
+	pthread_mutex_unlock( &s->mtx );
+}
+
+int
+scope_stream_get_fd(ScopeStream *s)
+{
+	return s->cfg.callback ? -EINVAL : s->efd;
+}
+
+void
+scope_stream_get_stats(ScopeStream *s, ScopeStreamStats *stats)
+{
+	pthread_mutex_lock( &s->mtx );
+	*stats = s->stats;
+	pthread_mutex_unlock( &s->mtx );
+}
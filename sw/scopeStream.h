@@ -0,0 +1,130 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Continuous acquisition: a reader thread reads every completed
+ * buffer (which also re-arms the trigger) into a ring of
+ * preallocated slots; consumers obtain filled slots either by
+ * means of a callback (executed by the reader thread) or with
+ * scope_stream_get()/scope_stream_put().
+ *
+ * If no free slot is available then the oldest filled slot which
+ * has not been handed to a consumer yet is recycled (and counted as
+ * an overrun). The reader stalls only if all slots are held by
+ * consumers.
+ */
+
+typedef struct ScopePvt    ScopePvt;
+typedef struct ScopeStream ScopeStream;
+
+typedef struct ScopeStreamSlot {
+	uint8_t         *buf;
+	int              len;   /* bytes read (see buf_read())                 */
+	uint16_t         hdr;   /* buffer header (see buf_read())              */
+	uint64_t         seq;   /* acquisition number (counted by the reader)  */
+	struct timespec  stamp; /* CLOCK_MONOTONIC time of readout completion  */
+} ScopeStreamSlot;
+
+/* The slot is recycled when the callback returns */
+typedef void (*ScopeStreamCallback)(void *closure, const ScopeStreamSlot *slot);
+
+typedef struct ScopeStreamConfig {
+	unsigned             nslots;    /* ring size (>= 2)                                */
+	size_t               slotSize;  /* bytes; 0: size of a full buffer                 */
+	unsigned             maxPollUs; /* max. back-off while no data are ready; 0: 1000
+	                                 * (unused if the firmware holds the reply until
+	                                 * the acquisition completes; FW_BUF_FLG_WAIT)     */
+	ScopeStreamCallback  callback;  /* optional                                        */
+	void                *closure;
+	/* optional; held while the reader thread accesses the device (up to
+	 * buf_get_wait_hold_ms() per request if the firmware holds the reply);
+	 * other threads using the device must hold it as well
+	 */
+	pthread_mutex_t     *fwMtx;
+} ScopeStreamConfig;
+
+typedef struct ScopeStreamStats {
+	uint64_t         acquisitions; /* buffers read                             */
+	uint64_t         overruns;     /* filled slots recycled before consumption */
+	uint64_t         stalls;       /* reader waited for a slot                 */
+	uint64_t         polls;        /* reads which found no data                */
+	uint64_t         errors;       /* failed reads                             */
+	int              lastError;
+} ScopeStreamStats;
+
+void
+scope_stream_config_init(ScopeStreamConfig *cfg);
+
+/* Flush the device buffer and start the reader thread.
+ * RETURNS: stream handle or NULL (error message printed).
+ */
+ScopeStream *
+scope_stream_start(ScopePvt *scp, const ScopeStreamConfig *cfg);
+
+/* Stop the reader thread and release all resources; slots obtained
+ * with scope_stream_get() must not be used after this returns.
+ * RETURNS: last error encountered by the reader (0 if none).
+ */
+int
+scope_stream_stop(ScopeStream *stream);
+
+/* Obtain the oldest filled slot; 'timeoutMs' < 0 waits forever.
+ * Not available if a callback is used.
+ * RETURNS: 0, -ETIMEDOUT, -EINVAL (callback mode).
+ */
+int
+scope_stream_get(ScopeStream *stream, ScopeStreamSlot **pslot, int timeoutMs);
+
+/* Return a slot obtained with scope_stream_get() */
+void
+scope_stream_put(ScopeStream *stream, ScopeStreamSlot *slot);
+
+/* File descriptor (eventfd) which is readable while filled slots
+ * are available; for use with poll/select/epoll - the descriptor
+ * must not be read or closed by the caller. Obtain the slots with
+ * scope_stream_get( stream, &slot, 0 ).
+ * Not available if a callback is used.
+ * RETURNS: descriptor or -EINVAL (callback mode).
+ */
+int
+scope_stream_get_fd(ScopeStream *stream);
+
+void
+scope_stream_get_stats(ScopeStream *stream, ScopeStreamStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
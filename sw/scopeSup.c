@@ -38,22 +38,29 @@
 #include "tca6408FECSup.h"
 #include "lmh6882Sup.h"
 #include "ad8370Sup.h"
+#include "sampleConv.h"
+#include "sampleStats.h"
 
 
 #include <math.h>
 #include <time.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define FW_BUF_FLG_GET_SMPLSZ(flags) ( ( (flags) & FW_BUF_FLG_16B ) ? 9 + ( ( (flags) >> 1 ) & 7 ) : 8 )
+/* hold time of firmware which supports FW_BUF_FLG_WAIT but does not report it */
+#define BUF_WAIT_HOLD_DFLT_MS 100
 
 #define BITS_FW_CMD_ACQ_MSK_SRC  7
 #define BITS_FW_CMD_ACQ_SHF_SRC  0
 #define BITS_FW_CMD_ACQ_SHF_EDG  3
 #define BITS_FW_CMD_ACQ_SHF_TGO  4
+#define BITS_FW_CMD_ACQ_SHF_DBL  5
 
 #define BITS_FW_CMD_ACQ_IDX_MSK     0
 #define BITS_FW_CMD_ACQ_LEN_MSK_V1  sizeof(uint8_t)
@@ -68,9 +75,15 @@
 #define BITS_FW_CMD_ACQ_LEN_DCM     3
 #define BITS_FW_CMD_ACQ_LEN_SCL     4
 #define BITS_FW_CMD_ACQ_LEN_HYS     2
+#define BITS_FW_CMD_ACQ_LEN_SEG     2
+#define BITS_FW_CMD_ACQ_LEN_AVG     2
 
 #define BITS_FW_CMD_ACQ_TOT_LEN_V1 15
 #define BITS_FW_CMD_ACQ_TOT_LEN_V2 24
+/* V2 + number of segments (FW_BUF_FLG_SEG) */
+#define BITS_FW_CMD_ACQ_TOT_LEN_V3 26
+/* V3 + number of averaged acquisitions (FW_BUF_FLG_AVG) */
+#define BITS_FW_CMD_ACQ_TOT_LEN_V4 28
 
 #define BITS_FW_CMD_ACQ_DCM0_SHFT 20
 
@@ -93,8 +106,80 @@ typedef struct ScopePvt {
 	FECOps         *fec;
 	const UnitData *unitData;
 	DACData         dacData;
+	/* authoritative copy of the device settings (see scope_get_params());
+	 * fields with a 'stale' bit set must be re-read from the hardware
+	 */
+	ScopeParams    *parms;
+	unsigned        parmsStale;
+	unsigned       *afeStale;
+	/* acquisition retrieved by buf_wait_triggered() but not yet
+	 * consumed by a buf_read variant ('pendLen' == 0 if none)
+	 */
+	uint8_t        *pendBuf;
+	size_t          pendCap;
+	size_t          pendLen;
+	uint16_t        pendHdr;
+	/* header of the data most recently transferred (byte order) */
+	uint16_t        rdHdr;
+	/* extended header of the last acquisition read */
+	int             xhdrEna;
+	int             xhdrVld;
+	BufHdrExt       xhdr;
+	/* packed transfer; 'packBuf' receives the packed samples */
+	int             packEna;
+	uint8_t        *packBuf;
+	size_t          packCap;
+	/* raw samples for buf_read_volts_xxx(), buf_read_range() */
+	uint8_t        *convBuf;
+	size_t          convCap;
 } ScopePvt;
 
+/* 'parmsStale' bits */
+#define PARM_CLKOUT    (1<<0)
+#define PARM_ALL       (PARM_CLKOUT)
+
+/* 'afeStale' bits (per channel) */
+#define AFE_FULSCL     (1<<0)
+#define AFE_CURSCL     (1<<1)
+#define AFE_PGOFF      (1<<2)
+#define AFE_PGA_ATT    (1<<3)
+#define AFE_FEC_ATT    (1<<4)
+#define AFE_FEC_TERM   (1<<5)
+#define AFE_FEC_CPLING (1<<6)
+#define AFE_DAC_VOLT   (1<<7)
+#define AFE_DAC_RNG    (1<<8)
+#define AFE_ALL        ((1<<9) - 1)
+
+/* Mark cached parameters stale; channel < 0 selects all channels */
+static void
+parmsStale(ScopePvt *scp, int channel, unsigned afeMsk, unsigned msk)
+{
+unsigned ch;
+	scp->parmsStale |= msk;
+	if ( ! scp->afeStale ) {
+		return;
+	}
+	for ( ch = 0; ch < scp->numChannels; ++ch ) {
+		if ( channel < 0 || (unsigned)channel == ch ) {
+			scp->afeStale[ch] |= afeMsk;
+		}
+	}
+}
+
+/* Clear stale bits after a value was written to the hardware; the caller
+ * stores the applied value in the returned cache entry (if not NULL).
+ * Fields which the hardware may round or clamp remain stale.
+ */
+static AFEParams *
+parmsApplied(ScopePvt *scp, unsigned channel, unsigned afeMsk)
+{
+	if ( ! scp->afeStale || channel >= scp->numChannels ) {
+		return NULL;
+	}
+	scp->afeStale[channel] &= ~afeMsk;
+	return &scp->parms->afeParams[channel];
+}
+
 
 typedef struct ClkOutConfig {
 	int              outIdx;
@@ -352,6 +437,7 @@ int      st;
 	if ( nelms > scope_get_num_channels( scp ) ) {
 		return -EINVAL;
 	}
+	parmsStale( scp, -1, AFE_ALL, 0 );
 	for ( ch = 0; ch < scope_get_num_channels( scp ); ++ch ) {
 		/* offset is applied by the DAC; make sure the new
 		 * setting is propagated.
@@ -683,6 +769,7 @@ int
 scope_is_initialized(FWInfo *fw)
 {
 	uint8_t reg,tst;
+	reg_vec vec[2];
 	int st = fw_reg_read( fw, FW_USR_CSR_OFF, &reg, 1, REG_FLG_APP );
 	if ( 0 > st ) {
 		printf("scope_is_initialized: unable to read USR_CSR_OFF, fallback to is_dll_locked\n");
@@ -698,18 +785,22 @@ scope_is_initialized(FWInfo *fw)
 	st = fw_reg_write( fw, FW_USR_CSR_OFF, &tst, 1, REG_FLG_APP );
 	tst = reg;
 	if ( 0 <= st ) {
-		if ( 0 > (st = fw_reg_read( fw, FW_USR_CSR_OFF, &tst, 1, REG_FLG_APP)) ) {
-			fprintf(stderr, "FATAL ERROR: Reading USR CSR for a second time failed (%d); POWER_CYCLE RECOMMENDED.\n", st);
+		/* read back and restore in a single transfer */
+		vec[0].addr  = FW_USR_CSR_OFF;
+		vec[0].tbuf  = NULL;
+		vec[0].rbuf  = &tst;
+		vec[0].len   = 1;
+		vec[0].flags = REG_FLG_APP;
+		vec[1]       = vec[0];
+		vec[1].tbuf  = &reg;
+		vec[1].rbuf  = NULL;
+		if ( 0 > (st = fw_reg_xfer_vec( fw, vec, sizeof(vec)/sizeof(vec[0]) )) ) {
+			fprintf(stderr, "FATAL ERROR: Reading back/restoring USR CSR failed (%d); POWER_CYCLE RECOMMENDED.\n", st);
 			/* best effort to restore */
 			fw_reg_write( fw, FW_USR_CSR_OFF, &reg, 1, REG_FLG_APP );
 			abort();
 		}
 		if ( FW_USR_CSR_INIT_FLAG == (( (tst ^ reg) & FW_USR_CSR_INIT_FLAG) ) )  {
-			/* appears to be writable; restore */
-			if ( 0 > (st = fw_reg_write( fw, FW_USR_CSR_OFF, &reg, 1, REG_FLG_APP)) ) {
-				fprintf(stderr, "FATAL ERROR: Reading USR CSR for a second time failed (POWER_CYCLE RECOMMENDED).\n");
-				abort();
-			}
 			printf("scope_is_initialized: INIT_FLAG could be changed, tst 0x%02x, reg 0x%02x\n", tst, reg);
 			return !! (reg & FW_USR_CSR_INIT_FLAG);
 		}
@@ -745,6 +836,9 @@ unsigned boardVers = fw_get_board_version( scp->fw );
 	if ( ! force && scope_is_initialized( scp->fw ) ) {
 		return 0;
 	}
+	/* peripherals may be reset/power-cycled during initialization */
+	fw_shadow_invalidate( scp->fw, FW_SHADOW_ALL, FW_SHADOW_ALL );
+	parmsStale( scp, -1, AFE_ALL, PARM_ALL );
 	if ( (st = boardClkInit( scp )) ) {
 		return st;
 	}
@@ -793,10 +887,15 @@ scope_get_post_gain_offset_tick(ScopePvt *scp, unsigned channel, double *pVal)
 int
 scope_set_full_scale_volt(ScopePvt *scp, unsigned channel, double fullScaleVolt)
 {
+AFEParams *afe;
 	if ( channel >= scope_get_num_channels( scp ) ) {
 		return -EINVAL;
 	}
+	parmsStale( scp, channel, AFE_CURSCL, 0 );
 	scp->calData[channel].fullScaleVolt = fullScaleVolt;
+	if ( (afe = parmsApplied( scp, channel, AFE_FULSCL )) ) {
+		afe->fullScaleVolt = fullScaleVolt;
+	}
 	return 0;
 }
 
@@ -929,6 +1028,8 @@ int       wasInitialized;
 	}
 	sc->sampleSize     = -ENOTSUP;
 	sc->numChannels    = 2;
+	sc->xhdrEna        = !! (sc->memFlags & FW_BUF_FLG_XHDR);
+	sc->packEna        = !! (sc->memFlags & FW_BUF_FLG_PACK);
 
 	sc->calData        = calloc( sizeof(*sc->calData), sc->numChannels );
 	if ( ! sc->calData ) {
@@ -940,6 +1041,8 @@ int       wasInitialized;
 
 	sc->sampleSize = (sc->memFlags & FW_BUF_FLG_16B) ? 10 : 8;
 
+	sc->parmsStale = PARM_ALL;
+
 	if ( fw_get_api_version( fw ) >= FW_API_VERSION_3 ) {
 		if ( (st = __fw_get_sampling_freq_mhz( fw )) <= 0 ) {
 			fprintf(stderr, "Error %d: unable to read sample frequency\n", st);
@@ -955,6 +1058,12 @@ int       wasInitialized;
 		}
 	}
 
+	if ( ! (sc->parms = scope_alloc_params( sc )) || ! (sc->afeStale = calloc( sizeof(*sc->afeStale), sc->numChannels )) ) {
+		perror("scope_open(): no memory");
+		goto bail;
+	}
+	parmsStale( sc, -1, AFE_ALL, PARM_ALL );
+
 	/* If firmware implements adc pll status reg then that's a better
 	 * indicator than the MAX DLL lock.
 	 */
@@ -966,6 +1075,10 @@ int       wasInitialized;
 		}
 	}
 
+	/* status registers of the board peripherals must not be cached */
+	versaClkInit( fw );
+	dac47cxInit( fw );
+
 	switch ( boardVersion ) {
 		case 0:
 			sc->pga            = &lmh6882PGAOps;
@@ -1074,6 +1187,11 @@ scope_close(ScopePvt *scp)
 	if ( scp ) {
 		unitDataFree( scp->unitData );
 		fecClose( scp );
+		scope_free_params( scp->parms );
+		free( scp->afeStale );
+		free( scp->pendBuf );
+		free( scp->convBuf );
+		free( scp->packBuf );
 		free( scp->calData );
 		free( scp );
 	}
@@ -1097,6 +1215,17 @@ buf_get_flags(ScopePvt *scp)
 	return scp->memFlags;
 }
 
+unsigned
+buf_get_wait_hold_ms(ScopePvt *scp)
+{
+unsigned ms;
+	if ( ! (buf_get_flags( scp ) & FW_BUF_FLG_WAIT) ) {
+		return 0;
+	}
+	ms = ( (buf_get_flags( scp ) & FW_BUF_FLG_HOLD_MSK) >> FW_BUF_FLG_HOLD_SHFT ) * FW_BUF_WAIT_HOLD_UNIT_MS;
+	return ms ? ms : BUF_WAIT_HOLD_DFLT_MS;
+}
+
 double
 buf_get_sampling_freq(ScopePvt *scp)
 {
@@ -1121,38 +1250,119 @@ buf_get_full_scale_ticks(ScopePvt *scp)
 	return (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 32767 : 127;
 }
 
-int
-buf_read(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len)
-{
-uint8_t h[2];
-rbufvec v[2];
-size_t  rcnt;
-int     rv;
-int     i;
-const union {
-	uint8_t  b[2];
-	uint16_t s;
-} isLE = { s : 1 };
+/* range-read parameters: offset, count, bucket size, options */
+#define BUF_RANGE_PAR_LEN    16
+#define BUF_RANGE_OPT_XHDR   (1<<0)
+#define BUF_RANGE_OPT_PACK   (1<<1)
+/* sequence number (16-bit), trigger timestamp (48-bit) */
+#define BUF_XHDR_LEN          8
+
+/* 'par' ('plen' octets) are sent along with the command */
+static int
+bufXfer(ScopePvt *scp, FWCmd fwCmd, const uint8_t *par, size_t plen, uint16_t *hdr, uint8_t *buf, size_t len)
+{
+uint8_t   h[2];
+uint8_t   x[BUF_XHDR_LEN];
+uint8_t   xpar[BUF_RANGE_PAR_LEN];
+rbufvec   v[3];
+tbufvec   t[1];
+size_t    rcnt;
+int       xhdr = 0;
+int       bits = scp->sampleSize;
+size_t    nwrd = len / 2;
+size_t    plsz = 0;
+uint32_t  bkt  = 0;
+uint8_t   opts = 0;
+uint8_t  *nb;
+int       i;
+int       rv;
+
+	scp->xhdrVld = 0;
+	scp->rdHdr   = 0;
+
+	if ( FW_CMD_ADC_FLUSH != fwCmd && len > 0 ) {
+		if ( scp->xhdrEna ) {
+			opts |= BUF_RANGE_OPT_XHDR;
+		}
+		/* min/max (bucket size > 1) are not packed */
+		for ( i = 11; i >= 8 && i < (int)plen; i-- ) {
+			bkt = (bkt << 8) | par[i];
+		}
+		/* averaged data (32-bit sums) are not packed either */
+		if ( scp->packEna && nwrd > 0 && bits > 8 && bits < 16 && bkt < 2 && scp->acqParams.naverage < 2 ) {
+			plsz = ( nwrd * bits + 7 ) / 8;
+			if ( scp->packCap < plsz ) {
+				if ( ! (nb = realloc( scp->packBuf, plsz )) ) {
+					return -ENOMEM;
+				}
+				scp->packBuf = nb;
+				scp->packCap = plsz;
+			}
+			opts |= BUF_RANGE_OPT_PACK;
+		}
+	}
+
+	if ( opts ) {
+		/* the options of the range read; zero offset and count
+		 * cover the entire acquisition and a bucket size < 2 does
+		 * not reduce.
+		 */
+		memset( xpar, 0, sizeof(xpar) );
+		if ( plen ) {
+			memcpy( xpar, par, plen );
+		}
+		xpar[12] = opts;
+		par      = xpar;
+		plen     = sizeof(xpar);
+		if ( FW_CMD_ADC_BUF == fwCmd ) {
+			fwCmd = FW_CMD_ADC_BUF_RANGE;
+		} else if ( FW_CMD_ADC_BUF_WAIT == fwCmd ) {
+			fwCmd = FW_CMD_ADC_BUF_RANGE_WAIT;
+		}
+		xhdr = !! (opts & BUF_RANGE_OPT_XHDR);
+	}
 
 	v[0].buf = h;
 	v[0].len = sizeof(h);
-	v[1].buf = buf;
-	v[1].len = len;
+	v[1].buf = x;
+	v[1].len = sizeof(x);
+	/* data follow the extended header, if any */
+	v[1 + xhdr].buf = plsz ? scp->packBuf : buf;
+	v[1 + xhdr].len = plsz ? plsz         : len;
+	t[0].buf = par;
+	t[0].len = plen;
 
-	rcnt = (! hdr && 0 == len ? 0 : 2);
+	rcnt = (! hdr && 0 == len ? 0 : 2 + xhdr);
 
-	uint8_t cmd = fw_get_cmd( scp->fw, 0 == len ? FW_CMD_ADC_FLUSH : FW_CMD_ADC_BUF );
-	rv = fw_xfer_vec( scp->fw, cmd, 0, 0, v, rcnt );
+	rv = fw_xfer_vec( scp->fw, fw_get_cmd( scp->fw, fwCmd ), t, plen ? 1 : 0, v, rcnt );
+	if ( rv >= 2 ) {
+		scp->rdHdr = (h[1]<<8) | h[0];
+	}
 	if ( hdr ) {
 		*hdr = (h[1]<<8) | h[0];
 	}
-	if ( ! isLE.b[0] && !! (buf_get_flags(scp) & FW_BUF_FLG_16B) ) {
-		for ( i = 0; i < (len & ~1); i+=2 ) {
-			uint8_t tmp = buf[i];
-			buf[i  ] = buf[i+1];
-			buf[i+1] = tmp;
+	if ( xhdr && rv >= 2 ) {
+		if ( rv >= 2 + (int)sizeof(x) ) {
+			scp->xhdr.seq    = x[0] | (x[1] << 8);
+			scp->xhdr.tstamp = 0;
+			for ( i = sizeof(x) - 1; i >= 2; i-- ) {
+				scp->xhdr.tstamp = (scp->xhdr.tstamp << 8) | x[i];
+			}
+			scp->xhdrVld     = 1;
+			rv -= sizeof(x);
+		} else {
+			/* header only; no data */
+			rv  = 2;
 		}
 	}
+	if ( plsz && rv > 2 ) {
+		/* expand to 16-bit words; the last octet may be padding */
+		if ( (size_t)(rv - 2) * 8 / bits < nwrd ) {
+			nwrd = (size_t)(rv - 2) * 8 / bits;
+		}
+		sampleUnpack( buf, scp->packBuf, bits, nwrd );
+		rv = 2 + 2 * nwrd;
+	}
 	if ( rv >= 2 ) {
 		rv -= 2;
 	}
@@ -1160,161 +1370,840 @@ const union {
 }
 
 int
-buf_read_flt(ScopePvt *scp, uint16_t *hdr, float *buf, size_t nelms)
+buf_set_ext_header(ScopePvt *scp, int enable)
 {
-int       rv;
-ssize_t   i;
-int8_t   *i8_p  = (int8_t*)buf;
-int16_t  *i16_p = (int16_t*)buf;
-int       elsz  = ( (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 2 : 1 );
+	if ( enable && ! (buf_get_flags( scp ) & FW_BUF_FLG_XHDR) ) {
+		return -ENOTSUP;
+	}
+	scp->xhdrEna = !! enable;
+	return 0;
+}
 
+int
+buf_set_packed(ScopePvt *scp, int enable)
+{
+	if ( enable && ! (buf_get_flags( scp ) & FW_BUF_FLG_PACK) ) {
+		return -ENOTSUP;
+	}
+	scp->packEna = !! enable;
+	return 0;
+}
 
-	rv = buf_read( scp, hdr, (uint8_t*)buf, nelms*elsz );
-	if ( rv > 0 ) {
-		if ( 2 == elsz ) {
-			for ( i = nelms - 1; i >= 0; i-- ) {
-				buf[i] = (float)(i16_p[i]);
-			}
-		} else {
-			for ( i = nelms - 1; i >= 0; i-- ) {
-				buf[i] = (float)(i8_p[i]);
-			}
+int
+buf_get_ext_header(ScopePvt *scp, BufHdrExt *xhdr)
+{
+	if ( ! scp->xhdrVld ) {
+		return -ENODATA;
+	}
+	*xhdr = scp->xhdr;
+	return 0;
+}
+
+/* Bytes per sample and channel of the data as transferred */
+static size_t
+bufSmplSize(ScopePvt *scp)
+{
+	if ( scp->acqParams.naverage > 1 ) {
+		/* sums */
+		return sizeof(int32_t);
+	}
+	return (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 2 : 1;
+}
+
+/* Scale factor converting a sum of averaged samples into an
+ * ordinary (i.e., left-adjusted if 16-bit) sample
+ */
+static double
+bufAvgScale(ScopePvt *scp)
+{
+double scl = 1.0/(double)scp->acqParams.naverage;
+
+	if ( (buf_get_flags( scp ) & FW_BUF_FLG_16B) ) {
+		scl *= (double)(1 << (16 - scp->sampleSize));
+	}
+	return scl;
+}
+
+/* the layout of the data is identified by 'scp->rdHdr' */
+static void
+bufSwap(ScopePvt *scp, uint8_t *buf, size_t len)
+{
+size_t  i;
+uint8_t tmp;
+const union {
+	uint8_t  b[2];
+	uint16_t s;
+} isLE = { .s = 1 };
+
+	if ( isLE.b[0] ) {
+		return;
+	}
+	if ( (scp->rdHdr & FW_BUF_HDR_FLG_AVG) ) {
+		for ( i = 0; i < (len & ~3); i+=4 ) {
+			tmp      = buf[i  ];
+			buf[i  ] = buf[i+3];
+			buf[i+3] = tmp;
+			tmp      = buf[i+1];
+			buf[i+1] = buf[i+2];
+			buf[i+2] = tmp;
+		}
+	} else if ( !! (buf_get_flags(scp) & FW_BUF_FLG_16B) ) {
+		for ( i = 0; i < (len & ~1); i+=2 ) {
+			tmp      = buf[i];
+			buf[i  ] = buf[i+1];
+			buf[i+1] = tmp;
 		}
 	}
-	return rv;
 }
 
-int
-buf_read_int16(ScopePvt *scp, uint16_t *hdr, int16_t *buf, size_t nelms)
+/* Hand out an acquisition retrieved by buf_wait_triggered() */
+static int
+bufTakePending(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len)
 {
-int       rv;
-ssize_t   i;
-int8_t   *i8_p  = (int8_t*)buf;
-int       elsz  = ( (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 2 : 1 );
+size_t n = scp->pendLen < len ? scp->pendLen : len;
+
+	memcpy( buf, scp->pendBuf, n );
+	if ( hdr ) {
+		*hdr = scp->pendHdr;
+	}
+	scp->pendLen = 0;
+	scp->rdHdr   = scp->pendHdr;
+	bufSwap( scp, buf, n );
+	return (int)n;
+}
 
+static int64_t
+nowUs()
+{
+struct timespec ts;
 
-	rv = buf_read( scp, hdr, (uint8_t*)buf, nelms*elsz );
-	if ( rv > 0 ) {
-		if ( 2 == elsz ) {
-			/* nothing to do :-) */
-		} else {
-			for ( i = nelms - 1; i >= 0; i-- ) {
-				buf[i] = (((int16_t)(i8_p[i])) << 8);
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Poll interval bounds (us) if the firmware cannot hold the reply */
+#define BUF_WAIT_POLL_MIN_US    20
+#define BUF_WAIT_POLL_MAX_US 10000
+
+static int
+bufWait(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, int timeoutMs)
+{
+int     rv;
+int     hold;
+int64_t holdUs   = (int64_t)buf_get_wait_hold_ms( scp ) * 1000;
+int64_t deadline = timeoutMs < 0 ? -1 : nowUs() + (int64_t)timeoutMs * 1000;
+int64_t left     = (int64_t)timeoutMs * 1000;
+long    pollUs   = BUF_WAIT_POLL_MIN_US;
+
+	/* the firmware holds a 'wait' request for a bounded time (well
+	 * below the transport timeout) and then replies without data;
+	 * keep asking until the deadline expires. Poll if less than the
+	 * hold time is left so that short timeouts are honored.
+	 */
+	for ( ;; ) {
+		hold = holdUs > 0 && ( deadline < 0 || left >= holdUs );
+		if ( 0 != (rv = bufXfer( scp, hold ? FW_CMD_ADC_BUF_WAIT : FW_CMD_ADC_BUF, NULL, 0, hdr, buf, len )) ) {
+			break;
+		}
+		if ( deadline >= 0 && (left = deadline - nowUs()) <= 0 ) {
+			break;
+		}
+		if ( ! hold ) {
+			if ( deadline >= 0 && pollUs > left ) {
+				pollUs = left;
+			}
+			usleep( pollUs );
+			if ( (pollUs *= 2) > BUF_WAIT_POLL_MAX_US ) {
+				pollUs = BUF_WAIT_POLL_MAX_US;
 			}
 		}
 	}
 	return rv;
 }
 
-static void
-putBuf(uint8_t **bufp, uint32_t val, int len)
+int
+buf_read(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len)
 {
-int i;
+int     rv;
 
-	for ( i = 0; i < len; i++ ) {
-		**bufp  = (val & 0xff);
-		val   >>= 8;
-		(*bufp)++;
+	if ( scp->pendLen ) {
+		if ( len ) {
+			return bufTakePending( scp, hdr, buf, len );
+		}
+		/* flush discards the pending acquisition, too */
+		scp->pendLen = 0;
 	}
+	rv = bufXfer( scp, 0 == len ? FW_CMD_ADC_FLUSH : FW_CMD_ADC_BUF, NULL, 0, hdr, buf, len );
+	bufSwap( scp, buf, len );
+	return rv;
 }
 
-static uint32_t
-getBuf(uint8_t **bufp, int len)
+int
+buf_read_wait(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, int timeoutMs)
 {
-int      i;
-uint32_t rv = 0;
+int     rv;
 
-	for ( i = len - 1; i >= 0; i-- ) {
-		rv = (rv << 8 ) | (*bufp)[ i ];
+	if ( 0 == len ) {
+		return -EINVAL;
 	}
-	(*bufp) += len;
-
+	if ( scp->pendLen ) {
+		return bufTakePending( scp, hdr, buf, len );
+	}
+	rv = bufWait( scp, hdr, buf, len, timeoutMs );
+	bufSwap( scp, buf, len );
 	return rv;
 }
 
+static void putBuf(uint8_t **bufp, uint32_t val, int len);
 
-/* Set new parameters and obtain previous parameters.
- * A new acquisition is started if any mask bit is set.
- *
- * Either 'set' or 'get' may be NULL with obvious semantics.
- */
+static uint8_t *
+convScratch(ScopePvt *scp, size_t len)
+{
+uint8_t *nb;
+
+	if ( scp->convCap < len ) {
+		if ( ! (nb = realloc( scp->convBuf, len )) ) {
+			return NULL;
+		}
+		scp->convBuf = nb;
+		scp->convCap = len;
+	}
+	return scp->convBuf;
+}
 
 int
-acq_set_params(ScopePvt *scp, AcqParams *set, AcqParams *get)
+buf_read_range(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, unsigned long offset, unsigned long count)
 {
-uint8_t   cmd = fw_get_cmd( scp->fw, FW_CMD_ACQ_PARMS );
-uint8_t   buf[BITS_FW_CMD_ACQ_TOT_LEN_V2];
-uint8_t  *bufp;
-uint8_t   v8;
-uint32_t  v24;
-uint32_t  v32;
-uint32_t  nsamples;
-int       got;
-int       len;
-uint32_t  smask = set ? set->mask : ACQ_PARAM_MSK_GET;
-unsigned  apiVersion = fw_get_api_version( scp->fw );
+size_t   ssz = scope_get_num_channels( scp ) * bufSmplSize( scp );
+size_t   nsmpl;
+uint8_t  par[8];
+uint8_t *p;
+uint8_t *raw;
+int      rv;
 
-	if ( ! scp ) {
+	if ( 0 == count || count > len / ssz ) {
+		count = len / ssz;
+	}
+	if ( 0 == count || offset > UINT32_MAX ) {
 		return -EINVAL;
 	}
 
-	if ( ! (fw_get_features( scp->fw ) & FW_FEATURE_ADC) ) {
-		return -ENOTSUP;
+	if ( 0 == scp->pendLen && (buf_get_flags( scp ) & FW_BUF_FLG_RANGE) ) {
+		p = par;
+		putBuf( &p, offset, 4 );
+		putBuf( &p, count,  4 );
+		rv = bufXfer( scp, FW_CMD_ADC_BUF_RANGE, par, sizeof(par), hdr, buf, count * ssz );
+		if ( rv > 0 ) {
+			bufSwap( scp, buf, rv );
+		}
+		return rv;
 	}
 
-	if ( ! set || (ACQ_PARAM_MSK_GET == smask) ) {
-		if ( get == &scp->acqParams ) {
-			/* read the cache !! */
-			if ( ! set ) {
-				set   = get;
+	/* read the entire acquisition and extract the region */
+	if ( ! (raw = convScratch( scp, buf_get_size( scp ) * ssz )) ) {
+		return -ENOMEM;
+	}
+	if ( (rv = buf_read( scp, hdr, raw, buf_get_size( scp ) * ssz )) <= 0 ) {
+		return rv;
+	}
+	nsmpl = rv / ssz;
+	if ( offset >= nsmpl ) {
+		/* same as the firmware: the last sample is never skipped */
+		offset = nsmpl - 1;
+	}
+	if ( count > nsmpl - offset ) {
+		count = nsmpl - offset;
+	}
+	memcpy( buf, raw + offset * ssz, count * ssz );
+	return count * ssz;
+}
+
+/* Reduce 'nsmpl' raw samples to min/max pairs of 'bkt' samples each */
+static size_t
+peakReduce(uint8_t *dst, const uint8_t *src, size_t nsmpl, size_t bkt, unsigned nch, int wide)
+{
+size_t   ssz = nch * ( wide ? 2 : 1 );
+size_t   i, k;
+unsigned ch;
+long     v, vmn, vmx;
+size_t   imn, imx;
+uint8_t *p   = dst;
+
+	for ( i = 0; i < nsmpl; i += bkt ) {
+		for ( ch = 0; ch < nch; ch++ ) {
+			vmn = LONG_MAX;
+			vmx = LONG_MIN;
+			imn = imx = 0;
+			for ( k = i; k < i + bkt && k < nsmpl; k++ ) {
+				if ( wide ) {
+					v = (int16_t)( src[k*ssz + 2*ch] | ( src[k*ssz + 2*ch + 1] << 8 ) );
+				} else {
+					v = (int8_t)src[k*ssz + ch];
+				}
+				if ( v < vmn ) {
+					vmn = v;
+					imn = k;
+				}
+				if ( v > vmx ) {
+					vmx = v;
+					imx = k;
+				}
 			}
-		} else {
-			if ( get ) {
-				*get = scp->acqParams;
+			if ( wide ) {
+				memcpy( p +       2*ch, src + imn*ssz + 2*ch, 2 );
+				memcpy( p + ssz + 2*ch, src + imx*ssz + 2*ch, 2 );
+			} else {
+				p[      ch] = src[imn*ssz + ch];
+				p[ssz + ch] = src[imx*ssz + ch];
 			}
-			return 0;
 		}
+		p += 2*ssz;
 	}
+	return p - dst;
+}
 
-	/* parameter validation and updating of cache */
-	if ( ( smask & ACQ_PARAM_MSK_SRC ) ) {
-		scp->acqParams.src    = set->src;
+int
+buf_read_overview(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, unsigned long offset, unsigned long count, unsigned long nbuckets)
+{
+unsigned nch  = scope_get_num_channels( scp );
+int      wide = !! (buf_get_flags( scp ) & FW_BUF_FLG_16B);
+size_t   ssz  = nch * ( wide ? 2 : 1 );
+size_t   bkt;
+size_t   nsmpl;
+uint8_t  par[12];
+uint8_t *p;
+uint8_t *raw;
+int      rv;
+
+	if ( scp->acqParams.naverage > 1 ) {
+		return -ENOTSUP;
 	}
-
-	if ( ( smask & ACQ_PARAM_MSK_TGO ) ) {
-		scp->acqParams.trigOutEn = set->trigOutEn;
+	if ( 0 == count ) {
+		count = scp->acqParams.nsamples ? scp->acqParams.nsamples : buf_get_size( scp );
 	}
-
-	if ( EXT == scp->acqParams.src && !! scp->acqParams.trigOutEn ) {
-		scp->acqParams.trigOutEn = set->trigOutEn = 0;
-		smask |= ACQ_PARAM_MSK_TGO;
+	if ( nbuckets > len / (2*ssz) ) {
+		nbuckets = len / (2*ssz);
 	}
-
-	if ( ( smask & ACQ_PARAM_MSK_EDG ) ) {
-		scp->acqParams.rising = set->rising;
+	if ( 0 == nbuckets || offset > UINT32_MAX || count > UINT32_MAX ) {
+		return -EINVAL;
+	}
+	bkt = ( count + nbuckets - 1 ) / nbuckets;
+	if ( bkt < 2 ) {
+		/* nothing to reduce */
+		return buf_read_range( scp, hdr, buf, len, offset, count );
 	}
+	/* the buckets actually used */
+	nbuckets = ( count + bkt - 1 ) / bkt;
 
-	if ( ( smask & ACQ_PARAM_MSK_DCM ) ) {
-		if ( 1 >= set->cic0Decimation ) {
-			set->cic1Decimation = 1;
-		}
-		/* If they change the decimation but not explicitly the scale
-		 * then adjust the scale automatically
-		 */
-		if (  ! ( smask & ACQ_PARAM_MSK_SCL ) ) {
-			smask         |= ACQ_PARAM_MSK_SCL;
-			set->cic0Shift = 0;
-			set->cic1Shift = 0;
-			set->scale     = acq_default_cic1Scale( set->cic1Decimation );
+	if ( 0 == scp->pendLen && (buf_get_flags( scp ) & FW_BUF_FLG_PEAK) ) {
+		p = par;
+		putBuf( &p, offset, 4 );
+		putBuf( &p, count,  4 );
+		putBuf( &p, bkt,    4 );
+		rv = bufXfer( scp, FW_CMD_ADC_BUF_RANGE, par, sizeof(par), hdr, buf, nbuckets * 2 * ssz );
+		if ( rv > 0 ) {
+			bufSwap( scp, buf, rv );
 		}
-		scp->acqParams.cic0Decimation = set->cic0Decimation;
-		scp->acqParams.cic1Decimation = set->cic1Decimation;
+		return rv;
 	}
 
-	nsamples = scp->acqParams.nsamples;
-
-	if ( ( smask & ACQ_PARAM_MSK_NSM ) ) {
-		if ( apiVersion < FW_API_VERSION_2 ) {
+	/* read the entire acquisition (buf_read_range() itself may need
+	 * the scratch buffer) and reduce the region
+	 */
+	if ( ! (raw = convScratch( scp, buf_get_size( scp ) * ssz )) ) {
+		return -ENOMEM;
+	}
+	if ( (rv = buf_read( scp, hdr, raw, buf_get_size( scp ) * ssz )) <= 0 ) {
+		return rv;
+	}
+	nsmpl = rv / ssz;
+	if ( offset >= nsmpl ) {
+		offset = nsmpl - 1;
+	}
+	if ( count > nsmpl - offset ) {
+		count = nsmpl - offset;
+	}
+	return peakReduce( buf, raw + offset * ssz, count, bkt, nch, wide );
+}
+
+int
+buf_read_segments(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, BufSegInfo *info, unsigned maxsegs)
+{
+unsigned  nch    = scope_get_num_channels( scp );
+int       wide   = !! (buf_get_flags( scp ) & FW_BUF_FLG_16B);
+size_t    ssz    = nch * ( wide ? 2 : 1 );
+size_t    nsmpl  = scp->acqParams.nsamples;
+size_t    seglen = nsmpl + BUF_SEG_TRAILER_SMPLS;
+size_t    cap    = buf_get_size( scp ) * ssz;
+size_t    nsegs;
+uint16_t  x[BUF_SEG_TRAILER_SMPLS];
+uint8_t  *raw;
+uint8_t  *t;
+unsigned  k, w;
+int       rv;
+
+	/* the trailer is stored in channels A and B */
+	if ( scp->acqParams.nsegments < 2 || 2 != nch ) {
+		return -ENOTSUP;
+	}
+	if ( ! (raw = convScratch( scp, cap )) ) {
+		return -ENOMEM;
+	}
+	if ( (rv = buf_read( scp, hdr, raw, cap )) <= 0 ) {
+		return rv;
+	}
+	nsegs = rv / ( seglen * ssz );
+	if ( nsegs > maxsegs ) {
+		nsegs = maxsegs;
+	}
+	if ( nsegs > len / ( nsmpl * ssz ) ) {
+		nsegs = len / ( nsmpl * ssz );
+	}
+	for ( k = 0; k < nsegs; k++ ) {
+		memcpy( buf + k * nsmpl * ssz, raw + k * seglen * ssz, nsmpl * ssz );
+		if ( ! info ) {
+			continue;
+		}
+		/* each trailer sample holds the low byte of a 16-bit value in
+		 * (the upper byte of) channel A and the high byte in channel B;
+		 * buf_read() has swapped to host byte order.
+		 */
+		t = raw + ( k * seglen + nsmpl ) * ssz;
+		for ( w = 0; w < BUF_SEG_TRAILER_SMPLS; w++, t += ssz ) {
+			if ( wide ) {
+				x[w] = ( ((uint16_t*)t)[0] >> 8 ) | ( ((uint16_t*)t)[1] & 0xff00 );
+			} else {
+				x[w] = t[0] | ( t[1] << 8 );
+			}
+		}
+		info[k].hdr    = x[0];
+		info[k].tstamp = (uint64_t)x[1] | ( (uint64_t)x[2] << 16 ) | ( (uint64_t)x[3] << 32 );
+	}
+	return nsegs;
+}
+
+int
+buf_wait_triggered(ScopePvt *scp, int timeoutMs)
+{
+size_t  cap = scp->memSize * scp->numChannels * bufSmplSize( scp );
+uint8_t *nb;
+int     rv;
+
+	if ( scp->pendLen ) {
+		return 1;
+	}
+	if ( scp->pendCap < cap ) {
+		if ( ! (nb = realloc( scp->pendBuf, cap )) ) {
+			return -ENOMEM;
+		}
+		scp->pendBuf = nb;
+		scp->pendCap = cap;
+	}
+	rv = bufWait( scp, &scp->pendHdr, scp->pendBuf, scp->pendCap, timeoutMs );
+	if ( rv <= 0 ) {
+		return rv;
+	}
+	scp->pendLen = rv;
+	return 1;
+}
+
+int
+buf_read_flt(ScopePvt *scp, uint16_t *hdr, float *buf, size_t nelms)
+{
+int       rv;
+ssize_t   i;
+int8_t   *i8_p  = (int8_t*)buf;
+int16_t  *i16_p = (int16_t*)buf;
+int32_t  *i32_p = (int32_t*)buf;
+int       elsz  = bufSmplSize( scp );
+uint16_t  h;
+float     scl;
+
+
+	rv = buf_read( scp, &h, (uint8_t*)buf, nelms*elsz );
+	if ( hdr ) {
+		*hdr = h;
+	}
+	if ( rv > 0 && !! (h & FW_BUF_HDR_FLG_AVG) != ( scp->acqParams.naverage > 1 ) ) {
+		/* acquired before averaging was switched */
+		return -EAGAIN;
+	}
+	if ( rv > 0 ) {
+		if ( (h & FW_BUF_HDR_FLG_AVG) ) {
+			/* sums; same size as a float */
+			scl = (float)bufAvgScale( scp );
+			for ( i = 0; i < rv / (ssize_t)sizeof(*i32_p); i++ ) {
+				buf[i] = (float)(i32_p[i]) * scl;
+			}
+		} else if ( 2 == elsz ) {
+			for ( i = nelms - 1; i >= 0; i-- ) {
+				buf[i] = (float)(i16_p[i]);
+			}
+		} else {
+			for ( i = nelms - 1; i >= 0; i-- ) {
+				buf[i] = (float)(i8_p[i]);
+			}
+		}
+	}
+	return rv;
+}
+
+int
+buf_read_int16(ScopePvt *scp, uint16_t *hdr, int16_t *buf, size_t nelms)
+{
+int       rv;
+ssize_t   i;
+int8_t   *i8_p  = (int8_t*)buf;
+int32_t  *i32_p;
+int       elsz  = ( (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 2 : 1 );
+double    scl;
+long      v;
+
+	if ( scp->acqParams.naverage > 1 ) {
+		/* the sums don't fit; read into scratch */
+		if ( ! (i32_p = (int32_t*)convScratch( scp, nelms*sizeof(*i32_p) )) ) {
+			return -ENOMEM;
+		}
+		if ( (rv = buf_read_avg( scp, hdr, i32_p, nelms )) > 0 ) {
+			scl = bufAvgScale( scp );
+			if ( ! (buf_get_flags( scp ) & FW_BUF_FLG_16B) ) {
+				/* same as ordinary 8-bit samples (below) */
+				scl *= 256.0;
+			}
+			for ( i = 0; i < rv / (ssize_t)sizeof(*i32_p); i++ ) {
+				v = lrint( (double)i32_p[i] * scl );
+				buf[i] = v > INT16_MAX ? INT16_MAX : ( v < INT16_MIN ? INT16_MIN : v );
+			}
+			rv = i * sizeof(*buf);
+		}
+		return rv;
+	}
+
+	rv = buf_read( scp, hdr, (uint8_t*)buf, nelms*elsz );
+	if ( rv > 0 ) {
+		if ( 2 == elsz ) {
+			/* nothing to do :-) */
+		} else {
+			for ( i = nelms - 1; i >= 0; i-- ) {
+				buf[i] = (((int16_t)(i8_p[i])) << 8);
+			}
+		}
+	}
+	return rv;
+}
+
+int
+buf_read_avg(ScopePvt *scp, uint16_t *hdr, int32_t *buf, size_t nelms)
+{
+uint16_t  h;
+int       rv;
+
+	if ( scp->acqParams.naverage < 2 ) {
+		return -ENOTSUP;
+	}
+	rv = buf_read( scp, &h, (uint8_t*)buf, nelms*sizeof(*buf) );
+	if ( hdr ) {
+		*hdr = h;
+	}
+	if ( rv > 0 && ! (h & FW_BUF_HDR_FLG_AVG) ) {
+		/* acquired before averaging was enabled */
+		return -EAGAIN;
+	}
+	return rv;
+}
+
+static int parmsRefresh(ScopePvt *scp);
+
+int
+buf_get_volt_scale(ScopePvt *scp, unsigned channel, double *pscl, double *poff)
+{
+AFEParams *afe;
+double     scl;
+int        st;
+
+	if ( channel >= scope_get_num_channels( scp ) ) {
+		return -EINVAL;
+	}
+	/* cheap unless a setting has changed */
+	if ( (st = parmsRefresh( scp )) ) {
+		return st;
+	}
+	afe = &scp->parms->afeParams[channel];
+	scl = afe->currentScaleVolt / (double)buf_get_full_scale_ticks( scp );
+	if ( pscl ) {
+		*pscl = scl;
+	}
+	if ( poff ) {
+		*poff = - afe->postGainOffsetTick * scl;
+	}
+	return 0;
+}
+
+static int
+convVolts(ScopePvt *scp, float * const fdst[], double * const ddst[], const uint8_t *raw, size_t nbytes)
+{
+unsigned nch  = scope_get_num_channels( scp );
+int      wide = !! (buf_get_flags( scp ) & FW_BUF_FLG_16B);
+size_t   nsmpl = nbytes / ( nch * (wide ? 2 : 1) );
+double   dscl[nch], doff[nch];
+float    fscl[nch], foff[nch];
+unsigned ch;
+int      st;
+
+	for ( ch = 0; ch < nch; ++ch ) {
+		if ( (st = buf_get_volt_scale( scp, ch, &dscl[ch], &doff[ch] )) ) {
+			return st;
+		}
+		fscl[ch] = (float)dscl[ch];
+		foff[ch] = (float)doff[ch];
+	}
+	if ( fdst ) {
+		sampleConvFlt( fdst, raw, wide, nch, nsmpl, fscl, foff );
+	} else {
+		sampleConvDbl( ddst, raw, wide, nch, nsmpl, dscl, doff );
+	}
+	return (int)nsmpl;
+}
+
+/* Convert averaged data (sums) to volts */
+static int
+convAvgVolts(ScopePvt *scp, float * const fdst[], double * const ddst[], const int32_t *raw, size_t nbytes)
+{
+unsigned nch   = scope_get_num_channels( scp );
+size_t   nsmpl = nbytes / ( nch * sizeof(*raw) );
+double   scl, off, x;
+unsigned ch;
+size_t   i;
+int      st;
+
+	for ( ch = 0; ch < nch; ++ch ) {
+		if ( (st = buf_get_volt_scale( scp, ch, &scl, &off )) ) {
+			return st;
+		}
+		scl *= bufAvgScale( scp );
+		for ( i = 0; i < nsmpl; i++ ) {
+			x = (double)raw[i*nch + ch] * scl + off;
+			if ( fdst ) {
+				fdst[ch][i] = (float)x;
+			} else {
+				ddst[ch][i] = x;
+			}
+		}
+	}
+	return (int)nsmpl;
+}
+
+static int
+readVolts(ScopePvt *scp, uint16_t *hdr, float * const fdst[], double * const ddst[], size_t nsmpl)
+{
+size_t   len = nsmpl * scope_get_num_channels( scp ) * bufSmplSize( scp );
+uint8_t *raw;
+uint16_t h;
+int      rv;
+
+	if ( ! (raw = convScratch( scp, len )) ) {
+		return -ENOMEM;
+	}
+	rv = buf_read( scp, &h, raw, len );
+	if ( hdr ) {
+		*hdr = h;
+	}
+	if ( rv <= 0 ) {
+		return rv;
+	}
+	if ( !! (h & FW_BUF_HDR_FLG_AVG) != ( scp->acqParams.naverage > 1 ) ) {
+		/* acquired before averaging was switched */
+		return -EAGAIN;
+	}
+	if ( (h & FW_BUF_HDR_FLG_AVG) ) {
+		return convAvgVolts( scp, fdst, ddst, (const int32_t*)raw, rv );
+	}
+	return convVolts( scp, fdst, ddst, raw, rv );
+}
+
+int
+buf_read_volts_flt(ScopePvt *scp, uint16_t *hdr, float * const dst[], size_t nsmpl)
+{
+	return readVolts( scp, hdr, dst, NULL, nsmpl );
+}
+
+int
+buf_read_volts_dbl(ScopePvt *scp, uint16_t *hdr, double * const dst[], size_t nsmpl)
+{
+	return readVolts( scp, hdr, NULL, dst, nsmpl );
+}
+
+int
+buf_conv_volts_flt(ScopePvt *scp, float * const dst[], const uint8_t *raw, size_t nbytes)
+{
+	return convVolts( scp, dst, NULL, raw, nbytes );
+}
+
+int
+buf_conv_volts_dbl(ScopePvt *scp, double * const dst[], const uint8_t *raw, size_t nbytes)
+{
+	return convVolts( scp, NULL, dst, raw, nbytes );
+}
+
+int
+buf_compute_stats(ScopePvt *scp, SampleStats *st, const void *buf, int wide, size_t nsmpl)
+{
+int bits  = 8;
+int shift = 0;
+
+	if ( (buf_get_flags( scp ) & FW_BUF_FLG_16B) ) {
+		bits = buf_get_sample_size( scp );
+		if ( bits < 9 || bits > 16 ) {
+			bits = 16;
+		}
+	}
+	if ( wide ) {
+		/* left-adjusted */
+		shift = 16 - bits;
+	}
+	return sampleStats( st, buf, wide, scope_get_num_channels( scp ), nsmpl,
+	                    -(1 << (bits - 1)) * (1 << shift),
+	                    ((1 << (bits - 1)) - 1) * (1 << shift) );
+}
+
+static void
+putBuf(uint8_t **bufp, uint32_t val, int len)
+{
+int i;
+
+	for ( i = 0; i < len; i++ ) {
+		**bufp  = (val & 0xff);
+		val   >>= 8;
+		(*bufp)++;
+	}
+}
+
+static uint32_t
+getBuf(uint8_t **bufp, int len)
+{
+int      i;
+uint32_t rv = 0;
+
+	for ( i = len - 1; i >= 0; i-- ) {
+		rv = (rv << 8 ) | (*bufp)[ i ];
+	}
+	(*bufp) += len;
+
+	return rv;
+}
+
+
+/* Set new parameters and obtain previous parameters.
+ * A new acquisition is started if any mask bit is set.
+ *
+ * Either 'set' or 'get' may be NULL with obvious semantics.
+ */
+
+int
+acq_set_params(ScopePvt *scp, AcqParams *set, AcqParams *get)
+{
+uint8_t   cmd = fw_get_cmd( scp->fw, FW_CMD_ACQ_PARMS );
+uint8_t   buf[BITS_FW_CMD_ACQ_TOT_LEN_V3];
+uint8_t  *bufp;
+uint8_t   v8;
+uint32_t  v24;
+uint32_t  v32;
+uint32_t  nsamples;
+uint32_t  nsegs;
+uint32_t  maxsegs;
+uint32_t  memLim;
+uint32_t  navg;
+int       got;
+int       len;
+uint32_t  smask = set ? set->mask : ACQ_PARAM_MSK_GET;
+unsigned  apiVersion = fw_get_api_version( scp->fw );
+int       segSup;
+int       dblSup;
+int       avgSup;
+int       dbl;
+
+	if ( ! scp ) {
+		return -EINVAL;
+	}
+
+	if ( ! (fw_get_features( scp->fw ) & FW_FEATURE_ADC) ) {
+		return -ENOTSUP;
+	}
+
+	segSup = ( apiVersion >= FW_API_VERSION_2 ) && !! (buf_get_flags( scp ) & FW_BUF_FLG_SEG);
+	dblSup = ( apiVersion >= FW_API_VERSION_2 ) && !! (buf_get_flags( scp ) & FW_BUF_FLG_DBL);
+	/* the number of averages follows the number of segments */
+	avgSup = segSup && !! (buf_get_flags( scp ) & FW_BUF_FLG_AVG);
+
+	if ( ! set || (ACQ_PARAM_MSK_GET == smask) ) {
+		if ( get == &scp->acqParams ) {
+			/* read the cache !! */
+			if ( ! set ) {
+				set   = get;
+			}
+		} else {
+			if ( get ) {
+				*get = scp->acqParams;
+			}
+			return 0;
+		}
+	}
+
+	/* parameter validation and updating of cache */
+	if ( ( smask & ACQ_PARAM_MSK_SRC ) ) {
+		scp->acqParams.src    = set->src;
+	}
+
+	if ( ( smask & ACQ_PARAM_MSK_TGO ) ) {
+		scp->acqParams.trigOutEn = set->trigOutEn;
+	}
+
+	if ( EXT == scp->acqParams.src && !! scp->acqParams.trigOutEn ) {
+		scp->acqParams.trigOutEn = set->trigOutEn = 0;
+		smask |= ACQ_PARAM_MSK_TGO;
+	}
+
+	if ( ( smask & ACQ_PARAM_MSK_EDG ) ) {
+		scp->acqParams.rising = set->rising;
+	}
+
+	if ( ( smask & ACQ_PARAM_MSK_DCM ) ) {
+		if ( 1 >= set->cic0Decimation ) {
+			set->cic1Decimation = 1;
+		}
+		/* If they change the decimation but not explicitly the scale
+		 * then adjust the scale automatically
+		 */
+		if (  ! ( smask & ACQ_PARAM_MSK_SCL ) ) {
+			smask         |= ACQ_PARAM_MSK_SCL;
+			set->cic0Shift = 0;
+			set->cic1Shift = 0;
+			set->scale     = acq_default_cic1Scale( set->cic1Decimation );
+		}
+		scp->acqParams.cic0Decimation = set->cic0Decimation;
+		scp->acqParams.cic1Decimation = set->cic1Decimation;
+	}
+
+	dbl = scp->acqParams.doubleBuffer;
+
+	if ( ( smask & ACQ_PARAM_MSK_DBL ) ) {
+		if ( ! dblSup ) {
+			if ( set->doubleBuffer ) {
+				return -ENOTSUP;
+			}
+			smask &= ~ACQ_PARAM_MSK_DBL;
+		}
+		dbl = !! set->doubleBuffer;
+	}
+	scp->acqParams.doubleBuffer = dbl;
+
+	/* in ping-pong mode each half holds an acquisition */
+	memLim   = dbl ? scp->memSize / 2 : scp->memSize;
+
+	nsamples = scp->acqParams.nsamples;
+
+	if ( ( smask & ACQ_PARAM_MSK_NSM ) ) {
+		if ( apiVersion < FW_API_VERSION_2 ) {
 			if ( set->nsamples != scp->memSize ) {
 				return -ENOTSUP;
 			}
@@ -1327,8 +2216,82 @@ unsigned  apiVersion = fw_get_api_version( scp->fw );
 			set->nsamples = 1;
 		}
 		nsamples = set->nsamples;
-		scp->acqParams.nsamples = set->nsamples;
 	}
+	if ( nsamples > memLim ) {
+		if ( ( smask & ACQ_PARAM_MSK_NSM ) ) {
+			fprintf(stderr, "acq_set_params: WARNING %" PRIu32 " samples don't fit (ping-pong mode); clipping to %" PRIu32 "\n", nsamples, memLim);
+		}
+		nsamples = memLim;
+		smask   |= ACQ_PARAM_MSK_NSM;
+	}
+	if ( ( smask & ACQ_PARAM_MSK_NSM ) ) {
+		set->nsamples = nsamples;
+	}
+	scp->acqParams.nsamples = nsamples;
+
+	navg = scp->acqParams.naverage;
+
+	if ( ( smask & ACQ_PARAM_MSK_AVG ) ) {
+		if ( ! avgSup ) {
+			if ( set->naverage > 1 ) {
+				return -ENOTSUP;
+			}
+			smask &= ~ACQ_PARAM_MSK_AVG;
+		}
+		navg = set->naverage;
+	}
+	if ( navg < 1 ) {
+		navg = 1;
+	}
+	if ( navg > (1 << 8*BITS_FW_CMD_ACQ_LEN_AVG) ) {
+		/* the firmware clips further */
+		navg = (1 << 8*BITS_FW_CMD_ACQ_LEN_AVG);
+	}
+	if ( ( smask & ACQ_PARAM_MSK_AVG ) ) {
+		set->naverage = navg;
+	}
+	scp->acqParams.naverage = navg;
+
+	nsegs = scp->acqParams.nsegments;
+
+	if ( ( smask & ACQ_PARAM_MSK_SEG ) ) {
+		if ( ! segSup ) {
+			if ( set->nsegments > 1 ) {
+				return -ENOTSUP;
+			}
+			smask &= ~ACQ_PARAM_MSK_SEG;
+		}
+		nsegs = set->nsegments;
+	}
+	if ( nsegs < 1 ) {
+		nsegs = 1;
+	}
+	if ( nsegs > 1 && navg > 1 ) {
+		if ( ( smask & ACQ_PARAM_MSK_SEG ) ) {
+			fprintf(stderr, "acq_set_params: WARNING segmented acquisition is not available when averaging\n");
+		}
+		nsegs  = 1;
+		smask |= ACQ_PARAM_MSK_SEG;
+	}
+	if ( nsegs > 1 ) {
+		/* every segment carries a trailer */
+		maxsegs = memLim / ( nsamples + BUF_SEG_TRAILER_SMPLS );
+		if ( maxsegs > (1 << 8*BITS_FW_CMD_ACQ_LEN_SEG) ) {
+			maxsegs = (1 << 8*BITS_FW_CMD_ACQ_LEN_SEG);
+		}
+		if ( maxsegs < 1 ) {
+			maxsegs = 1;
+		}
+		if ( nsegs > maxsegs ) {
+			fprintf(stderr, "acq_set_params: WARNING %" PRIu32 " segments don't fit; clipping to %" PRIu32 "\n", nsegs, maxsegs);
+			nsegs  = maxsegs;
+			smask |= ACQ_PARAM_MSK_SEG;
+		}
+	}
+	if ( ( smask & ACQ_PARAM_MSK_SEG ) ) {
+		set->nsegments = nsegs;
+	}
+	scp->acqParams.nsegments = nsegs;
 
 	bufp = buf + BITS_FW_CMD_ACQ_IDX_MSK;
 	len  = (apiVersion >= FW_API_VERSION_2) ? BITS_FW_CMD_ACQ_LEN_MSK_V2 : BITS_FW_CMD_ACQ_LEN_MSK_V1;
@@ -1337,6 +2300,7 @@ unsigned  apiVersion = fw_get_api_version( scp->fw );
 	v8  = (set->src & BITS_FW_CMD_ACQ_MSK_SRC)  << BITS_FW_CMD_ACQ_SHF_SRC;
 	v8 |= (set->rising    ? 1 : 0)              << BITS_FW_CMD_ACQ_SHF_EDG;
 	v8 |= (set->trigOutEn ? 1 : 0)              << BITS_FW_CMD_ACQ_SHF_TGO;
+	v8 |= (dbl            ? 1 : 0)              << BITS_FW_CMD_ACQ_SHF_DBL;
 	putBuf( &bufp, v8, BITS_FW_CMD_ACQ_LEN_SRC );
 
 	if ( ( smask & ACQ_PARAM_MSK_LVL ) ) {
@@ -1351,8 +2315,16 @@ unsigned  apiVersion = fw_get_api_version( scp->fw );
 			set->npts = nsamples - 1;
 			fprintf(stderr, "acq_set_params: WARNING npts >= nsamples requested; clipping to %" PRId32 "\n", set->npts);
 		}
+		if ( nsegs > 1 && set->npts ) {
+			set->npts = 0;
+			fprintf(stderr, "acq_set_params: WARNING no pre-trigger samples in segmented mode\n");
+		}
 		scp->acqParams.npts = set->npts;
 	}
+	if ( nsegs > 1 ) {
+		/* the firmware ignores npts in segmented mode */
+		scp->acqParams.npts = 0;
+	}
 
 	len  = (apiVersion >= FW_API_VERSION_2) ? BITS_FW_CMD_ACQ_LEN_NPT_V2 : BITS_FW_CMD_ACQ_LEN_NPT_V1;
 	putBuf( &bufp, set->npts, len );
@@ -1418,20 +2390,52 @@ unsigned  apiVersion = fw_get_api_version( scp->fw );
 		putBuf( &bufp, set->hysteresis, BITS_FW_CMD_ACQ_LEN_HYS );
 	}
 
-	got = fw_xfer( scp->fw, cmd, buf, buf, sizeof(buf) );
+	if ( segSup ) {
+		/* firmware uses nsegments - 1 */
+		putBuf( &bufp, nsegs - 1, BITS_FW_CMD_ACQ_LEN_SEG );
+	}
+
+	if ( avgSup ) {
+		/* firmware uses naverage - 1 */
+		putBuf( &bufp, navg - 1, BITS_FW_CMD_ACQ_LEN_AVG );
+	}
+
+	if ( avgSup ) {
+		len = BITS_FW_CMD_ACQ_TOT_LEN_V4;
+	} else {
+		len = segSup ? BITS_FW_CMD_ACQ_TOT_LEN_V3 : BITS_FW_CMD_ACQ_TOT_LEN_V2;
+	}
+
+	got = fw_xfer( scp->fw, cmd, buf, buf, len );
 
 	if ( got < 0 ) {
 		fprintf(stderr, "Error: acq_set_params(); fifo transfer failed\n");
 		return got;
 	}
 
-	len  = (apiVersion >= FW_API_VERSION_2) ? BITS_FW_CMD_ACQ_TOT_LEN_V2 : BITS_FW_CMD_ACQ_TOT_LEN_V1;
+	if ( avgSup ) {
+		len = BITS_FW_CMD_ACQ_TOT_LEN_V4;
+	} else if ( segSup ) {
+		len = BITS_FW_CMD_ACQ_TOT_LEN_V3;
+	} else {
+		len = (apiVersion >= FW_API_VERSION_2) ? BITS_FW_CMD_ACQ_TOT_LEN_V2 : BITS_FW_CMD_ACQ_TOT_LEN_V1;
+	}
 
 	if ( got < len ) {
 		fprintf(stderr, "Error: acq_set_params(); fifo transfer short\n");
 		return -ENODATA;
 	}
 
+	if ( avgSup && ( smask & (ACQ_PARAM_MSK_AVG | ACQ_PARAM_MSK_NSM) ) && ( navg > 1 || ( smask & ACQ_PARAM_MSK_AVG ) ) ) {
+		/* the firmware limits naverage and nsamples (size of the
+		 * accumulator memory); the reply holds the previous settings,
+		 * thus read back the effective ones.
+		 */
+		if ( (got = acq_set_params( scp, NULL, &scp->acqParams )) ) {
+			return got;
+		}
+	}
+
 	if ( ! get ) {
 		return 0;
 	}
@@ -1450,6 +2454,7 @@ unsigned  apiVersion = fw_get_api_version( scp->fw );
 
 	get->rising         = !! ( (v8 >> BITS_FW_CMD_ACQ_SHF_EDG) & 1 );
 	get->trigOutEn      = !! ( (v8 >> BITS_FW_CMD_ACQ_SHF_TGO) & 1 );
+	get->doubleBuffer   = dblSup && ( (v8 >> BITS_FW_CMD_ACQ_SHF_DBL) & 1 );
 
 	get->level          = getBuf( &bufp, BITS_FW_CMD_ACQ_LEN_LVL );
 
@@ -1481,6 +2486,20 @@ unsigned  apiVersion = fw_get_api_version( scp->fw );
 	} else {
 		get->hysteresis     = 0;
 	}
+
+	if ( segSup ) {
+		/* firmware uses nsegments - 1 */
+		get->nsegments      = getBuf( &bufp, BITS_FW_CMD_ACQ_LEN_SEG ) + 1;
+	} else {
+		get->nsegments      = 1;
+	}
+
+	if ( avgSup ) {
+		/* firmware uses naverage - 1 */
+		get->naverage       = getBuf( &bufp, BITS_FW_CMD_ACQ_LEN_AVG ) + 1;
+	} else {
+		get->naverage       = 1;
+	}
 	return 0;
 }
 
@@ -1540,6 +2559,54 @@ AcqParams p;
 	return acq_set_params( scp, &p, 0 );
 }
 
+int
+acq_set_nsegments(ScopePvt *scp, uint32_t nsegments)
+{
+AcqParams p;
+
+	if ( ! (buf_get_flags( scp ) & FW_BUF_FLG_SEG) || ! (fw_get_features( scp->fw ) & FW_FEATURE_ADC) ) {
+		if ( nsegments <= 1 ) {
+			return 0;
+		}
+		return -ENOTSUP;
+	}
+	p.mask          = ACQ_PARAM_MSK_SEG;
+	p.nsegments     = nsegments;
+	return acq_set_params( scp, &p, 0 );
+}
+
+int
+acq_set_double_buffer(ScopePvt *scp, int enable)
+{
+AcqParams p;
+
+	if ( ! (buf_get_flags( scp ) & FW_BUF_FLG_DBL) || ! (fw_get_features( scp->fw ) & FW_FEATURE_ADC) ) {
+		if ( ! enable ) {
+			return 0;
+		}
+		return -ENOTSUP;
+	}
+	p.mask          = ACQ_PARAM_MSK_DBL;
+	p.doubleBuffer  = enable;
+	return acq_set_params( scp, &p, 0 );
+}
+
+int
+acq_set_naverage(ScopePvt *scp, uint32_t naverage)
+{
+AcqParams p;
+
+	if ( ! (buf_get_flags( scp ) & FW_BUF_FLG_AVG) || ! (fw_get_features( scp->fw ) & FW_FEATURE_ADC) ) {
+		if ( naverage <= 1 ) {
+			return 0;
+		}
+		return -ENOTSUP;
+	}
+	p.mask          = ACQ_PARAM_MSK_AVG;
+	p.naverage      = naverage;
+	return acq_set_params( scp, &p, 0 );
+}
+
 
 #define CIC1_SHF_STRIDE  8
 #define CIC1_STAGES      4
@@ -1665,6 +2732,9 @@ pgaReadReg(ScopePvt *scp, unsigned ch, unsigned reg)
 int
 pgaWriteReg(ScopePvt *scp, unsigned ch, unsigned reg, unsigned val)
 {
+	if ( scp ) {
+		parmsStale( scp, -1, AFE_PGA_ATT | AFE_CURSCL, 0 );
+	}
 	return scp && scp->pga && scp->pga->writeReg ? scp->pga->writeReg(scp->fw, ch, reg, val) : -ENOTSUP;
 }
 
@@ -1692,6 +2762,7 @@ pgaSetAttDb(ScopePvt *scp, unsigned channel, double att)
 	if ( channel >= scope_get_num_channels( scp ) ) {
 		return -EINVAL;
 	}
+	parmsStale( scp, channel, AFE_PGA_ATT | AFE_CURSCL, 0 );
 	return scp && scp->pga && scp->pga->setAttDb ? scp->pga->setAttDb(scp->fw, channel, att) : -ENOTSUP;
 }
 
@@ -1713,6 +2784,7 @@ int
 fecSetAttDb(ScopePvt *scp, unsigned channel, double attDb)
 {
 	if ( channel >= scope_get_num_channels( scp ) ) return -EINVAL;
+	parmsStale( scp, channel, AFE_FEC_ATT | AFE_CURSCL, 0 );
 	return scp && scp->fec && scp->fec->setAttDb ? scp->fec->setAttDb(scp->fec, channel, attDb) : -ENOTSUP;
 }
 
@@ -1726,8 +2798,15 @@ fecGetACMode(ScopePvt *scp, unsigned channel)
 int
 fecSetACMode(ScopePvt *scp, unsigned channel, unsigned val)
 {
+AFEParams *afe;
+int        st;
 	if ( channel >= scope_get_num_channels( scp ) ) return -EINVAL;
-	return scp && scp->fec && scp->fec->setACMode ? scp->fec->setACMode(scp->fec, channel, val) : -ENOTSUP;
+	parmsStale( scp, channel, AFE_FEC_CPLING, 0 );
+	st = scp && scp->fec && scp->fec->setACMode ? scp->fec->setACMode(scp->fec, channel, val) : -ENOTSUP;
+	if ( st >= 0 && (afe = parmsApplied( scp, channel, AFE_FEC_CPLING )) ) {
+		afe->fecCouplingAC = !! val;
+	}
+	return st;
 }
 
 int
@@ -1757,8 +2836,16 @@ fecSetTerminationOhm(ScopePvt *scp, unsigned channel, double val)
 int
 fecSetTermination(ScopePvt *scp, unsigned channel, unsigned	val)
 {
+AFEParams *afe;
+int        st;
 	if ( channel >= scope_get_num_channels( scp ) ) return -EINVAL;
-	return scp && scp->fec && scp->fec->setTermination ? scp->fec->setTermination(scp->fec, channel, val) : -ENOTSUP;
+	parmsStale( scp, channel, AFE_FEC_TERM, 0 );
+	st = scp && scp->fec && scp->fec->setTermination ? scp->fec->setTermination(scp->fec, channel, val) : -ENOTSUP;
+	if ( st >= 0 && (afe = parmsApplied( scp, channel, AFE_FEC_TERM )) ) {
+		/* as reported by fecGetTerminationOhm() */
+		afe->fecTerminationOhm = val ? 50.0 : 1.0E6;
+	}
+	return st;
 }
 
 int
@@ -1771,8 +2858,15 @@ fecGetDACRangeHi(ScopePvt *scp, unsigned channel)
 int
 fecSetDACRangeHi(ScopePvt *scp, unsigned channel, unsigned	val)
 {
+AFEParams *afe;
+int        st;
 	if ( channel >= scope_get_num_channels( scp ) ) return -EINVAL;
-	return scp && scp->fec && scp->fec->setDACRangeHi ? scp->fec->setDACRangeHi(scp->fec, channel, val) : -ENOTSUP;
+	parmsStale( scp, channel, AFE_DAC_RNG, 0 );
+	st = scp && scp->fec && scp->fec->setDACRangeHi ? scp->fec->setDACRangeHi(scp->fec, channel, val) : -ENOTSUP;
+	if ( st >= 0 && (afe = parmsApplied( scp, channel, AFE_DAC_RNG )) ) {
+		afe->dacRangeHi = !! val;
+	}
+	return st;
 }
 
 void
@@ -1802,8 +2896,9 @@ int      st;
 int
 dacSetVolt(ScopePvt *scp, unsigned channel, double volt)
 {
-double val, voltMin, voltMax;
-int    st;
+double     val, voltMin, voltMax;
+int        st, tick;
+AFEParams *afe;
 	if ( channel >= scope_get_num_channels( scp ) ) {
 		return -EINVAL;
 	}
@@ -1823,7 +2918,17 @@ int    st;
 	printf("dacSetVolt: %g, offset %g\n", volt , scp->calData[channel].offsetVolt);
 	val = (volt - scp->calData[channel].offsetVolt);
 
-	return dac47cxSet( scp->fw, channel, dacVolt2Tick( scp, val ) );
+	parmsStale( scp, channel, AFE_DAC_VOLT, 0 );
+
+	tick = dacVolt2Tick( scp, val );
+	if ( (st = dac47cxSet( scp->fw, channel, tick )) < 0 ) {
+		return st;
+	}
+	/* the quantized value, as reported by dacGetVolt() */
+	if ( (afe = parmsApplied( scp, channel, AFE_DAC_VOLT )) ) {
+		afe->dacVolt = dacTick2Volt( scp, tick ) + scp->calData[channel].offsetVolt;
+	}
+	return st;
 }
 
 int
@@ -1904,93 +3009,164 @@ scope_copy_params(ScopeParams *to, const ScopeParams *from) {
 	}
 }
 
-int
-scope_get_params(ScopePvt *scp, ScopeParams *p)
-{
-	int      st;
-	unsigned ch;
-
-	if ( (st = acq_set_params( scp, NULL, &p->acqParams )) ) {
-		fprintf(stderr, "scope_get_params() - Error %d: unable to read acquisition parameters.\n", st);
-		return st;
-	}
-
-	for ( ch = 0; ch < p->numChannels; ++ch ) {
-		if ( (st = scope_get_current_scale( scp, ch, &p->afeParams[ch].currentScaleVolt )) ) {
-			fprintf(stderr, "scope_get_params() - Error %d: reading current scale (channel %d) failed.\n", st, ch);
-			p->afeParams[ch].currentScaleVolt = 0.0;
-		}
-		if ( (st = scope_get_full_scale_volt( scp, ch, &p->afeParams[ch].fullScaleVolt )) ) {
-			fprintf(stderr, "scope_get_params() - Error %d: reading current scale (channel %d) failed.\n", st, ch);
-			return st;
-		}
-		if ( (st = scope_get_post_gain_offset_tick( scp, ch, &p->afeParams[ch].postGainOffsetTick )) ) {
-			fprintf(stderr, "scope_get_params() - Error %d: reading post-gain offset (channel %d) failed.\n", st, ch);
-			return st;
-		}
-		if ( (st = pgaGetAttDb( scp, ch, &p->afeParams[ch].pgaAttDb )) ) {
-			if ( -ENOTSUP == st  ) {
-				p->afeParams[ch].pgaAttDb = 0.0/0.0;
+/* Re-read stale fields of the cached parameters from the hardware */
+static int
+parmsRefresh(ScopePvt *scp)
+{
+	int        st;
+	unsigned   ch;
+	AFEParams *afe;
+	unsigned  *stale;
+
+	for ( ch = 0; ch < scp->numChannels; ++ch ) {
+		afe   = &scp->parms->afeParams[ch];
+		stale = &scp->afeStale[ch];
+		if ( (*stale & AFE_CURSCL) ) {
+			if ( (st = scope_get_current_scale( scp, ch, &afe->currentScaleVolt )) ) {
+				fprintf(stderr, "scope_get_params() - Error %d: reading current scale (channel %d) failed.\n", st, ch);
+				afe->currentScaleVolt = 0.0;
 			} else {
-				fprintf(stderr, "scope_get_params() - Error %d: reading PGA attenuation (channel %d) failed.\n", st, ch);
+				*stale &= ~AFE_CURSCL;
+			}
+		}
+		if ( (*stale & AFE_FULSCL) ) {
+			if ( (st = scope_get_full_scale_volt( scp, ch, &afe->fullScaleVolt )) ) {
+				fprintf(stderr, "scope_get_params() - Error %d: reading current scale (channel %d) failed.\n", st, ch);
 				return st;
 			}
+			*stale &= ~AFE_FULSCL;
 		}
-		if ( (st = fecGetAttDb( scp, ch, &p->afeParams[ch].fecAttDb )) ) {
-			if ( -ENOTSUP == st  ) {
-				p->afeParams[ch].fecAttDb = 0.0/0.0;
-			} else {
-				fprintf(stderr, "scope_get_params() - Error %d: reading FEC attenuation (channel %d) failed.\n", st, ch);
+		if ( (*stale & AFE_PGOFF) ) {
+			if ( (st = scope_get_post_gain_offset_tick( scp, ch, &afe->postGainOffsetTick )) ) {
+				fprintf(stderr, "scope_get_params() - Error %d: reading post-gain offset (channel %d) failed.\n", st, ch);
 				return st;
 			}
+			*stale &= ~AFE_PGOFF;
+		}
+		if ( (*stale & AFE_PGA_ATT) ) {
+			if ( (st = pgaGetAttDb( scp, ch, &afe->pgaAttDb )) ) {
+				if ( -ENOTSUP == st  ) {
+					afe->pgaAttDb = 0.0/0.0;
+				} else {
+					fprintf(stderr, "scope_get_params() - Error %d: reading PGA attenuation (channel %d) failed.\n", st, ch);
+					return st;
+				}
+			}
+			*stale &= ~AFE_PGA_ATT;
+		}
+		if ( (*stale & AFE_FEC_ATT) ) {
+			if ( (st = fecGetAttDb( scp, ch, &afe->fecAttDb )) ) {
+				if ( -ENOTSUP == st  ) {
+					afe->fecAttDb = 0.0/0.0;
+				} else {
+					fprintf(stderr, "scope_get_params() - Error %d: reading FEC attenuation (channel %d) failed.\n", st, ch);
+					return st;
+				}
+			}
+			*stale &= ~AFE_FEC_ATT;
+		}
+		if ( (*stale & AFE_FEC_TERM) ) {
+			if ( (st = fecGetTerminationOhm( scp, ch, &afe->fecTerminationOhm )) ) {
+				if ( -ENOTSUP == st  ) {
+					afe->fecTerminationOhm = 0.0/0.0;
+				} else {
+					fprintf(stderr, "scope_get_params() - Error %d: reading FEC termination (channel %d) failed.\n", st, ch);
+					return st;
+				}
+			}
+			*stale &= ~AFE_FEC_TERM;
 		}
-		if ( (st = fecGetTerminationOhm( scp, ch, &p->afeParams[ch].fecTerminationOhm )) ) {
-			if ( -ENOTSUP == st  ) {
-				p->afeParams[ch].fecTerminationOhm = 0.0/0.0;
+
+		if ( (*stale & AFE_FEC_CPLING) ) {
+			st = fecGetACMode( scp, ch );
+			if ( st >= 0 ) {
+				afe->fecCouplingAC = st;
+			} else if ( -ENOTSUP == st  ) {
+				afe->fecCouplingAC = -1;
 			} else {
-				fprintf(stderr, "scope_get_params() - Error %d: reading FEC termination (channel %d) failed.\n", st, ch);
+				fprintf(stderr, "scope_get_params() - Error %d: reading FEC coupling mode (channel %d) failed.\n", st, ch);
 				return st;
 			}
+			*stale &= ~AFE_FEC_CPLING;
 		}
 
-		st = fecGetACMode( scp, ch );
-		if ( st >= 0 ) {
-		    p->afeParams[ch].fecCouplingAC = st;
-		} else if ( -ENOTSUP == st  ) {
-			p->afeParams[ch].fecCouplingAC = -1;
-		} else {
-			fprintf(stderr, "scope_get_params() - Error %d: reading FEC coupling mode (channel %d) failed.\n", st, ch);
-			return st;
+		if ( (*stale & AFE_DAC_VOLT) ) {
+			if ( (st = dacGetVolt( scp, ch, &afe->dacVolt )) ) {
+				if ( -ENOTSUP == st  ) {
+					afe->dacVolt = 0.0/0.0;
+				} else {
+					fprintf(stderr, "scope_get_params() - Error %d: reading DAC (channel %d) failed.\n", st, ch);
+					return st;
+				}
+			}
+			*stale &= ~AFE_DAC_VOLT;
 		}
 
-		if ( (st = dacGetVolt( scp, ch, &p->afeParams[ch].dacVolt )) ) {
-			if ( -ENOTSUP == st  ) {
-				p->afeParams[ch].dacVolt = 0.0/0.0;
+		if ( (*stale & AFE_DAC_RNG) ) {
+			st = fecGetDACRangeHi( scp, ch );
+			if ( st >= 0 ) {
+				afe->dacRangeHi = st;
+			} else if ( -ENOTSUP == st  ) {
+				afe->dacRangeHi = -1;
 			} else {
-				fprintf(stderr, "scope_get_params() - Error %d: reading DAC (channel %d) failed.\n", st, ch);
+				fprintf(stderr, "scope_get_params() - Error %d: reading DAC range (channel %d) failed.\n", st, ch);
 				return st;
 			}
+			*stale &= ~AFE_DAC_RNG;
 		}
+	}
 
-		st = fecGetDACRangeHi( scp, ch );
-		if ( st >= 0 ) {
-		    p->afeParams[ch].dacRangeHi = st;
-		} else if ( -ENOTSUP == st  ) {
-			p->afeParams[ch].dacRangeHi = -1;
-		} else {
-			fprintf(stderr, "scope_get_params() - Error %d: reading DAC range (channel %d) failed.\n", st, ch);
+	if ( (scp->parmsStale & PARM_CLKOUT) ) {
+		st = scope_get_clock_out_freq( scp, &scp->parms->clockOutFreqHz, &scp->parms->clockOutIsRef );
+		if ( st && -ENOTSUP != st ) {
 			return st;
 		}
+		scp->parmsStale &= ~PARM_CLKOUT;
 	}
 
-	st = scope_get_clock_out_freq( scp, &p->clockOutFreqHz, &p->clockOutIsRef );
-	if ( st && -ENOTSUP != st ) {
+	return 0;
+}
+
+int
+scope_get_params(ScopePvt *scp, ScopeParams *p)
+{
+	int      st;
+	unsigned ch;
+
+	if ( (st = acq_set_params( scp, NULL, &p->acqParams )) ) {
+		fprintf(stderr, "scope_get_params() - Error %d: unable to read acquisition parameters.\n", st);
 		return st;
 	}
 
+	if ( (st = parmsRefresh( scp )) ) {
+		return st;
+	}
+
+	for ( ch = 0; ch < p->numChannels && ch < scp->numChannels; ++ch ) {
+		p->afeParams[ch] = scp->parms->afeParams[ch];
+	}
+
+	p->clockOutFreqHz = scp->parms->clockOutFreqHz;
+	p->clockOutIsRef  = scp->parms->clockOutIsRef;
+
 	return 0;
 }
 
+int
+scope_resync_params(ScopePvt *scp)
+{
+	int      st;
+
+	fw_shadow_invalidate( scp->fw, FW_SHADOW_ALL, FW_SHADOW_ALL );
+	parmsStale( scp, -1, AFE_ALL, PARM_ALL );
+
+	if ( (st = acq_set_params( scp, NULL, &scp->acqParams )) ) {
+		fprintf(stderr, "scope_resync_params() - Error %d: unable to read acquisition parameters.\n", st);
+		return st;
+	}
+	return parmsRefresh( scp );
+}
+
 /* helper struct to reduce number of arguments */
 typedef struct ch_set_s {
 	ScopePvt    *scp;
@@ -2009,6 +3185,10 @@ ch_set_dbl(ch_set_s *a, int (*f)(ScopePvt *, unsigned, double), double *off, con
 		/* not parameter available; ignore */
 		return 0;
 	}
+	if ( v == *(double*)((uintptr_t)&a->scp->parms->afeParams[a->ch] + (uintptr_t)off) ) {
+		/* unchanged */
+		return 0;
+	}
 	st = f( a->scp, a->ch, v );
 	if ( -ENOTSUP == st ) {
 		fprintf( stderr, "scope_set_params: WARNING - settings contain %s but not supported by this device.\n", msg );
@@ -2031,6 +3211,10 @@ ch_set_uns(ch_set_s *a, int (*f)(ScopePvt *, unsigned, unsigned), int *off, cons
 		/* no parameter available; ignore */
 		return 0;
 	}
+	if ( v == *(int*)((uintptr_t)&a->scp->parms->afeParams[a->ch] + (uintptr_t)off) ) {
+		/* unchanged */
+		return 0;
+	}
 	st = f( a->scp, a->ch, (unsigned)v );
 	if ( -ENOTSUP == st ) {
 		fprintf( stderr, "scope_set_params: WARNING - settings contain %s but not supported by this device.\n", msg );
@@ -2045,12 +3229,79 @@ ch_set_uns(ch_set_s *a, int (*f)(ScopePvt *, unsigned, unsigned), int *off, cons
 #define CH_SET_DBL(a, fn, fld, m) ch_set_dbl((a),(fn),&((AFEParams*)0)->fld, (m))
 #define CH_SET_UNS(a, fn, fld, m) ch_set_uns((a),(fn),&((AFEParams*)0)->fld, (m))
 
+/* Mask of acquisition parameters in 'set' which differ from the cached ones */
+static uint32_t
+acqDeltaMask(const AcqParams *cur, const AcqParams *set)
+{
+	uint32_t m = set->mask;
+
+	if ( cur->src == set->src ) {
+		m &= ~ACQ_PARAM_MSK_SRC;
+	}
+	if ( cur->rising == set->rising ) {
+		m &= ~ACQ_PARAM_MSK_EDG;
+	}
+	if ( cur->level == set->level && cur->hysteresis == set->hysteresis ) {
+		m &= ~ACQ_PARAM_MSK_LVL;
+	}
+	if ( cur->npts == set->npts ) {
+		m &= ~ACQ_PARAM_MSK_NPT;
+	}
+	if ( cur->autoTimeoutMS == set->autoTimeoutMS ) {
+		m &= ~ACQ_PARAM_MSK_AUT;
+	}
+	if ( cur->cic0Decimation == set->cic0Decimation && cur->cic1Decimation == set->cic1Decimation ) {
+		m &= ~ACQ_PARAM_MSK_DCM;
+	}
+	if ( cur->cic0Shift == set->cic0Shift && cur->cic1Shift == set->cic1Shift && cur->scale == set->scale ) {
+		m &= ~ACQ_PARAM_MSK_SCL;
+	}
+	if ( cur->nsamples == set->nsamples ) {
+		m &= ~ACQ_PARAM_MSK_NSM;
+	}
+	if ( !! cur->trigOutEn == !! set->trigOutEn ) {
+		m &= ~ACQ_PARAM_MSK_TGO;
+	}
+	if ( cur->nsegments == set->nsegments ) {
+		m &= ~ACQ_PARAM_MSK_SEG;
+	}
+	if ( !! cur->doubleBuffer == !! set->doubleBuffer ) {
+		m &= ~ACQ_PARAM_MSK_DBL;
+	}
+	if ( ( cur->naverage > 1 ? cur->naverage : 1 ) == ( set->naverage > 1 ? set->naverage : 1 ) ) {
+		m &= ~ACQ_PARAM_MSK_AVG;
+	}
+	/* dependencies: the firmware/acq_set_params() adjust the scale when
+	 * the decimation changes, npts is clipped to nsamples (which is
+	 * clipped in ping-pong and averaging mode), averaging disables
+	 * segmented mode and the trigger output is disabled for an
+	 * external source.
+	 */
+	if ( (m & ACQ_PARAM_MSK_DCM) ) {
+		m |= (set->mask & ACQ_PARAM_MSK_SCL);
+	}
+	if ( (m & ACQ_PARAM_MSK_DBL) ) {
+		m |= (set->mask & ACQ_PARAM_MSK_NSM);
+	}
+	if ( (m & ACQ_PARAM_MSK_AVG) ) {
+		m |= (set->mask & (ACQ_PARAM_MSK_NSM | ACQ_PARAM_MSK_SEG));
+	}
+	if ( (m & ACQ_PARAM_MSK_NSM) ) {
+		m |= (set->mask & (ACQ_PARAM_MSK_NPT | ACQ_PARAM_MSK_SEG));
+	}
+	if ( (m & ACQ_PARAM_MSK_SRC) ) {
+		m |= (set->mask & ACQ_PARAM_MSK_TGO);
+	}
+	return m;
+}
+
 int
 scope_set_params(ScopePvt *scp, ScopeParams *p)
 {
-	int      st;
-	unsigned ch;
-	ch_set_s h; /* helper */
+	int       st;
+	unsigned  ch;
+	ch_set_s  h; /* helper */
+	AcqParams acq;
 
 	h.scp = scp;
 	h.p   = p;
@@ -2065,13 +3316,23 @@ scope_set_params(ScopePvt *scp, ScopeParams *p)
 		return -EINVAL;
 	}
 
+	/* Only settings which differ from the cached ones are applied; the
+	 * order below respects their dependencies. The setters store what
+	 * they applied in the cache; fields which the hardware may round or
+	 * clamp are stale and re-read first so that settings obtained from
+	 * scope_get_params() compare equal.
+	 */
+	if ( (st = parmsRefresh( scp )) ) {
+		return st;
+	}
 	for ( ch = 0; ch < p->numChannels; ++ch ) {
 		h.ch = ch;
 
 		/* fullScaleVolt is normally set by device calibration;
 		 * most use-cases will have 'nan' in the settings!
 		 */
-		if ( ! isnan( p->afeParams[ch].fullScaleVolt ) ) {
+		if ( ! isnan( p->afeParams[ch].fullScaleVolt )
+		     && p->afeParams[ch].fullScaleVolt != scp->parms->afeParams[ch].fullScaleVolt ) {
 			if ( (st = scope_set_full_scale_volt( scp, ch, p->afeParams[ch].fullScaleVolt )) < 0 ) {
 				/* should never happen */
 				return -EPERM;
@@ -2107,11 +3368,23 @@ scope_set_params(ScopePvt *scp, ScopeParams *p)
 		st = CH_SET_DBL( &h, dacSetVolt, dacVolt, "DAC" );
 	}
 
-	st = acq_set_params( scp, &p->acqParams, NULL );
-	if ( st ) {
-		return st;
+	/* writing the acquisition parameters re-arms the acquisition;
+	 * skip if nothing changed.
+	 */
+	acq      = p->acqParams;
+	acq.mask = acqDeltaMask( &scp->acqParams, &p->acqParams );
+	if ( acq.mask ) {
+		st = acq_set_params( scp, &acq, NULL );
+		if ( st ) {
+			return st;
+		}
 	}
 	if ( p->clockOutIsRef >= 0 ) {
+		if ( p->clockOutIsRef == scp->parms->clockOutIsRef
+		     && ( p->clockOutIsRef || p->clockOutFreqHz == scp->parms->clockOutFreqHz ) ) {
+			/* unchanged */
+			return 0;
+		}
 		if ( p->clockOutIsRef ) {
 			st = scope_set_clock_out_to_ref( scp );
 		} else {
@@ -2341,6 +3614,8 @@ double   dummyInt;
 		return status;
 	}
 
+	parmsStale( scp, -1, 0, PARM_CLKOUT );
+
 	if ( freq < 0.0 ) {
 		return -EINVAL;
 	} else if ( 0.0 == freq ) {
@@ -2446,6 +3721,7 @@ int      status;
 		return status;
 	}
 
+	parmsStale( scp, -1, 0, PARM_CLKOUT );
 
 	if ( (status = versaClkSetFODRoute( scp->fw, out2, CASC_OUT )) ) {
 		return status;
@@ -145,10 +145,42 @@ buf_get_size(ScopePvt *);
 
 /* buffer uses 16-bit samples */
 #define FW_BUF_FLG_16B (1<<0)
+/* firmware can hold a buffer-read reply until an acquisition
+ * completes (see buf_read_wait())
+ */
+#define FW_BUF_FLG_WAIT (1<<4)
+/* firmware can transfer a region of the buffer (see buf_read_range()) */
+#define FW_BUF_FLG_RANGE (1<<5)
+/* firmware can reduce a region to min/max per bucket (see buf_read_overview()) */
+#define FW_BUF_FLG_PEAK (1<<6)
+/* firmware supports segmented acquisition (see buf_read_segments()) */
+#define FW_BUF_FLG_SEG (1<<7)
+/* firmware can append an extended header (see buf_get_ext_header()) */
+#define FW_BUF_FLG_XHDR (1<<8)
+/* firmware supports ping-pong buffering (see acq_set_double_buffer()) */
+#define FW_BUF_FLG_DBL (1<<9)
+/* firmware can transfer packed 16-bit samples (see buf_set_packed()) */
+#define FW_BUF_FLG_PACK (1<<10)
+/* firmware can average acquisitions (see acq_set_naverage()) */
+#define FW_BUF_FLG_AVG (1<<11)
+/* max. time the firmware holds a buffer-read reply (FW_BUF_FLG_WAIT) in
+ * units of FW_BUF_WAIT_HOLD_UNIT_MS, rounded up; zero if not reported
+ * (see buf_get_wait_hold_ms())
+ */
+#define FW_BUF_FLG_HOLD_SHFT 12
+#define FW_BUF_FLG_HOLD_MSK  (0xf << FW_BUF_FLG_HOLD_SHFT)
+#define FW_BUF_WAIT_HOLD_UNIT_MS 10
 
 unsigned
 buf_get_flags(ScopePvt *);
 
+/* Max. time (ms) the firmware holds a buffer-read reply (as reported
+ * by the firmware; FW_BUF_FLG_HOLD_MSK).
+ * RETURNS: 0 if the firmware does not support FW_BUF_FLG_WAIT.
+ */
+unsigned
+buf_get_wait_hold_ms(ScopePvt *);
+
 /* Requres API vers. 3; returns -ENOTSUP if API is older */
 int
 buf_get_sample_size(ScopePvt *);
@@ -168,10 +200,56 @@ buf_flush(ScopePvt *);
 
 #define FW_BUF_HDR_FLG_OVR(ch) (1<<(ch))
 #define FW_BUF_HDR_FLG_AUTO_TRIGGERED (1<<8)
+/* half of the ping-pong buffer which held the acquisition */
+#define FW_BUF_HDR_FLG_HALF (1<<9)
+/* the data are sums of averaged acquisitions (see buf_read_avg()) */
+#define FW_BUF_HDR_FLG_AVG (1<<10)
+
+/* Extended buffer header (FW_BUF_FLG_XHDR) */
+typedef struct BufHdrExt {
+	uint16_t      seq;     /* counts triggered acquisitions (wraps
+	                        * around)                             */
+	uint64_t      tstamp;  /* trigger time (ADC clock cycles; the
+	                        * 48-bit counter wraps around); first
+	                        * segment of a segmented acquisition  */
+} BufHdrExt;
+
+/* Enable/disable the extended header. scope_open() enables it if the
+ * firmware supports it (FW_BUF_FLG_XHDR); the buf_read variants then
+ * retrieve it along with the data.
+ * RETURNS: 0 on success, -ENOTSUP if the firmware lacks support.
+ */
+int
+buf_set_ext_header(ScopePvt *scp, int enable);
+
+/* Retrieve the extended header of the acquisition most recently
+ * returned by a buf_read variant. Gaps in the sequence indicate
+ * acquisitions which were discarded (flushed or not read before
+ * the parameters changed); the difference of consecutive timestamps
+ * is the actual acquisition period (dead time included).
+ * RETURNS: 0 on success, -ENODATA if not available.
+ */
+int
+buf_get_ext_header(ScopePvt *scp, BufHdrExt *xhdr);
+
+/* Enable/disable packed transfer of 16-bit samples: only the
+ * significant bits (buf_get_sample_size()) are transferred, e.g.,
+ * 3 octets for two 12-bit samples. The samples are expanded by the
+ * host, i.e., this is transparent to the buf_read variants (the
+ * min/max of buf_read_overview() are never packed). scope_open()
+ * enables packing if the firmware supports it (FW_BUF_FLG_PACK).
+ * RETURNS: 0 on success, -ENOTSUP if the firmware lacks support.
+ */
+int
+buf_set_packed(ScopePvt *scp, int enable);
 
 /* All buf_read variants return number of bytes read or negative error
  * all buf_read variants also take care of swapping multi-byte samples
  * to host-byte order.
+ * In averaging mode (AcqParams.naverage > 1) the raw data are 32-bit
+ * sums (see buf_read_avg()); buf_read_flt() and buf_read_int16()
+ * return the averages (scaled like ordinary samples) and the volts
+ * variants convert the averages.
  */
 int
 buf_read(ScopePvt *, uint16_t *hdr, uint8_t *buf, size_t len);
@@ -182,6 +260,139 @@ buf_read_flt(ScopePvt *scp, uint16_t *hdr, float *buf, size_t nelms);
 int
 buf_read_int16(ScopePvt *scp, uint16_t *hdr, int16_t *buf, size_t nelms);
 
+/* Read the sums of an averaged acquisition ('nelms' int32 elements,
+ * channels interleaved). The sums are in units of the (right-adjusted)
+ * sample size (buf_get_sample_size()); FW_BUF_HDR_FLG_AVG is set in
+ * '*hdr'. The overrange and auto-trigger flags are combined over all
+ * averaged acquisitions; the extended header is that of the last one.
+ * RETURNS: number of bytes read, -ENOTSUP if averaging is not enabled,
+ *          -EAGAIN if the data were acquired before averaging was
+ *          enabled or another negative error.
+ */
+int
+buf_read_avg(ScopePvt *scp, uint16_t *hdr, int32_t *buf, size_t nelms);
+
+/* Like buf_read() but block until an acquisition is available or
+ * 'timeoutMs' expires (wait forever if 'timeoutMs' < 0).
+ * If the firmware supports it (FW_BUF_FLG_WAIT) the reply is held
+ * by the firmware until the acquisition completes (for at most
+ * buf_get_wait_hold_ms() per request); otherwise - and once less than
+ * the hold time of the timeout remains - the buffer is polled
+ * with an increasing interval.
+ * RETURNS: number of bytes read, 0 on timeout or negative error.
+ */
+int
+buf_read_wait(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, int timeoutMs);
+
+/* Read 'count' samples (of each channel) starting at sample 'offset'
+ * of the acquisition; a 'count' of zero reads up to the end or as
+ * many samples as fit into 'buf' ('len' octets). An 'offset' beyond
+ * the end yields the last sample.
+ * If the firmware supports it (FW_BUF_FLG_RANGE) only the region is
+ * transferred; otherwise the whole buffer is read and the region
+ * extracted. Like buf_read() this consumes the acquisition (and
+ * re-arms the trigger), i.e., only one region per acquisition can be
+ * read.
+ * RETURNS: number of bytes read, 0 if no data are available or
+ *          negative error.
+ */
+int
+buf_read_range(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, unsigned long offset, unsigned long count);
+
+/* Read a peak-detect overview of 'count' samples starting at 'offset'
+ * ('count' == 0: the acquisition length, see acq_set_nsamples()) which
+ * is split into (at most) 'nbuckets' buckets. For each bucket the
+ * minimum and the maximum of every channel are stored in 'buf' as two
+ * consecutive samples in the usual (raw) format, i.e., the result
+ * reads like an acquisition of 2*nbuckets samples (fewer if 'len' is
+ * too small or there are fewer samples than buckets).
+ * If the firmware supports it (FW_BUF_FLG_PEAK) the reduction is done
+ * by the firmware and only the overview is transferred; otherwise the
+ * region is read (buf_read_range()) and reduced here. This consumes
+ * the acquisition like buf_read().
+ * RETURNS: number of bytes read, 0 if no data are available or
+ *          negative error.
+ */
+int
+buf_read_overview(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, unsigned long offset, unsigned long count, unsigned long nbuckets);
+
+/* Block until an acquisition is available or 'timeoutMs' expires
+ * (wait forever if 'timeoutMs' < 0). The acquisition is retrieved
+ * and handed out by the next buf_read variant; buf_flush() discards it.
+ * RETURNS: 1 if an acquisition is available, 0 on timeout or
+ *          negative error.
+ */
+int
+buf_wait_triggered(ScopePvt *scp, int timeoutMs);
+
+/* Segmented acquisition (AcqParams.nsegments > 1): the firmware records
+ * up to 'nsegments' triggers of 'nsamples' samples each back-to-back and
+ * re-arms after every segment w/o host intervention. Pre-trigger samples
+ * are not supported in this mode. In the buffer each segment is followed
+ * by a trailer of BUF_SEG_TRAILER_SMPLS samples which buf_read_segments()
+ * strips and decodes.
+ */
+#define BUF_SEG_TRAILER_SMPLS 4
+
+typedef struct BufSegInfo {
+	uint16_t      hdr;     /* FW_BUF_HDR_FLG_xxx of the segment   */
+	uint64_t      tstamp;  /* trigger time (ADC clock cycles; the
+	                        * 48-bit counter wraps around)        */
+} BufSegInfo;
+
+/* Read a segmented acquisition. The segments are stored consecutively
+ * (each holding 'nsamples' raw samples, see AcqParams) in 'buf' ('len'
+ * octets) and their trailers in 'info' (which may be NULL or must have
+ * room for 'maxsegs' entries). Fewer segments than requested are
+ * recorded if the buffer cannot hold them all.
+ * RETURNS: number of segments read, 0 if no data are available or
+ *          negative error (-ENOTSUP if the acquisition is not segmented).
+ */
+int
+buf_read_segments(ScopePvt *scp, uint16_t *hdr, uint8_t *buf, size_t len, BufSegInfo *info, unsigned maxsegs);
+
+/* Conversion of ADC ticks to volts for 'channel' based on the current
+ * gain settings and calibration:
+ *   volt = ticks * scl + off
+ * 'pscl' or 'poff' may be NULL.
+ */
+int
+buf_get_volt_scale(ScopePvt *scp, unsigned channel, double *pscl, double *poff);
+
+/* Read an acquisition and convert it to volts. The channels are
+ * de-interleaved into 'dst' which holds one array per channel
+ * (scope_get_num_channels()) with room for 'nsmpl' samples each.
+ * The conversion uses SIMD instructions if available (sampleConv.h).
+ * RETURNS: number of samples per channel, 0 if no data are available
+ *          or negative error.
+ */
+int
+buf_read_volts_flt(ScopePvt *scp, uint16_t *hdr, float * const dst[], size_t nsmpl);
+
+int
+buf_read_volts_dbl(ScopePvt *scp, uint16_t *hdr, double * const dst[], size_t nsmpl);
+
+/* Convert 'nbytes' of raw data as obtained from buf_read() (e.g., by
+ * the stream engine) to volts; see buf_read_volts_flt().
+ * RETURNS: number of samples per channel or negative error.
+ */
+int
+buf_conv_volts_flt(ScopePvt *scp, float * const dst[], const uint8_t *raw, size_t nbytes);
+
+int
+buf_conv_volts_dbl(ScopePvt *scp, double * const dst[], const uint8_t *raw, size_t nbytes);
+
+struct SampleStats;
+
+/* Per-channel statistics (see sampleStats.h) of 'nsmpl' samples as
+ * obtained from buf_read() ('wide' must match FW_BUF_FLG_16B) or from
+ * buf_read_int16() ('wide' nonzero) in a single pass. Samples at the
+ * limits of the ADC range are counted as overrange.
+ * RETURNS: 0 on success or negative error.
+ */
+int
+buf_compute_stats(ScopePvt *scp, struct SampleStats *st, const void *buf, int wide, size_t nsmpl);
+
 /* enum value = channel index */
 typedef enum TriggerSource { CHA = 0, CHB = 1, EXT = 10 } TriggerSource;
 
@@ -199,6 +410,12 @@ typedef enum TriggerSource { CHA = 0, CHB = 1, EXT = 10 } TriggerSource;
 /* number of samples requires firmware V2 */
 #define ACQ_PARAM_MSK_NSM (1<<7) /* number of samples to acquire  */
 #define ACQ_PARAM_MSK_TGO (1<<8) /* ext. trigger-output enable    */
+/* segmented acquisition requires FW_BUF_FLG_SEG */
+#define ACQ_PARAM_MSK_SEG (1<<9) /* number of segments            */
+/* ping-pong buffering requires FW_BUF_FLG_DBL */
+#define ACQ_PARAM_MSK_DBL (1<<10) /* ping-pong buffering          */
+/* averaging requires FW_BUF_FLG_AVG */
+#define ACQ_PARAM_MSK_AVG (1<<11) /* number of averaged acq.      */
 
 #define ACQ_LD_SCALE_ONE 30
 #define ACQ_SCALE_ONE (1L<<ACQ_LD_SCALE_ONE)
@@ -228,6 +445,9 @@ typedef struct AcqParams {
 	uint8_t       cic0Shift;
 	uint8_t       cic1Shift;
 	int32_t       scale;
+	uint32_t      nsegments;  /* 0, 1: ordinary acquisition */
+	int           doubleBuffer; /* ping-pong buffering      */
+	uint32_t      naverage;   /* 0, 1: no averaging         */
 } AcqParams;
 
 typedef struct AFEParams {
@@ -266,7 +486,14 @@ scope_copy_params(struct ScopeParams *to, const struct ScopeParams *from);
 #define SCOPE_KEY_TRG_H_PERC "triggerHysteresisPercent"
 #define SCOPE_KEY_NPTS       "numPreTriggerSamples"
 #define SCOPE_KEY_NSAMPLES   "numSamples"
+#define SCOPE_KEY_NSEGMENTS  "numSegments"
+#define SCOPE_KEY_DBL_BUF    "doubleBuffer"
+#define SCOPE_KEY_NAVERAGE   "numAverages"
+#define SCOPE_KEY_SEG_HDR    "segmentHeader"
+#define SCOPE_KEY_SEG_TSTAMP "segmentTriggerTicks"
 #define SCOPE_KEY_TRG_AUTO   "autoTriggered"
+#define SCOPE_KEY_ACQ_SEQ    "acquisitionSequence"
+#define SCOPE_KEY_TRG_TSTAMP "triggerTicks"
 #define SCOPE_KEY_AUTOTRG_MS "autoTriggerMilliSeconds"
 #define SCOPE_KEY_DECIMATION "decimation"
 
@@ -321,12 +548,28 @@ scope_init_params(ScopePvt *scp, ScopeParams *p);
 size_t
 scope_sizeof_params(ScopePvt *scp);
 
+/* The library maintains a cached copy of all parameters; the setters
+ * of this library record the values they applied. The getter only
+ * re-reads fields which the hardware may have rounded or clamped
+ * since the last read. The setter only applies fields which differ
+ * from the cached values (a value the hardware cannot represent exactly
+ * differs from the rounded one and is applied again; settings obtained
+ * from scope_get_params() do not).
+ */
 int
 scope_get_params(ScopePvt *, ScopeParams *);
 
 int
 scope_set_params(ScopePvt *, ScopeParams *);
 
+/* Discard the cached parameters (and register shadow) and re-read
+ * everything from the hardware; use if the device has been modified
+ * by other means (e.g., by direct driver or register access or by
+ * another program).
+ */
+int
+scope_resync_params(ScopePvt *);
+
 
 /* Set new parameters and obtain previous parameters.
  * A new acquisition is started if any mask bit is set.
@@ -366,6 +609,33 @@ acq_set_npts(ScopePvt *, uint32_t npts);
 int
 acq_set_nsamples(ScopePvt *, uint32_t nsamples);
 
+/* Returns -ENOTSUP if the firmware does not support segmented acquisition */
+int
+acq_set_nsegments(ScopePvt *, uint32_t nsegments);
+
+/* Ping-pong buffering: the firmware records the next acquisition into
+ * one half of the sample memory while the other half is read out which
+ * removes the readout dead time (at most half of the memory is available
+ * to an acquisition; nsamples is clipped accordingly). The buf_read
+ * variants are unaffected; FW_BUF_HDR_FLG_HALF identifies the half.
+ * Returns -ENOTSUP if the firmware does not support ping-pong buffering.
+ */
+int
+acq_set_double_buffer(ScopePvt *, int enable);
+
+/* Averaging: the firmware sums up 'naverage' triggered acquisitions
+ * of a repetitive signal (in wider words) and hands out the result
+ * as a single acquisition (see buf_read_avg()); uncorrelated noise
+ * is reduced by sqrt(naverage). The firmware limits 'naverage' and
+ * 'nsamples' (the accumulator memory may be smaller than the sample
+ * buffer); the effective values are read back. Averaging is not
+ * available in segmented mode (nsegments is reset) and
+ * buf_read_overview() returns -ENOTSUP.
+ * Returns -ENOTSUP if the firmware does not support averaging.
+ */
+int
+acq_set_naverage(ScopePvt *, uint32_t naverage);
+
 int32_t
 acq_default_cic1Scale(uint32_t cic1Decimation);
 
@@ -0,0 +1,165 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Benchmark sustained acquisitions/sec: polled readout vs. streaming engine */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "fwComm.h"
+#include "scopeSup.h"
+#include "scopeStream.h"
+
+static void usage(const char *nm)
+{
+	printf("usage: %s [-h] [-d usb-dev] [-t seconds] [-n slots] [-p poll_ms]\n", nm);
+	printf("   -h           : this message.\n");
+	printf("   -d usb-dev   : device or transport URI, e.g., tcp:host:port or\n");
+	printf("                  sim: (in-process firmware model)\n");
+	printf("                  (default: $BBCLI_DEVICE or /dev/ttyACM0).\n");
+	printf("   -t seconds   : duration of each measurement (default: 2).\n");
+	printf("   -n slots     : number of ring slots of the streaming engine (default: 4).\n");
+	printf("   -p poll_ms   : sleep of the polled readout while no data are\n");
+	printf("                  ready (default: 10).\n");
+}
+
+static double
+now(void)
+{
+struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (double)t.tv_sec + 1.0E-9*(double)t.tv_nsec;
+}
+
+int
+main(int argc, char **argv)
+{
+const char        *devn;
+unsigned           speed   = 115200;
+unsigned           secs    = 2;
+unsigned           pollMs  = 10;
+unsigned          *u_p;
+int                opt;
+int                rval    = 1;
+int                st;
+unsigned long      n;
+FWInfo            *fw      = NULL;
+ScopePvt          *scp     = NULL;
+ScopeStream       *strm    = NULL;
+ScopeStreamConfig  cfg;
+ScopeStreamSlot   *slot;
+ScopeStreamStats   stats;
+uint8_t           *buf     = NULL;
+uint16_t           hdr;
+size_t             bufsz;
+struct timespec    wai;
+double             then, el;
+
+	if ( ! (devn = getenv( "BBCLI_DEVICE" )) ) {
+		devn = "/dev/ttyACM0";
+	}
+
+	scope_stream_config_init( &cfg );
+
+	while ( (opt = getopt(argc, argv, "d:hn:p:t:")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'h': usage(argv[0]);                                                 return 0;
+			default : fprintf(stderr, "Unknown option -%c (use -h for help)\n", opt); return 1;
+			case 'd': devn = optarg;                                                  break;
+			case 'n': u_p  = &cfg.nslots;                                             break;
+			case 'p': u_p  = &pollMs;                                                 break;
+			case 't': u_p  = &secs;                                                   break;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr, "Unable to scan argument to option -%c -- should be a number\n", opt);
+			goto bail;
+		}
+	}
+
+	if ( ! (fw = fw_open( devn, speed ) ) ) {
+		goto bail;
+	}
+	if ( ! (scp = scope_open( fw )) ) {
+		goto bail;
+	}
+
+	bufsz = buf_get_size( scp ) * scope_get_num_channels( scp ) * ( (buf_get_flags( scp ) & FW_BUF_FLG_16B) ? 2 : 1 );
+	if ( ! (buf = malloc( bufsz )) ) {
+		perror("No memory");
+		goto bail;
+	}
+
+	printf("%-10s %12s %12s\n", "mode", "acq/s", "overruns");
+
+	wai.tv_sec  = pollMs / 1000;
+	wai.tv_nsec = (pollMs % 1000) * 1000000L;
+	buf_flush( scp );
+	n    = 0;
+	then = now();
+	while ( (el = now() - then) < (double)secs ) {
+		if ( (st = buf_read( scp, &hdr, buf, bufsz )) < 0 ) {
+			fprintf(stderr, "buf_read failed: %s\n", strerror(-st));
+			goto bail;
+		}
+		if ( 0 == st ) {
+			clock_nanosleep( CLOCK_MONOTONIC, 0, &wai, NULL );
+		} else {
+			n++;
+		}
+	}
+	printf("%-10s %12.1f %12s\n", "polled", (double)n/el, "-");
+
+	if ( ! (strm = scope_stream_start( scp, &cfg )) ) {
+		goto bail;
+	}
+	n    = 0;
+	then = now();
+	while ( (el = now() - then) < (double)secs ) {
+		if ( 0 == scope_stream_get( strm, &slot, 100 ) ) {
+			n++;
+			scope_stream_put( strm, slot );
+		}
+	}
+	scope_stream_get_stats( strm, &stats );
+	if ( (st = scope_stream_stop( strm )) ) {
+		fprintf(stderr, "Streaming failed: %s\n", strerror(-st));
+		goto bail;
+	}
+	printf("%-10s %12.1f %12llu\n", "stream", (double)n/el, (unsigned long long)stats.overruns);
+
+	rval = 0;
+
+bail:
+	free( buf );
+	scope_close( scp );
+	fw_close( fw );
+	return rval;
+}
@@ -0,0 +1,296 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Micro-benchmark (and consistency check) of the byte-stuffing kernels
+ * and of the COBS framing; the 'wire %' column lists the framing overhead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <math.h>
+
+#include "byteStuff.h"
+
+#define COMMA  BYTE_STUFF_COMMA
+#define ESCAP  BYTE_STUFF_ESCAP
+
+/* chunk size used by the transmitter (cmdXfer) */
+#define TX_CHUNK 500
+
+static void usage(const char *nm)
+{
+	printf("usage: %s [-h] [-s size] [-r repeat]\n", nm);
+	printf("   -h           : this message.\n");
+	printf("   -s size      : size of test data in bytes (default: 4MB).\n");
+	printf("   -r repeat    : number of repetitions per measurement (default: 10).\n");
+}
+
+static double
+now(void)
+{
+struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (double)t.tv_sec + 1.0E-9*(double)t.tv_nsec;
+}
+
+/* Reference: byte-by-byte implementation of the framing */
+static size_t
+refStuff(uint8_t *dst, const uint8_t *src, size_t len)
+{
+size_t i, put = 0;
+	for ( i = 0; i < len; i++ ) {
+		if ( COMMA == src[i] || ESCAP == src[i] ) {
+			dst[put++] = ESCAP;
+		}
+		dst[put++] = src[i];
+	}
+	dst[put++] = COMMA;
+	return put;
+}
+
+static size_t
+kernStuff(uint8_t *dst, const uint8_t *src, size_t len)
+{
+size_t got = 0, put = 0, n;
+	while ( got < len ) {
+		n    = len - got;
+		put += byteStuffBuf( dst + put, TX_CHUNK, src + got, &n );
+		got += n;
+	}
+	dst[put++] = COMMA;
+	return put;
+}
+
+static size_t
+kernDeStuff(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t len, int *peof)
+{
+size_t put;
+int    esc = 0;
+	byteDeStuffBuf( dst, dstsz, src, len, &put, &esc, peof );
+	return put;
+}
+
+static size_t
+cobsStuff(uint8_t *dst, const uint8_t *src, size_t len)
+{
+size_t put;
+	put        = cobsStuffBuf( dst, src, len );
+	dst[put++] = COMMA;
+	return put;
+}
+
+static size_t
+cobsDeStuff(uint8_t *dst, size_t dstsz, const uint8_t *src, size_t len, int *peof)
+{
+size_t put;
+int    st = 0;
+	cobsDeStuffBuf( dst, dstsz, src, len, &put, &st, peof );
+	return put;
+}
+
+typedef struct Pattern {
+	const char *name;
+	void      (*fill)(uint8_t *buf, size_t len, unsigned arg);
+	unsigned    arg;
+} Pattern;
+
+/* 'density': special characters per 256 octets */
+static void
+fill(uint8_t *buf, size_t len, unsigned density)
+{
+size_t i;
+	for ( i = 0; i < len; i++ ) {
+		if ( (unsigned)(random() & 0xff) < density ) {
+			buf[i] = (random() & 1) ? COMMA : ESCAP;
+		} else {
+			do {
+				buf[i] = random();
+			} while ( COMMA == buf[i] || ESCAP == buf[i] );
+		}
+	}
+}
+
+/* Typical waveform: 8-bit samples of a full-scale sine with 'period'
+ * samples plus a little noise.
+ */
+static void
+fillSine(uint8_t *buf, size_t len, unsigned period)
+{
+size_t i;
+	for ( i = 0; i < len; i++ ) {
+		buf[i] = (uint8_t)lrint( 127.0*sin( 2.0*M_PI*(double)i/(double)period ) + (double)(random() % 5) - 2.0 );
+	}
+}
+
+/* Constant signal (e.g., a DC level which happens to be ESCAP) */
+static void
+fillConst(uint8_t *buf, size_t len, unsigned val)
+{
+	memset( buf, val, len );
+}
+
+int
+main(int argc, char **argv)
+{
+static const Pattern pats[] = {
+	{ "clean",  fill,      0     },
+	{ "random", fill,      2     },
+	{ "dense",  fill,      64    },
+	{ "worst",  fill,      256   },
+	{ "sine",   fillSine,  1000  },
+	{ "dc",     fillConst, ESCAP },
+};
+static const ByteStuffKernel kerns[] = {
+	BYTE_STUFF_KERNEL_SCALAR,
+	BYTE_STUFF_KERNEL_SSE2,
+	BYTE_STUFF_KERNEL_AVX2,
+};
+unsigned  size   = 4*1024*1024;
+unsigned  repeat = 10;
+unsigned *u_p;
+int       opt, eof;
+int       rval   = 1;
+uint8_t  *src    = NULL;
+uint8_t  *ref    = NULL;
+uint8_t  *stf    = NULL;
+uint8_t  *dst    = NULL;
+size_t    rlen, slen, dlen;
+unsigned  p, k, r;
+double    then, tStuff, tDeStuff;
+
+	while ( (opt = getopt(argc, argv, "hr:s:")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'h': usage(argv[0]);                                                 return 0;
+			default : fprintf(stderr, "Unknown option -%c (use -h for help)\n", opt); return 1;
+			case 's': u_p = &size;                                                    break;
+			case 'r': u_p = &repeat;                                                  break;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr, "Unable to scan argument to option -%c -- should be a number\n", opt);
+			goto bail;
+		}
+	}
+
+	if ( repeat < 1 ) {
+		fprintf(stderr, "Number of repetitions must be positive\n");
+		goto bail;
+	}
+
+	src = malloc( size );
+	dst = malloc( size );
+	ref = malloc( 2*size + 1 );
+	stf = malloc( 2*size + 1 + BYTE_STUFF_COBS_MAXLEN( size ) );
+	if ( ! src || ! dst || ! ref || ! stf ) {
+		perror("No memory");
+		goto bail;
+	}
+
+	printf("%-8s %-8s %12s %12s %8s\n", "data", "kernel", "stuff MB/s", "destuff MB/s", "wire %");
+	for ( p = 0; p < sizeof(pats)/sizeof(pats[0]); p++ ) {
+		pats[p].fill( src, size, pats[p].arg );
+		rlen = refStuff( ref, src, size );
+		for ( k = 0; k < sizeof(kerns)/sizeof(kerns[0]); k++ ) {
+			if ( byteStuffSelectKernel( kerns[k] ) ) {
+				/* not supported by this CPU */
+				continue;
+			}
+			tStuff = tDeStuff = 0.0;
+			for ( r = 0; r < repeat; r++ ) {
+				then    = now();
+				slen    = kernStuff( stf, src, size );
+				tStuff += now() - then;
+				if ( slen != rlen || memcmp( stf, ref, rlen ) ) {
+					fprintf(stderr, "FAILED: %s kernel stuffing mismatch (%s data)\n", byteStuffKernelName( kerns[k] ), pats[p].name);
+					goto bail;
+				}
+				then      = now();
+				dlen      = kernDeStuff( dst, size, stf, slen, &eof );
+				tDeStuff += now() - then;
+				if ( ! eof || dlen != size || memcmp( dst, src, size ) ) {
+					fprintf(stderr, "FAILED: %s kernel de-stuffing mismatch (%s data)\n", byteStuffKernelName( kerns[k] ), pats[p].name);
+					goto bail;
+				}
+			}
+			/* in-place */
+			slen = kernStuff( stf, src, size );
+			dlen = kernDeStuff( stf, size, stf, slen, &eof );
+			if ( ! eof || dlen != size || memcmp( stf, src, size ) ) {
+				fprintf(stderr, "FAILED: %s kernel in-place de-stuffing mismatch (%s data)\n", byteStuffKernelName( kerns[k] ), pats[p].name);
+				goto bail;
+			}
+			printf("%-8s %-8s %12.1f %12.1f %8.2f\n",
+				pats[p].name,
+				byteStuffKernelName( kerns[k] ),
+				1.0E-6*(double)size*(double)repeat/tStuff,
+				1.0E-6*(double)size*(double)repeat/tDeStuff,
+				100.0*(double)(slen - size)/(double)size);
+		}
+		byteStuffSelectKernel( BYTE_STUFF_KERNEL_AUTO );
+		tStuff = tDeStuff = 0.0;
+		for ( r = 0; r < repeat; r++ ) {
+			then    = now();
+			slen    = cobsStuff( stf, src, size );
+			tStuff += now() - then;
+			if ( slen > BYTE_STUFF_COBS_MAXLEN( size ) + 1 || memchr( stf, COMMA, slen - 1 ) ) {
+				fprintf(stderr, "FAILED: COBS encoding invalid (%s data)\n", pats[p].name);
+				goto bail;
+			}
+			then      = now();
+			dlen      = cobsDeStuff( dst, size, stf, slen, &eof );
+			tDeStuff += now() - then;
+			if ( ! eof || dlen != size || memcmp( dst, src, size ) ) {
+				fprintf(stderr, "FAILED: COBS decoding mismatch (%s data)\n", pats[p].name);
+				goto bail;
+			}
+		}
+		slen = cobsStuff( stf, src, size );
+		dlen = cobsDeStuff( stf, size, stf, slen, &eof );
+		if ( ! eof || dlen != size || memcmp( stf, src, size ) ) {
+			fprintf(stderr, "FAILED: COBS in-place decoding mismatch (%s data)\n", pats[p].name);
+			goto bail;
+		}
+		printf("%-8s %-8s %12.1f %12.1f %8.2f\n",
+			pats[p].name,
+			"cobs",
+			1.0E-6*(double)size*(double)repeat/tStuff,
+			1.0E-6*(double)size*(double)repeat/tDeStuff,
+			100.0*(double)(slen - size)/(double)size);
+	}
+
+	rval = 0;
+
+bail:
+	byteStuffSelectKernel( BYTE_STUFF_KERNEL_AUTO );
+	free( stf );
+	free( ref );
+	free( dst );
+	free( src );
+	return rval;
+}
@@ -31,6 +31,7 @@
 #include "scopeSup.h"
 #include "tca6408FECSup.h"
 
+#define INP_REG 0x00
 #define OUT_REG 0x01
 #define DIR_REG 0x03
 #define DIR_ALL_OUT 0x00
@@ -45,17 +46,43 @@ typedef struct TCA6408FECSup {
 	unsigned     invert;
 } TCA6408FECSup;
 
+/* The output register is only changed by us; serve it from the
+ * register shadow.
+ */
+static int
+readOut(TCA6408FECSup *fec)
+{
+	uint8_t        sla8 = (fec->sla << 1);
+	int            st;
+	if ( (st = fw_shadow_get( fec->fw, FW_SHADOW_I2C( sla8 ), OUT_REG )) < 0 ) {
+		if ( (st = bb_i2c_read_reg( fec->fw, sla8, OUT_REG )) >= 0 ) {
+			fw_shadow_set( fec->fw, FW_SHADOW_I2C( sla8 ), OUT_REG, st );
+		}
+	}
+	return st;
+}
+
+static int
+writeOut(TCA6408FECSup *fec, uint8_t val)
+{
+	uint8_t        sla8 = (fec->sla << 1);
+	int            st;
+	if ( (st = bb_i2c_write_reg( fec->fw, sla8, OUT_REG, val )) >= 0 ) {
+		fw_shadow_set( fec->fw, FW_SHADOW_I2C( sla8 ), OUT_REG, val );
+	}
+	return st;
+}
+
 static int
 readBit(FECOps *ops, unsigned channel, I2CFECSupBitSelect which)
 {
 	TCA6408FECSup *fec  = (TCA6408FECSup*)ops;
-	uint8_t        sla8 = (fec->sla << 1);
 	int            msk  = fec->getBit( fec->fw, channel, which );
 	int            st;
 	if ( msk < 0 ) {
 		return msk;
 	}
-	if ( (st = bb_i2c_read_reg( fec->fw, sla8, OUT_REG )) < 0 ) {
+	if ( (st = readOut( fec )) < 0 ) {
 		return st;
 	}
 	return !! ((st ^ fec->invert) & msk );
@@ -65,13 +92,12 @@ static int
 writeBit(FECOps *ops, unsigned channel, I2CFECSupBitSelect which, unsigned on)
 {
 	TCA6408FECSup *fec  = (TCA6408FECSup*)ops;
-	uint8_t        sla8 = (fec->sla << 1);
 	int            msk  = fec->getBit( fec->fw, channel, which );
 	int            st;
 	if ( msk < 0 ) {
 		return msk;
 	}
-	if ( (st = bb_i2c_read_reg( fec->fw, sla8, OUT_REG )) < 0 ) {
+	if ( (st = readOut( fec )) < 0 ) {
 		return st;
 	}
 	if ( !!on != !!(msk & fec->invert) ) {
@@ -79,7 +105,7 @@ writeBit(FECOps *ops, unsigned channel, I2CFECSupBitSelect which, unsigned on)
 	} else {
 		st &= ~msk;
 	}
-	return bb_i2c_write_reg( fec->fw, sla8, OUT_REG, st );
+	return writeOut( fec, st );
 }
 
 
@@ -45,22 +45,57 @@
  */
 #undef  USE_INT_MODE
 
+#define SHADOW      FW_SHADOW_I2C( CLK_I2C_SLA )
+
+/* Status (PLL lock, loss-of-signal) registers must not be cached */
+#define STATUS_REG_FIRST 0x9d
+#define STATUS_REG_LAST  0x9f
+
+void
+versaClkInit(FWInfo *fw)
+{
+unsigned reg;
+	for ( reg = STATUS_REG_FIRST; reg <= STATUS_REG_LAST; reg++ ) {
+		fw_shadow_set_volatile( fw, SHADOW, reg );
+	}
+}
+
+static int
+rawReadReg(FWInfo *fw, unsigned reg)
+{
+int st;
+	if ( (st = bb_i2c_read_reg(fw, CLK_I2C_SLA, reg)) >= 0 ) {
+		fw_shadow_set( fw, SHADOW, reg, st );
+	}
+	return st;
+}
+
+/* configuration registers are served from the register shadow */
 static int
 readReg(FWInfo *fw, unsigned reg)
 {
-	return bb_i2c_read_reg(fw, CLK_I2C_SLA, reg);
+int st;
+	if ( (st = fw_shadow_get( fw, SHADOW, reg )) < 0 ) {
+		st = rawReadReg( fw, reg );
+	}
+	return st;
 }
 
 static int
 writeReg(FWInfo *fw, unsigned reg, uint8_t val)
 {
-	return bb_i2c_write_reg(fw, CLK_I2C_SLA, reg, val);
+int st;
+	if ( (st = bb_i2c_write_reg(fw, CLK_I2C_SLA, reg, val)) >= 0 ) {
+		fw_shadow_set( fw, SHADOW, reg, val );
+	}
+	return st;
 }
 
+/* Always reads the device */
 int
 versaClkReadReg(FWInfo *fw, unsigned reg)
 {
-	return readReg( fw, reg );
+	return rawReadReg( fw, reg );
 }
 
 int
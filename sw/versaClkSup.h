@@ -67,6 +67,12 @@ typedef enum VersaClkFODRoute {
   OFF      = 3  /* FOD and OUT disabled       */
 } VersaClkFODRoute;
 
+/* Exclude the status registers from the register shadow;
+ * call once after fw_open() (scope_open() does).
+ */
+void
+versaClkInit(FWInfo *fw);
+
 int
 versaClkReadReg(FWInfo *fw, unsigned reg);
 
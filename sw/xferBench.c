@@ -0,0 +1,155 @@
+/**LB-MIT
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Till Straumann
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **LE-MIT*/
+
+/* Benchmark command throughput (ops/sec) versus pipeline depth */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "fwComm.h"
+
+static void usage(const char *nm)
+{
+	printf("usage: %s [-h] [-d usb-dev] [-n num_ops] [-D max_depth]\n", nm);
+	printf("   -h           : this message.\n");
+	printf("   -d usb-dev   : device or transport URI, e.g., tcp:host:port or\n");
+	printf("                  sim: (in-process firmware model)\n");
+	printf("                  (default: $BBCLI_DEVICE or /dev/ttyACM0).\n");
+	printf("   -n num_ops   : number of commands per measurement (default: 2000).\n");
+	printf("   -D max_depth : max. number of commands in flight; depth is\n");
+	printf("                  doubled from 1 up to this value (default: 64).\n");
+}
+
+static double
+now(void)
+{
+struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (double)t.tv_sec + 1.0E-9*(double)t.tv_nsec;
+}
+
+int
+main(int argc, char **argv)
+{
+const char   *devn;
+unsigned      speed    = 115200;
+unsigned      nops     = 2000;
+unsigned      maxDepth = 64;
+unsigned     *u_p;
+unsigned      depth, i;
+int           opt;
+int           rval     = 1;
+int           st;
+FWInfo       *fw       = NULL;
+FifoXferReq  *reqs     = NULL;
+uint8_t      *cmds     = NULL;
+uint8_t      *vers     = NULL;
+rbufvec      *rvec     = NULL;
+uint8_t       cmd;
+double        then, secs;
+
+	if ( ! (devn = getenv( "BBCLI_DEVICE" )) ) {
+		devn = "/dev/ttyACM0";
+	}
+
+	while ( (opt = getopt(argc, argv, "d:D:hn:")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'h': usage(argv[0]);                                                 return 0;
+			default : fprintf(stderr, "Unknown option -%c (use -h for help)\n", opt); return 1;
+			case 'd': devn = optarg;                                                  break;
+			case 'n': u_p  = &nops;                                                   break;
+			case 'D': u_p  = &maxDepth;                                               break;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr, "Unable to scan argument to option -%c -- should be a number\n", opt);
+			goto bail;
+		}
+	}
+
+	if ( 0 == nops || 0 == maxDepth ) {
+		fprintf(stderr, "Number of ops and depth must be > 0\n");
+		goto bail;
+	}
+
+	reqs = calloc( nops, sizeof(*reqs) );
+	cmds = calloc( nops, sizeof(*cmds) );
+	vers = calloc( nops, sizeof(uint64_t) );
+	rvec = calloc( nops, sizeof(*rvec) );
+	if ( ! reqs || ! cmds || ! vers || ! rvec ) {
+		perror("No memory");
+		goto bail;
+	}
+
+	if ( ! (fw = fw_open( devn, speed ) ) ) {
+		goto bail;
+	}
+
+	cmd = fw_get_cmd( fw, FW_CMD_VERSION );
+
+	printf("%8s %12s %12s\n", "depth", "ops/s", "us/op");
+	for ( depth = 1; depth <= maxDepth; depth <<= 1 ) {
+		for ( i = 0; i < nops; i++ ) {
+			cmds[i]        = cmd;
+			rvec[i].buf    = vers + i*sizeof(uint64_t);
+			rvec[i].len    = sizeof(uint64_t);
+			reqs[i].cmdp   = &cmds[i];
+			reqs[i].tbuf   = NULL;
+			reqs[i].tcnt   = 0;
+			reqs[i].rbuf   = &rvec[i];
+			reqs[i].rcnt   = 1;
+			reqs[i].status = 0;
+		}
+		then = now();
+		st   = fw_xfer_vec_multi( fw, reqs, nops, depth );
+		secs = now() - then;
+		if ( st < 0 ) {
+			fprintf(stderr, "Transfer failed (depth %u): %s\n", depth, strerror(-st));
+			goto bail;
+		}
+		for ( i = 0; i < nops; i++ ) {
+			if ( reqs[i].status < 0 || memcmp( vers, vers + i*sizeof(uint64_t), sizeof(uint64_t) ) ) {
+				fprintf(stderr, "Reply %u mismatch (depth %u)\n", i, depth);
+				goto bail;
+			}
+		}
+		printf("%8u %12.0f %12.2f\n", depth, (double)nops/secs, 1.0E6*secs/(double)nops);
+	}
+
+	rval = 0;
+
+bail:
+	fw_close( fw );
+	free( rvec );
+	free( vers );
+	free( cmds );
+	free( reqs );
+	return rval;
+}